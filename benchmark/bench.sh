@@ -0,0 +1,274 @@
+#!/bin/sh
+#
+# end-to-end benchmark.  for each scenario of benchmark/workload, starts a
+# fresh Xvfb (with GLX, Mesa drawing with llvmpipe) and a fresh Ortle on it,
+# plays the scenario, and reads what it cost from Ortle's metrics socket and
+# /proc.  the results go to standard output, or the given file, as JSON:
+#
+#   frames         how many were drawn during the scenario and their mean,
+#                  and the quantiles over Ortle's most recent frames, in ms
+#   cpu_seconds    Ortle's user and system time, and the X server's
+#   x_round_trips  blocking X requests and the time spent on them, in total
+#                  and by call site
+#   x_events       X events Ortle handled
+#   memory_kb      Ortle's resident and peak resident memory at the end
+#
+# usage: benchmark/bench.sh [output]
+#
+# and to change what is run, e.g.
+#
+#   BENCH_SCENARIOS="tiling resize" BENCH_WINDOWS=64 BENCH_SECONDS=20 make bench
+#
+
+set -eu
+
+
+here=$(dirname "$0")
+
+ortle=${ORTLE:-$here/../ortle}
+workload=$here/workload
+
+scenarios=${BENCH_SCENARIOS:-"windows tiling resize popups shaped wallpaper"}
+windows=${BENCH_WINDOWS:-16}
+seconds=${BENCH_SECONDS:-10}
+screen=${BENCH_SCREEN:-1920x1080x24}
+display=${BENCH_DISPLAY:-:97}
+
+output=${1:-/dev/stdout}
+
+
+directory=$(mktemp -d "${TMPDIR:-/tmp}/ortle-bench.XXXXXX")
+metrics=$directory/metrics
+
+xvfb_pid=
+ortle_pid=
+
+
+stop()
+{
+	if [ -n "$ortle_pid" ]; then
+		kill "$ortle_pid" 2> /dev/null || true
+		wait "$ortle_pid" 2> /dev/null || true
+		ortle_pid=
+	fi
+
+	if [ -n "$xvfb_pid" ]; then
+		kill "$xvfb_pid" 2> /dev/null || true
+		wait "$xvfb_pid" 2> /dev/null || true
+		xvfb_pid=
+	fi
+}
+
+trap 'stop; rm -rf "$directory"' EXIT
+trap 'exit 1' INT TERM
+
+
+fail()
+{
+	echo "bench: $*" >&2
+
+	if [ -s "$directory/ortle.log" ]; then
+		tail -n 20 "$directory/ortle.log" >&2
+	fi
+
+	exit 1
+}
+
+
+# waits up to five seconds for something to exist, e.g. a socket
+
+wait_for()
+{
+	tries=0
+
+	while [ ! -S "$1" ]; do
+
+		tries=$((tries + 1))
+
+		if [ "$tries" -gt 50 ]; then
+			return 1
+		fi
+
+		sleep 0.1
+	done
+}
+
+
+# utime and stime, in clock ticks, from /proc/<pid>/stat.  the command name
+# may have spaces in it, so the fields are counted from the closing paren.
+
+cpu_ticks()
+{
+	sed 's/.*) //' "/proc/$1/stat" | awk '{ print $12, $13 }'
+}
+
+
+memory()
+{
+	awk '/^VmRSS:/ { rss = $2 } /^VmHWM:/ { peak = $2 } END { print rss, peak }' "/proc/$1/status"
+}
+
+
+scrape()
+{
+	curl -s --unix-socket "$metrics" http://ortle/metrics > "$1" || fail "could not read the metrics"
+}
+
+
+run()
+{
+	scenario=$1
+
+	Xvfb "$display" -screen 0 "$screen" +extension GLX +extension Composite -nolisten tcp -noreset > "$directory/xvfb.log" 2>&1 &
+	xvfb_pid=$!
+
+	wait_for "/tmp/.X11-unix/X${display#:}" || fail "Xvfb did not start"
+
+	rm -f "$metrics"
+
+	DISPLAY=$display ORTLE_METRICS=$metrics "$ortle" > "$directory/ortle.log" 2>&1 &
+	ortle_pid=$!
+
+	wait_for "$metrics" || fail "Ortle did not start"
+
+	# let the first frames, and the shaders being compiled, get out of the
+	# way
+
+	sleep 1
+
+	scrape "$directory/before"
+	set -- $(cpu_ticks "$ortle_pid") $(cpu_ticks "$xvfb_pid")
+	user_before=$1 system_before=$2 server_before=$(($3 + $4))
+
+	steps=$(DISPLAY=$display "$workload" "$scenario" "$windows" "$seconds" | sed -n 's/.*"steps": \([0-9]*\).*/\1/p')
+
+	[ -n "$steps" ] || fail "the $scenario workload failed"
+
+	# and the last frames to be drawn
+
+	sleep 0.2
+
+	kill -0 "$ortle_pid" 2> /dev/null || fail "Ortle exited during $scenario"
+
+	scrape "$directory/after"
+	set -- $(cpu_ticks "$ortle_pid") $(cpu_ticks "$xvfb_pid") $(memory "$ortle_pid")
+	user=$(($1 - user_before)) system=$(($2 - system_before)) server=$(($3 + $4 - server_before))
+	rss=$5 peak=$6
+
+	stop
+
+	awk \
+		-v scenario="$scenario" \
+		-v windows="$windows" \
+		-v seconds="$seconds" \
+		-v steps="$steps" \
+		-v ticks="$(getconf CLK_TCK)" \
+		-v user_ticks="$user" \
+		-v system_ticks="$system" \
+		-v server_ticks="$server" \
+		-v rss="$rss" \
+		-v peak="$peak" \
+		'
+		# site names have spaces in them, so the value is whatever follows
+		# the last one
+
+		/^#/ { next }
+
+		{
+			value = $NF
+			name = substr($0, 1, length($0) - length(value) - 1)
+		}
+
+		FNR == NR { before[name] = value; next }
+
+		{ after[name] = value }
+
+		function delta(name) {
+			return after[name] - before[name]
+		}
+
+		function milliseconds(name) {
+			return (after[name] == "NaN" ? "null" : sprintf("%.3f", after[name] * 1000))
+		}
+
+		END {
+			frames = delta("ortle_frame_seconds_count")
+			frame_time = delta("ortle_frame_seconds_sum")
+
+			events = 0
+			round_trips = 0
+			round_trip_time = 0
+			sites = ""
+
+			for (name in after) {
+
+				if (name ~ /^ortle_x_events_total/) {
+					events += delta(name)
+				}
+
+				if (name ~ /^ortle_x_round_trips_total/ && delta(name) > 0) {
+
+					site = name
+					sub(/^[^"]*"/, "", site)
+					sub(/"}$/, "", site)
+
+					time = name
+					sub(/^ortle_x_round_trips_total/, "ortle_x_round_trip_seconds_total", time)
+
+					round_trips += delta(name)
+					round_trip_time += delta(time)
+
+					sites = sites (sites == "" ? "" : ",") sprintf("\n\t\t\t\t\"%s\": { \"count\": %d, \"seconds\": %.6f }", site, delta(name), delta(time))
+				}
+			}
+
+			printf "\t\t{\n"
+			printf "\t\t\t\"scenario\": \"%s\",\n", scenario
+			printf "\t\t\t\"windows\": %d,\n", windows
+			printf "\t\t\t\"seconds\": %s,\n", seconds
+			printf "\t\t\t\"steps\": %d,\n", steps
+			printf "\t\t\t\"frames\": { \"count\": %d, \"mean_ms\": %s, \"p50_ms\": %s, \"p95_ms\": %s, \"p99_ms\": %s },\n", frames, (frames > 0 ? sprintf("%.3f", frame_time / frames * 1000) : "null"), milliseconds("ortle_frame_seconds{quantile=\"0.5\"}"), milliseconds("ortle_frame_seconds{quantile=\"0.95\"}"), milliseconds("ortle_frame_seconds{quantile=\"0.99\"}")
+			printf "\t\t\t\"cpu_seconds\": { \"user\": %.2f, \"system\": %.2f, \"server\": %.2f },\n", user_ticks / ticks, system_ticks / ticks, server_ticks / ticks
+			printf "\t\t\t\"x_round_trips\": { \"count\": %d, \"seconds\": %.6f, \"sites\": {%s%s} },\n", round_trips, round_trip_time, sites, (sites == "" ? "" : "\n\t\t\t")
+			printf "\t\t\t\"x_events\": %d,\n", events
+			printf "\t\t\t\"memory_kb\": { \"rss\": %d, \"peak\": %d }\n", rss, peak
+			printf "\t\t}"
+		}
+		' "$directory/before" "$directory/after"
+}
+
+
+[ -x "$ortle" ] || fail "no Ortle at $ortle, build it first"
+[ -x "$workload" ] || fail "no workload client at $workload, build it first"
+
+command -v Xvfb > /dev/null || fail "Xvfb is needed"
+command -v curl > /dev/null || fail "curl is needed"
+
+
+# Mesa, drawing on the CPU.  the numbers are only comparable between runs
+# on the same machine.
+
+export LIBGL_ALWAYS_SOFTWARE=1
+export GALLIUM_DRIVER=llvmpipe
+
+export ORTLE_LOG=${ORTLE_LOG:-warning}
+
+
+results=$directory/results
+separator=
+
+{
+	printf '{\n\t"scenarios": [\n'
+
+	for scenario in $scenarios; do
+		printf '%s' "$separator"
+		run "$scenario"
+		separator=$(printf ',\n_')
+		separator=${separator%_}
+	done
+
+	printf '\n\t]\n}\n'
+
+} > "$results"
+
+cat "$results" > "$output"
@@ -0,0 +1,612 @@
+#include "fake_server.hpp"
+
+#include "../source/x11/xlib.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xcomposite.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+
+
+
+namespace {
+
+
+unsigned int const l_depth = 24;
+
+
+// the server, while there is one.  as with the recorder, calls on any other
+// display go straight to Xlib.
+
+FakeServer* g_server = nullptr;
+
+
+bool faked(::Display* display)
+{
+	return g_server != nullptr && display == g_server->display();
+}
+
+
+
+
+::Atom intern_atom(::Display* display, char const* name, Bool only_if_exists)
+{
+	if (!faked(display)) {
+		return XInternAtom(display, name, only_if_exists);
+	}
+
+	return g_server->atom(name);
+}
+
+
+Status get_window_attributes(::Display* display, ::Window window, XWindowAttributes* attributes)
+{
+	if (!faked(display)) {
+		return XGetWindowAttributes(display, window, attributes);
+	}
+
+	FakeServer::Drawable const* drawable = g_server->find(window);
+
+	if (drawable == nullptr || drawable->pixmap) {
+		return 0;
+	}
+
+	std::memset(attributes, 0, sizeof(*attributes));
+
+	attributes->x = drawable->x;
+	attributes->y = drawable->y;
+	attributes->width = static_cast<int>(drawable->width);
+	attributes->height = static_cast<int>(drawable->height);
+	attributes->depth = static_cast<int>(drawable->depth);
+	attributes->visual = g_server->visual();
+	attributes->root = g_server->root();
+	attributes->c_class = (drawable->input_only ? InputOnly : InputOutput);
+	attributes->map_state = (drawable->mapped ? IsViewable : IsUnmapped);
+	attributes->override_redirect = False;
+
+	return 1;
+}
+
+
+// there are no properties
+
+int get_window_property(::Display* display, ::Window window, ::Atom property, long offset, long length, Bool remove, ::Atom requested_type, ::Atom* type, int* format, unsigned long* count, unsigned long* remaining, unsigned char** data)
+{
+	if (!faked(display)) {
+		return XGetWindowProperty(display, window, property, offset, length, remove, requested_type, type, format, count, remaining, data);
+	}
+
+	*type = None;
+	*format = 0;
+	*count = 0;
+	*remaining = 0;
+	*data = nullptr;
+
+	return Success;
+}
+
+
+// the stack is the window manager's business, so the tree is always empty
+
+Status query_tree(::Display* display, ::Window window, ::Window* root, ::Window* parent, ::Window** children, unsigned int* count)
+{
+	if (!faked(display)) {
+		return XQueryTree(display, window, root, parent, children, count);
+	}
+
+	if (g_server->find(window) == nullptr) {
+		return 0;
+	}
+
+	*root = g_server->root();
+	*parent = (window == g_server->root() ? None : g_server->root());
+	*children = nullptr;
+	*count = 0;
+
+	return 1;
+}
+
+
+Status get_geometry(::Display* display, ::Drawable target, ::Window* root, int* x, int* y, unsigned int* width, unsigned int* height, unsigned int* border_width, unsigned int* depth)
+{
+	if (!faked(display)) {
+		return XGetGeometry(display, target, root, x, y, width, height, border_width, depth);
+	}
+
+	FakeServer::Drawable const* drawable = g_server->find(target);
+
+	if (drawable == nullptr) {
+		return 0;
+	}
+
+	*root = g_server->root();
+	*x = drawable->x;
+	*y = drawable->y;
+	*width = drawable->width;
+	*height = drawable->height;
+	*border_width = 0;
+	*depth = drawable->depth;
+
+	return 1;
+}
+
+
+// every window is a child of the root
+
+Bool translate_coordinates(::Display* display, ::Window source, ::Window destination, int source_x, int source_y, int* x, int* y, ::Window* child)
+{
+	if (!faked(display)) {
+		return XTranslateCoordinates(display, source, destination, source_x, source_y, x, y, child);
+	}
+
+	FakeServer::Drawable const* from = g_server->find(source);
+	FakeServer::Drawable const* to = g_server->find(destination);
+
+	if (from == nullptr || to == nullptr) {
+		return False;
+	}
+
+	*x = source_x + from->x - to->x;
+	*y = source_y + from->y - to->y;
+	*child = None;
+
+	return True;
+}
+
+
+Status shape_query_extents(::Display* display, ::Window window, Bool* bounding_shaped, int* bounding_x, int* bounding_y, unsigned int* bounding_width, unsigned int* bounding_height, Bool* clip_shaped, int* clip_x, int* clip_y, unsigned int* clip_width, unsigned int* clip_height)
+{
+	if (!faked(display)) {
+		return XShapeQueryExtents(display, window, bounding_shaped, bounding_x, bounding_y, bounding_width, bounding_height, clip_shaped, clip_x, clip_y, clip_width, clip_height);
+	}
+
+	FakeServer::Drawable const* drawable = g_server->find(window);
+
+	if (drawable == nullptr) {
+		return 0;
+	}
+
+	*bounding_shaped = *clip_shaped = False;
+	*bounding_x = *clip_x = 0;
+	*bounding_y = *clip_y = 0;
+	*bounding_width = *clip_width = drawable->width;
+	*bounding_height = *clip_height = drawable->height;
+
+	return 1;
+}
+
+
+XRectangle* shape_get_rectangles(::Display* display, ::Window window, int kind, int* count, int* ordering)
+{
+	if (!faked(display)) {
+		return XShapeGetRectangles(display, window, kind, count, ordering);
+	}
+
+	FakeServer::Drawable const* drawable = g_server->find(window);
+
+	if (drawable == nullptr) {
+		*count = 0;
+		return nullptr;
+	}
+
+	// freed with XFree, which is free()
+
+	XRectangle* rectangle = static_cast<XRectangle*>(std::malloc(sizeof(XRectangle)));
+	rectangle->x = 0;
+	rectangle->y = 0;
+	rectangle->width = static_cast<unsigned short>(drawable->width);
+	rectangle->height = static_cast<unsigned short>(drawable->height);
+
+	*count = 1;
+	*ordering = YXBanded;
+
+	return rectangle;
+}
+
+
+Visual* screen_visual(::Display* display, int screen)
+{
+	if (!faked(display)) {
+		return XDefaultVisual(display, screen);
+	}
+
+	return g_server->visual();
+}
+
+
+int screen_depth(::Display* display, int screen)
+{
+	if (!faked(display)) {
+		return XDefaultDepth(display, screen);
+	}
+
+	return static_cast<int>(l_depth);
+}
+
+
+GC screen_gc(::Display* display, int screen)
+{
+	if (!faked(display)) {
+		return XDefaultGC(display, screen);
+	}
+
+	return nullptr;
+}
+
+
+// like the real thing, a new pixmap every time, as long as the window is
+// mapped
+
+::Pixmap composite_name_window_pixmap(::Display* display, ::Window window)
+{
+	if (!faked(display)) {
+		return XCompositeNameWindowPixmap(display, window);
+	}
+
+	FakeServer::Drawable const* drawable = g_server->find(window);
+
+	if (drawable == nullptr || drawable->input_only || !drawable->mapped) {
+		return None;
+	}
+
+	return g_server->add_pixmap(drawable->width, drawable->height, drawable->depth);
+}
+
+
+::Pixmap create_pixmap(::Display* display, ::Drawable drawable, unsigned int width, unsigned int height, unsigned int depth)
+{
+	if (!faked(display)) {
+		return XCreatePixmap(display, drawable, width, height, depth);
+	}
+
+	return g_server->add_pixmap(width, height, depth);
+}
+
+
+int free_pixmap(::Display* display, ::Pixmap pixmap)
+{
+	if (!faked(display)) {
+		return XFreePixmap(display, pixmap);
+	}
+
+	g_server->remove_pixmap(pixmap);
+
+	return 1;
+}
+
+
+::Damage damage_create(::Display* display, ::Drawable drawable, int level)
+{
+	if (!faked(display)) {
+		return XDamageCreate(display, drawable, level);
+	}
+
+	return g_server->allocate_id();
+}
+
+
+// the rest change nothing window management can see
+
+void damage_destroy(::Display* display, ::Damage damage)
+{
+	if (!faked(display)) {
+		XDamageDestroy(display, damage);
+	}
+}
+
+
+void damage_subtract(::Display* display, ::Damage damage, XserverRegion repair, XserverRegion parts)
+{
+	if (!faked(display)) {
+		XDamageSubtract(display, damage, repair, parts);
+	}
+}
+
+
+void composite_redirect_subwindows(::Display* display, ::Window window, int update)
+{
+	if (!faked(display)) {
+		XCompositeRedirectSubwindows(display, window, update);
+	}
+}
+
+
+void composite_unredirect_subwindows(::Display* display, ::Window window, int update)
+{
+	if (!faked(display)) {
+		XCompositeUnredirectSubwindows(display, window, update);
+	}
+}
+
+
+int copy_area(::Display* display, ::Drawable source, ::Drawable destination, GC gc, int source_x, int source_y, unsigned int width, unsigned int height, int x, int y)
+{
+	if (!faked(display)) {
+		return XCopyArea(display, source, destination, gc, source_x, source_y, width, height, x, y);
+	}
+
+	return 0;
+}
+
+
+int select_input(::Display* display, ::Window window, long mask)
+{
+	if (!faked(display)) {
+		return XSelectInput(display, window, mask);
+	}
+
+	return 0;
+}
+
+
+void shape_select_input(::Display* display, ::Window window, unsigned long mask)
+{
+	if (!faked(display)) {
+		XShapeSelectInput(display, window, mask);
+	}
+}
+
+
+int grab_server(::Display* display)
+{
+	if (!faked(display)) {
+		return XGrabServer(display);
+	}
+
+	return 0;
+}
+
+
+int ungrab_server(::Display* display)
+{
+	if (!faked(display)) {
+		return XUngrabServer(display);
+	}
+
+	return 0;
+}
+
+
+} // namespace
+
+
+
+
+FakeServer::FakeServer(unsigned int width, unsigned int height)
+	: m_token(0)
+	, m_display(reinterpret_cast<::Display*>(&m_token))
+	, m_root(None)
+	, m_visual()
+	, m_drawables()
+	, m_atoms()
+	, m_next_id(0x200000)
+	, m_serial(0)
+	, m_pixmaps(0)
+{
+	assert(g_server == nullptr);
+
+	std::memset(&m_visual, 0, sizeof(m_visual));
+	m_visual.visualid = 0x21;
+	m_visual.c_class = TrueColor;
+	m_visual.red_mask = 0xff0000;
+	m_visual.green_mask = 0x00ff00;
+	m_visual.blue_mask = 0x0000ff;
+	m_visual.bits_per_rgb = 8;
+	m_visual.map_entries = 256;
+
+	m_root = allocate_id();
+
+	Drawable root = { 0, 0, width, height, l_depth, false, false, true };
+	m_drawables.emplace(m_root, root);
+
+
+	g_server = this;
+
+	X11::Xlib::InternAtom = &intern_atom;
+	X11::Xlib::GetWindowAttributes = &get_window_attributes;
+	X11::Xlib::GetWindowProperty = &get_window_property;
+	X11::Xlib::QueryTree = &query_tree;
+	X11::Xlib::GetGeometry = &get_geometry;
+	X11::Xlib::TranslateCoordinates = &translate_coordinates;
+	X11::Xlib::ShapeQueryExtents = &shape_query_extents;
+	X11::Xlib::ShapeGetRectangles = &shape_get_rectangles;
+
+	X11::Xlib::ScreenVisual = &screen_visual;
+	X11::Xlib::ScreenDepth = &screen_depth;
+	X11::Xlib::ScreenGC = &screen_gc;
+
+	X11::Xlib::CompositeNameWindowPixmap = &composite_name_window_pixmap;
+
+	X11::Xlib::CompositeRedirectSubwindows = &composite_redirect_subwindows;
+	X11::Xlib::CompositeUnredirectSubwindows = &composite_unredirect_subwindows;
+	X11::Xlib::DamageCreate = &damage_create;
+	X11::Xlib::DamageDestroy = &damage_destroy;
+	X11::Xlib::DamageSubtract = &damage_subtract;
+	X11::Xlib::CreatePixmap = &create_pixmap;
+	X11::Xlib::FreePixmap = &free_pixmap;
+	X11::Xlib::CopyArea = &copy_area;
+	X11::Xlib::SelectInput = &select_input;
+	X11::Xlib::ShapeSelectInput = &shape_select_input;
+	X11::Xlib::GrabServer = &grab_server;
+	X11::Xlib::UngrabServer = &ungrab_server;
+}
+
+
+
+
+FakeServer::~FakeServer()
+{
+	X11::Xlib::reset();
+	g_server = nullptr;
+}
+
+
+
+
+XCreateWindowEvent FakeServer::create(int x, int y, unsigned int width, unsigned int height, bool input_only)
+{
+	::Window window = allocate_id();
+
+	Drawable created = { x, y, width, height, (input_only ? 0 : l_depth), false, input_only, false };
+	m_drawables.emplace(window, created);
+
+	XCreateWindowEvent event;
+	std::memset(&event, 0, sizeof(event));
+
+	event.type = CreateNotify;
+	event.serial = ++m_serial;
+	event.display = m_display;
+	event.parent = m_root;
+	event.window = window;
+	event.x = x;
+	event.y = y;
+	event.width = static_cast<int>(width);
+	event.height = static_cast<int>(height);
+
+	return event;
+}
+
+
+XConfigureEvent FakeServer::configure(::Window window, int x, int y, unsigned int width, unsigned int height, ::Window above)
+{
+	Drawable& configured = drawable(window);
+	configured.x = x;
+	configured.y = y;
+	configured.width = width;
+	configured.height = height;
+
+	XConfigureEvent event;
+	std::memset(&event, 0, sizeof(event));
+
+	event.type = ConfigureNotify;
+	event.serial = ++m_serial;
+	event.display = m_display;
+	event.event = m_root;
+	event.window = window;
+	event.x = x;
+	event.y = y;
+	event.width = static_cast<int>(width);
+	event.height = static_cast<int>(height);
+	event.above = above;
+
+	return event;
+}
+
+
+XMapEvent FakeServer::map(::Window window)
+{
+	drawable(window).mapped = true;
+
+	XMapEvent event;
+	std::memset(&event, 0, sizeof(event));
+
+	event.type = MapNotify;
+	event.serial = ++m_serial;
+	event.display = m_display;
+	event.event = m_root;
+	event.window = window;
+
+	return event;
+}
+
+
+XUnmapEvent FakeServer::unmap(::Window window)
+{
+	drawable(window).mapped = false;
+
+	XUnmapEvent event;
+	std::memset(&event, 0, sizeof(event));
+
+	event.type = UnmapNotify;
+	event.serial = ++m_serial;
+	event.display = m_display;
+	event.event = m_root;
+	event.window = window;
+
+	return event;
+}
+
+
+XDestroyWindowEvent FakeServer::destroy(::Window window)
+{
+	assert(window != m_root);
+
+	m_drawables.erase(window);
+
+	XDestroyWindowEvent event;
+	std::memset(&event, 0, sizeof(event));
+
+	event.type = DestroyNotify;
+	event.serial = ++m_serial;
+	event.display = m_display;
+	event.event = m_root;
+	event.window = window;
+
+	return event;
+}
+
+
+
+
+FakeServer::Drawable const* FakeServer::find(::Drawable drawable) const
+{
+	auto found = m_drawables.find(drawable);
+
+	return (found != m_drawables.end() ? &found->second : nullptr);
+}
+
+
+::XID FakeServer::allocate_id()
+{
+	return ++m_next_id;
+}
+
+
+::Pixmap FakeServer::add_pixmap(unsigned int width, unsigned int height, unsigned int depth)
+{
+	::Pixmap pixmap = allocate_id();
+
+	Drawable created = { 0, 0, width, height, depth, true, false, false };
+	m_drawables.emplace(pixmap, created);
+
+	++m_pixmaps;
+
+	return pixmap;
+}
+
+
+void FakeServer::remove_pixmap(::Pixmap pixmap)
+{
+	auto found = m_drawables.find(pixmap);
+
+	if (found != m_drawables.end() && found->second.pixmap) {
+		m_drawables.erase(found);
+		--m_pixmaps;
+	}
+}
+
+
+::Atom FakeServer::atom(char const* name)
+{
+	auto inserted = m_atoms.emplace(name, static_cast<::Atom>(m_atoms.size() + 1000));
+
+	return inserted.first->second;
+}
+
+
+
+
+FakeServer::Drawable& FakeServer::drawable(::Window window)
+{
+	auto found = m_drawables.find(window);
+
+	assert(found != m_drawables.end() && !found->second.pixmap);
+
+	return found->second;
+}
@@ -0,0 +1,125 @@
+#ifndef ORTLE_BENCHMARK_FAKE_SERVER_HPP
+#define ORTLE_BENCHMARK_FAKE_SERVER_HPP
+
+
+#include <X11/Xlib.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+
+
+
+// an X server in the same process, as far as window management can tell.
+// while it lives, it answers the calls in X11::Xlib made on its display,
+// which is a token that must never reach Xlib itself: windows and pixmaps
+// are entries in a table, and every request is answered at once.  windows
+// are created, moved and so on by calling it, which returns the event the
+// server would have sent, for the caller to hand to the window manager.
+//
+// nothing is drawn and nothing is shaped.  there can only be one at a time.
+
+class FakeServer {
+
+public:
+
+	FakeServer(unsigned int width, unsigned int height);
+
+	FakeServer(FakeServer&&) = delete;
+	FakeServer& operator=(FakeServer&&) = delete;
+
+	~FakeServer();
+
+
+public:
+
+	::Display* display() const
+	{
+		return m_display;
+	}
+
+	::Window root() const
+	{
+		return m_root;
+	}
+
+
+	// these change the table and return the event that tells of it
+
+	XCreateWindowEvent create(int x, int y, unsigned int width, unsigned int height, bool input_only = false);
+	XConfigureEvent configure(::Window window, int x, int y, unsigned int width, unsigned int height, ::Window above);
+	XMapEvent map(::Window window);
+	XUnmapEvent unmap(::Window window);
+	XDestroyWindowEvent destroy(::Window window);
+
+
+	// pixmaps that haven't been freed, to check that they all are
+
+	std::size_t pixmaps() const
+	{
+		return m_pixmaps;
+	}
+
+
+public:
+
+	// for the calls in X11::Xlib
+
+	struct Drawable {
+
+		int x;
+		int y;
+		unsigned int width;
+		unsigned int height;
+		unsigned int depth;
+
+		bool pixmap;
+		bool input_only;
+		bool mapped;
+
+	};
+
+	Drawable const* find(::Drawable drawable) const;
+
+	::XID allocate_id();
+
+	::Pixmap add_pixmap(unsigned int width, unsigned int height, unsigned int depth);
+	void remove_pixmap(::Pixmap pixmap);
+
+	::Atom atom(char const* name);
+
+	Visual* visual()
+	{
+		return &m_visual;
+	}
+
+
+private:
+
+	Drawable& drawable(::Window window);
+
+
+private:
+
+	// only its address is used
+
+	char m_token;
+
+	::Display* m_display;
+	::Window m_root;
+
+	Visual m_visual;
+
+	std::unordered_map<::XID, Drawable> m_drawables;
+	std::unordered_map<std::string, ::Atom> m_atoms;
+
+	::XID m_next_id;
+	unsigned long m_serial;
+
+	std::size_t m_pixmaps;
+
+};
+
+
+#endif
@@ -0,0 +1,213 @@
+//
+// simulates the FrameGovernor against made-up frame costs, without drawing
+// anything, and prints how it responds to each of a few loads: every change
+// of level and the frame it came on.  a frame's cost depends on the level it
+// was drawn at, the way shedding effects makes real frames cheaper, and the
+// governor hears of it a few frames late, the way GPU times are read back.
+//
+// with --check, it prints nothing unless the governor misbehaves: a load
+// over budget at every level must step down one level at a time, at least
+// FrameGovernor::settle_frames apart; a load that the first step brings
+// under budget must stop there; and a load that goes away must step all the
+// way back up.
+//
+// usage: benchmark/frame_governor [--check]
+//
+
+#include "../source/frame_governor.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <initializer_list>
+#include <vector>
+
+
+
+
+namespace {
+
+
+// how many frames late the governor hears what a frame cost
+
+std::size_t const l_latency = 4;
+
+int const l_level_count = FrameGovernor::SlowBackground + 1;
+
+
+char const* const l_level_names[l_level_count] = {
+	"full",
+	"no shadows",
+	"fast animations",
+	"no animations",
+	"slow background"
+};
+
+
+// a frame's cost at each level, as a fraction of the budget, until a frame
+// (0 for never), after which every level costs the same
+
+struct Load {
+
+	char const* name;
+
+	double cost[l_level_count];
+
+	unsigned long until;
+	double then;
+
+	unsigned long frames;
+
+};
+
+
+Load const l_over = { "over budget at every level", { 2.0, 2.0, 2.0, 2.0, 2.0 }, 0, 0.0, 400 };
+Load const l_shadows = { "shadows cost too much", { 1.3, 0.8, 0.7, 0.6, 0.5 }, 0, 0.0, 600 };
+Load const l_animations = { "animations cost too much", { 1.6, 1.4, 1.2, 0.8, 0.7 }, 0, 0.0, 600 };
+Load const l_passing = { "over budget for a while", { 2.0, 2.0, 2.0, 2.0, 2.0 }, 200, 0.3, 2000 };
+
+
+struct Step {
+
+	unsigned long frame;
+	FrameGovernor::Level level;
+
+};
+
+
+struct Run {
+
+	std::vector<Step> steps;
+	FrameGovernor::Level level;
+
+};
+
+
+Run run(Load const& load)
+{
+	FrameGovernor governor;
+
+	// the levels the last few frames were drawn at, oldest first
+
+	std::deque<FrameGovernor::Level> drawn(l_latency, FrameGovernor::Full);
+
+	Run result;
+
+	for (unsigned long frame = 0; frame < load.frames; ++frame) {
+
+		drawn.push_back(governor.level());
+
+		FrameGovernor::Level level = drawn.front();
+		drawn.pop_front();
+
+		double fraction = (load.until != 0 && frame >= load.until ? load.then : load.cost[level]);
+
+		if (governor.observe(fraction * governor.budget())) {
+			Step step = { frame, governor.level() };
+			result.steps.push_back(step);
+		}
+	}
+
+	result.level = governor.level();
+	return result;
+}
+
+
+void report(Load const& load, Run const& result)
+{
+	std::printf("%s:\n", load.name);
+
+	FrameGovernor::Level previous = FrameGovernor::Full;
+
+	for (auto const& step : result.steps) {
+		std::printf("  frame %5lu  %s -> %s\n", step.frame, l_level_names[previous], l_level_names[step.level]);
+		previous = step.level;
+	}
+
+	std::printf("  after %lu frames: %s\n", load.frames, l_level_names[result.level]);
+}
+
+
+bool check()
+{
+	bool passed = true;
+
+
+	// one level at a time, and no faster than the settle window allows
+
+	Run over = run(l_over);
+
+	if (over.level != FrameGovernor::SlowBackground) {
+		std::printf("over budget at every level: ended at %s, not %s\n", l_level_names[over.level], l_level_names[FrameGovernor::SlowBackground]);
+		passed = false;
+	}
+
+	for (std::size_t i = 0; i < over.steps.size(); ++i) {
+
+		if (over.steps[i].level != static_cast<FrameGovernor::Level>(i + 1)) {
+			std::printf("over budget at every level: step %zu went to %s\n", i + 1, l_level_names[over.steps[i].level]);
+			passed = false;
+		}
+
+		if (i > 0 && over.steps[i].frame - over.steps[i - 1].frame <= FrameGovernor::settle_frames) {
+			std::printf("over budget at every level: steps %zu and %zu only %lu frames apart\n", i, i + 1, over.steps[i].frame - over.steps[i - 1].frame);
+			passed = false;
+		}
+	}
+
+
+	// loads that shedding deals with stop where it does
+
+	Run shadows = run(l_shadows);
+
+	if (shadows.steps.size() != 1 || shadows.level != FrameGovernor::NoShadows) {
+		std::printf("shadows cost too much: %zu steps, ended at %s\n", shadows.steps.size(), l_level_names[shadows.level]);
+		passed = false;
+	}
+
+	Run animations = run(l_animations);
+
+	if (animations.steps.size() != 3 || animations.level != FrameGovernor::NoAnimations) {
+		std::printf("animations cost too much: %zu steps, ended at %s\n", animations.steps.size(), l_level_names[animations.level]);
+		passed = false;
+	}
+
+
+	// and once the load is gone, everything comes back
+
+	Run passing = run(l_passing);
+
+	if (passing.level != FrameGovernor::Full) {
+		std::printf("over budget for a while: ended at %s\n", l_level_names[passing.level]);
+		passed = false;
+	}
+
+	return passed;
+}
+
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	bool checking = (argc == 2 && std::strcmp(argv[1], "--check") == 0);
+
+	if (argc > 2 || (argc == 2 && !checking)) {
+		std::fprintf(stderr, "usage: %s [--check]\n", argv[0]);
+		return 1;
+	}
+
+	if (checking) {
+		return check() ? 0 : 1;
+	}
+
+	for (Load const* load : { &l_over, &l_shadows, &l_animations, &l_passing }) {
+		report(*load, run(*load));
+	}
+
+	return 0;
+}
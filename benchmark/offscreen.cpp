@@ -0,0 +1,109 @@
+#include "offscreen.hpp"
+
+#include "../source/exceptions.hpp"
+#include "../source/framebuffer_cache.hpp"
+
+#include "../source/glx/context.hpp"
+#include "../source/glx/functions.hpp"
+
+#include "../source/opengl/core330.hpp"
+#include "../source/opengl/debug.hpp"
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+#include <cassert>
+
+
+
+
+namespace {
+
+
+int const l_framebuffer_attributes[] = {
+
+	GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT | GLX_PBUFFER_BIT,
+	GLX_RENDER_TYPE,   GLX_RGBA_BIT,
+	GLX_X_RENDERABLE,  True,
+
+	GLX_RED_SIZE,      8,
+	GLX_GREEN_SIZE,    8,
+	GLX_BLUE_SIZE,     8,
+	GLX_ALPHA_SIZE,    8,
+
+	None
+
+};
+
+
+int const l_context_attributes[] = {
+
+	GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+	GLX_CONTEXT_MINOR_VERSION_ARB, 3,
+	GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+	GLX_RENDER_TYPE,               GLX_RGBA_TYPE,
+
+	None
+
+};
+
+
+} // namespace
+
+
+
+
+Offscreen::Offscreen(Display* display, int screen, FramebufferCache& framebuffers, int width, int height)
+	: m_display(display)
+	, m_framebuffer(nullptr)
+	, m_context()
+	, m_pbuffer(None)
+{
+	assert(display != nullptr);
+	assert(width > 0 && height > 0);
+
+	GLX::load_functions();
+
+	m_framebuffer = framebuffers.choose(screen, l_framebuffer_attributes);
+
+	m_context = GLX::Context(display, m_framebuffer, l_context_attributes);
+
+	int const pbuffer_attributes[] = {
+		GLX_PBUFFER_WIDTH,  width,
+		GLX_PBUFFER_HEIGHT, height,
+		None
+	};
+
+	m_pbuffer = glXCreatePbuffer(display, m_framebuffer, pbuffer_attributes);
+
+	if (m_pbuffer == None || !glXMakeContextCurrent(display, m_pbuffer, m_pbuffer, m_context)) {
+		throw InitializationError("Could not make a pbuffer current.");
+	}
+
+	if (!gl::sys::LoadFunctions()) {
+		throw InitializationError("Could not load OpenGL functions.");
+	}
+
+	OpenGL::enable_debug_output();
+}
+
+
+
+
+Offscreen::~Offscreen()
+{
+	glXMakeContextCurrent(m_display, None, None, nullptr);
+
+	if (m_pbuffer != None) {
+		glXDestroyPbuffer(m_display, m_pbuffer);
+	}
+}
+
+
+
+
+GLX::Context Offscreen::create_shared_context() const
+{
+	return GLX::Context(m_display, m_framebuffer, m_context, l_context_attributes);
+}
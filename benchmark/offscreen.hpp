@@ -0,0 +1,52 @@
+#ifndef ORTLE_BENCHMARK_OFFSCREEN_HPP
+#define ORTLE_BENCHMARK_OFFSCREEN_HPP
+
+
+#include "../source/framebuffer_cache.hpp"
+
+#include "../source/glx/context.hpp"
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+
+
+
+// a pbuffer of the given size, with a context like the presenter's current
+// on it for as long as this lives, for drawing with the renderer without
+// showing anything.  the GLX and GL functions are loaded on the way.  throws
+// FramebufferError or InitializationError if any of it can't be had.
+
+class Offscreen {
+
+public:
+
+	Offscreen(Display* display, int screen, FramebufferCache& framebuffers, int width, int height);
+
+	Offscreen(Offscreen&&) = delete;
+	Offscreen& operator=(Offscreen&&) = delete;
+
+	~Offscreen();
+
+
+public:
+
+	// for the texture binder
+
+	GLX::Context create_shared_context() const;
+
+
+private:
+
+	Display* m_display;
+
+	GLXFBConfig m_framebuffer;
+	GLX::Context m_context;
+
+	GLXPbuffer m_pbuffer;
+
+};
+
+
+#endif
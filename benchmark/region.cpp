@@ -0,0 +1,539 @@
+//
+// microbenchmark for X11::Region.  builds random sets of window-sized
+// rectangles and times union, intersection and subtraction, the way a frame
+// would use them: everything is built from scratch and the arena is reset
+// after every round.  if pixman is available (make sets ORTLE_HAVE_PIXMAN),
+// pixman_region32 is timed on the same input for comparison.
+//
+// with --check, it times nothing, and instead compares every operation on
+// random regions in a small grid with the same operation done pixel by
+// pixel, and checks that each result is banded the way it should be.  the
+// kernels checked are the ones this was compiled with (scalar, SSE2, or
+// AVX2 with -mavx2), so it is worth running once for each.
+//
+// usage: benchmark/region [rectangles per region] [rounds]
+//        benchmark/region --check [cases]
+//
+
+#include "../source/x11/region.hpp"
+#include "../source/x11/region_arena.hpp"
+
+#include <X11/Xlib.h>
+
+#ifdef ORTLE_HAVE_PIXMAN
+	#include <pixman.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+struct Result {
+
+	double unite;
+	double intersect;
+	double subtract;
+	unsigned long boxes;
+
+};
+
+
+std::vector<XRectangle> random_rectangles(std::mt19937& random, std::size_t count)
+{
+	std::uniform_int_distribution<int> position(0, 3000);
+	std::uniform_int_distribution<int> size(16, 800);
+
+	std::vector<XRectangle> rectangles(count);
+
+	for (auto& rectangle : rectangles) {
+		rectangle.x = static_cast<short>(position(random));
+		rectangle.y = static_cast<short>(position(random));
+		rectangle.width = static_cast<unsigned short>(size(random));
+		rectangle.height = static_cast<unsigned short>(size(random));
+	}
+
+	return rectangles;
+}
+
+
+double microseconds(Clock::duration duration)
+{
+	return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+
+Result run_ortle(std::vector<XRectangle> const& a, std::vector<XRectangle> const& b, int rounds)
+{
+	Result result = { 0.0, 0.0, 0.0, 0 };
+
+	X11::RegionArena arena;
+
+	for (int round = 0; round < rounds; ++round) {
+
+		arena.reset();
+
+		X11::Region first(arena, a.data(), a.data() + a.size());
+		X11::Region second(arena, b.data(), b.data() + b.size());
+
+		auto start = Clock::now();
+
+		X11::Region united(arena);
+		united.unite(first);
+		united.unite(second);
+
+		auto united_at = Clock::now();
+
+		X11::Region intersected(arena);
+		intersected.unite(first);
+		intersected.intersect(second);
+
+		auto intersected_at = Clock::now();
+
+		X11::Region subtracted(arena);
+		subtracted.unite(first);
+		subtracted.subtract(second);
+
+		auto subtracted_at = Clock::now();
+
+		result.unite += microseconds(united_at - start);
+		result.intersect += microseconds(intersected_at - united_at);
+		result.subtract += microseconds(subtracted_at - intersected_at);
+		result.boxes += united.size() + intersected.size() + subtracted.size();
+	}
+
+	return result;
+}
+
+
+#ifdef ORTLE_HAVE_PIXMAN
+
+void build_pixman(pixman_region32_t* region, std::vector<XRectangle> const& rectangles)
+{
+	std::vector<pixman_box32_t> boxes;
+
+	for (auto const& rectangle : rectangles) {
+		pixman_box32_t box = { rectangle.x, rectangle.y, rectangle.x + rectangle.width, rectangle.y + rectangle.height };
+		boxes.push_back(box);
+	}
+
+	pixman_region32_init_rects(region, boxes.data(), static_cast<int>(boxes.size()));
+}
+
+
+Result run_pixman(std::vector<XRectangle> const& a, std::vector<XRectangle> const& b, int rounds)
+{
+	Result result = { 0.0, 0.0, 0.0, 0 };
+
+	for (int round = 0; round < rounds; ++round) {
+
+		pixman_region32_t first;
+		pixman_region32_t second;
+		pixman_region32_t united;
+		pixman_region32_t intersected;
+		pixman_region32_t subtracted;
+
+		build_pixman(&first, a);
+		build_pixman(&second, b);
+
+		pixman_region32_init(&united);
+		pixman_region32_init(&intersected);
+		pixman_region32_init(&subtracted);
+
+		auto start = Clock::now();
+
+		pixman_region32_union(&united, &first, &second);
+
+		auto united_at = Clock::now();
+
+		pixman_region32_intersect(&intersected, &first, &second);
+
+		auto intersected_at = Clock::now();
+
+		pixman_region32_subtract(&subtracted, &first, &second);
+
+		auto subtracted_at = Clock::now();
+
+		result.unite += microseconds(united_at - start);
+		result.intersect += microseconds(intersected_at - united_at);
+		result.subtract += microseconds(subtracted_at - intersected_at);
+		result.boxes += pixman_region32_n_rects(&united) + pixman_region32_n_rects(&intersected) + pixman_region32_n_rects(&subtracted);
+
+		pixman_region32_fini(&first);
+		pixman_region32_fini(&second);
+		pixman_region32_fini(&united);
+		pixman_region32_fini(&intersected);
+		pixman_region32_fini(&subtracted);
+	}
+
+	return result;
+}
+
+#endif
+
+
+void report(char const* name, Result const& result, int rounds)
+{
+	std::printf(
+		"%-8s  unite %9.3f us  intersect %9.3f us  subtract %9.3f us  (%lu boxes)\n",
+		name,
+		result.unite / rounds,
+		result.intersect / rounds,
+		result.subtract / rounds,
+		result.boxes / rounds
+	);
+}
+
+
+// for --check: regions are drawn in a grid of l_grid pixels square, and
+// translated by up to l_margin, so bitmaps are a margin bigger on each side
+
+int const l_grid = 48;
+int const l_margin = 8;
+int const l_bitmap_size = l_grid + 2 * l_margin;
+
+std::size_t const l_max_rectangles = 8;
+
+// small, so that combining regions goes through several arena blocks
+
+std::size_t const l_arena_capacity = 16;
+
+
+using Bitmap = std::vector<bool>;
+
+
+char const* kernels()
+{
+#if defined(__AVX2__)
+	return "AVX2";
+#elif defined(__SSE2__)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+
+std::vector<XRectangle> grid_rectangles(std::mt19937& random)
+{
+	std::uniform_int_distribution<std::size_t> count(0, l_max_rectangles);
+	std::uniform_int_distribution<int> position(0, l_grid - 1);
+	std::uniform_int_distribution<int> size(1, l_grid / 2);
+
+	std::vector<XRectangle> rectangles(count(random));
+
+	for (auto& rectangle : rectangles) {
+		rectangle.x = static_cast<short>(position(random));
+		rectangle.y = static_cast<short>(position(random));
+		rectangle.width = static_cast<unsigned short>(std::min(size(random), l_grid - rectangle.x));
+		rectangle.height = static_cast<unsigned short>(std::min(size(random), l_grid - rectangle.y));
+	}
+
+	return rectangles;
+}
+
+
+void fill(Bitmap& bitmap, int x1, int y1, int x2, int y2)
+{
+	for (int y = y1; y < y2; ++y) {
+		for (int x = x1; x < x2; ++x) {
+			bitmap[(y + l_margin) * l_bitmap_size + x + l_margin] = true;
+		}
+	}
+}
+
+
+Bitmap rasterize(std::vector<XRectangle> const& rectangles)
+{
+	Bitmap bitmap(l_bitmap_size * l_bitmap_size, false);
+
+	for (auto const& rectangle : rectangles) {
+		fill(bitmap, rectangle.x, rectangle.y, rectangle.x + rectangle.width, rectangle.y + rectangle.height);
+	}
+
+	return bitmap;
+}
+
+
+// false if a box falls outside the bitmap
+
+bool rasterize(X11::Region const& region, Bitmap& bitmap)
+{
+	bitmap.assign(l_bitmap_size * l_bitmap_size, false);
+
+	for (auto const& box : region) {
+
+		if (box.x1 < -l_margin || box.y1 < -l_margin || box.x2 > l_grid + l_margin || box.y2 > l_grid + l_margin) {
+			return false;
+		}
+
+		fill(bitmap, box.x1, box.y1, box.x2, box.y2);
+	}
+
+	return true;
+}
+
+
+bool same_spans(X11::Region::Box const* first, std::size_t first_count, X11::Region::Box const* second, std::size_t second_count)
+{
+	if (first_count != second_count) {
+		return false;
+	}
+
+	for (std::size_t i = 0; i < first_count; ++i) {
+		if (first[i].x1 != second[i].x1 || first[i].x2 != second[i].x2) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// whether the boxes are banded as X11::Region promises, and the extents
+// match them
+
+bool well_formed(X11::Region const& region)
+{
+	X11::Region::Box const* previous = nullptr;
+	std::size_t previous_count = 0;
+
+	X11::Region::Box extents = { INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+
+	for (auto band = region.begin(); band != region.end(); ) {
+
+		auto band_end = band;
+
+		while (band_end != region.end() && band_end->y1 == band->y1 && band_end->y2 == band->y2) {
+			++band_end;
+		}
+
+		for (auto box = band; box != band_end; ++box) {
+
+			if (box->x1 >= box->x2 || box->y1 >= box->y2) {
+				return false;
+			}
+
+			if (box != band && box->x1 <= (box - 1)->x2) {
+				return false;
+			}
+
+			extents.x1 = std::min(extents.x1, box->x1);
+			extents.y1 = std::min(extents.y1, box->y1);
+			extents.x2 = std::max(extents.x2, box->x2);
+			extents.y2 = std::max(extents.y2, box->y2);
+		}
+
+		std::size_t count = static_cast<std::size_t>(band_end - band);
+
+		if (previous != nullptr) {
+
+			if (band->y1 < previous->y2) {
+				return false;
+			}
+
+			if (band->y1 == previous->y2 && same_spans(previous, previous_count, band, count)) {
+				return false;
+			}
+		}
+
+		previous = band;
+		previous_count = count;
+		band = band_end;
+	}
+
+	if (region.empty()) {
+		return true;
+	}
+
+	X11::Region::Box const& actual = region.extents();
+
+	return actual.x1 == extents.x1 && actual.y1 == extents.y1 && actual.x2 == extents.x2 && actual.y2 == extents.y2;
+}
+
+
+bool matches(X11::Region const& region, Bitmap const& expected)
+{
+	Bitmap actual;
+	return well_formed(region) && rasterize(region, actual) && actual == expected;
+}
+
+
+Bitmap combine(Bitmap const& first, Bitmap const& second, X11::Region::Operation operation)
+{
+	Bitmap result(first.size());
+
+	for (std::size_t i = 0; i < result.size(); ++i) {
+		switch (operation) {
+			case X11::Region::Operation::Unite: result[i] = first[i] || second[i]; break;
+			case X11::Region::Operation::Intersect: result[i] = first[i] && second[i]; break;
+			case X11::Region::Operation::Subtract: result[i] = first[i] && !second[i]; break;
+		}
+	}
+
+	return result;
+}
+
+
+Bitmap translate(Bitmap const& bitmap, int dx, int dy)
+{
+	Bitmap result(bitmap.size(), false);
+
+	for (int y = 0; y < l_bitmap_size; ++y) {
+		for (int x = 0; x < l_bitmap_size; ++x) {
+			if (bitmap[y * l_bitmap_size + x]) {
+				result[(y + dy) * l_bitmap_size + x + dx] = true;
+			}
+		}
+	}
+
+	return result;
+}
+
+
+int check(unsigned long cases)
+{
+	std::mt19937 random(1);
+
+	std::uniform_int_distribution<int> offset(-l_margin, l_margin);
+
+	X11::RegionArena arena(l_arena_capacity);
+
+	unsigned long failures = 0;
+
+	auto fail = [&](unsigned long index, char const* operation) {
+		if (++failures <= 10) {
+			std::printf("case %lu: %s does not match\n", index, operation);
+		}
+	};
+
+	for (unsigned long index = 0; index < cases; ++index) {
+
+		arena.reset();
+
+		auto a = grid_rectangles(random);
+		auto b = grid_rectangles(random);
+
+		Bitmap expected_a = rasterize(a);
+		Bitmap expected_b = rasterize(b);
+
+		X11::Region first(arena, a.data(), a.data() + a.size());
+		X11::Region second(arena, b.data(), b.data() + b.size());
+
+		if (!matches(first, expected_a) || !matches(second, expected_b)) {
+			fail(index, "construction");
+			continue;
+		}
+
+		X11::Region united(arena);
+		united.unite(first);
+		united.unite(second);
+
+		if (!matches(united, combine(expected_a, expected_b, X11::Region::Operation::Unite))) {
+			fail(index, "unite");
+		}
+
+		X11::Region intersected(arena);
+		intersected.unite(first);
+		intersected.intersect(second);
+
+		if (!matches(intersected, combine(expected_a, expected_b, X11::Region::Operation::Intersect))) {
+			fail(index, "intersect");
+		}
+
+		X11::Region subtracted(arena);
+		subtracted.unite(first);
+		subtracted.subtract(second);
+
+		if (!matches(subtracted, combine(expected_a, expected_b, X11::Region::Operation::Subtract))) {
+			fail(index, "subtract");
+		}
+
+		int dx = offset(random);
+		int dy = offset(random);
+
+		X11::Region translated(arena);
+		translated.unite(first);
+		translated.translate(dx, dy);
+
+		if (!matches(translated, translate(expected_a, dx, dy))) {
+			fail(index, "translate");
+		}
+
+		if (!b.empty()) {
+
+			XRectangle const& rectangle = b.front();
+
+			X11::Region extended(arena);
+			extended.unite(first);
+			extended.unite(rectangle.x, rectangle.y, rectangle.width, rectangle.height);
+
+			if (!matches(extended, combine(expected_a, rasterize(std::vector<XRectangle>(1, rectangle)), X11::Region::Operation::Unite))) {
+				fail(index, "unite with a rectangle");
+			}
+		}
+	}
+
+	std::printf("%lu cases with %s kernels, %lu failures\n", cases, kernels(), failures);
+
+	return (failures == 0 ? 0 : 1);
+}
+
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+
+		unsigned long cases = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000);
+
+		if (argc > 3 || cases < 1) {
+			std::fprintf(stderr, "usage: %s --check [cases]\n", argv[0]);
+			return 1;
+		}
+
+		return check(cases);
+	}
+
+	std::size_t count = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64);
+	int rounds = (argc > 2 ? std::atoi(argv[2]) : 2000);
+
+	if (count < 1 || rounds < 1) {
+		std::fprintf(stderr, "usage: %s [rectangles per region] [rounds]\n", argv[0]);
+		return 1;
+	}
+
+	std::mt19937 random(1);
+
+	auto a = random_rectangles(random, count);
+	auto b = random_rectangles(random, count);
+
+	std::printf("%zu rectangles per region, %d rounds\n", count, rounds);
+
+	report("ortle", run_ortle(a, b, rounds), rounds);
+
+#ifdef ORTLE_HAVE_PIXMAN
+	report("pixman", run_pixman(a, b, rounds), rounds);
+#else
+	std::printf("pixman    not available\n");
+#endif
+
+	return 0;
+}
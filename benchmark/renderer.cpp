@@ -0,0 +1,423 @@
+//
+// microbenchmark for the renderer's draw path.  draws synthetic scenes into
+// a pbuffer (see Offscreen), one variant at a time: how many windows, how
+// big, shaped or not, with or without alpha, shadows on or off, and whether
+// every window changes every frame (so that everything is drawn directly)
+// or only the top one does (so that the rest come from the layer cache).
+// each window is a pixmap filled with one color.
+//
+// after a warm-up, which waits for every texture to be bound and every
+// window's entry animation to finish, each frame is timed on the GPU with a
+// timer query around prepare() and draw_output(), and on the CPU up to the
+// end of a glFinish.  the output is the mean of each per frame, and the
+// pixels of window content composited per second of GPU time.  it needs an
+// X server with GLX (e.g. Xvfb, with LIBGL_ALWAYS_SOFTWARE=1).
+//
+// usage: benchmark/renderer [frames per variant]
+//
+
+#include "offscreen.hpp"
+
+#include "../source/framebuffer_cache.hpp"
+#include "../source/renderer.hpp"
+#include "../source/scene.hpp"
+#include "../source/texture_binder.hpp"
+
+#include "../source/opengl/core330.hpp"
+#include "../source/opengl/query.hpp"
+
+#include "../source/x11/display.hpp"
+#include "../source/x11/pixmap.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+int const l_width = 1920;
+int const l_height = 1080;
+
+// frames drawn after every texture is bound, before timing starts, so that
+// entry animations are over
+
+int const l_warm_up_frames = 60;
+
+// the corners cut from shaped windows
+
+int const l_corner = 12;
+
+
+struct Variant {
+
+	int count;
+	int width;
+	int height;
+
+	bool shaped;
+	bool rgba;
+	bool shadows;
+
+	// every window changes every frame, or only the top one
+
+	bool all_changing;
+
+};
+
+
+Variant const l_variants[] = {
+
+	//  count  width  height  shaped  rgba   shadows  all changing
+
+	{   20,    800,   600,    false,  false, true,    true  },
+	{   20,    800,   600,    false,  false, false,   true  },
+	{   20,    800,   600,    false,  true,  true,    true  },
+	{   20,    800,   600,    true,   false, true,    true  },
+	{   20,    800,   600,    false,  false, true,    false },
+	{    1,   1920,  1080,    false,  false, true,    true  },
+	{   10,   1600,   900,    false,  false, true,    true  },
+	{  100,    256,   256,    false,  false, true,    true  },
+	{  500,    128,   128,    false,  false, true,    true  },
+	{  500,    128,   128,    false,  false, false,   true  },
+
+};
+
+
+std::string describe(Variant const& variant)
+{
+	return std::to_string(variant.count) + " x " + std::to_string(variant.width) + "x" + std::to_string(variant.height)
+		+ (variant.shaped ? " shaped" : "")
+		+ (variant.rgba ? " rgba" : " rgb")
+		+ (variant.shadows ? "" : " no-shadows")
+		+ (variant.all_changing ? "" : " top-changing");
+}
+
+
+void add_vertex(std::vector<GLfloat>& vertices, int x, int y)
+{
+	GLfloat const vertex[] = {
+		static_cast<GLfloat>(x), static_cast<GLfloat>(y), 0.0f, 1.0f,
+		static_cast<GLfloat>(x), static_cast<GLfloat>(y)
+	};
+
+	vertices.insert(vertices.end(), vertex, vertex + Scene::shape_vertex_size);
+}
+
+
+void add_rectangle(std::vector<GLfloat>& vertices, int x, int y, int width, int height)
+{
+	add_vertex(vertices, x, y);
+	add_vertex(vertices, x + width, y);
+	add_vertex(vertices, x + width, y + height);
+
+	add_vertex(vertices, x, y);
+	add_vertex(vertices, x + width, y + height);
+	add_vertex(vertices, x, y + height);
+}
+
+
+// a window with its corners cut off, as three bands
+
+std::vector<GLfloat> shape_vertices(int width, int height)
+{
+	std::vector<GLfloat> vertices;
+
+	add_rectangle(vertices, l_corner, 0, width - 2 * l_corner, l_corner);
+	add_rectangle(vertices, 0, l_corner, width, height - 2 * l_corner);
+	add_rectangle(vertices, l_corner, height - l_corner, width - 2 * l_corner, l_corner);
+
+	return vertices;
+}
+
+
+struct Result {
+
+	double gpu_nanoseconds;
+	double cpu_nanoseconds;
+	double pixels;
+
+};
+
+
+class Bench {
+
+public:
+
+	Bench(Display* display, int screen, FramebufferCache& framebuffers, Offscreen& offscreen, Variant const& variant);
+
+	Bench(Bench&&) = delete;
+	Bench& operator=(Bench&&) = delete;
+
+
+public:
+
+	void warm_up();
+	Result run(int frames);
+
+
+private:
+
+	void describe_scene();
+	void draw();
+
+
+private:
+
+	Variant m_variant;
+
+	// declared first, so that the renderer lets go of them first
+
+	std::vector<X11::Pixmap> m_pixmaps;
+	VisualID m_visual_id;
+	int m_depth;
+
+	TextureBinder m_binder;
+	Renderer m_renderer;
+
+	Scene m_scene;
+	std::vector<GLfloat> m_shape;
+
+	Scene::Output m_output;
+
+	unsigned long m_frame;
+
+};
+
+
+Bench::Bench(Display* display, int screen, FramebufferCache& framebuffers, Offscreen& offscreen, Variant const& variant)
+	: m_variant(variant)
+	, m_pixmaps()
+	, m_visual_id(0)
+	, m_depth(variant.rgba ? 32 : 24)
+	, m_binder(display, offscreen.create_shared_context())
+	, m_renderer(display, screen, framebuffers, m_binder)
+	, m_scene()
+	, m_shape(variant.shaped ? shape_vertices(variant.width, variant.height) : std::vector<GLfloat>())
+	, m_output()
+	, m_frame(0)
+{
+	XVisualInfo info;
+
+	if (!XMatchVisualInfo(display, screen, m_depth, TrueColor, &info)) {
+		throw std::runtime_error("no TrueColor visual of depth " + std::to_string(m_depth));
+	}
+
+	m_visual_id = info.visualid;
+
+	Window root = XRootWindow(display, screen);
+
+	for (int i = 0; i < variant.count; ++i) {
+
+		m_pixmaps.push_back(X11::Pixmap(display, root, variant.width, variant.height, m_depth));
+
+		GC gc = XCreateGC(display, m_pixmaps.back(), 0, nullptr);
+		XSetForeground(display, gc, ((static_cast<unsigned long>(i) * 0x9e3779b1ul) & 0xffffff) | (variant.rgba ? 0xc0000000ul : 0));
+		XFillRectangle(display, m_pixmaps.back(), gc, 0, 0, variant.width, variant.height);
+		XFreeGC(display, gc);
+	}
+
+	// the binder works on its own thread, over the same connection
+
+	XSync(display, False);
+
+	m_output.x = 0;
+	m_output.y = 0;
+	m_output.width = l_width;
+	m_output.height = l_height;
+
+	m_renderer.set_output_count(1);
+	m_renderer.set_shadows(variant.shadows);
+
+	gl::ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+
+void Bench::describe_scene()
+{
+	// windows are spread over the screen bottom to top, the same way every
+	// time
+
+	m_scene.clear();
+	m_scene.resize(l_width, l_height);
+	m_scene.set_serial(m_frame);
+
+	int columns = (l_width > m_variant.width ? l_width - m_variant.width : 1);
+	int rows = (l_height > m_variant.height ? l_height - m_variant.height : 1);
+
+	for (int i = 0; i < m_variant.count; ++i) {
+
+		bool top = (i == m_variant.count - 1);
+
+		Scene::Window window = Scene::Window();
+
+		window.id = m_pixmaps[i];
+		window.pixmap = m_pixmaps[i];
+		window.visual_id = m_visual_id;
+		window.depth = m_depth;
+		window.x = (i * 97) % columns;
+		window.y = (i * 53) % rows;
+		window.width = m_variant.width;
+		window.height = m_variant.height;
+		window.shaped = m_variant.shaped;
+		window.changes = (m_variant.all_changing || top ? m_frame : 1);
+		window.shape_changes = 1;
+
+		if (m_variant.shaped) {
+			m_scene.add(window, m_shape);
+		}
+		else {
+			m_scene.add(window);
+		}
+	}
+
+	m_scene.add_output(m_output);
+}
+
+
+void Bench::draw()
+{
+	m_renderer.prepare(m_scene);
+
+	if (m_renderer.damaged(0, m_output)) {
+		m_renderer.draw_output(0, m_output);
+	}
+
+	m_renderer.advance_animations();
+}
+
+
+void Bench::warm_up()
+{
+	++m_frame;
+	describe_scene();
+
+	// until the binder has bound every texture
+
+	while (m_renderer.settled() < m_frame) {
+		draw();
+		gl::Finish();
+	}
+
+	for (int i = 0; i < l_warm_up_frames; ++i) {
+		++m_frame;
+		describe_scene();
+		draw();
+		gl::Finish();
+	}
+}
+
+
+Result Bench::run(int frames)
+{
+	OpenGL::Query query;
+
+	double gpu = 0.0;
+	double cpu = 0.0;
+
+	for (int i = 0; i < frames; ++i) {
+
+		++m_frame;
+		describe_scene();
+
+		auto start = Clock::now();
+
+		gl::BeginQuery(gl::TIME_ELAPSED, query);
+		draw();
+		gl::EndQuery(gl::TIME_ELAPSED);
+
+		gl::Finish();
+
+		cpu += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+		GLuint64 elapsed = 0;
+		gl::GetQueryObjectui64v(query, gl::QUERY_RESULT, &elapsed);
+
+		gpu += static_cast<double>(elapsed);
+	}
+
+	double pixels = static_cast<double>(m_variant.count) * m_variant.width * m_variant.height;
+
+	Result result = { gpu / frames, cpu / frames, pixels };
+	return result;
+}
+
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	int frames = (argc > 1 ? std::atoi(argv[1]) : 300);
+
+	if (argc > 2 || frames < 1) {
+		std::fprintf(stderr, "usage: %s [frames per variant]\n", argv[0]);
+		return 1;
+	}
+
+	// the texture binder uses the connection from a thread of its own
+
+	if (!XInitThreads()) {
+		std::fprintf(stderr, "could not initialize Xlib threads\n");
+		return 1;
+	}
+
+	try {
+
+		X11::Display display(nullptr);
+
+		int screen = XDefaultScreen(display);
+
+		FramebufferCache framebuffers(display);
+
+		Offscreen offscreen(display, screen, framebuffers, l_width, l_height);
+
+		std::printf("%d frames of %dx%d per variant\n", frames, l_width, l_height);
+		std::printf("%-44s %14s %14s %14s\n", "variant", "gpu ns/frame", "cpu ns/frame", "Mpixels/s");
+
+		for (auto const& variant : l_variants) {
+
+			std::string name = describe(variant);
+
+			try {
+
+				Bench bench(display, screen, framebuffers, offscreen, variant);
+
+				bench.warm_up();
+
+				Result result = bench.run(frames);
+
+				double rate = (result.gpu_nanoseconds > 0.0 ? result.pixels / result.gpu_nanoseconds * 1e3 : 0.0);
+
+				std::printf("%-44s %14.0f %14.0f %14.1f\n", name.c_str(), result.gpu_nanoseconds, result.cpu_nanoseconds, rate);
+			}
+
+			catch (std::runtime_error& e) {
+				std::printf("%-44s skipped: %s\n", name.c_str(), e.what());
+			}
+		}
+
+		return 0;
+	}
+
+	catch (std::exception& e) {
+		std::fprintf(stderr, "renderer benchmark failed: %s\n", e.what());
+	}
+
+	return 1;
+}
@@ -0,0 +1,309 @@
+//
+// replays a recording made with ORTLE_RECORD (see EventRecorder) through the
+// window manager and the renderer, drawing into a pbuffer the size of the
+// recorded screen instead of on the screen itself.  window management sees
+// exactly what it saw when it was recorded, so runs can be compared with each
+// other.  window contents are stand-ins: every window is a pixmap of the
+// right size and depth, filled with one color.
+//
+// by default the recording is replayed as fast as it can be, which measures
+// the cost of everything but waiting.  with --real-time each flush waits for
+// its recorded time, which shows what happened frame by frame.  it needs an
+// X server with GLX (e.g. Xvfb, with LIBGL_ALWAYS_SOFTWARE=1), whose screen
+// doesn't need to match the one recorded.
+//
+// usage: benchmark/replay <recording> [--real-time]
+//
+
+#include "offscreen.hpp"
+
+#include "../source/event_player.hpp"
+#include "../source/event_recording.hpp"
+#include "../source/framebuffer_cache.hpp"
+#include "../source/pixmap_ledger.hpp"
+#include "../source/renderer.hpp"
+#include "../source/scene.hpp"
+#include "../source/scene_exchange.hpp"
+#include "../source/texture_binder.hpp"
+#include "../source/window_manager.hpp"
+
+#include "../source/opengl/core330.hpp"
+
+#include "../source/x11/display.hpp"
+#include "../source/x11/error_handler.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+
+// stand-in windows go away whenever the recorded ones did, and requests
+// about them can race with that just as they do for real.  count the errors
+// rather than stop.
+
+unsigned long g_x_errors = 0;
+
+int count_x_error(Display*, XErrorEvent*)
+{
+	++g_x_errors;
+	return 0;
+}
+
+
+struct Counts {
+
+	unsigned long events;
+	unsigned long flushes;
+	unsigned long scenes;
+	unsigned long frames;
+
+};
+
+
+void dispatch(XEvent& event, EventRecording::Header const& header, WindowManager& window_manager, PixmapLedger& pixmaps)
+{
+	// the same as Compositor::process_pending_events, less RandR and the
+	// screen saver: the replay has one output, and is never blanked
+
+	switch (event.type) {
+
+		case CirculateNotify:
+			window_manager.on_circulate_notify(event.xcirculate);
+			break;
+
+		case ConfigureNotify:
+			window_manager.on_configure_notify(event.xconfigure);
+			break;
+
+		case CreateNotify:
+			window_manager.on_create_notify(event.xcreatewindow, pixmaps);
+			break;
+
+		case DestroyNotify:
+			window_manager.on_destroy_notify(event.xdestroywindow);
+			break;
+
+		case GraphicsExpose:
+			window_manager.on_graphics_expose(event.xgraphicsexpose);
+			break;
+
+		case MapNotify:
+			window_manager.on_map_notify(event.xmap);
+			break;
+
+		case NoExpose:
+			window_manager.on_no_expose(event.xnoexpose);
+			break;
+
+		case PropertyNotify:
+			if (event.xproperty.window == header.root) {
+				window_manager.on_property_notify(event.xproperty);
+			}
+			break;
+
+		case ReparentNotify:
+			window_manager.on_reparent_notify(event.xreparent, pixmaps);
+			break;
+
+		case UnmapNotify:
+			window_manager.on_unmap_notify(event.xunmap);
+			break;
+
+		default:
+
+			if (event.type == ShapeNotify + header.shape_event_base) {
+				window_manager.on_shape_notify(reinterpret_cast<XShapeEvent&>(event));
+			}
+
+			else if (event.type == XDamageNotify + header.damage_event_base) {
+				window_manager.on_damage_notify(reinterpret_cast<XDamageNotifyEvent&>(event));
+			}
+	}
+}
+
+
+double percentile(std::vector<double>& values, double fraction)
+{
+	if (values.empty()) {
+		return 0.0;
+	}
+
+	std::size_t index = static_cast<std::size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+
+	return values[index];
+}
+
+
+int replay(char const* path, bool real_time)
+{
+	// the window manager's connection stands in for the event thread's, and
+	// the renderer's for the render thread's, as they do in Ortle
+
+	X11::Display event_display(nullptr);
+	X11::Display render_display(nullptr);
+
+	X11::ErrorHandler error_handler(&count_x_error);
+
+	int screen = XDefaultScreen(render_display);
+
+	EventPlayer player(path, event_display, screen);
+
+	EventRecording::Header const& header = player.header();
+
+	int width = static_cast<int>(header.width);
+	int height = static_cast<int>(header.height);
+
+
+	// a pbuffer the size of the recorded screen stands in for the outputs
+
+	FramebufferCache framebuffers(render_display);
+
+	Offscreen offscreen(render_display, screen, framebuffers, width, height);
+
+
+	Counts counts = Counts();
+	std::vector<double> frame_times;
+
+	{
+		TextureBinder binder(render_display, offscreen.create_shared_context());
+
+		Renderer renderer(render_display, screen, framebuffers, binder);
+		renderer.set_output_count(1);
+
+		PixmapLedger pixmaps;
+		SceneExchange scenes;
+
+		WindowManager window_manager(event_display, screen, header.root, pixmaps);
+
+		Scene::Output output = { 0, 0, width, height };
+
+		gl::ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+
+		auto origin = Clock::now();
+
+		EventPlayer::Record record;
+
+		while (player.next(record)) {
+
+			if (record.kind == EventRecording::Event) {
+				++counts.events;
+				dispatch(record.event, header, window_manager, pixmaps);
+				continue;
+			}
+
+			++counts.flushes;
+
+			if (real_time) {
+				std::this_thread::sleep_until(origin + record.time);
+			}
+
+
+			// what Compositor::publish_scene does, then a frame
+
+			auto now = origin + std::chrono::duration_cast<Clock::duration>(record.time);
+
+			window_manager.flush_damage(now);
+			window_manager.settle_resizes(now);
+
+			if (window_manager.changed()) {
+
+				Scene& scene = scenes.back();
+
+				window_manager.describe(scene);
+				window_manager.clear_changed();
+
+				scene.add_output(output);
+				scene.set_fence(None);
+
+				if (pixmaps.take_added()) {
+					XSync(event_display, False);
+				}
+
+				pixmaps.published(scenes.publish());
+
+				++counts.scenes;
+			}
+
+			auto frame_start = Clock::now();
+
+			scenes.acquire();
+			renderer.prepare(scenes.front());
+
+			if (renderer.damaged(0, output)) {
+
+				renderer.draw_output(0, output);
+				gl::Finish();
+
+				frame_times.push_back(Milliseconds(Clock::now() - frame_start).count());
+				++counts.frames;
+			}
+
+			renderer.advance_animations();
+
+			scenes.acknowledge(renderer.settled());
+			pixmaps.collect(scenes.acknowledged());
+		}
+
+		double total = Milliseconds(Clock::now() - origin).count();
+
+		std::printf("%lu events, %lu flushes, %lu scenes, %lu frames in %.1f ms\n", counts.events, counts.flushes, counts.scenes, counts.frames, total);
+		std::printf("frame time (ms)  p50 %.3f  p95 %.3f  p99 %.3f\n", percentile(frame_times, 0.50), percentile(frame_times, 0.95), percentile(frame_times, 0.99));
+		std::printf("%lu X errors from stand-in windows\n", g_x_errors);
+	}
+
+	return 0;
+}
+
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	bool real_time = (argc > 2 && std::strcmp(argv[2], "--real-time") == 0);
+
+	if (argc < 2 || argc > 3 || (argc == 3 && !real_time)) {
+		std::fprintf(stderr, "usage: %s <recording> [--real-time]\n", argv[0]);
+		return 1;
+	}
+
+	// the texture binder uses the render connection from a thread of its own
+
+	if (!XInitThreads()) {
+		std::fprintf(stderr, "could not initialize Xlib threads\n");
+		return 1;
+	}
+
+	try {
+		return replay(argv[1], real_time);
+	}
+
+	catch (std::exception& e) {
+		std::fprintf(stderr, "replay failed: %s\n", e.what());
+	}
+
+	return 1;
+}
@@ -0,0 +1,328 @@
+//
+// microbenchmark for WindowManager's event handling.  the window manager
+// runs against FakeServer, which answers its X calls in the same process, so
+// what is timed is the stack code and the managed windows, with no server
+// round trips.  each benchmark is run with 10, 100, 1000 and 10000 windows
+// on the stack, to show how its cost scales:
+//
+//   create     - CreateNotify for each of that many windows, from empty
+//   configure  - ConfigureNotify moving a window and restacking it above
+//                another, picked at random
+//   map        - UnmapNotify and MapNotify of a window picked at random
+//   destroy    - DestroyNotify for each window, in random order, until empty
+//
+// each is repeated until it has been timed for at least the given number of
+// milliseconds, and the time per event is the mean.  setting up and tearing
+// down the stack isn't timed.
+//
+// usage: benchmark/window_manager [milliseconds per benchmark]
+//
+
+#include "fake_server.hpp"
+
+#include "../source/pixmap_ledger.hpp"
+#include "../source/window_manager.hpp"
+
+#include <X11/Xlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+std::size_t const l_window_counts[] = { 10, 100, 1000, 10000 };
+
+// events per round for the benchmarks that don't change the window count
+
+std::size_t const l_events_per_round = 1000;
+
+
+struct Measurement {
+
+	Clock::duration time;
+	unsigned long events;
+
+};
+
+
+// a window manager on a fake server, with some windows
+
+class Fixture {
+
+public:
+
+	Fixture()
+		: m_server(3840, 2160)
+		, m_pixmaps()
+		, m_window_manager(m_server.display(), 0, m_server.root(), m_pixmaps)
+		, m_windows()
+		, m_random(1)
+		, m_serial(0)
+	{}
+
+
+	XCreateWindowEvent create()
+	{
+		std::uniform_int_distribution<int> position(0, 3000);
+		std::uniform_int_distribution<unsigned int> size(64, 1200);
+
+		XCreateWindowEvent event = m_server.create(position(m_random), position(m_random), size(m_random), size(m_random));
+		m_windows.push_back(event.window);
+
+		return event;
+	}
+
+
+	void populate(std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i) {
+			m_window_manager.on_create_notify(create(), m_pixmaps);
+			m_window_manager.on_map_notify(m_server.map(m_windows.back()));
+		}
+
+		collect();
+	}
+
+
+	Window pick()
+	{
+		std::uniform_int_distribution<std::size_t> index(0, m_windows.size() - 1);
+		return m_windows[index(m_random)];
+	}
+
+
+	// frees the pixmaps the windows have given up, as if the render thread
+	// had moved on
+
+	void collect()
+	{
+		m_window_manager.clear_changed();
+		m_pixmaps.published(++m_serial);
+		m_pixmaps.collect(m_serial);
+	}
+
+
+	FakeServer& server()
+	{
+		return m_server;
+	}
+
+	PixmapLedger& pixmaps()
+	{
+		return m_pixmaps;
+	}
+
+	WindowManager& window_manager()
+	{
+		return m_window_manager;
+	}
+
+	std::vector<Window>& windows()
+	{
+		return m_windows;
+	}
+
+	std::mt19937& random()
+	{
+		return m_random;
+	}
+
+
+private:
+
+	// the server goes last, since the others give their pixmaps back to it
+
+	FakeServer m_server;
+	PixmapLedger m_pixmaps;
+	WindowManager m_window_manager;
+
+	std::vector<Window> m_windows;
+
+	std::mt19937 m_random;
+	unsigned long m_serial;
+
+};
+
+
+
+
+Measurement create(std::size_t count)
+{
+	Fixture fixture;
+
+	std::vector<XCreateWindowEvent> events;
+
+	for (std::size_t i = 0; i < count; ++i) {
+		events.push_back(fixture.create());
+	}
+
+	auto start = Clock::now();
+
+	for (auto const& event : events) {
+		fixture.window_manager().on_create_notify(event, fixture.pixmaps());
+	}
+
+	Measurement measurement = { Clock::now() - start, count };
+	return measurement;
+}
+
+
+Measurement configure(std::size_t count)
+{
+	Fixture fixture;
+	fixture.populate(count);
+
+	std::uniform_int_distribution<int> nudge(-8, 8);
+
+	// the events are made up front, so that only handling them is timed.  a
+	// window is sometimes put at the bottom (above None), and never above
+	// itself.
+
+	std::vector<XConfigureEvent> events;
+
+	for (std::size_t i = 0; i < l_events_per_round; ++i) {
+
+		Window window = fixture.pick();
+		Window above = fixture.pick();
+
+		if (above == window) {
+			above = None;
+		}
+
+		FakeServer::Drawable const* drawable = fixture.server().find(window);
+
+		events.push_back(fixture.server().configure(window, drawable->x + nudge(fixture.random()), drawable->y + nudge(fixture.random()), drawable->width, drawable->height, above));
+	}
+
+	auto start = Clock::now();
+
+	for (auto const& event : events) {
+		fixture.window_manager().on_configure_notify(event);
+	}
+
+	Measurement measurement = { Clock::now() - start, l_events_per_round };
+	return measurement;
+}
+
+
+Measurement map(std::size_t count)
+{
+	Fixture fixture;
+	fixture.populate(count);
+
+	// each window is unmapped in the fake server as the event is made, and
+	// mapped again by the next one, so the server agrees with the events by
+	// the time they are handled
+
+	std::vector<XUnmapEvent> unmaps;
+	std::vector<XMapEvent> maps;
+
+	for (std::size_t i = 0; i < l_events_per_round / 2; ++i) {
+		Window window = fixture.pick();
+		unmaps.push_back(fixture.server().unmap(window));
+		maps.push_back(fixture.server().map(window));
+	}
+
+	auto start = Clock::now();
+
+	for (std::size_t i = 0; i < maps.size(); ++i) {
+		fixture.window_manager().on_unmap_notify(unmaps[i]);
+		fixture.window_manager().on_map_notify(maps[i]);
+	}
+
+	Measurement measurement = { Clock::now() - start, 2 * maps.size() };
+	return measurement;
+}
+
+
+Measurement destroy(std::size_t count)
+{
+	Fixture fixture;
+	fixture.populate(count);
+
+	std::vector<Window> windows = fixture.windows();
+	std::shuffle(windows.begin(), windows.end(), fixture.random());
+
+	std::vector<XDestroyWindowEvent> events;
+
+	for (Window window : windows) {
+		events.push_back(fixture.server().destroy(window));
+	}
+
+	auto start = Clock::now();
+
+	for (auto const& event : events) {
+		fixture.window_manager().on_destroy_notify(event);
+	}
+
+	Measurement measurement = { Clock::now() - start, count };
+
+	fixture.collect();
+
+	return measurement;
+}
+
+
+
+
+void run(char const* name, Measurement (*benchmark)(std::size_t), std::chrono::milliseconds minimum)
+{
+	for (std::size_t count : l_window_counts) {
+
+		Clock::duration time = Clock::duration::zero();
+		unsigned long events = 0;
+		unsigned long rounds = 0;
+
+		while (time < minimum) {
+			Measurement measurement = benchmark(count);
+			time += measurement.time;
+			events += measurement.events;
+			++rounds;
+		}
+
+		double nanoseconds = std::chrono::duration<double, std::nano>(time).count() / static_cast<double>(events);
+
+		std::string label = std::string(name) + "/" + std::to_string(count);
+
+		std::printf("%-20s %12.1f ns %14.0f %10lu\n", label.c_str(), nanoseconds, 1e9 / nanoseconds, rounds);
+	}
+}
+
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	long milliseconds = (argc > 1 ? std::strtol(argv[1], nullptr, 10) : 200);
+
+	if (argc > 2 || milliseconds < 1) {
+		std::fprintf(stderr, "usage: %s [milliseconds per benchmark]\n", argv[0]);
+		return 1;
+	}
+
+	std::chrono::milliseconds minimum(milliseconds);
+
+	std::printf("%-20s %15s %14s %10s\n", "benchmark", "time/event", "events/s", "rounds");
+
+	run("create", &create, minimum);
+	run("configure", &configure, minimum);
+	run("map", &map, minimum);
+	run("destroy", &destroy, minimum);
+
+	return 0;
+}
@@ -0,0 +1,332 @@
+//
+// scripted X client for the end-to-end benchmark (see benchmark/bench.sh).
+// it plays one scenario against whatever compositor is running on $DISPLAY,
+// waiting for the server after every step so that it never gets ahead of
+// it, and prints how many steps it managed as JSON.
+//
+//   windows    maps a grid of windows, then destroys them, over and over
+//   tiling     keeps the windows mapped and lays them out again every step,
+//              as a tiling window manager switching layouts would
+//   resize     resizes one large window above the others every step, as a
+//              drag would
+//   popups     maps and destroys a small override-redirect window every
+//              step, as menus and tooltips do
+//   shaped     gives every window a new shape every step
+//   wallpaper  sets a new wallpaper pixmap every step
+//
+// usage: benchmark/workload <scenario> [windows] [seconds]
+//
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+struct Workload {
+
+	Display* display;
+	Window root;
+	int width;
+	int height;
+
+	std::vector<Window> windows;
+
+	// the size of each window, as last laid out
+	int cell_width;
+	int cell_height;
+
+};
+
+
+unsigned long color(int index)
+{
+	// a spread of colors, so that every window's contents differ
+
+	return ((index * 0x3f5a7bUL) & 0xffffffUL) | 0x404040UL;
+}
+
+
+Window create_window(Workload& workload, int x, int y, int width, int height, int index, bool override_redirect = false)
+{
+	XSetWindowAttributes attributes;
+	attributes.background_pixel = color(index);
+	attributes.override_redirect = (override_redirect ? True : False);
+
+	return XCreateWindow(
+		workload.display,
+		workload.root,
+		x, y,
+		static_cast<unsigned int>(width), static_cast<unsigned int>(height),
+		0,
+		CopyFromParent,
+		InputOutput,
+		CopyFromParent,
+		CWBackPixel | CWOverrideRedirect,
+		&attributes
+	);
+}
+
+
+// lays count windows out in the given number of columns, filling the
+// screen
+
+void tile(Workload& workload, int columns, bool create)
+{
+	int count = static_cast<int>(workload.windows.size());
+	int rows = (count + columns - 1) / columns;
+
+	int width = workload.width / columns;
+	int height = workload.height / (rows > 0 ? rows : 1);
+
+	workload.cell_width = width;
+	workload.cell_height = height;
+
+	for (int i = 0; i < count; ++i) {
+
+		int x = (i % columns) * width;
+		int y = (i / columns) * height;
+
+		if (create) {
+			workload.windows[static_cast<std::size_t>(i)] = create_window(workload, x, y, width, height, i);
+		}
+		else {
+			XMoveResizeWindow(workload.display, workload.windows[static_cast<std::size_t>(i)], x, y, static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+		}
+	}
+}
+
+
+int columns_for(std::size_t count)
+{
+	return static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+}
+
+
+void map_all(Workload& workload)
+{
+	tile(workload, columns_for(workload.windows.size()), true);
+
+	for (Window window : workload.windows) {
+		XMapWindow(workload.display, window);
+	}
+}
+
+
+void destroy_all(Workload& workload)
+{
+	for (Window window : workload.windows) {
+		XDestroyWindow(workload.display, window);
+	}
+}
+
+
+
+
+void step_windows(Workload& workload, unsigned long step)
+{
+	if (step % 2 == 0) {
+		map_all(workload);
+	}
+	else {
+		destroy_all(workload);
+	}
+}
+
+
+void step_tiling(Workload& workload, unsigned long step)
+{
+	// cycles between one column and as many as there are windows
+
+	int columns = static_cast<int>(step % workload.windows.size()) + 1;
+
+	tile(workload, columns, false);
+}
+
+
+void step_resize(Workload& workload, unsigned long step)
+{
+	// the last window is the one being dragged, its corner going round in a
+	// circle
+
+	double angle = static_cast<double>(step) * 0.05;
+
+	int width = workload.width / 2 + static_cast<int>(std::cos(angle) * workload.width / 4);
+	int height = workload.height / 2 + static_cast<int>(std::sin(angle) * workload.height / 4);
+
+	XResizeWindow(workload.display, workload.windows.back(), static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+}
+
+
+void step_popups(Workload& workload, unsigned long step)
+{
+	int x = static_cast<int>((step * 97) % static_cast<unsigned long>(workload.width - 200));
+	int y = static_cast<int>((step * 61) % static_cast<unsigned long>(workload.height - 300));
+
+	Window popup = create_window(workload, x, y, 200, 300, static_cast<int>(step), true);
+
+	XMapRaised(workload.display, popup);
+	XSync(workload.display, False);
+
+	XDestroyWindow(workload.display, popup);
+}
+
+
+void step_shaped(Workload& workload, unsigned long step)
+{
+	// a plus sign whose arms grow and shrink
+
+	int width = workload.cell_width;
+	int height = workload.cell_height;
+
+	for (std::size_t i = 0; i < workload.windows.size(); ++i) {
+
+		int thickness = 1 + static_cast<int>((step + i) % 16) * std::min(width, height) / 32;
+
+		XRectangle arms[2] = {
+			{ 0, static_cast<short>(height / 2 - thickness), static_cast<unsigned short>(width), static_cast<unsigned short>(thickness * 2) },
+			{ static_cast<short>(width / 2 - thickness), 0, static_cast<unsigned short>(thickness * 2), static_cast<unsigned short>(height) }
+		};
+
+		XShapeCombineRectangles(workload.display, workload.windows[i], ShapeBounding, 0, 0, arms, 2, ShapeSet, Unsorted);
+	}
+}
+
+
+void step_wallpaper(Workload& workload, unsigned long step)
+{
+	// the previous pixmap is freed once the new one is set, as wallpaper
+	// setters do
+
+	static Atom xrootpmap_id = XInternAtom(workload.display, "_XROOTPMAP_ID", False);
+	static Pixmap previous = None;
+
+	int depth = DefaultDepth(workload.display, DefaultScreen(workload.display));
+
+	Pixmap pixmap = XCreatePixmap(workload.display, workload.root, static_cast<unsigned int>(workload.width), static_cast<unsigned int>(workload.height), static_cast<unsigned int>(depth));
+
+	GC gc = XCreateGC(workload.display, pixmap, 0, nullptr);
+	XSetForeground(workload.display, gc, color(static_cast<int>(step)));
+	XFillRectangle(workload.display, pixmap, gc, 0, 0, static_cast<unsigned int>(workload.width), static_cast<unsigned int>(workload.height));
+	XFreeGC(workload.display, gc);
+
+	XChangeProperty(workload.display, workload.root, xrootpmap_id, XA_PIXMAP, 32, PropModeReplace, reinterpret_cast<unsigned char*>(&pixmap), 1);
+
+	if (previous != None) {
+		XFreePixmap(workload.display, previous);
+	}
+
+	previous = pixmap;
+}
+
+
+struct Scenario {
+
+	char const* name;
+	void (*step)(Workload&, unsigned long);
+
+	// whether the windows are mapped before the first step.  the wallpaper
+	// would be hidden behind them.
+	bool mapped;
+
+};
+
+
+Scenario const l_scenarios[] = {
+	{ "windows", step_windows, false },
+	{ "tiling", step_tiling, true },
+	{ "resize", step_resize, true },
+	{ "popups", step_popups, true },
+	{ "shaped", step_shaped, true },
+	{ "wallpaper", step_wallpaper, false }
+};
+
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s <scenario> [windows] [seconds]\n", argv[0]);
+		return 1;
+	}
+
+	Scenario const* scenario = nullptr;
+
+	for (auto const& candidate : l_scenarios) {
+		if (std::strcmp(candidate.name, argv[1]) == 0) {
+			scenario = &candidate;
+		}
+	}
+
+	if (scenario == nullptr) {
+		std::fprintf(stderr, "unknown scenario: %s\n", argv[1]);
+		return 1;
+	}
+
+	std::size_t count = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16);
+	double seconds = (argc > 3 ? std::atof(argv[3]) : 10.0);
+
+	if (count == 0) {
+		count = 1;
+	}
+
+	Display* display = XOpenDisplay(nullptr);
+
+	if (display == nullptr) {
+		std::fprintf(stderr, "could not open display\n");
+		return 1;
+	}
+
+	int screen = DefaultScreen(display);
+
+	Workload workload = {
+		display,
+		RootWindow(display, screen),
+		DisplayWidth(display, screen),
+		DisplayHeight(display, screen),
+		std::vector<Window>(count),
+		0,
+		0
+	};
+
+	if (scenario->mapped) {
+		map_all(workload);
+		XSync(display, False);
+	}
+
+	auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	unsigned long steps = 0;
+
+	while (Clock::now() < end) {
+		scenario->step(workload, steps);
+		XSync(display, False);
+		++steps;
+	}
+
+	// everything created goes with the connection
+
+	XCloseDisplay(display);
+
+	std::printf("{ \"steps\": %lu, \"seconds\": %.3f }\n", steps, seconds);
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+#include "blanking_monitor.hpp"
+
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
+
+#include "x11/round_trip.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/dpms.h>
+#include <X11/extensions/scrnsaver.h>
+
+#include <cassert>
+
+#include <chrono>
+#include <utility>
+
+
+
+
+namespace {
+
+
+// how long it may take to notice that the monitors have been powered down
+// or back up.  each poll is a round trip.
+
+std::chrono::milliseconds const l_dpms_poll_interval(1000);
+
+
+} // namespace
+
+
+
+
+BlankingMonitor::BlankingMonitor()
+	: m_display(nullptr)
+	, m_screen_saver_event_type(-1)
+	, m_screen_saver_on(false)
+	, m_dpms(false)
+	, m_powered_down(false)
+	, m_dpms_polled()
+{}
+
+
+BlankingMonitor::BlankingMonitor(Display* display, Window root)
+	: BlankingMonitor()
+{
+	assert(display != nullptr);
+	assert(root != None);
+
+	m_display = display;
+
+
+	int event_base = 0;
+	int error_base = 0;
+
+	if (XScreenSaverQueryExtension(display, &event_base, &error_base)) {
+
+		m_screen_saver_event_type = event_base + ScreenSaverNotify;
+
+		XScreenSaverSelectInput(display, root, ScreenSaverNotifyMask);
+
+		XScreenSaverInfo* info = XScreenSaverAllocInfo();
+
+		if (info != nullptr) {
+			if (XScreenSaverQueryInfo(display, root, info)) {
+				m_screen_saver_on = (info->state == ScreenSaverOn);
+			}
+			XFree(info);
+		}
+	}
+	else {
+		LOG_DEBUG(Render, "no MIT-SCREEN-SAVER extension, the screen saver will be drawn over");
+	}
+
+
+	if (DPMSQueryExtension(display, &event_base, &error_base) && DPMSCapable(display)) {
+		m_dpms = true;
+		query_dpms();
+	}
+	else {
+		LOG_DEBUG(Render, "no DPMS, rendering will go on while the monitors are off");
+	}
+}
+
+
+
+
+BlankingMonitor::BlankingMonitor(BlankingMonitor&& other)
+	: BlankingMonitor()
+{
+	swap(*this, other);
+}
+
+
+BlankingMonitor& BlankingMonitor::operator=(BlankingMonitor&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+BlankingMonitor::~BlankingMonitor()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(BlankingMonitor& first, BlankingMonitor& second)
+{
+	using std::swap;
+
+	swap(first.m_display, second.m_display);
+	swap(first.m_screen_saver_event_type, second.m_screen_saver_event_type);
+	swap(first.m_screen_saver_on, second.m_screen_saver_on);
+	swap(first.m_dpms, second.m_dpms);
+	swap(first.m_powered_down, second.m_powered_down);
+	swap(first.m_dpms_polled, second.m_dpms_polled);
+}
+
+
+
+
+void BlankingMonitor::on_screen_saver_notify(XScreenSaverNotifyEvent const& event)
+{
+	// ScreenSaverCycle means it is still on, and moving on to the next image
+
+	m_screen_saver_on = (event.state != ScreenSaverOff);
+
+	LOG_DEBUG(Render, "screen saver", m_screen_saver_on ? "on" : "off");
+}
+
+
+void BlankingMonitor::poll()
+{
+	if (m_dpms && std::chrono::steady_clock::now() - m_dpms_polled >= l_dpms_poll_interval) {
+		query_dpms();
+	}
+}
+
+
+
+
+void BlankingMonitor::query_dpms()
+{
+	m_dpms_polled = std::chrono::steady_clock::now();
+
+	CARD16 power_level = DPMSModeOn;
+	BOOL enabled = False;
+
+	Status found = 0;
+
+	{
+		X11::RoundTrip round_trip(Utility::Metrics::DpmsGetInfo);
+		found = DPMSInfo(m_display, &power_level, &enabled);
+	}
+
+	if (found) {
+
+		bool powered_down = (enabled && power_level != DPMSModeOn);
+
+		if (powered_down != m_powered_down) {
+			LOG_DEBUG(Render, "monitors powered", powered_down ? "down" : "up");
+			m_powered_down = powered_down;
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef ORTLE_BLANKING_MONITOR_HPP
+#define ORTLE_BLANKING_MONITOR_HPP
+
+
+#include <X11/Xlib.h>
+#include <X11/extensions/scrnsaver.h>
+
+#include <chrono>
+
+
+
+
+// tells the event thread whether the screen is blanked, either because the
+// monitors have been powered down (DPMS) or because the screen saver is on
+// (MIT-SCREEN-SAVER).  the screen saver sends events; DPMS doesn't, so its
+// state is polled every so often instead.  servers without either extension
+// are simply never blanked.
+
+class BlankingMonitor {
+
+public:
+
+	BlankingMonitor();
+	BlankingMonitor(Display* display, Window root);
+
+	BlankingMonitor(BlankingMonitor&& other);
+	BlankingMonitor& operator=(BlankingMonitor&& other);
+
+	~BlankingMonitor();
+
+	friend void swap(BlankingMonitor& first, BlankingMonitor& second);
+
+
+public:
+
+	bool blanked() const
+	{
+		return m_screen_saver_on || m_powered_down;
+	}
+
+
+	// the type of the screen saver's notify events, or -1 if the server has
+	// no screen saver extension
+
+	int screen_saver_event_type() const
+	{
+		return m_screen_saver_event_type;
+	}
+
+	void on_screen_saver_notify(XScreenSaverNotifyEvent const& event);
+
+
+	// asks the server for the DPMS power level, unless it was asked recently
+
+	void poll();
+
+
+private:
+
+	void query_dpms();
+
+
+private:
+
+	Display* m_display;
+
+	int m_screen_saver_event_type;
+	bool m_screen_saver_on;
+
+	bool m_dpms;
+	bool m_powered_down;
+	std::chrono::steady_clock::time_point m_dpms_polled;
+
+};
+
+
+#endif
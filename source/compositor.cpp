@@ -0,0 +1,854 @@
+#include "compositor.hpp"
+
+#include "blanking_monitor.hpp"
+#include "event_recorder.hpp"
+#include "fence_ring.hpp"
+#include "frame_governor.hpp"
+#include "framebuffer_cache.hpp"
+#include "output_layout.hpp"
+#include "pixmap_ledger.hpp"
+#include "presenter.hpp"
+#include "renderer.hpp"
+#include "scene.hpp"
+#include "scene_exchange.hpp"
+#include "texture_binder.hpp"
+#include "window_manager.hpp"
+
+#include "glx/functions.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/debug.hpp"
+#include "opengl/exceptions.hpp"
+
+#include "utility/flight_recorder.hpp"
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
+
+#include "x11/composite_manager_atom.hpp"
+#include "x11/composite_overlay.hpp"
+#include "x11/display.hpp"
+#include "x11/extension.hpp"
+#include "x11/round_trip.hpp"
+#include "x11/window.hpp"
+
+#include <poll.h>
+#include <signal.h>
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xcomposite.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/scrnsaver.h>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+
+
+namespace {
+
+
+// how long the event thread sleeps without events before it checks whether
+// it should stop, and collects pixmaps the render thread has let go of.
+
+int const l_event_timeout = 100;
+
+
+// how long the render thread sleeps between checks while the screen is
+// blanked
+
+std::chrono::milliseconds const l_blanked_sleep(100);
+
+
+// a frame over budget asks for the flight recorder to be dumped, but no more
+// often than this, and not in the first moments after starting (whose frames
+// compile shaders and bind every window for the first time).
+
+std::chrono::seconds const l_dump_interval(30);
+
+
+// a batch of events whose blocking X requests took longer than this in all
+// says which call site was the worst.  a quarter of a frame at 60 Hz.  they
+// are logged no more often than the interval, so that a storm of them
+// doesn't flood the log.
+
+std::chrono::milliseconds const l_round_trip_budget(4);
+std::chrono::seconds const l_round_trip_log_interval(1);
+
+
+// pending_shape_notify
+// predicate used with XCheckIfEvent to compress shape events for a window, so
+// that only the most recent event is processed.
+
+Bool pending_shape_notify(Display*, XEvent* event, XPointer arg)
+{
+	XShapeEvent* shape_event = reinterpret_cast<XShapeEvent*>(arg);
+	if (event->type == shape_event->type && reinterpret_cast<XShapeEvent*>(event)->window == shape_event->window) {
+		return True;
+	}
+	return False;
+}
+
+
+// an input-only window, never mapped, to own the composite manager selection
+
+X11::Window create_selection_window(Display* display, Window parent)
+{
+	XSetWindowAttributes attributes;
+	attributes.override_redirect = True;
+
+	return X11::Window(display, parent, -1, -1, 1, 1, 0, CopyFromParent, InputOnly, CopyFromParent, CWOverrideRedirect, attributes);
+}
+
+
+} // namespace
+
+
+
+
+Compositor::Compositor(Display* render_display, int screen, FramebufferCache& framebuffers, std::atomic<bool>& running, std::string const& recording)
+
+	: m_running(&running)
+
+	, m_display(DisplayString(render_display))
+	, m_render_display(render_display)
+	, m_screen(screen)
+	, m_root(XRootWindow(m_display, m_screen))
+
+	, m_composite(m_display, "XComposite", 0, 4, &XCompositeQueryExtension, &XCompositeQueryVersion)
+	, m_damage(m_display, "XDamage", 1, 1, &XDamageQueryExtension, &XDamageQueryVersion)
+	, m_fixes(m_display, "XFixes", 2, 0, &XFixesQueryExtension, &XFixesQueryVersion)
+	, m_shape(m_display, "XShape", 1, 1, &XShapeQueryExtension, &XShapeQueryVersion)
+	, m_glx(m_display, "GLX", 1, 4, &glXQueryExtension, &glXQueryVersion)
+
+	, m_framebuffers(&framebuffers)
+
+	, m_composite_overlay(m_display, m_root)
+
+	, m_presenter(m_render_display, m_screen, m_root, m_composite_overlay, framebuffers)
+
+	, m_selection_window(create_selection_window(m_display, m_composite_overlay))
+
+	, m_composite_manager_atom(m_display, m_screen, m_selection_window)
+
+	, m_binder(m_render_display, m_presenter.create_shared_context())
+
+	, m_renderer(m_render_display, m_screen, framebuffers, m_binder)
+
+	, m_governor()
+
+	, m_pixmaps()
+
+	, m_fences(m_display, m_root, m_renderer.waits_for_x_fences())
+
+	, m_recorder(recording, m_display, m_screen, m_root, m_shape.event_base, m_damage.event_base)
+
+	, m_window_manager(m_display, m_screen, m_root, m_pixmaps)
+
+	, m_output_layout(m_display, m_root)
+
+	, m_scenes()
+
+	, m_blanking(m_display, m_root)
+	, m_blanked(m_blanking.blanked())
+
+	, m_render_error()
+
+	, m_metrics(nullptr)
+	, m_poll_descriptors()
+	, m_slow_batches(0)
+	, m_slowest_batch()
+	, m_slow_batches_logged()
+
+{
+	LOG_DEBUG(Events, "compositing screen", screen);
+
+
+#ifdef DEBUG_SYNCHRONIZE
+
+	XSynchronize(m_display, True);
+
+#endif
+
+}
+
+
+Compositor::~Compositor()
+{
+	// the renderer's resources are destroyed on whichever thread destroys
+	// the compositor, so the context has to be current there.
+
+	m_presenter.make_context_current();
+}
+
+
+
+
+void Compositor::run(Utility::Metrics::Server* metrics)
+{
+	m_metrics = metrics;
+
+
+	// hand the context over to the render thread.  signals are blocked
+	// while it starts, so that it inherits a mask that leaves them all to
+	// the main thread (whose poll() they interrupt).
+
+	m_presenter.release_context();
+
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGHUP);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGUSR1);
+	sigaddset(&signals, SIGUSR2);
+
+	sigset_t previous;
+
+	pthread_sigmask(SIG_BLOCK, &signals, &previous);
+	std::thread render_thread(&Compositor::render_frames, this);
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+	try {
+		handle_events();
+	}
+	catch (...) {
+		*m_running = false;
+		render_thread.join();
+		throw;
+	}
+
+	render_thread.join();
+
+	if (m_render_error) {
+		std::rethrow_exception(m_render_error);
+	}
+}
+
+
+
+
+void Compositor::handle_events()
+{
+	Utility::FlightRecorder::name_thread("events " + std::to_string(m_screen));
+
+	while (*m_running) {
+
+		{
+			Utility::Span span("process events");
+			process_pending_events();
+		}
+
+		update_blanking();
+
+		{
+			Utility::Span span("publish scene");
+			auto now = std::chrono::steady_clock::now();
+			m_recorder.record_flush(now);
+			m_window_manager.flush_damage(now);
+			m_window_manager.settle_resizes(now);
+			publish_scene();
+		}
+
+		report_round_trips();
+
+		m_pixmaps.collect(m_scenes.acknowledged());
+
+		// dumps are written here rather than where they are asked for, which
+		// may be a signal handler or the render thread in the middle of a
+		// frame.
+
+		Utility::FlightRecorder::dump_if_requested();
+
+		if (m_metrics != nullptr) {
+			m_metrics->serve();
+		}
+
+		wait_for_events();
+	}
+}
+
+
+void Compositor::render_frames()
+{
+	try {
+
+		Utility::FlightRecorder::name_thread("render " + std::to_string(m_screen));
+
+		unsigned int last_retrace = 0;
+
+		auto last_dump = std::chrono::steady_clock::now();
+
+		m_presenter.make_context_current();
+
+		m_renderer.set_output_count(m_presenter.size());
+
+		gl::ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+		bool suspended = false;
+
+		// the outputs drawn in each frame, to be presented once it is
+
+		std::vector<std::size_t> drawn;
+
+		std::string gl_error;
+
+		while (*m_running) {
+
+			// every OpenGL error is fatal.  debug builds hear of them from the
+			// driver as they happen, rather than asking every frame (which can
+			// make the driver synchronize).  release builds don't check.
+
+			if (OpenGL::take_debug_error(gl_error)) {
+				throw OpenGL::StateError(gl_error);
+			}
+
+
+			// take the newest scene.  if none has been published since the last
+			// frame, the previous one is prepared again, which moves any
+			// animations along.
+
+			m_scenes.acquire();
+
+			Scene const& scene = m_scenes.front();
+
+			if (m_presenter.update(scene)) {
+				m_renderer.set_output_count(m_presenter.size());
+			}
+
+
+			// nobody can see what we draw while the screen is blanked, so don't
+			// clear, draw or swap, nor build the layer or take snapshots.  the
+			// renderer still follows each scene's windows and bindings, and
+			// acknowledges it, so that the pixmaps they stop using are freed.
+			// the first frame after it wakes redraws everything.
+
+			if (m_blanked.load(std::memory_order_acquire)) {
+
+				if (!suspended) {
+					LOG_DEBUG(Render, "screen blanked, suspending rendering");
+					suspended = true;
+				}
+
+				m_renderer.follow(scene);
+				m_scenes.acknowledge(m_renderer.settled());
+
+				std::this_thread::sleep_for(l_blanked_sleep);
+				continue;
+			}
+
+			if (suspended) {
+				LOG_DEBUG(Render, "screen woke up, resuming rendering");
+				suspended = false;
+				m_renderer.invalidate();
+			}
+
+			auto frame_start = std::chrono::steady_clock::now();
+
+			m_governor.begin_frame();
+
+			{
+				Utility::Span span("prepare", scene.serial());
+				m_renderer.prepare(scene);
+			}
+
+
+			// then draw the outputs that have shown their last frame, if
+			// anything on them has changed since.  the rest keep what they
+			// have until their own retrace comes round.
+
+			bool paced = m_presenter.ready(m_presenter.pacing());
+
+			drawn.clear();
+
+			for (std::size_t i = 0; i < m_presenter.size(); ++i) {
+
+				if (!m_presenter.ready(i) || !m_renderer.damaged(i, m_presenter.output(i))) {
+					continue;
+				}
+
+				Utility::Span span("draw output", i);
+				m_presenter.begin(i);
+				m_renderer.draw_output(i, m_presenter.output(i));
+
+				drawn.push_back(i);
+			}
+
+			if (paced) {
+				m_renderer.advance_animations();
+			}
+
+
+			// the governor leaves out the swaps: without OML_sync_control a
+			// swap blocks until the retrace, which would look like a frame
+			// that took the whole refresh period to draw.
+
+			if (m_governor.end_frame()) {
+				m_governor.apply(m_renderer);
+			}
+
+			for (std::size_t i : drawn) {
+
+				// current again, so that the swap flushes what was drawn on it
+
+				Utility::Span span("swap", i);
+				auto started = std::chrono::steady_clock::now();
+				m_presenter.begin(i);
+				m_presenter.present(i);
+				m_renderer.add_swap_time(std::chrono::steady_clock::now() - started);
+			}
+
+			if (!drawn.empty()) {
+				Utility::Metrics::observe_frame(std::chrono::steady_clock::now() - frame_start);
+			}
+
+			if (m_governor.over_budget()) {
+
+				auto now = std::chrono::steady_clock::now();
+
+				if (now - last_dump >= l_dump_interval) {
+					Utility::FlightRecorder::request_dump("frame over budget");
+					last_dump = now;
+				}
+			}
+
+			m_scenes.acknowledge(m_renderer.settled());
+
+
+			unsigned int current_retrace = 0;
+			bool retraced = false;
+
+			{
+				Utility::Span span("wait for vblank");
+				retraced = m_presenter.wait(current_retrace);
+			}
+
+			if (retraced) {
+
+				m_governor.retraced(current_retrace);
+
+				// with several outputs, most wake-ups are for the others
+
+				if (m_presenter.size() == 1) {
+					if (current_retrace == last_retrace) {
+						LOG_DEBUG(Render, "woke up on the same retrace", last_retrace, current_retrace);
+						Utility::Metrics::add(Utility::Metrics::DuplicateRetraces);
+					}
+					else if (current_retrace > last_retrace + 1) {
+						LOG_DEBUG(Render, "missed a retrace", last_retrace, current_retrace);
+						Utility::Metrics::add(Utility::Metrics::DroppedRetraces, current_retrace - last_retrace - 1);
+					}
+				}
+
+				last_retrace = current_retrace;
+			}
+		}
+	}
+
+	catch (...) {
+		m_render_error = std::current_exception();
+		*m_running = false;
+	}
+
+	m_presenter.release_context();
+}
+
+
+
+
+void Compositor::wait_for_events()
+{
+	// XPending also flushes our requests, so everything done while handling
+	// the last batch of events has been sent by the time we go to sleep.
+
+	if (XPending(m_display) > 0) {
+		return;
+	}
+
+	pollfd descriptor;
+	descriptor.fd = XConnectionNumber(m_display);
+	descriptor.events = POLLIN;
+	descriptor.revents = 0;
+
+	m_poll_descriptors.clear();
+	m_poll_descriptors.push_back(descriptor);
+
+	// metrics clients wake us, too
+
+	if (m_metrics != nullptr) {
+		m_metrics->add_descriptors(m_poll_descriptors);
+	}
+
+	// wake up in time to hand over damage held back for background windows,
+	// and to name the pixmaps of windows that have stopped resizing
+
+	int timeout = l_event_timeout;
+
+	for (int deadline : { m_window_manager.damage_timeout(), m_window_manager.resize_timeout() }) {
+		if (deadline >= 0 && deadline < timeout) {
+			timeout = deadline;
+		}
+	}
+
+	poll(m_poll_descriptors.data(), m_poll_descriptors.size(), timeout);
+}
+
+
+void Compositor::report_round_trips()
+{
+	X11::RoundTrips round_trips = X11::take_round_trips();
+
+	if (round_trips.time > l_round_trip_budget) {
+
+		if (m_slow_batches == 0 || round_trips.time > m_slowest_batch.time) {
+			m_slowest_batch = round_trips;
+		}
+
+		++m_slow_batches;
+	}
+
+	if (m_slow_batches == 0) {
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+
+	if (now - m_slow_batches_logged < l_round_trip_log_interval) {
+		return;
+	}
+
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	LOG_INFO(Events, "blocking X requests held up scenes", m_slow_batches,
+		m_slowest_batch.count, Milliseconds(m_slowest_batch.time).count(),
+		Utility::Metrics::round_trip_name(m_slowest_batch.worst_site), m_slowest_batch.worst_count, Milliseconds(m_slowest_batch.worst_time).count());
+
+	m_slow_batches = 0;
+	m_slow_batches_logged = now;
+}
+
+
+void Compositor::update_blanking()
+{
+	m_blanking.poll();
+	m_blanked.store(m_blanking.blanked(), std::memory_order_release);
+}
+
+
+void Compositor::publish_scene()
+{
+	if (!m_window_manager.changed() && !m_output_layout.changed()) {
+		return;
+	}
+
+	Scene& scene = m_scenes.back();
+
+	m_window_manager.describe(scene);
+	m_window_manager.clear_changed();
+
+	m_output_layout.describe(scene);
+	m_output_layout.clear_changed();
+
+	Utility::Metrics::set(Utility::Metrics::ManagedWindows, m_screen, static_cast<long long>(m_window_manager.size()));
+	Utility::Metrics::set(Utility::Metrics::VisibleWindows, m_screen, static_cast<long long>(scene.windows().size()));
+
+
+	// every damage event in this batch means the server has been asked to
+	// draw into a pixmap.  the fence is triggered once all of that is done,
+	// and the render thread waits for it before drawing the scene.
+
+	scene.set_fence(m_fences.trigger(m_scenes.acknowledged()));
+
+
+	// the render thread binds pixmaps over its own connection, whose requests
+	// the server may well handle before the ones on ours.  if any of the
+	// pixmaps in this scene are new, make sure the server has them first.
+	// otherwise just make sure the fence gets to it.
+
+	if (m_pixmaps.take_added()) {
+		X11::RoundTrip round_trip(Utility::Metrics::SyncPixmaps);
+		XSync(m_display, False);
+	}
+	else if (scene.fence() != None) {
+		XFlush(m_display);
+	}
+
+	unsigned long serial = m_scenes.publish();
+
+	m_pixmaps.published(serial);
+	m_fences.published(serial);
+}
+
+
+
+
+void Compositor::process_pending_events()
+{
+	while (*m_running && XPending(m_display) > 0) {
+
+		XEvent event;
+		XNextEvent(m_display, &event);
+
+		// only the last of a run of ShapeNotify events for a window is
+		// handled, and recorded
+
+		if (event.type == ShapeNotify + m_shape.event_base) {
+			while (XCheckIfEvent(m_display, &event, &pending_shape_notify, reinterpret_cast<XPointer>(&event)) == True) {
+				LOG_DEBUG(Events, "pending ShapeNotify event found, ignoring this one.");
+			}
+		}
+
+		m_recorder.record_event(event);
+
+		switch (event.type) {
+
+			case CirculateNotify:
+				Utility::Metrics::count_event(Utility::Metrics::CirculateEvent);
+				on_circulate_notify(event.xcirculate);
+				break;
+
+			case ClientMessage:
+				Utility::Metrics::count_event(Utility::Metrics::ClientMessageEvent);
+				LOG_DEBUG(Events, "client message", event.xclient.window, event.xclient.message_type, event.xclient.format);
+				break;
+
+			case ConfigureNotify:
+				Utility::Metrics::count_event(Utility::Metrics::ConfigureEvent);
+				on_configure_notify(event.xconfigure);
+				break;
+
+
+			case CreateNotify:
+				Utility::Metrics::count_event(Utility::Metrics::CreateEvent);
+				on_create_notify(event.xcreatewindow);
+				break;
+
+			case DestroyNotify:
+				Utility::Metrics::count_event(Utility::Metrics::DestroyEvent);
+				on_destroy_notify(event.xdestroywindow);
+				break;
+
+			// case Expose:
+			// 	on_expose(event.xexpose);
+			// 	break;
+
+			case GraphicsExpose:
+				Utility::Metrics::count_event(Utility::Metrics::GraphicsExposeEvent);
+				on_graphics_expose(event.xgraphicsexpose);
+				break;
+
+			case MapNotify:
+				Utility::Metrics::count_event(Utility::Metrics::MapEvent);
+				on_map_notify(event.xmap);
+				break;
+
+			case NoExpose:
+				Utility::Metrics::count_event(Utility::Metrics::NoExposeEvent);
+				on_no_expose(event.xnoexpose);
+				break;
+
+			case PropertyNotify:
+				Utility::Metrics::count_event(Utility::Metrics::PropertyEvent);
+				on_property_notify(event.xproperty);
+				break;
+
+			case ReparentNotify:
+				Utility::Metrics::count_event(Utility::Metrics::ReparentEvent);
+				on_reparent_notify(event.xreparent);
+				break;
+
+			case UnmapNotify:
+				Utility::Metrics::count_event(Utility::Metrics::UnmapEvent);
+				on_unmap_notify(event.xunmap);
+				break;
+
+			default:
+
+				if (event.type == ShapeNotify + m_shape.event_base) {
+					Utility::Metrics::count_event(Utility::Metrics::ShapeEvent);
+					on_shape_notify(reinterpret_cast<XShapeEvent&>(event));
+				}
+
+				else if (event.type == XDamageNotify + m_damage.event_base) {
+					Utility::Metrics::count_event(Utility::Metrics::DamageEvent);
+					on_damage_notify(reinterpret_cast<XDamageNotifyEvent&>(event));
+				}
+
+				else if (m_output_layout.event_base() >= 0 && (event.type == m_output_layout.event_base() + RRScreenChangeNotify || event.type == m_output_layout.event_base() + RRNotify)) {
+					Utility::Metrics::count_event(Utility::Metrics::RandrEvent);
+					m_output_layout.on_randr_event(event);
+				}
+
+				else if (event.type == m_blanking.screen_saver_event_type()) {
+					Utility::Metrics::count_event(Utility::Metrics::ScreenSaverEvent);
+					m_blanking.on_screen_saver_notify(reinterpret_cast<XScreenSaverNotifyEvent&>(event));
+				}
+
+				else {
+					Utility::Metrics::count_event(Utility::Metrics::OtherEvent);
+					LOG_DEBUG(Events, "unhandled event", event.type);
+				}
+		}
+	}
+}
+
+
+
+
+void Compositor::on_circulate_notify(XCirculateEvent const& event)
+{
+	// raised when event.window is circulated either above or below all of its
+	// siblings.
+
+	LOG_DEBUG(Events, event.window, event.place);
+
+	m_window_manager.on_circulate_notify(event);
+}
+
+
+void Compositor::on_configure_notify(XConfigureEvent const& event)
+{
+	// raised when event.window is configured, which can include changing
+	// its position, size, border width, or stacking order.
+
+	LOG_DEBUG(Events, event.window, event.x, event.y, event.width, event.height, event.above);
+
+	// if it's the root window, the new size goes out with the next scene.
+	// the presenter resizes its output window from that if RandR can't say
+	// where the monitors are.
+
+	// pass the event along to the window manager
+
+	m_window_manager.on_configure_notify(event);
+}
+
+
+void Compositor::on_create_notify(XCreateWindowEvent const& event)
+{
+	// raised when event.window is created
+
+	LOG_DEBUG(Events, event.window, event.parent, event.x, event.y, event.width, event.height, event.override_redirect);
+
+	m_window_manager.on_create_notify(event, m_pixmaps);
+}
+
+
+void Compositor::on_damage_notify(XDamageNotifyEvent const& event)
+{
+	// raised when the contents of event.drawable change.  this is the only
+	// way we learn that a window needs to be redrawn without its geometry or
+	// stacking changing.
+
+	LOG_DEBUG(Events, event.drawable);
+
+	m_window_manager.on_damage_notify(event);
+}
+
+
+void Compositor::on_destroy_notify(XDestroyWindowEvent const& event)
+{
+	// raised when event.window is destroyed
+	
+	LOG_DEBUG(Events, event.window);
+
+	m_window_manager.on_destroy_notify(event);
+}
+
+
+// void Compositor::on_expose(XExposeEvent const& event)
+// {
+// 	LOG_DEBUG(Events, event.window, event.x, event.y, event.width, event.height);
+// }
+
+
+void Compositor::on_graphics_expose(XGraphicsExposeEvent const& event)
+{
+	// raised when XCopyArea or XCopyPlane fails when the source of the copy
+	// is either not available (e.g. an obscured root window), or the rquested
+	// area is out of the source's bounds.
+
+	LOG_DEBUG(Events, event.drawable, event.x, event.y, event.width, event.y);
+
+	m_window_manager.on_graphics_expose(event);
+}
+
+
+void Compositor::on_map_notify(XMapEvent const& event)
+{
+	// raised when event.window is mapped
+
+	LOG_DEBUG(Events, event.window, event.override_redirect);
+
+	m_window_manager.on_map_notify(event);
+}
+
+
+void Compositor::on_no_expose(XNoExposeEvent const& event)
+{
+	// raised when XCopyArea or XCopyPlane works.  this tells us that we
+	// succeeded when trying to copy the root window pixmap, and we can now
+	// draw th eroot window.
+
+	LOG_DEBUG(Events, event.drawable);
+
+	m_window_manager.on_no_expose(event);
+}
+
+void Compositor::on_property_notify(XPropertyEvent const& event)
+{
+	// raised when one of event.window's properties changes.  we are only
+	// interested when this happens on the root window, and then only when its
+	// wallpaper pixmap property changes.
+
+	LOG_DEBUG(Events, event.window, event.atom);
+
+	if (event.window == m_root) {
+		m_window_manager.on_property_notify(event);
+	}
+}
+
+
+void Compositor::on_reparent_notify(XReparentEvent const& event)
+{
+	// raised when event.window gets a new parent
+
+	// this is explained more in window_manager.cpp, but the short version is:
+	// we need to start managing event.window if it has been reparented to the
+	// root window, and we need to stop managing it if it has been reparented
+	// to anything else.
+
+	LOG_DEBUG(Events, event.window, event.parent, event.x, event.y);
+
+	m_window_manager.on_reparent_notify(event, m_pixmaps);
+}
+
+
+void Compositor::on_shape_notify(XShapeEvent const& event)
+{
+	// raised when event.window's shape changes
+
+	LOG_DEBUG(Events, event.window, "shaped", event.shaped, "extents", event.x, event.y, event.width, event.height);
+
+	m_window_manager.on_shape_notify(event);
+}
+
+
+void Compositor::on_unmap_notify(XUnmapEvent const& event)
+{
+	// raised when event.window is unmapped
+
+	LOG_DEBUG(Events, event.window);
+
+	m_window_manager.on_unmap_notify(event);
+}
+
@@ -0,0 +1,194 @@
+#ifndef ORTLE_COMPOSITOR_HPP
+#define ORTLE_COMPOSITOR_HPP
+
+
+#include "blanking_monitor.hpp"
+#include "event_recorder.hpp"
+#include "fence_ring.hpp"
+#include "frame_governor.hpp"
+#include "framebuffer_cache.hpp"
+#include "output_layout.hpp"
+#include "pixmap_ledger.hpp"
+#include "presenter.hpp"
+#include "renderer.hpp"
+#include "scene_exchange.hpp"
+#include "texture_binder.hpp"
+#include "window_manager.hpp"
+
+#include "utility/metrics.hpp"
+
+#include "x11/composite_manager_atom.hpp"
+#include "x11/composite_overlay.hpp"
+#include "x11/display.hpp"
+#include "x11/extension.hpp"
+#include "x11/round_trip.hpp"
+#include "x11/window.hpp"
+
+#include <poll.h>
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <vector>
+
+
+
+
+// composites one X screen.  it has a connection of its own for events, and
+// shares the render connection and the framebuffer cache with the
+// compositors of the other screens (see Ortle).  running is shared, too: it
+// is cleared to stop every screen.  if a recording path is given, what the
+// event thread sees is recorded there (see EventRecorder).
+
+class Compositor {
+
+public:
+
+	Compositor(Display* render_display, int screen, FramebufferCache& framebuffers, std::atomic<bool>& running, std::string const& recording = std::string());
+
+	Compositor(Compositor&&) = delete;
+	Compositor& operator=(Compositor&&) = delete;
+
+	~Compositor();
+
+
+public:
+
+	// handles events on the calling thread and draws on a thread of its own
+	// until running is cleared.  the calling thread should leave signals to
+	// the process's main thread, unless it is that thread.  if given a
+	// metrics server, the event thread serves it between batches of events.
+
+	void run(Utility::Metrics::Server* metrics = nullptr);
+
+
+private:
+
+	// the event thread (the one run() is called on) handles events and
+	// publishes scenes, and the render thread draws them.
+
+	void handle_events();
+	void render_frames();
+
+	void wait_for_events();
+	void publish_scene();
+
+	void process_pending_events();
+
+	// notes the blocking X requests made since the last call, if they took
+	// long enough to matter (see X11::RoundTrip), and logs what it has noted
+	// at most once a second
+
+	void report_round_trips();
+
+	void update_blanking();
+
+	void on_circulate_notify(XCirculateEvent const& event);
+	void on_configure_notify(XConfigureEvent const& event);
+	void on_create_notify(XCreateWindowEvent const& event);
+	void on_damage_notify(XDamageNotifyEvent const& event);
+	void on_destroy_notify(XDestroyWindowEvent const& event);
+	// void on_expose(XExposeEvent const& event);
+	void on_graphics_expose(XGraphicsExposeEvent const& event);
+	void on_map_notify(XMapEvent const& event);
+	void on_no_expose(XNoExposeEvent const& event);
+	void on_property_notify(XPropertyEvent const& event);
+	void on_reparent_notify(XReparentEvent const& event);
+	void on_shape_notify(XShapeEvent const& event);
+	void on_unmap_notify(XUnmapEvent const& event);
+
+
+private:
+
+	std::atomic<bool>* m_running;
+
+	X11::Display m_display;
+
+	// the render thread's connection.  the output windows and everything
+	// drawn on them belong to this one, so that rendering never waits on the
+	// event thread's use of m_display.
+
+	Display* m_render_display;
+
+	int m_screen;
+	Window m_root;
+
+	X11::Extension m_composite;
+	X11::Extension m_damage;
+	X11::Extension m_fixes;
+	X11::Extension m_shape;
+	X11::Extension m_glx;
+
+	FramebufferCache* m_framebuffers;
+
+	X11::CompositeOverlay m_composite_overlay;
+
+	// the context everything is drawn with, and a window for each output
+
+	Presenter m_presenter;
+
+	// owns the composite manager selection.  the output windows come and go
+	// with the monitors, so this is a window of its own.
+
+	X11::Window m_selection_window;
+
+	X11::CompositeManagerAtom m_composite_manager_atom;
+
+	// binds window textures for the renderer on a thread of its own, with a
+	// context shared with the presenter's.
+
+	TextureBinder m_binder;
+
+	Renderer m_renderer;
+
+	// render thread only
+
+	FrameGovernor m_governor;
+
+	PixmapLedger m_pixmaps;
+
+	FenceRing m_fences;
+
+	// made just before the window manager, so that what it asks the server
+	// while setting up is recorded too
+
+	EventRecorder m_recorder;
+
+	WindowManager m_window_manager;
+
+	OutputLayout m_output_layout;
+
+	SceneExchange m_scenes;
+
+	// the render thread draws nothing while the screen is blanked.  the event
+	// thread keeps track (m_blanking) and tells it through m_blanked.
+
+	BlankingMonitor m_blanking;
+	std::atomic<bool> m_blanked;
+
+	// set if the render thread stops because of an exception, which run()
+	// then rethrows on the event thread.
+
+	std::exception_ptr m_render_error;
+
+	// event thread only
+
+	Utility::Metrics::Server* m_metrics;
+	std::vector<pollfd> m_poll_descriptors;
+
+	// batches of events held up by blocking X requests since they were last
+	// logged, and the slowest of them
+
+	unsigned long m_slow_batches;
+	X11::RoundTrips m_slowest_batch;
+	std::chrono::steady_clock::time_point m_slow_batches_logged;
+
+};
+
+
+#endif
@@ -0,0 +1,145 @@
+#include "draw_list.hpp"
+
+#include "surface.hpp"
+
+#include "opengl/core330.hpp"
+
+#include <X11/Xlib.h>
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+
+
+DrawList::DrawList()
+	: m_owners()
+	, m_windows()
+	, m_textures()
+	, m_border_widths()
+	, m_window_geometries()
+	, m_rectangle_geometries()
+	, m_shadow_sizes()
+	, m_shape_buffers()
+	, m_shape_vertex_counts()
+	, m_animated_flags()
+	, m_animated()
+{}
+
+
+
+
+DrawList::DrawList(DrawList&& other)
+	: DrawList()
+{
+	swap(*this, other);
+}
+
+
+DrawList& DrawList::operator=(DrawList&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+DrawList::~DrawList()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(DrawList& first, DrawList& second)
+{
+	using std::swap;
+
+	swap(first.m_owners, second.m_owners);
+	swap(first.m_windows, second.m_windows);
+	swap(first.m_textures, second.m_textures);
+	swap(first.m_border_widths, second.m_border_widths);
+	swap(first.m_window_geometries, second.m_window_geometries);
+	swap(first.m_rectangle_geometries, second.m_rectangle_geometries);
+	swap(first.m_shadow_sizes, second.m_shadow_sizes);
+	swap(first.m_shape_buffers, second.m_shape_buffers);
+	swap(first.m_shape_vertex_counts, second.m_shape_vertex_counts);
+	swap(first.m_animated_flags, second.m_animated_flags);
+	swap(first.m_animated, second.m_animated);
+}
+
+
+
+
+void DrawList::clear()
+{
+	// clear() keeps the capacity of every vector, so once the list has grown
+	// to the size of the stack, rebuilding it does not allocate.
+
+	m_owners.clear();
+	m_windows.clear();
+	m_textures.clear();
+	m_border_widths.clear();
+	m_window_geometries.clear();
+	m_rectangle_geometries.clear();
+	m_shadow_sizes.clear();
+	m_shape_buffers.clear();
+	m_shape_vertex_counts.clear();
+	m_animated_flags.clear();
+
+	m_animated.clear();
+}
+
+
+
+
+void DrawList::add(Surface& owner, Item const& item)
+{
+	std::size_t index = m_owners.size();
+
+	m_owners.push_back(&owner);
+	m_windows.push_back(owner);
+	m_textures.push_back(item.texture);
+	m_border_widths.push_back(item.border_width);
+	m_window_geometries.push_back(item.window_geometry);
+	m_rectangle_geometries.push_back(item.rectangle_geometry);
+	m_shadow_sizes.push_back(item.shadow_size);
+	m_shape_buffers.push_back(item.shape_buffer);
+	m_shape_vertex_counts.push_back(item.shape_vertex_count);
+	m_animated_flags.push_back(item.animated);
+
+	if (item.animated) {
+		m_animated.push_back(index);
+	}
+}
+
+
+void DrawList::update(std::size_t index, Item const& item)
+{
+	assert(index < m_owners.size());
+
+	m_textures[index] = item.texture;
+	m_border_widths[index] = item.border_width;
+	m_window_geometries[index] = item.window_geometry;
+	m_rectangle_geometries[index] = item.rectangle_geometry;
+	m_shadow_sizes[index] = item.shadow_size;
+	m_shape_buffers[index] = item.shape_buffer;
+	m_shape_vertex_counts[index] = item.shape_vertex_count;
+	m_animated_flags[index] = item.animated;
+}
+
+
+
+
+void DrawList::prune_animated()
+{
+	auto stopped = [this](std::size_t index) { return m_animated_flags[index] == 0; };
+
+	m_animated.erase(std::remove_if(m_animated.begin(), m_animated.end(), stopped), m_animated.end());
+}
@@ -0,0 +1,166 @@
+#ifndef ORTLE_DRAW_LIST_HPP
+#define ORTLE_DRAW_LIST_HPP
+
+
+#include "opengl/core330.hpp"
+
+#include <X11/Xlib.h>
+
+#include <cstddef>
+#include <vector>
+
+
+
+
+class Surface;
+
+
+class DrawList {
+
+public:
+
+	struct Quad {
+
+		float x;
+		float y;
+		float width;
+		float height;
+
+	};
+
+
+	// everything the renderer needs to draw one window.
+
+	struct Item {
+
+		GLuint texture;
+
+		float border_width;
+
+		Quad window_geometry;
+		Quad rectangle_geometry;
+
+		// a shaped window is drawn from a vertex buffer holding its shape
+		// (see Surface::update_shape_buffer) instead of
+		// rectangle_geometry.  the count is zero if the window is not shaped.
+
+		GLuint shape_buffer;
+		GLsizei shape_vertex_count;
+
+		// zero if the window has no shadow
+
+		float shadow_size;
+
+		// animated items are updated by their surface every frame
+
+		bool animated;
+
+	};
+
+
+public:
+
+	DrawList();
+
+	DrawList(DrawList&& other);
+	DrawList& operator=(DrawList&& other);
+
+	~DrawList();
+
+	friend void swap(DrawList& first, DrawList& second);
+
+
+public:
+
+	void clear();
+
+	void add(Surface& owner, Item const& item);
+
+	void update(std::size_t index, Item const& item);
+
+
+	// indices of the animated entries.  prune_animated drops the ones that
+	// have stopped animating since the last call.
+
+	std::vector<std::size_t> const& animated() const
+	{
+		return m_animated;
+	}
+
+	void prune_animated();
+
+
+public:
+
+	std::size_t size() const
+	{
+		return m_owners.size();
+	}
+
+	Surface& owner(std::size_t index) const
+	{
+		return *m_owners[index];
+	}
+
+	::Window window(std::size_t index) const
+	{
+		return m_windows[index];
+	}
+
+	GLuint texture(std::size_t index) const
+	{
+		return m_textures[index];
+	}
+
+	float border_width(std::size_t index) const
+	{
+		return m_border_widths[index];
+	}
+
+	Quad const& window_geometry(std::size_t index) const
+	{
+		return m_window_geometries[index];
+	}
+
+	Quad const& rectangle_geometry(std::size_t index) const
+	{
+		return m_rectangle_geometries[index];
+	}
+
+	float shadow_size(std::size_t index) const
+	{
+		return m_shadow_sizes[index];
+	}
+
+	GLuint shape_buffer(std::size_t index) const
+	{
+		return m_shape_buffers[index];
+	}
+
+	GLsizei shape_vertex_count(std::size_t index) const
+	{
+		return m_shape_vertex_counts[index];
+	}
+
+
+private:
+
+	// one element per entry
+
+	std::vector<Surface*> m_owners;
+	std::vector< ::Window> m_windows;
+	std::vector<GLuint> m_textures;
+	std::vector<float> m_border_widths;
+	std::vector<Quad> m_window_geometries;
+	std::vector<Quad> m_rectangle_geometries;
+	std::vector<float> m_shadow_sizes;
+	std::vector<GLuint> m_shape_buffers;
+	std::vector<GLsizei> m_shape_vertex_counts;
+	std::vector<char> m_animated_flags;
+
+	std::vector<std::size_t> m_animated;
+
+};
+
+
+#endif
@@ -0,0 +1,556 @@
+#include "event_player.hpp"
+
+#include "event_recording.hpp"
+#include "exceptions.hpp"
+
+#include "utility/log.hpp"
+
+#include "x11/xlib.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xcomposite.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+
+
+
+namespace {
+
+
+using namespace EventRecording;
+
+
+// the player, while there is one.  as with the recorder, calls on any other
+// display go straight to Xlib.
+
+EventPlayer* g_player = nullptr;
+
+
+bool played(::Display* display)
+{
+	return g_player != nullptr && display == g_player->display();
+}
+
+
+// Xlib's callers free what it returns with XFree, which is free()
+
+template<typename T>
+T* allocate(std::size_t count)
+{
+	return static_cast<T*>(std::malloc(count > 0 ? count * sizeof(T) : 1));
+}
+
+
+// a visual of the player's screen for a recorded depth
+
+Visual* visual_for(int depth)
+{
+	XVisualInfo info;
+
+	if (XMatchVisualInfo(g_player->display(), g_player->screen(), depth, TrueColor, &info)) {
+		return info.visual;
+	}
+
+	return XDefaultVisual(g_player->display(), g_player->screen());
+}
+
+
+bool depth_supported(int depth)
+{
+	int count = 0;
+	int* depths = XListDepths(g_player->display(), g_player->screen(), &count);
+
+	bool supported = false;
+
+	for (int i = 0; i < count; ++i) {
+		supported = supported || (depths[i] == depth);
+	}
+
+	XFree(depths);
+
+	return supported;
+}
+
+
+
+
+::Atom intern_atom(::Display* display, char const* name, Bool only_if_exists)
+{
+	if (!played(display)) {
+		return XInternAtom(display, name, only_if_exists);
+	}
+
+	return g_player->reply(InternAtom).get<std::uint64_t>();
+}
+
+
+Status get_window_attributes(::Display* display, ::Window window, XWindowAttributes* attributes)
+{
+	if (!played(display)) {
+		return XGetWindowAttributes(display, window, attributes);
+	}
+
+	Reader reply = g_player->reply(GetWindowAttributes);
+
+	Status status = reply.get<std::int32_t>();
+
+	if (status) {
+
+		std::memset(attributes, 0, sizeof(*attributes));
+
+		attributes->x = reply.get<std::int32_t>();
+		attributes->y = reply.get<std::int32_t>();
+		attributes->width = reply.get<std::int32_t>();
+		attributes->height = reply.get<std::int32_t>();
+		attributes->border_width = reply.get<std::int32_t>();
+		attributes->depth = reply.get<std::int32_t>();
+		attributes->c_class = reply.get<std::int32_t>();
+		attributes->map_state = reply.get<std::int32_t>();
+		attributes->override_redirect = reply.get<std::int32_t>();
+		attributes->root = reply.get<std::uint64_t>();
+
+		// the recorded visual's id means nothing here
+
+		reply.get<std::uint64_t>();
+
+		attributes->visual = visual_for(attributes->depth);
+		attributes->screen = XScreenOfDisplay(display, g_player->screen());
+	}
+
+	return status;
+}
+
+
+int get_window_property(::Display* display, ::Window window, ::Atom property, long offset, long length, Bool remove, ::Atom requested_type, ::Atom* type, int* format, unsigned long* count, unsigned long* remaining, unsigned char** data)
+{
+	if (!played(display)) {
+		return XGetWindowProperty(display, window, property, offset, length, remove, requested_type, type, format, count, remaining, data);
+	}
+
+	Reader reply = g_player->reply(GetWindowProperty);
+
+	int result = reply.get<std::int32_t>();
+
+	if (result == Success) {
+
+		*type = reply.get<std::uint64_t>();
+		*format = reply.get<std::int32_t>();
+		*count = reply.get<std::uint64_t>();
+		*remaining = reply.get<std::uint64_t>();
+
+		std::uint32_t size = reply.get<std::uint32_t>();
+
+		*data = allocate<unsigned char>(size);
+		reply.read(*data, size);
+	}
+
+	return result;
+}
+
+
+Status query_tree(::Display* display, ::Window window, ::Window* root, ::Window* parent, ::Window** children, unsigned int* count)
+{
+	if (!played(display)) {
+		return XQueryTree(display, window, root, parent, children, count);
+	}
+
+	Reader reply = g_player->reply(QueryTree);
+
+	Status status = reply.get<std::int32_t>();
+
+	if (status) {
+
+		*root = reply.get<std::uint64_t>();
+		*parent = reply.get<std::uint64_t>();
+		*count = reply.get<std::uint32_t>();
+
+		*children = (*count > 0 ? allocate<::Window>(*count) : nullptr);
+
+		for (unsigned int i = 0; i < *count; ++i) {
+			(*children)[i] = reply.get<std::uint64_t>();
+		}
+	}
+
+	return status;
+}
+
+
+Status get_geometry(::Display* display, ::Drawable drawable, ::Window* root, int* x, int* y, unsigned int* width, unsigned int* height, unsigned int* border_width, unsigned int* depth)
+{
+	if (!played(display)) {
+		return XGetGeometry(display, drawable, root, x, y, width, height, border_width, depth);
+	}
+
+	Reader reply = g_player->reply(GetGeometry);
+
+	Status status = reply.get<std::int32_t>();
+
+	if (status) {
+		*root = reply.get<std::uint64_t>();
+		*x = reply.get<std::int32_t>();
+		*y = reply.get<std::int32_t>();
+		*width = reply.get<std::uint32_t>();
+		*height = reply.get<std::uint32_t>();
+		*border_width = reply.get<std::uint32_t>();
+		*depth = reply.get<std::uint32_t>();
+	}
+
+	return status;
+}
+
+
+Bool translate_coordinates(::Display* display, ::Window source, ::Window destination, int source_x, int source_y, int* x, int* y, ::Window* child)
+{
+	if (!played(display)) {
+		return XTranslateCoordinates(display, source, destination, source_x, source_y, x, y, child);
+	}
+
+	Reader reply = g_player->reply(TranslateCoordinates);
+
+	Bool result = reply.get<std::int32_t>();
+	*x = reply.get<std::int32_t>();
+	*y = reply.get<std::int32_t>();
+	*child = reply.get<std::uint64_t>();
+
+	return result;
+}
+
+
+Status shape_query_extents(::Display* display, ::Window window, Bool* bounding_shaped, int* bounding_x, int* bounding_y, unsigned int* bounding_width, unsigned int* bounding_height, Bool* clip_shaped, int* clip_x, int* clip_y, unsigned int* clip_width, unsigned int* clip_height)
+{
+	if (!played(display)) {
+		return XShapeQueryExtents(display, window, bounding_shaped, bounding_x, bounding_y, bounding_width, bounding_height, clip_shaped, clip_x, clip_y, clip_width, clip_height);
+	}
+
+	Reader reply = g_player->reply(ShapeQueryExtents);
+
+	Status status = reply.get<std::int32_t>();
+
+	if (status) {
+		*bounding_shaped = reply.get<std::int32_t>();
+		*bounding_x = reply.get<std::int32_t>();
+		*bounding_y = reply.get<std::int32_t>();
+		*bounding_width = reply.get<std::uint32_t>();
+		*bounding_height = reply.get<std::uint32_t>();
+		*clip_shaped = reply.get<std::int32_t>();
+		*clip_x = reply.get<std::int32_t>();
+		*clip_y = reply.get<std::int32_t>();
+		*clip_width = reply.get<std::uint32_t>();
+		*clip_height = reply.get<std::uint32_t>();
+	}
+
+	return status;
+}
+
+
+XRectangle* shape_get_rectangles(::Display* display, ::Window window, int kind, int* count, int* ordering)
+{
+	if (!played(display)) {
+		return XShapeGetRectangles(display, window, kind, count, ordering);
+	}
+
+	Reader reply = g_player->reply(ShapeGetRectangles);
+
+	if (reply.get<std::uint8_t>() == 0) {
+		*count = 0;
+		return nullptr;
+	}
+
+	*count = reply.get<std::int32_t>();
+	*ordering = reply.get<std::int32_t>();
+
+	std::size_t size = static_cast<std::size_t>(*count);
+
+	XRectangle* rectangles = allocate<XRectangle>(size);
+	reply.read(rectangles, size * sizeof(XRectangle));
+
+	return rectangles;
+}
+
+
+::Pixmap composite_name_window_pixmap(::Display* display, ::Window window)
+{
+	if (!played(display)) {
+		return XCompositeNameWindowPixmap(display, window);
+	}
+
+	Reader reply = g_player->reply(CompositeNameWindowPixmap);
+
+	::Pixmap recorded = reply.get<std::uint64_t>();
+	unsigned int width = reply.get<std::uint32_t>();
+	unsigned int height = reply.get<std::uint32_t>();
+	unsigned int depth = reply.get<std::uint32_t>();
+
+	if (recorded == None || width == 0 || height == 0 || !depth_supported(static_cast<int>(depth))) {
+		return None;
+	}
+
+	::Pixmap pixmap = XCreatePixmap(display, XRootWindow(display, g_player->screen()), width, height, depth);
+
+	// opaque, whatever the depth, so that every window is seen
+
+	unsigned long color = ((window * 0x9e3779b1ul) & 0xffffff) | 0xff000000ul;
+
+	GC gc = XCreateGC(display, pixmap, 0, nullptr);
+	XSetForeground(display, gc, color);
+	XFillRectangle(display, pixmap, gc, 0, 0, width, height);
+	XFreeGC(display, gc);
+
+	return pixmap;
+}
+
+
+// resources are made on the player's screen, whichever window they were
+// asked for on
+
+::Pixmap create_pixmap(::Display* display, ::Drawable drawable, unsigned int width, unsigned int height, unsigned int depth)
+{
+	if (!played(display)) {
+		return XCreatePixmap(display, drawable, width, height, depth);
+	}
+
+	return XCreatePixmap(display, XRootWindow(display, g_player->screen()), width, height, depth);
+}
+
+
+::Damage damage_create(::Display* display, ::Drawable drawable, int level)
+{
+	if (!played(display)) {
+		return XDamageCreate(display, drawable, level);
+	}
+
+	return g_player->next_damage();
+}
+
+
+// the rest only ask the server to do something to windows that don't exist
+// here, so they are dropped
+
+void damage_destroy(::Display* display, ::Damage damage)
+{
+	if (!played(display)) {
+		XDamageDestroy(display, damage);
+	}
+}
+
+
+void damage_subtract(::Display* display, ::Damage damage, XserverRegion repair, XserverRegion parts)
+{
+	if (!played(display)) {
+		XDamageSubtract(display, damage, repair, parts);
+	}
+}
+
+
+void composite_redirect_subwindows(::Display* display, ::Window window, int update)
+{
+	if (!played(display)) {
+		XCompositeRedirectSubwindows(display, window, update);
+	}
+}
+
+
+void composite_unredirect_subwindows(::Display* display, ::Window window, int update)
+{
+	if (!played(display)) {
+		XCompositeUnredirectSubwindows(display, window, update);
+	}
+}
+
+
+int copy_area(::Display* display, ::Drawable source, ::Drawable destination, GC gc, int source_x, int source_y, unsigned int width, unsigned int height, int x, int y)
+{
+	if (!played(display)) {
+		return XCopyArea(display, source, destination, gc, source_x, source_y, width, height, x, y);
+	}
+
+	return 0;
+}
+
+
+int select_input(::Display* display, ::Window window, long mask)
+{
+	if (!played(display)) {
+		return XSelectInput(display, window, mask);
+	}
+
+	return 0;
+}
+
+
+void shape_select_input(::Display* display, ::Window window, unsigned long mask)
+{
+	if (!played(display)) {
+		XShapeSelectInput(display, window, mask);
+	}
+}
+
+
+int grab_server(::Display* display)
+{
+	if (!played(display)) {
+		return XGrabServer(display);
+	}
+
+	return 0;
+}
+
+
+int ungrab_server(::Display* display)
+{
+	if (!played(display)) {
+		return XUngrabServer(display);
+	}
+
+	return 0;
+}
+
+
+} // namespace
+
+
+
+
+EventPlayer::EventPlayer(std::string const& path, Display* display, int screen)
+	: m_recording()
+	, m_position(0)
+	, m_header()
+	, m_display(display)
+	, m_screen(screen)
+	, m_damage(0)
+{
+	assert(display != nullptr);
+	assert(g_player == nullptr);
+
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file) {
+		throw RecordingError("Could not open the recording.");
+	}
+
+	m_recording.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	if (m_recording.size() < sizeof(m_header)) {
+		throw RecordingError("Recording is too short to be one.");
+	}
+
+	std::memcpy(&m_header, m_recording.data(), sizeof(m_header));
+	m_position = sizeof(m_header);
+
+	if (std::memcmp(m_header.magic, magic, sizeof(magic)) != 0 || m_header.version != version) {
+		throw RecordingError("Not a recording, or one made by a different version.");
+	}
+
+
+	g_player = this;
+
+	X11::Xlib::InternAtom = &intern_atom;
+	X11::Xlib::GetWindowAttributes = &get_window_attributes;
+	X11::Xlib::GetWindowProperty = &get_window_property;
+	X11::Xlib::QueryTree = &query_tree;
+	X11::Xlib::GetGeometry = &get_geometry;
+	X11::Xlib::TranslateCoordinates = &translate_coordinates;
+	X11::Xlib::ShapeQueryExtents = &shape_query_extents;
+	X11::Xlib::ShapeGetRectangles = &shape_get_rectangles;
+
+	X11::Xlib::CompositeNameWindowPixmap = &composite_name_window_pixmap;
+
+	X11::Xlib::CompositeRedirectSubwindows = &composite_redirect_subwindows;
+	X11::Xlib::CompositeUnredirectSubwindows = &composite_unredirect_subwindows;
+	X11::Xlib::DamageCreate = &damage_create;
+	X11::Xlib::DamageDestroy = &damage_destroy;
+	X11::Xlib::DamageSubtract = &damage_subtract;
+	X11::Xlib::CreatePixmap = &create_pixmap;
+	X11::Xlib::CopyArea = &copy_area;
+	X11::Xlib::SelectInput = &select_input;
+	X11::Xlib::ShapeSelectInput = &shape_select_input;
+	X11::Xlib::GrabServer = &grab_server;
+	X11::Xlib::UngrabServer = &ungrab_server;
+
+	LOG_INFO(Events, "replaying", path, "recorded on a screen of", m_header.width, m_header.height);
+}
+
+
+
+
+EventPlayer::~EventPlayer()
+{
+	X11::Xlib::reset();
+	g_player = nullptr;
+}
+
+
+
+
+bool EventPlayer::next(Record& record)
+{
+	if (m_position == m_recording.size()) {
+		return false;
+	}
+
+	Reader reader(m_recording.data() + m_position, m_recording.data() + m_recording.size());
+
+	record.kind = static_cast<Kind>(reader.get<std::uint8_t>());
+
+	if (record.kind != Event && record.kind != Flush) {
+		throw RecordingError("Replay is out of step with the recording: a reply was not asked for.");
+	}
+
+	record.time = std::chrono::nanoseconds(reader.get<std::uint64_t>());
+
+	std::size_t size = sizeof(std::uint8_t) + sizeof(std::uint64_t);
+
+	if (record.kind == Event) {
+
+		std::uint32_t event_size = reader.get<std::uint32_t>();
+
+		if (event_size > sizeof(record.event)) {
+			throw RecordingError("Recording holds an event larger than any.");
+		}
+
+		std::memset(&record.event, 0, sizeof(record.event));
+		reader.read(&record.event, event_size);
+
+		record.event.xany.display = m_display;
+
+		size += sizeof(std::uint32_t) + event_size;
+	}
+
+	m_position += size;
+
+	return true;
+}
+
+
+Reader EventPlayer::reply(Call call)
+{
+	Reader reader(m_recording.data() + m_position, m_recording.data() + m_recording.size());
+
+	if (reader.empty() || reader.get<std::uint8_t>() != Reply || reader.get<std::uint8_t>() != call) {
+		throw RecordingError("Replay is out of step with the recording: a call was made that was not recorded.");
+	}
+
+	std::uint32_t size = reader.get<std::uint32_t>();
+
+	std::size_t begin = m_position + 2 * sizeof(std::uint8_t) + sizeof(std::uint32_t);
+
+	if (m_recording.size() - begin < size) {
+		throw RecordingError("Recording ends in the middle of a record.");
+	}
+
+	m_position = begin + size;
+
+	return Reader(m_recording.data() + begin, m_recording.data() + begin + size);
+}
@@ -0,0 +1,120 @@
+#ifndef ORTLE_EVENT_PLAYER_HPP
+#define ORTLE_EVENT_PLAYER_HPP
+
+
+#include "event_recording.hpp"
+
+#include <X11/Xlib.h>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+
+
+// plays back what an EventRecorder recorded.  the events and flushes come
+// out of next() in order.  while the player lives, it answers the calls in
+// X11::Xlib made on the given display from the recording instead of the
+// server, so that window management sees exactly what it saw when it was
+// recorded, and expects them to be made in the same order.  the few calls
+// that create something the renderer needs are still made, on the real
+// server:
+//
+//   - each window pixmap is replaced by one of the same size and depth,
+//     filled with a color picked from the window's id
+//   - pixmaps are created and freed as asked
+//
+// everything else is either answered from the recording or dropped.  there
+// can only be one player at a time, and not alongside a recorder.
+
+class EventPlayer {
+
+public:
+
+	struct Record {
+
+		EventRecording::Kind kind;
+
+		// since recording began
+
+		std::chrono::nanoseconds time;
+
+		// events only.  whatever the recording didn't keep is zero, and the
+		// display is the player's.
+
+		XEvent event;
+
+	};
+
+
+public:
+
+	// reads the whole recording.  throws RecordingError if it can't, or if
+	// it isn't one.
+
+	EventPlayer(std::string const& path, Display* display, int screen);
+
+	EventPlayer(EventPlayer&&) = delete;
+	EventPlayer& operator=(EventPlayer&&) = delete;
+
+	~EventPlayer();
+
+
+public:
+
+	EventRecording::Header const& header() const
+	{
+		return m_header;
+	}
+
+
+	// the next event or flush.  returns false at the end of the recording,
+	// and throws RecordingError if a reply is next, which means the calls
+	// being made are not the ones that were recorded.
+
+	bool next(Record& record);
+
+
+	// the next reply, which must be to the given call
+
+	EventRecording::Reader reply(EventRecording::Call call);
+
+
+	Display* display() const
+	{
+		return m_display;
+	}
+
+
+	int screen() const
+	{
+		return m_screen;
+	}
+
+
+	// counts the damage objects handed out in place of real ones
+
+	unsigned long next_damage()
+	{
+		return ++m_damage;
+	}
+
+
+private:
+
+	std::vector<char> m_recording;
+	std::size_t m_position;
+
+	EventRecording::Header m_header;
+
+	Display* m_display;
+	int m_screen;
+
+	unsigned long m_damage;
+
+};
+
+
+#endif
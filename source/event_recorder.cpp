@@ -0,0 +1,410 @@
+#include "event_recorder.hpp"
+
+#include "event_recording.hpp"
+
+#include "utility/log.hpp"
+
+#include "x11/xlib.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xcomposite.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+
+
+
+namespace {
+
+
+using namespace EventRecording;
+
+
+// the recorder, while there is one.  the wrappers below only record calls
+// on its display, and pass on everything else untouched.
+
+EventRecorder* g_recorder = nullptr;
+
+
+bool recorded(::Display* display)
+{
+	return g_recorder != nullptr && display == g_recorder->display();
+}
+
+
+// each wrapper makes the call, then records its results.  the arguments
+// aren't recorded: the replay makes the same calls in the same order.
+
+::Atom intern_atom(::Display* display, char const* name, Bool only_if_exists)
+{
+	::Atom atom = XInternAtom(display, name, only_if_exists);
+
+	if (recorded(display)) {
+		std::string reply;
+		put<std::uint64_t>(reply, atom);
+		g_recorder->record_reply(InternAtom, reply);
+	}
+
+	return atom;
+}
+
+
+Status get_window_attributes(::Display* display, ::Window window, XWindowAttributes* attributes)
+{
+	Status status = XGetWindowAttributes(display, window, attributes);
+
+	if (recorded(display)) {
+
+		// the visual and screen are pointers into this connection's
+		// structures, so only the visual's id goes in
+
+		std::string reply;
+		put<std::int32_t>(reply, status);
+
+		if (status) {
+			put<std::int32_t>(reply, attributes->x);
+			put<std::int32_t>(reply, attributes->y);
+			put<std::int32_t>(reply, attributes->width);
+			put<std::int32_t>(reply, attributes->height);
+			put<std::int32_t>(reply, attributes->border_width);
+			put<std::int32_t>(reply, attributes->depth);
+			put<std::int32_t>(reply, attributes->c_class);
+			put<std::int32_t>(reply, attributes->map_state);
+			put<std::int32_t>(reply, attributes->override_redirect);
+			put<std::uint64_t>(reply, attributes->root);
+			put<std::uint64_t>(reply, XVisualIDFromVisual(attributes->visual));
+		}
+
+		g_recorder->record_reply(GetWindowAttributes, reply);
+	}
+
+	return status;
+}
+
+
+int get_window_property(::Display* display, ::Window window, ::Atom property, long offset, long length, Bool remove, ::Atom requested_type, ::Atom* type, int* format, unsigned long* count, unsigned long* remaining, unsigned char** data)
+{
+	int result = XGetWindowProperty(display, window, property, offset, length, remove, requested_type, type, format, count, remaining, data);
+
+	if (recorded(display)) {
+
+		std::string reply;
+		put<std::int32_t>(reply, result);
+
+		if (result == Success) {
+
+			// Xlib hands out format 32 as longs
+
+			std::size_t unit = (*format == 32 ? sizeof(long) : *format == 16 ? sizeof(short) : 1);
+			std::size_t size = (*data != nullptr ? *count * unit : 0);
+
+			put<std::uint64_t>(reply, *type);
+			put<std::int32_t>(reply, *format);
+			put<std::uint64_t>(reply, *count);
+			put<std::uint64_t>(reply, *remaining);
+			put<std::uint32_t>(reply, static_cast<std::uint32_t>(size));
+			reply.append(reinterpret_cast<char const*>(*data), size);
+		}
+
+		g_recorder->record_reply(GetWindowProperty, reply);
+	}
+
+	return result;
+}
+
+
+Status query_tree(::Display* display, ::Window window, ::Window* root, ::Window* parent, ::Window** children, unsigned int* count)
+{
+	Status status = XQueryTree(display, window, root, parent, children, count);
+
+	if (recorded(display)) {
+
+		std::string reply;
+		put<std::int32_t>(reply, status);
+
+		if (status) {
+
+			put<std::uint64_t>(reply, *root);
+			put<std::uint64_t>(reply, *parent);
+			put<std::uint32_t>(reply, *count);
+
+			for (unsigned int i = 0; i < *count; ++i) {
+				put<std::uint64_t>(reply, (*children)[i]);
+			}
+		}
+
+		g_recorder->record_reply(QueryTree, reply);
+	}
+
+	return status;
+}
+
+
+Status get_geometry(::Display* display, ::Drawable drawable, ::Window* root, int* x, int* y, unsigned int* width, unsigned int* height, unsigned int* border_width, unsigned int* depth)
+{
+	Status status = XGetGeometry(display, drawable, root, x, y, width, height, border_width, depth);
+
+	if (recorded(display)) {
+
+		std::string reply;
+		put<std::int32_t>(reply, status);
+
+		if (status) {
+			put<std::uint64_t>(reply, *root);
+			put<std::int32_t>(reply, *x);
+			put<std::int32_t>(reply, *y);
+			put<std::uint32_t>(reply, *width);
+			put<std::uint32_t>(reply, *height);
+			put<std::uint32_t>(reply, *border_width);
+			put<std::uint32_t>(reply, *depth);
+		}
+
+		g_recorder->record_reply(GetGeometry, reply);
+	}
+
+	return status;
+}
+
+
+Bool translate_coordinates(::Display* display, ::Window source, ::Window destination, int source_x, int source_y, int* x, int* y, ::Window* child)
+{
+	Bool result = XTranslateCoordinates(display, source, destination, source_x, source_y, x, y, child);
+
+	if (recorded(display)) {
+
+		std::string reply;
+		put<std::int32_t>(reply, result);
+		put<std::int32_t>(reply, *x);
+		put<std::int32_t>(reply, *y);
+		put<std::uint64_t>(reply, *child);
+
+		g_recorder->record_reply(TranslateCoordinates, reply);
+	}
+
+	return result;
+}
+
+
+Status shape_query_extents(::Display* display, ::Window window, Bool* bounding_shaped, int* bounding_x, int* bounding_y, unsigned int* bounding_width, unsigned int* bounding_height, Bool* clip_shaped, int* clip_x, int* clip_y, unsigned int* clip_width, unsigned int* clip_height)
+{
+	Status status = XShapeQueryExtents(display, window, bounding_shaped, bounding_x, bounding_y, bounding_width, bounding_height, clip_shaped, clip_x, clip_y, clip_width, clip_height);
+
+	if (recorded(display)) {
+
+		std::string reply;
+		put<std::int32_t>(reply, status);
+
+		if (status) {
+			put<std::int32_t>(reply, *bounding_shaped);
+			put<std::int32_t>(reply, *bounding_x);
+			put<std::int32_t>(reply, *bounding_y);
+			put<std::uint32_t>(reply, *bounding_width);
+			put<std::uint32_t>(reply, *bounding_height);
+			put<std::int32_t>(reply, *clip_shaped);
+			put<std::int32_t>(reply, *clip_x);
+			put<std::int32_t>(reply, *clip_y);
+			put<std::uint32_t>(reply, *clip_width);
+			put<std::uint32_t>(reply, *clip_height);
+		}
+
+		g_recorder->record_reply(ShapeQueryExtents, reply);
+	}
+
+	return status;
+}
+
+
+XRectangle* shape_get_rectangles(::Display* display, ::Window window, int kind, int* count, int* ordering)
+{
+	XRectangle* rectangles = XShapeGetRectangles(display, window, kind, count, ordering);
+
+	if (recorded(display)) {
+
+		std::string reply;
+		put<std::uint8_t>(reply, rectangles != nullptr);
+
+		if (rectangles != nullptr) {
+			put<std::int32_t>(reply, *count);
+			put<std::int32_t>(reply, *ordering);
+			reply.append(reinterpret_cast<char const*>(rectangles), static_cast<std::size_t>(*count) * sizeof(XRectangle));
+		}
+
+		g_recorder->record_reply(ShapeGetRectangles, reply);
+	}
+
+	return rectangles;
+}
+
+
+::Pixmap composite_name_window_pixmap(::Display* display, ::Window window)
+{
+	::Pixmap pixmap = XCompositeNameWindowPixmap(display, window);
+
+	if (recorded(display)) {
+
+		// the replay draws a pixmap of the same size and depth in its place.
+		// this is a round trip that only recording makes, so it goes
+		// straight to Xlib.
+
+		::Window root = None;
+		int x = 0;
+		int y = 0;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		unsigned int border_width = 0;
+		unsigned int depth = 0;
+
+		if (pixmap != None && !XGetGeometry(display, pixmap, &root, &x, &y, &width, &height, &border_width, &depth)) {
+			width = height = depth = 0;
+		}
+
+		std::string reply;
+		put<std::uint64_t>(reply, pixmap);
+		put<std::uint32_t>(reply, width);
+		put<std::uint32_t>(reply, height);
+		put<std::uint32_t>(reply, depth);
+
+		g_recorder->record_reply(CompositeNameWindowPixmap, reply);
+	}
+
+	return pixmap;
+}
+
+
+} // namespace
+
+
+
+
+EventRecorder::EventRecorder()
+	: m_file()
+	, m_display(nullptr)
+	, m_shape_event_base(0)
+	, m_damage_event_base(0)
+	, m_start()
+	, m_buffer()
+{}
+
+
+EventRecorder::EventRecorder(std::string const& path, Display* display, int screen, Window root, int shape_event_base, int damage_event_base)
+	: EventRecorder()
+{
+	assert(display != nullptr);
+	assert(g_recorder == nullptr);
+
+	if (path.empty()) {
+		return;
+	}
+
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+
+	if (!m_file) {
+		LOG_WARNING(Events, "could not open", path, "to record events to");
+		return;
+	}
+
+	m_display = display;
+	m_shape_event_base = shape_event_base;
+	m_damage_event_base = damage_event_base;
+	m_start = std::chrono::steady_clock::now();
+
+	Header header;
+	std::memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = version;
+	header.screen = screen;
+	header.root = root;
+	header.width = XDisplayWidth(display, screen);
+	header.height = XDisplayHeight(display, screen);
+	header.shape_event_base = shape_event_base;
+	header.damage_event_base = damage_event_base;
+
+	m_file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+
+	g_recorder = this;
+
+	X11::Xlib::InternAtom = &intern_atom;
+	X11::Xlib::GetWindowAttributes = &get_window_attributes;
+	X11::Xlib::GetWindowProperty = &get_window_property;
+	X11::Xlib::QueryTree = &query_tree;
+	X11::Xlib::GetGeometry = &get_geometry;
+	X11::Xlib::TranslateCoordinates = &translate_coordinates;
+	X11::Xlib::ShapeQueryExtents = &shape_query_extents;
+	X11::Xlib::ShapeGetRectangles = &shape_get_rectangles;
+	X11::Xlib::CompositeNameWindowPixmap = &composite_name_window_pixmap;
+
+	LOG_INFO(Events, "recording events to", path);
+}
+
+
+
+
+EventRecorder::~EventRecorder()
+{
+	if (m_display != nullptr) {
+		X11::Xlib::reset();
+		g_recorder = nullptr;
+	}
+}
+
+
+
+
+void EventRecorder::record_event(XEvent const& event)
+{
+	if (m_display == nullptr) {
+		return;
+	}
+
+	std::size_t size = event_size(event, m_shape_event_base, m_damage_event_base);
+
+	m_buffer.clear();
+	put<std::uint8_t>(m_buffer, Event);
+	put_time(std::chrono::steady_clock::now());
+	put<std::uint32_t>(m_buffer, static_cast<std::uint32_t>(size));
+	m_buffer.append(reinterpret_cast<char const*>(&event), size);
+
+	m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+}
+
+
+void EventRecorder::record_flush(std::chrono::steady_clock::time_point now)
+{
+	if (m_display == nullptr) {
+		return;
+	}
+
+	m_buffer.clear();
+	put<std::uint8_t>(m_buffer, Flush);
+	put_time(now);
+
+	m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+}
+
+
+void EventRecorder::record_reply(Call call, std::string const& reply)
+{
+	m_buffer.clear();
+	put<std::uint8_t>(m_buffer, Reply);
+	put<std::uint8_t>(m_buffer, call);
+	put<std::uint32_t>(m_buffer, static_cast<std::uint32_t>(reply.size()));
+	m_buffer.append(reply);
+
+	m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+}
+
+
+
+
+void EventRecorder::put_time(std::chrono::steady_clock::time_point time)
+{
+	auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_start).count();
+
+	put<std::uint64_t>(m_buffer, static_cast<std::uint64_t>(nanoseconds > 0 ? nanoseconds : 0));
+}
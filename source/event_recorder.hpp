@@ -0,0 +1,93 @@
+#ifndef ORTLE_EVENT_RECORDER_HPP
+#define ORTLE_EVENT_RECORDER_HPP
+
+
+#include "event_recording.hpp"
+
+#include <X11/Xlib.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+
+
+
+// records what one screen's event thread sees, so that a problem can be
+// replayed exactly (see benchmark/replay.cpp): every event it handles, the
+// replies to the queries window management makes while handling them, and
+// the points at which it publishes scenes.  the queries are recorded by
+// replacing the calls in X11::Xlib for as long as the recorder lives, so
+// there can only be one at a time.
+//
+// recording costs little beyond writing the file, except that the size of
+// every new window pixmap is asked for as well, so that the replay can make
+// one like it.
+
+class EventRecorder {
+
+public:
+
+	// not recording
+
+	EventRecorder();
+
+	// records to the given file, replacing it.  if that fails, it says so and
+	// doesn't record, and if the path is empty, it quietly doesn't.  the display is the event thread's, whose calls are the
+	// ones recorded.
+
+	EventRecorder(std::string const& path, Display* display, int screen, Window root, int shape_event_base, int damage_event_base);
+
+	EventRecorder(EventRecorder&&) = delete;
+	EventRecorder& operator=(EventRecorder&&) = delete;
+
+	~EventRecorder();
+
+
+public:
+
+	bool recording() const
+	{
+		return m_display != nullptr;
+	}
+
+
+	// these do nothing unless recording
+
+	void record_event(XEvent const& event);
+	void record_flush(std::chrono::steady_clock::time_point now);
+
+
+	// for the calls in X11::Xlib, once they have their reply
+
+	void record_reply(EventRecording::Call call, std::string const& reply);
+
+
+	Display* display() const
+	{
+		return m_display;
+	}
+
+
+private:
+
+	void put_time(std::chrono::steady_clock::time_point time);
+
+
+private:
+
+	std::ofstream m_file;
+
+	Display* m_display;
+
+	int m_shape_event_base;
+	int m_damage_event_base;
+
+	std::chrono::steady_clock::time_point m_start;
+
+	std::string m_buffer;
+
+};
+
+
+#endif
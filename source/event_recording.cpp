@@ -0,0 +1,64 @@
+#include "event_recording.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <cstddef>
+
+
+
+
+namespace EventRecording {
+
+
+std::size_t event_size(XEvent const& event, int shape_event_base, int damage_event_base)
+{
+	switch (event.type) {
+
+		case CirculateNotify:
+			return sizeof(XCirculateEvent);
+
+		case ConfigureNotify:
+			return sizeof(XConfigureEvent);
+
+		case CreateNotify:
+			return sizeof(XCreateWindowEvent);
+
+		case DestroyNotify:
+			return sizeof(XDestroyWindowEvent);
+
+		case GraphicsExpose:
+			return sizeof(XGraphicsExposeEvent);
+
+		case MapNotify:
+			return sizeof(XMapEvent);
+
+		case NoExpose:
+			return sizeof(XNoExposeEvent);
+
+		case PropertyNotify:
+			return sizeof(XPropertyEvent);
+
+		case ReparentNotify:
+			return sizeof(XReparentEvent);
+
+		case UnmapNotify:
+			return sizeof(XUnmapEvent);
+
+		default:
+
+			if (event.type == ShapeNotify + shape_event_base) {
+				return sizeof(XShapeEvent);
+			}
+
+			if (event.type == XDamageNotify + damage_event_base) {
+				return sizeof(XDamageNotifyEvent);
+			}
+
+			return sizeof(XAnyEvent);
+	}
+}
+
+
+} // namespace EventRecording
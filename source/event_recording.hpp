@@ -0,0 +1,150 @@
+#ifndef ORTLE_EVENT_RECORDING_HPP
+#define ORTLE_EVENT_RECORDING_HPP
+
+
+#include "exceptions.hpp"
+
+#include <X11/Xlib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+
+
+
+// the file format shared by EventRecorder and EventPlayer.  a recording is a
+// Header followed by records, each a Kind byte and then:
+//
+//   Event  the time (nanoseconds since recording began, 8 bytes), the size
+//          of the event (4 bytes) and the event as Xlib handed it over,
+//          only as far as its type's structure goes
+//   Reply  the Call (1 byte), the size of the reply (4 bytes) and the reply
+//          (see event_recorder.cpp for what each holds)
+//   Flush  the time.  the event thread flushed held back damage and
+//          published a scene, if anything had changed.
+//
+// replies come in the order the calls were made, between the event whose
+// handling made them and the next.  everything is in the recording
+// machine's byte order and sizes, so a recording is only good on the same
+// kind of machine.
+
+namespace EventRecording {
+
+
+char const magic[8] = { 'O', 'R', 'T', 'L', 'E', 'R', 'E', 'C' };
+
+std::uint32_t const version = 1;
+
+
+struct Header {
+
+	char magic[8];
+	std::uint32_t version;
+
+	// of the screen that was recorded
+
+	std::int32_t screen;
+	std::uint64_t root;
+	std::int32_t width;
+	std::int32_t height;
+
+	// extension events are numbered from these
+
+	std::int32_t shape_event_base;
+	std::int32_t damage_event_base;
+
+};
+
+
+enum Kind : std::uint8_t {
+	Event = 1,
+	Reply = 2,
+	Flush = 3
+};
+
+
+// the calls in X11::Xlib whose results are recorded
+
+enum Call : std::uint8_t {
+	InternAtom = 1,
+	GetWindowAttributes,
+	GetWindowProperty,
+	QueryTree,
+	GetGeometry,
+	TranslateCoordinates,
+	ShapeQueryExtents,
+	ShapeGetRectangles,
+	CompositeNameWindowPixmap
+};
+
+
+// how much of an event is worth keeping: its type's structure, or just
+// XAnyEvent for types window management doesn't handle
+
+std::size_t event_size(XEvent const& event, int shape_event_base, int damage_event_base);
+
+
+template<typename T>
+void put(std::string& buffer, T const& value)
+{
+	buffer.append(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+
+
+
+// reads what put() wrote, throwing RecordingError if there is not enough of
+// it
+
+class Reader {
+
+public:
+
+	Reader(char const* begin, char const* end)
+		: m_position(begin)
+		, m_end(end)
+	{}
+
+
+public:
+
+	template<typename T>
+	T get()
+	{
+		T value;
+		read(&value, sizeof(value));
+		return value;
+	}
+
+
+	void read(void* destination, std::size_t size)
+	{
+		if (static_cast<std::size_t>(m_end - m_position) < size) {
+			throw RecordingError("Recording ends in the middle of a record.");
+		}
+
+		std::memcpy(destination, m_position, size);
+		m_position += size;
+	}
+
+
+	bool empty() const
+	{
+		return m_position == m_end;
+	}
+
+
+private:
+
+	char const* m_position;
+	char const* m_end;
+
+};
+
+
+} // namespace EventRecording
+
+
+#endif
@@ -31,5 +31,18 @@ public:
 };
 
 
+
+
+class RecordingError : public std::runtime_error {
+
+public:
+
+	RecordingError(char const* message)
+		: std::runtime_error(message)
+	{}
+
+};
+
+
 #endif
 
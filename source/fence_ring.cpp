@@ -0,0 +1,156 @@
+#include "fence_ring.hpp"
+
+#include "utility/log.hpp"
+
+#include "x11/exceptions.hpp"
+#include "x11/extension.hpp"
+#include "x11/fence.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
+
+#include <cassert>
+#include <cstddef>
+
+#include <utility>
+#include <vector>
+
+
+
+
+namespace {
+
+
+// the render thread rarely falls more than a scene or two behind, so this
+// many fences are enough that one is almost always free.  when none is, the
+// scene goes without, as it would without fence support at all.
+
+std::size_t const l_fence_count = 4;
+
+
+} // namespace
+
+
+
+
+FenceRing::FenceRing()
+	: m_fences()
+	, m_next(0)
+	, m_last(0)
+	, m_unpublished(false)
+{}
+
+
+FenceRing::FenceRing(Display* display, Window root, bool enabled)
+	: FenceRing()
+{
+	assert(display != nullptr);
+	assert(root != None);
+
+	if (!enabled) {
+		LOG_DEBUG(Glx, "not using x fences: the gl context cannot import them");
+		return;
+	}
+
+	try {
+		X11::Extension sync(display, "SYNC", 3, 1, &XSyncQueryExtension, &XSyncInitialize);
+	}
+	catch (X11::MissingExtension const&) {
+		LOG_DEBUG(Glx, "not using x fences: the server has no SYNC extension");
+		return;
+	}
+	catch (X11::IncompatibleVersion const&) {
+		LOG_DEBUG(Glx, "not using x fences: the server's SYNC extension is too old");
+		return;
+	}
+
+	for (std::size_t i = 0; i < l_fence_count; ++i) {
+		Entry entry = { X11::Fence(display, root), 0, false };
+		m_fences.push_back(std::move(entry));
+	}
+}
+
+
+
+
+FenceRing::FenceRing(FenceRing&& other)
+	: FenceRing()
+{
+	swap(*this, other);
+}
+
+
+FenceRing& FenceRing::operator=(FenceRing&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+FenceRing::~FenceRing()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(FenceRing& first, FenceRing& second)
+{
+	using std::swap;
+
+	swap(first.m_fences, second.m_fences);
+	swap(first.m_next, second.m_next);
+	swap(first.m_last, second.m_last);
+	swap(first.m_unpublished, second.m_unpublished);
+}
+
+
+
+
+XSyncFence FenceRing::trigger(unsigned long acknowledged)
+{
+	if (m_fences.empty()) {
+		return None;
+	}
+
+	Entry& entry = m_fences[m_next];
+
+
+	// the render thread is done with a fence once it has acknowledged a later
+	// scene than the one that carried it: it only does that once the GPU has
+	// actually waited on the fence, rather than just been told to.  resetting
+	// it any earlier could leave the GPU waiting on a fence that is not
+	// triggered again until the next batch of events.
+
+	if (entry.triggered) {
+
+		if (acknowledged <= entry.serial) {
+			LOG_DEBUG(Glx, "no free x fence, render thread is behind at", acknowledged);
+			return None;
+		}
+
+		entry.fence.reset();
+	}
+
+	entry.fence.trigger();
+	entry.triggered = true;
+
+	m_last = m_next;
+	m_unpublished = true;
+
+	m_next = (m_next + 1) % m_fences.size();
+
+	return entry.fence;
+}
+
+
+void FenceRing::published(unsigned long serial)
+{
+	if (m_unpublished) {
+		m_fences[m_last].serial = serial;
+		m_unpublished = false;
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef ORTLE_FENCE_RING_HPP
+#define ORTLE_FENCE_RING_HPP
+
+
+#include "x11/fence.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
+
+#include <cstddef>
+#include <vector>
+
+
+
+
+// the X fences the event thread triggers after each batch of events, so that
+// the render thread can have the GPU wait for the server to finish drawing
+// into window pixmaps before sampling them (see Renderer::render), rather
+// than relying on the driver to order the two.  a fence travels with the
+// scene it was triggered for, and is only reset and triggered again once the
+// render thread has acknowledged a later scene, which it does only once the
+// GPU has got past its wait on the fence (see Renderer::settled).
+
+class FenceRing {
+
+public:
+
+	FenceRing();
+
+	// an empty ring, which never hands out a fence, unless enabled is true
+	// and the server supports fences (SYNC 3.1).
+
+	FenceRing(Display* display, Window root, bool enabled);
+
+	FenceRing(FenceRing&& other);
+	FenceRing& operator=(FenceRing&& other);
+
+	~FenceRing();
+
+	friend void swap(FenceRing& first, FenceRing& second);
+
+
+public:
+
+	// triggers the next fence, unless the render thread may still be waiting
+	// on it, and returns it.  returns None if there is no fence to trigger.
+
+	XSyncFence trigger(unsigned long acknowledged);
+
+	// tags the fence last triggered with the serial of the scene that
+	// carries it.
+
+	void published(unsigned long serial);
+
+
+private:
+
+	struct Entry {
+		X11::Fence fence;
+		unsigned long serial;
+		bool triggered;
+	};
+
+
+private:
+
+	std::vector<Entry> m_fences;
+
+	std::size_t m_next;
+
+	// the fence triggered for the scene about to be published, if any
+
+	std::size_t m_last;
+	bool m_unpublished;
+
+};
+
+
+#endif
@@ -0,0 +1,354 @@
+#include "frame_governor.hpp"
+
+#include "renderer.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/query.hpp"
+
+#include "utility/log.hpp"
+
+#include <cmath>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+
+
+namespace {
+
+
+// enough queries in flight that the oldest has always finished by the time
+// it is read back
+
+std::size_t const l_query_count = 4;
+
+
+// until the retrace counter says otherwise
+
+double const l_default_budget = 1.0 / 60.0;
+
+
+// the weight of each frame in the running average of frame costs
+
+double const l_smoothing = 0.1;
+
+
+// stepping down has to happen quickly, or frames keep being dropped.
+// stepping up waits until the average has been well under budget for a
+// few seconds, so that the governor doesn't go back and forth.
+
+unsigned int const l_step_down_frames = 10;
+unsigned int const l_step_up_frames = 180;
+
+
+// after a step, frames are not judged until those timed before it have all
+// been read back (one per query), and for as long again as a change takes
+// to work its way through the running average (1 / l_smoothing).  the
+// average then starts over from the latest frame.
+
+unsigned int const l_settle_frames = l_query_count + 10;
+
+double const l_step_up_ratio = 0.6;
+
+
+// the refresh period is measured over this many retraces
+
+unsigned int const l_refresh_retraces = 120;
+
+double const l_shortest_period = 1.0 / 500.0;
+double const l_longest_period = 1.0 / 20.0;
+
+
+// more steps than any animation has, so that it ends on the next frame
+
+int const l_skipped_animation_steps = 1000;
+
+
+char const* level_name(FrameGovernor::Level level)
+{
+	switch (level) {
+		case FrameGovernor::Full: return "full";
+		case FrameGovernor::NoShadows: return "no shadows";
+		case FrameGovernor::FastAnimations: return "fast animations";
+		case FrameGovernor::NoAnimations: return "no animations";
+		case FrameGovernor::SlowBackground: return "slow background";
+	}
+
+	return "unknown";
+}
+
+
+} // namespace
+
+
+
+
+FrameGovernor::FrameGovernor()
+	: m_queries()
+	, m_query(0)
+	, m_pending(0)
+	, m_timing_gpu(false)
+	, m_frame_start()
+	, m_cpu_time(0.0)
+	, m_gpu_time(0.0)
+	, m_cost(0.0)
+	, m_budget(l_default_budget)
+	, m_refresh_start()
+	, m_refresh_retrace(0)
+	, m_refresh_started(false)
+	, m_level(Full)
+	, m_over_frames(0)
+	, m_under_frames(0)
+	, m_settling(0)
+{}
+
+
+
+
+FrameGovernor::FrameGovernor(FrameGovernor&& other)
+	: m_queries()
+	, m_query(0)
+	, m_pending(0)
+	, m_timing_gpu(false)
+	, m_frame_start()
+	, m_cpu_time(0.0)
+	, m_gpu_time(0.0)
+	, m_cost(0.0)
+	, m_budget(l_default_budget)
+	, m_refresh_start()
+	, m_refresh_retrace(0)
+	, m_refresh_started(false)
+	, m_level(Full)
+	, m_over_frames(0)
+	, m_under_frames(0)
+	, m_settling(0)
+{
+	swap(*this, other);
+}
+
+
+FrameGovernor& FrameGovernor::operator=(FrameGovernor&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+FrameGovernor::~FrameGovernor()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(FrameGovernor& first, FrameGovernor& second)
+{
+	using std::swap;
+
+	swap(first.m_queries, second.m_queries);
+	swap(first.m_query, second.m_query);
+	swap(first.m_pending, second.m_pending);
+	swap(first.m_timing_gpu, second.m_timing_gpu);
+	swap(first.m_frame_start, second.m_frame_start);
+	swap(first.m_cpu_time, second.m_cpu_time);
+	swap(first.m_gpu_time, second.m_gpu_time);
+	swap(first.m_cost, second.m_cost);
+	swap(first.m_budget, second.m_budget);
+	swap(first.m_refresh_start, second.m_refresh_start);
+	swap(first.m_refresh_retrace, second.m_refresh_retrace);
+	swap(first.m_refresh_started, second.m_refresh_started);
+	swap(first.m_level, second.m_level);
+	swap(first.m_over_frames, second.m_over_frames);
+	swap(first.m_under_frames, second.m_under_frames);
+	swap(first.m_settling, second.m_settling);
+}
+
+
+
+
+unsigned int const FrameGovernor::settle_frames = l_settle_frames;
+
+
+
+
+void FrameGovernor::begin_frame()
+{
+	m_frame_start = Clock::now();
+
+	// the queries are made here rather than in the constructor, where there
+	// may not be a current context
+
+	if (m_queries.empty()) {
+		for (std::size_t i = 0; i < l_query_count; ++i) {
+			m_queries.push_back(OpenGL::Query());
+		}
+	}
+
+
+	// if every query is still waiting to be read back, this frame goes
+	// untimed on the GPU rather than waiting for one.
+
+	m_timing_gpu = (m_pending < m_queries.size());
+
+	if (m_timing_gpu) {
+		gl::BeginQuery(gl::TIME_ELAPSED, m_queries[m_query]);
+	}
+}
+
+
+bool FrameGovernor::end_frame()
+{
+	if (m_timing_gpu) {
+		gl::EndQuery(gl::TIME_ELAPSED);
+		m_query = (m_query + 1) % m_queries.size();
+		++m_pending;
+	}
+
+	m_cpu_time = std::chrono::duration<double>(Clock::now() - m_frame_start).count();
+
+	collect_gpu_time();
+
+
+	// the CPU and GPU work overlap, so a frame costs as much as the slower of
+	// the two.
+
+	return observe(std::max(m_cpu_time, m_gpu_time));
+}
+
+
+bool FrameGovernor::observe(double cost)
+{
+	if (m_settling > 0) {
+		--m_settling;
+		m_cost = cost;
+		return false;
+	}
+
+	m_cost += l_smoothing * (cost - m_cost);
+
+	m_over_frames = (m_cost > m_budget ? m_over_frames + 1 : 0);
+	m_under_frames = (m_cost < m_budget * l_step_up_ratio ? m_under_frames + 1 : 0);
+
+	if (m_over_frames >= l_step_down_frames && m_level < SlowBackground) {
+		step(1);
+		return true;
+	}
+
+	if (m_under_frames >= l_step_up_frames && m_level > Full) {
+		step(-1);
+		return true;
+	}
+
+	return false;
+}
+
+
+void FrameGovernor::retraced(unsigned int retrace)
+{
+	Clock::time_point now = Clock::now();
+
+	if (!m_refresh_started) {
+		m_refresh_start = now;
+		m_refresh_retrace = retrace;
+		m_refresh_started = true;
+		return;
+	}
+
+	unsigned int retraces = retrace - m_refresh_retrace;
+
+	if (retraces < l_refresh_retraces) {
+		return;
+	}
+
+	double period = std::chrono::duration<double>(now - m_refresh_start).count() / retraces;
+
+
+	// the counter may stop while the monitors are off, or the render thread
+	// may have been suspended.  anything outside sensible refresh rates is
+	// not a measurement.
+
+	if (period < l_shortest_period || period > l_longest_period) {
+		m_refresh_start = now;
+		m_refresh_retrace = retrace;
+		return;
+	}
+
+	if (std::fabs(period - m_budget) > m_budget * 0.05) {
+		LOG_DEBUG(Render, "frame budget", m_budget * 1000.0, "ms ->", period * 1000.0, "ms");
+	}
+
+	m_budget = period;
+
+	m_refresh_start = now;
+	m_refresh_retrace = retrace;
+}
+
+
+void FrameGovernor::apply(Renderer& renderer) const
+{
+	renderer.set_shadows(m_level < NoShadows);
+
+	if (m_level >= NoAnimations) {
+		renderer.set_animation_steps(l_skipped_animation_steps);
+	}
+	else if (m_level >= FastAnimations) {
+		renderer.set_animation_steps(2);
+	}
+	else {
+		renderer.set_animation_steps(1);
+	}
+
+	renderer.set_background_interval(m_level >= SlowBackground ? 2 : 1);
+}
+
+
+
+
+void FrameGovernor::collect_gpu_time()
+{
+	// queries finish in the order they were issued, so read them back oldest
+	// first and stop at the first that isn't ready.
+
+	while (m_pending > 0) {
+
+		GLuint query = m_queries[(m_query + m_queries.size() - m_pending) % m_queries.size()];
+
+		GLuint available = gl::FALSE_;
+		gl::GetQueryObjectuiv(query, gl::QUERY_RESULT_AVAILABLE, &available);
+
+		if (available == gl::FALSE_) {
+			break;
+		}
+
+		GLuint64 nanoseconds = 0;
+		gl::GetQueryObjectui64v(query, gl::QUERY_RESULT, &nanoseconds);
+
+		m_gpu_time = static_cast<double>(nanoseconds) * 1e-9;
+
+		--m_pending;
+	}
+}
+
+
+void FrameGovernor::step(int direction)
+{
+	Level level = static_cast<Level>(m_level + direction);
+
+	// transitions are rare, and worth knowing about in release builds too
+
+	LOG_INFO(Render, "frame governor", level_name(m_level), "->", level_name(level), m_cost * 1000.0, "ms per frame, budget", m_budget * 1000.0, "ms");
+
+	m_level = level;
+
+	m_over_frames = 0;
+	m_under_frames = 0;
+
+	m_settling = l_settle_frames;
+}
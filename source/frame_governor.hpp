@@ -0,0 +1,152 @@
+#ifndef ORTLE_FRAME_GOVERNOR_HPP
+#define ORTLE_FRAME_GOVERNOR_HPP
+
+
+#include "opengl/core330.hpp"
+#include "opengl/query.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+
+
+
+class Renderer;
+
+
+// keeps frames within the refresh period by shedding effects when they take
+// too long.  it measures each frame's CPU time, and its GPU time with timer
+// queries (read back a few frames later, so it never stalls), and when the
+// slower of the two stays over budget it steps down one level:
+//
+//   full quality
+//   -> no shadows
+//   -> animations at double speed
+//   -> no animations
+//   -> windows below the top one redrawn every other frame
+//
+// it steps back up once frames have been comfortably under budget for a
+// while.  after each step it lets settle_frames frames go by unjudged, so
+// that a new level is only judged on frames drawn at it.  render thread
+// only.
+
+class FrameGovernor {
+
+public:
+
+	enum Level {
+		Full,
+		NoShadows,
+		FastAnimations,
+		NoAnimations,
+		SlowBackground
+	};
+
+
+public:
+
+	FrameGovernor();
+
+	FrameGovernor(FrameGovernor&& other);
+	FrameGovernor& operator=(FrameGovernor&& other);
+
+	~FrameGovernor();
+
+	friend void swap(FrameGovernor& first, FrameGovernor& second);
+
+
+public:
+
+	// bracket everything drawn for a frame, up to but not including the
+	// buffer swap.  end_frame() returns true if the level changed, in which
+	// case apply() should be called.
+
+	void begin_frame();
+	bool end_frame();
+
+	// for frames timed some other way (see benchmark/frame_governor.cpp),
+	// instead of begin_frame() and end_frame(): takes what a frame cost, in
+	// seconds, and returns the same as end_frame().
+
+	bool observe(double cost);
+
+	// how many frames go unjudged after each step
+
+	static unsigned int const settle_frames;
+
+	// the retrace counter after each swap, from which the refresh period
+	// (and so the budget) is worked out.  without it, 60 Hz is assumed.
+
+	void retraced(unsigned int retrace);
+
+	void apply(Renderer& renderer) const;
+
+
+public:
+
+	Level level() const
+	{
+		return m_level;
+	}
+
+	// one refresh period, in seconds
+
+	double budget() const
+	{
+		return m_budget;
+	}
+
+	// whether the last frame on its own took longer than the budget.  its GPU
+	// time is only known a few frames later, so that is the latest measured.
+
+	bool over_budget() const
+	{
+		return m_cpu_time > m_budget || m_gpu_time > m_budget;
+	}
+
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	void collect_gpu_time();
+	void step(int direction);
+
+
+private:
+
+	// a ring of timer queries.  m_query is the next one to begin, and
+	// m_pending counts those ended but not yet read back.
+
+	std::vector<OpenGL::Query> m_queries;
+	std::size_t m_query;
+	std::size_t m_pending;
+	bool m_timing_gpu;
+
+	Clock::time_point m_frame_start;
+
+	double m_cpu_time;
+	double m_gpu_time;
+	double m_cost;
+
+	// the refresh period, and where the current measurement of it started
+
+	double m_budget;
+	Clock::time_point m_refresh_start;
+	unsigned int m_refresh_retrace;
+	bool m_refresh_started;
+
+	Level m_level;
+
+	unsigned int m_over_frames;
+	unsigned int m_under_frames;
+
+	// frames still to go unjudged since the last step
+
+	unsigned int m_settling;
+
+};
+
+
+#endif
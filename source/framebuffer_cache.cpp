@@ -4,7 +4,7 @@
 
 #include "opengl/core330.hpp"
 
-#include "utility/trace.hpp"
+#include "utility/log.hpp"
 
 #include "x11/visual_info.hpp"
 
@@ -14,35 +14,38 @@
 #include <GL/glx.h>
 
 #include <cassert>
+#include <cstddef>
 
 #include <map>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 
 
 
-FramebufferCache::FramebufferCache(Display* display, int screen)
+FramebufferCache::FramebufferCache(Display* display)
 	: m_display(display)
-	, m_screen(screen)
-	, m_framebuffers(nullptr)
-	, m_count(0)
-	, m_table()
+	, m_screens()
+	, m_mutex()
 {
 	assert(display != nullptr);
-	assert(screen >= 0);
 
 
-	TRACE("loading glx framebuffer configurations");
+	LOG_DEBUG(Glx, "loading glx framebuffer configurations");
 
-	int count = 0;
-	GLXFBConfig* framebuffers = glXGetFBConfigs(display, screen, &count);
+	for (int screen = 0; screen < XScreenCount(display); ++screen) {
 
-	if (!framebuffers) {
-		throw InitializationError("Could not query available framebuffers.");
-	}
+		int count = 0;
+		GLXFBConfig* framebuffers = glXGetFBConfigs(display, screen, &count);
+
+		if (!framebuffers) {
+			throw InitializationError("Could not query available framebuffers.");
+		}
 
-	m_framebuffers = framebuffers;
-	m_count = count;
+		Screen entry = { framebuffers, count, Table() };
+		m_screens.push_back(entry);
+	}
 }
 
 
@@ -50,10 +53,8 @@ FramebufferCache::FramebufferCache(Display* display, int screen)
 
 FramebufferCache::FramebufferCache(FramebufferCache&& other)
 	: m_display(nullptr)
-	, m_screen(0)
-	, m_framebuffers(nullptr)
-	, m_count(0)
-	, m_table()
+	, m_screens()
+	, m_mutex()
 {
 	swap(*this, other);
 }
@@ -70,8 +71,8 @@ FramebufferCache& FramebufferCache::operator=(FramebufferCache&& other)
 
 FramebufferCache::~FramebufferCache()
 {
-	if (m_framebuffers != nullptr) {
-		XFree(m_framebuffers);
+	for (auto& screen : m_screens) {
+		XFree(screen.framebuffers);
 	}
 }
 
@@ -83,17 +84,20 @@ void swap(FramebufferCache& first, FramebufferCache& second)
 	using std::swap;
 
 	swap(first.m_display, second.m_display);
-	swap(first.m_screen, second.m_screen);
-	swap(first.m_framebuffers, second.m_framebuffers);
-	swap(first.m_count, second.m_count);
-	swap(first.m_table, second.m_table);
+	swap(first.m_screens, second.m_screens);
 }
 
 
 
 
-GLXFBConfig FramebufferCache::choose(int const* attributes)
+GLXFBConfig FramebufferCache::choose(int screen, int const* attributes)
 {
+	assert(screen >= 0 && static_cast<std::size_t>(screen) < m_screens.size());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Table& table = m_screens[screen].table;
+
 	// this requests a new list rather than use our cached one because it is
 	// easier to use glXChooseFBConfig than to duplicate whatever algorithm it
 	// uses.  any performance hit is probably negligible.
@@ -101,7 +105,7 @@ GLXFBConfig FramebufferCache::choose(int const* attributes)
 	GLXFBConfig result = nullptr;
 
 	int count;
-	GLXFBConfig* framebuffers = glXChooseFBConfig(m_display, m_screen, attributes, &count);
+	GLXFBConfig* framebuffers = glXChooseFBConfig(m_display, screen, attributes, &count);
 
 	if (framebuffers != nullptr) {
 
@@ -113,11 +117,11 @@ GLXFBConfig FramebufferCache::choose(int const* attributes)
 
 				// add this framebuffer to the table if it's not there already
 
-				if (m_table.find(info->visualid) == m_table.end()) {
-					m_table.emplace(info->visualid, framebuffers[i]);
+				if (table.find(info->visualid) == table.end()) {
+					table.emplace(info->visualid, framebuffers[i]);
 				}
 
-				TRACE("choosing framebuffer with visual", info->visualid);
+				LOG_DEBUG(Glx, "choosing framebuffer with visual", info->visualid);
 
 				result = framebuffers[i];
 				break;
@@ -143,25 +147,34 @@ GLXFBConfig FramebufferCache::choose(int const* attributes)
 }
 
 
-GLXFBConfig FramebufferCache::find(VisualID visual_id, int depth)
+GLXFBConfig FramebufferCache::find(int screen, VisualID visual_id, int depth)
 {
+	assert(screen >= 0 && static_cast<std::size_t>(screen) < m_screens.size());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Table& table = m_screens[screen].table;
+
+	GLXFBConfig* framebuffers = m_screens[screen].framebuffers;
+	int count = m_screens[screen].count;
+
 	GLXFBConfig result = nullptr;
 
 	// check if we already know this visual id
 
-	auto framebuffer = m_table.find(visual_id);
+	auto framebuffer = table.find(visual_id);
 
-	if (framebuffer != m_table.end()) {
+	if (framebuffer != table.end()) {
 		result = framebuffer->second;
 	}
 
 	else {
 
-		for (int i = 0; i < m_count; ++i) {
+		for (int i = 0; i < count; ++i) {
 
 			try {
 
-				X11::VisualInfo info(m_display, m_framebuffers[i]);
+				X11::VisualInfo info(m_display, framebuffers[i]);
 
 				int bind_targets = 0;
 				int rgb = False;
@@ -170,11 +183,11 @@ GLXFBConfig FramebufferCache::find(VisualID visual_id, int depth)
 				int alpha_depth = 0;
 
 
-				glXGetFBConfigAttrib(m_display, m_framebuffers[i], GLX_BIND_TO_TEXTURE_TARGETS_EXT, &bind_targets);
-				glXGetFBConfigAttrib(m_display, m_framebuffers[i], GLX_BIND_TO_TEXTURE_RGB_EXT, &rgb);
-				glXGetFBConfigAttrib(m_display, m_framebuffers[i], GLX_BIND_TO_TEXTURE_RGBA_EXT, &rgba);
-				glXGetFBConfigAttrib(m_display, m_framebuffers[i], GLX_BUFFER_SIZE, &total_depth);
-				glXGetFBConfigAttrib(m_display, m_framebuffers[i], GLX_ALPHA_SIZE, &alpha_depth);
+				glXGetFBConfigAttrib(m_display, framebuffers[i], GLX_BIND_TO_TEXTURE_TARGETS_EXT, &bind_targets);
+				glXGetFBConfigAttrib(m_display, framebuffers[i], GLX_BIND_TO_TEXTURE_RGB_EXT, &rgb);
+				glXGetFBConfigAttrib(m_display, framebuffers[i], GLX_BIND_TO_TEXTURE_RGBA_EXT, &rgba);
+				glXGetFBConfigAttrib(m_display, framebuffers[i], GLX_BUFFER_SIZE, &total_depth);
+				glXGetFBConfigAttrib(m_display, framebuffers[i], GLX_ALPHA_SIZE, &alpha_depth);
 
 				// first check: can we bind this to an rgb/rgba 2d texture?
 
@@ -208,12 +221,12 @@ GLXFBConfig FramebufferCache::find(VisualID visual_id, int depth)
 					if (depth == info->depth && depth == total_depth) {
 
 						if (depth >= 32 && rgba) {
-							result = m_framebuffers[i];
+							result = framebuffers[i];
 							break;
 						}
 
 						else if (result == nullptr) {
-							result = m_framebuffers[i];
+							result = framebuffers[i];
 						}
 					}
 				}
@@ -227,7 +240,7 @@ GLXFBConfig FramebufferCache::find(VisualID visual_id, int depth)
 		}
 
 		if (result) {
-			m_table.emplace(visual_id, result);
+			table.emplace(visual_id, result);
 		}
 	}
 
@@ -235,7 +248,7 @@ GLXFBConfig FramebufferCache::find(VisualID visual_id, int depth)
 		return result;
 	}
 	else {
-		TRACE(visual_id, depth);
+		LOG_DEBUG(Glx, visual_id, depth);
 		throw FramebufferError("Compatible framebuffer could not be found.");
 	}
 }
@@ -9,15 +9,23 @@
 #include <GL/glx.h>
 
 #include <map>
+#include <mutex>
+#include <vector>
 
 
 
 
+// the GLX framebuffer configurations of every screen of a display, and the
+// ones chosen for each visual so far.  one cache is shared by the
+// compositors of all the screens, whose render threads look visuals up
+// concurrently; the lists themselves never change after construction, and a
+// lock guards the table of visuals.
+
 class FramebufferCache {
 
 public:
 
-	FramebufferCache(Display* display, int screen);
+	explicit FramebufferCache(Display* display);
 
 	FramebufferCache(FramebufferCache&& other);
 	FramebufferCache& operator=(FramebufferCache&& other);
@@ -29,23 +37,33 @@ public:
 
 public:
 
-	GLXFBConfig choose(int const* attributes);
+	GLXFBConfig choose(int screen, int const* attributes);
 
-	GLXFBConfig find(VisualID visual_id, int depth);
+	GLXFBConfig find(int screen, VisualID visual_id, int depth);
 
 
 private:
 
 	using Table = std::map<VisualID, GLXFBConfig>;
 
+	struct Screen {
+
+		GLXFBConfig* framebuffers;
+		int count;
+
+		Table table;
+
+	};
+
 
 private:
 
 	Display* m_display;
-	int m_screen;
-	GLXFBConfig* m_framebuffers;
-	int m_count;
-	Table m_table;
+	std::vector<Screen> m_screens;
+
+	// not moved or swapped
+
+	std::mutex m_mutex;
 
 };
 
@@ -26,6 +26,11 @@ Context::Context()
 
 
 Context::Context(::Display* display, ::GLXFBConfig framebuffer, int const* attributes)
+	: Context(display, framebuffer, NULL, attributes)
+{}
+
+
+Context::Context(::Display* display, ::GLXFBConfig framebuffer, ::GLXContext share, int const* attributes)
 	: m_display(display)
 	, m_glx_context(nullptr)
 {
@@ -34,7 +39,7 @@ Context::Context(::Display* display, ::GLXFBConfig framebuffer, int const* attri
 	assert(CreateContextAttribsARB != nullptr);
 
 
-	::GLXContext glx_context = CreateContextAttribsARB(display, framebuffer, NULL, True, attributes);
+	::GLXContext glx_context = CreateContextAttribsARB(display, framebuffer, share, True, attributes);
 
 	if (!glx_context) {
 		throw InitializationError("Could not create a new glX Context.");
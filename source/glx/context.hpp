@@ -21,6 +21,10 @@ public:
 	Context();
 	Context(::Display* display, ::GLXFBConfig framebuffer, int const* attributes);
 
+	// a context that shares textures, buffers and the like with the given one
+
+	Context(::Display* display, ::GLXFBConfig framebuffer, ::GLXContext share, int const* attributes);
+
 	Context(Context&& other);
 	Context& operator=(Context&& other);
 
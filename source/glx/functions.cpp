@@ -9,6 +9,7 @@
 #include <GL/glx.h>
 
 #include <cassert>
+#include <cstdint>
 
 
 
@@ -50,6 +51,34 @@ WaitVideoSyncSGI_sig WaitVideoSyncSGI = nullptr;
 
 
 
+using GetSyncValuesOML_sig = Bool (*)(::Display*, ::GLXDrawable, int64_t*, int64_t*, int64_t*);
+GetSyncValuesOML_sig GetSyncValuesOML = nullptr;
+
+
+using GetMscRateOML_sig = Bool (*)(::Display*, ::GLXDrawable, int32_t*, int32_t*);
+GetMscRateOML_sig GetMscRateOML = nullptr;
+
+
+using SwapBuffersMscOML_sig = int64_t (*)(::Display*, ::GLXDrawable, int64_t, int64_t, int64_t);
+SwapBuffersMscOML_sig SwapBuffersMscOML = nullptr;
+
+
+using WaitForMscOML_sig = Bool (*)(::Display*, ::GLXDrawable, int64_t, int64_t, int64_t, int64_t*, int64_t*, int64_t*);
+WaitForMscOML_sig WaitForMscOML = nullptr;
+
+
+
+
+using ImportSyncEXT_sig = GLsync (*)(GLenum, GLintptr, GLbitfield);
+ImportSyncEXT_sig ImportSyncEXT = nullptr;
+
+
+using DebugMessageCallback_sig = void (*)(GLDEBUGPROC, void const*);
+DebugMessageCallback_sig DebugMessageCallback = nullptr;
+
+
+
+
 void load_functions()
 {
 	if (CreateContextAttribsARB == nullptr) {
@@ -103,6 +132,31 @@ void load_functions()
 			// throw GLX::InitializationError("Failed to load glXWaitVideoSyncSGI.");
 		}
 	}
+
+
+	if (GetSyncValuesOML == nullptr) {
+
+		GetSyncValuesOML = reinterpret_cast<GetSyncValuesOML_sig>(glXGetProcAddress(reinterpret_cast<GLubyte const*>("glXGetSyncValuesOML")));
+		GetMscRateOML = reinterpret_cast<GetMscRateOML_sig>(glXGetProcAddress(reinterpret_cast<GLubyte const*>("glXGetMscRateOML")));
+		SwapBuffersMscOML = reinterpret_cast<SwapBuffersMscOML_sig>(glXGetProcAddress(reinterpret_cast<GLubyte const*>("glXSwapBuffersMscOML")));
+		WaitForMscOML = reinterpret_cast<WaitForMscOML_sig>(glXGetProcAddress(reinterpret_cast<GLubyte const*>("glXWaitForMscOML")));
+
+		if (!GetSyncValuesOML || !GetMscRateOML || !SwapBuffersMscOML || !WaitForMscOML) {
+			GetSyncValuesOML = nullptr;
+			GetMscRateOML = nullptr;
+			SwapBuffersMscOML = nullptr;
+			WaitForMscOML = nullptr;
+		}
+	}
+
+
+	if (ImportSyncEXT == nullptr) {
+		ImportSyncEXT = reinterpret_cast<ImportSyncEXT_sig>(glXGetProcAddress(reinterpret_cast<GLubyte const*>("glImportSyncEXT")));
+	}
+
+	if (DebugMessageCallback == nullptr) {
+		DebugMessageCallback = reinterpret_cast<DebugMessageCallback_sig>(glXGetProcAddress(reinterpret_cast<GLubyte const*>("glDebugMessageCallback")));
+	}
 }
 
 
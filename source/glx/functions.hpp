@@ -8,6 +8,8 @@
 
 #include <GL/glx.h>
 
+#include <cstdint>
+
 
 
 
@@ -24,6 +26,25 @@ extern int (*SwapIntervalMESA)(int);
 extern int (*GetVideoSyncSGI)(unsigned int*);
 extern int (*WaitVideoSyncSGI)(int, int, unsigned int*);
 
+// GLX_OML_sync_control, which counts retraces per drawable (and so per
+// monitor) rather than for the whole screen.  all or none are loaded.
+
+extern Bool (*GetSyncValuesOML)(::Display*, ::GLXDrawable, int64_t*, int64_t*, int64_t*);
+extern Bool (*GetMscRateOML)(::Display*, ::GLXDrawable, int32_t*, int32_t*);
+extern int64_t (*SwapBuffersMscOML)(::Display*, ::GLXDrawable, int64_t, int64_t, int64_t);
+extern Bool (*WaitForMscOML)(::Display*, ::GLXDrawable, int64_t, int64_t, int64_t, int64_t*, int64_t*, int64_t*);
+
+// GL_EXT_x11_sync_object is an OpenGL extension, but as it ties GL to the X
+// server it is loaded along with these.  the context still has to list it
+// before it may be used.
+
+extern GLsync (*ImportSyncEXT)(GLenum, GLintptr, GLbitfield);
+
+// the same goes for GL_KHR_debug's glDebugMessageCallback, which debug
+// builds use to hear about errors (see OpenGL::enable_debug_output).
+
+extern void (*DebugMessageCallback)(GLDEBUGPROC, void const*);
+
 
 void load_functions();
 
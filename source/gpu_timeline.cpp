@@ -0,0 +1,195 @@
+#include "gpu_timeline.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/query.hpp"
+
+#include "utility/log.hpp"
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <vector>
+
+
+
+
+namespace {
+
+
+// frames in flight.  as with the FrameGovernor, enough that the oldest has
+// always finished by the time it is read back.
+
+std::size_t const l_frame_count = 4;
+
+
+} // namespace
+
+
+
+
+GpuTimeline::GpuTimeline(std::size_t phase_count)
+	: m_phase_count(phase_count)
+	, m_supported(false)
+	, m_frames(l_frame_count)
+	, m_current(0)
+	, m_result()
+	, m_valid(false)
+{
+	// timestamps are part of GL 3.3, but an implementation may still have
+	// no counter behind them
+
+	GLint bits = 0;
+	gl::GetQueryiv(gl::TIMESTAMP, gl::QUERY_COUNTER_BITS, &bits);
+
+	m_supported = (bits > 0);
+
+	if (!m_supported) {
+		LOG_INFO(Render, "no GPU timestamps, GPU times are not measured");
+	}
+
+	for (auto& frame : m_frames) {
+		frame.used = 0;
+		frame.pending = false;
+	}
+
+	m_result.totals.assign(m_phase_count, 0.0);
+	m_result.slowest_times.assign(m_phase_count, 0.0);
+	m_result.slowest_ids.assign(m_phase_count, 0);
+}
+
+
+
+
+GpuTimeline::~GpuTimeline()
+{
+	// nothing to do
+}
+
+
+
+
+void GpuTimeline::next_frame()
+{
+	if (!m_supported) {
+		return;
+	}
+
+	m_frames[m_current].pending = !m_frames[m_current].spans.empty();
+
+	m_current = (m_current + 1) % m_frames.size();
+
+
+	// the slot about to be reused holds the oldest frame
+
+	Frame& frame = m_frames[m_current];
+
+	if (frame.pending) {
+		collect(frame);
+	}
+
+	frame.used = 0;
+	frame.spans.clear();
+	frame.pending = false;
+}
+
+
+std::size_t GpuTimeline::begin(std::size_t phase, unsigned long id)
+{
+	assert(phase < m_phase_count);
+
+	if (!m_supported) {
+		return 0;
+	}
+
+	Frame& frame = m_frames[m_current];
+
+	Span span = { phase, id, stamp(), 0 };
+	frame.spans.push_back(span);
+
+	return frame.spans.size() - 1;
+}
+
+
+void GpuTimeline::end(std::size_t span)
+{
+	if (!m_supported) {
+		return;
+	}
+
+	Frame& frame = m_frames[m_current];
+
+	assert(span < frame.spans.size());
+
+	frame.spans[span].end = stamp();
+}
+
+
+bool GpuTimeline::result(Result& result) const
+{
+	if (!m_valid) {
+		return false;
+	}
+
+	result = m_result;
+	return true;
+}
+
+
+
+
+std::size_t GpuTimeline::stamp()
+{
+	Frame& frame = m_frames[m_current];
+
+	if (frame.used == frame.queries.size()) {
+		frame.queries.push_back(OpenGL::Query());
+	}
+
+	gl::QueryCounter(frame.queries[frame.used], gl::TIMESTAMP);
+
+	return frame.used++;
+}
+
+
+void GpuTimeline::collect(Frame& frame)
+{
+	// queries finish in order, so if the last has, they all have
+
+	GLuint available = gl::FALSE_;
+	gl::GetQueryObjectuiv(frame.queries[frame.used - 1], gl::QUERY_RESULT_AVAILABLE, &available);
+
+	if (available == gl::FALSE_) {
+		return;
+	}
+
+	std::fill(m_result.totals.begin(), m_result.totals.end(), 0.0);
+	std::fill(m_result.slowest_times.begin(), m_result.slowest_times.end(), 0.0);
+	std::fill(m_result.slowest_ids.begin(), m_result.slowest_ids.end(), 0);
+
+	for (auto const& span : frame.spans) {
+
+		// a span begun but never ended is left out
+
+		if (span.end == 0) {
+			continue;
+		}
+
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+
+		gl::GetQueryObjectui64v(frame.queries[span.begin], gl::QUERY_RESULT, &begin);
+		gl::GetQueryObjectui64v(frame.queries[span.end], gl::QUERY_RESULT, &end);
+
+		double time = (end > begin ? static_cast<double>(end - begin) * 1e-9 : 0.0);
+
+		m_result.totals[span.phase] += time;
+
+		if (time > m_result.slowest_times[span.phase]) {
+			m_result.slowest_times[span.phase] = time;
+			m_result.slowest_ids[span.phase] = span.id;
+		}
+	}
+
+	m_valid = true;
+}
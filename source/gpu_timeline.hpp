@@ -0,0 +1,107 @@
+#ifndef ORTLE_GPU_TIMELINE_HPP
+#define ORTLE_GPU_TIMELINE_HPP
+
+
+#include "opengl/core330.hpp"
+#include "opengl/query.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+
+
+// times parts of each frame on the GPU.  every span is a pair of timestamp
+// queries (GL_TIMESTAMP, rather than GL_TIME_ELAPSED, so that spans can nest
+// inside each other and inside the FrameGovernor's query).  a frame's
+// queries are read back a few frames later, once the last of them has
+// finished, so nothing ever waits for the GPU; a frame whose queries are
+// still running when its slot comes round again is dropped.
+//
+// spans are filed under a phase, and carry an id (e.g. a window).  the
+// results are the total time of each phase, and the slowest span of each.
+// render thread only.
+
+class GpuTimeline {
+
+public:
+
+	struct Result {
+
+		// in seconds, for each phase
+
+		std::vector<double> totals;
+
+		std::vector<double> slowest_times;
+		std::vector<unsigned long> slowest_ids;
+
+	};
+
+
+public:
+
+	explicit GpuTimeline(std::size_t phase_count);
+
+	GpuTimeline(GpuTimeline&&) = delete;
+	GpuTimeline& operator=(GpuTimeline&&) = delete;
+
+	~GpuTimeline();
+
+
+public:
+
+	// ends the current frame, reads back the oldest one if it has finished,
+	// and starts the next.
+
+	void next_frame();
+
+	// returns a handle for end()
+
+	std::size_t begin(std::size_t phase, unsigned long id);
+	void end(std::size_t span);
+
+	// the newest frame read back.  false if there isn't one yet, or the
+	// implementation has no timestamps.
+
+	bool result(Result& result) const;
+
+
+private:
+
+	struct Span {
+		std::size_t phase;
+		unsigned long id;
+		std::size_t begin;
+		std::size_t end;
+	};
+
+	struct Frame {
+		std::vector<OpenGL::Query> queries;
+		std::size_t used;
+		std::vector<Span> spans;
+		bool pending;
+	};
+
+
+private:
+
+	std::size_t stamp();
+
+	void collect(Frame& frame);
+
+
+private:
+
+	std::size_t m_phase_count;
+	bool m_supported;
+
+	std::vector<Frame> m_frames;
+	std::size_t m_current;
+
+	Result m_result;
+	bool m_valid;
+
+};
+
+
+#endif
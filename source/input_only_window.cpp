@@ -2,7 +2,7 @@
 
 #include "managed_window.hpp"
 
-#include "utility/trace.hpp"
+#include "utility/log.hpp"
 
 #include <X11/Xlib.h>
 
@@ -14,18 +14,18 @@
 
 
 InputOnlyWindow::InputOnlyWindow(XCreateWindowEvent const& event)
-	: ManagedWindow(event.window)
+	: ManagedWindow(Kind::InputOnlyWindow, event.window)
 {
 	assert(event.window != None);
 
-	TRACE("managing input-only window", event.window);
+	LOG_DEBUG(Events, "managing input-only window", event.window);
 }
 
 
 
 
 InputOnlyWindow::InputOnlyWindow(InputOnlyWindow&& other)
-	: ManagedWindow(None)
+	: ManagedWindow(Kind::InputOnlyWindow, None)
 {
 	swap(*this, other);
 }
@@ -43,7 +43,7 @@ InputOnlyWindow& InputOnlyWindow::operator=(InputOnlyWindow&& other)
 InputOnlyWindow::~InputOnlyWindow()
 {
 	if (*this != None) {
-		TRACE("stopping management of input-only window", *this);
+		LOG_DEBUG(Events, "stopping management of input-only window", static_cast<Window>(*this));
 	}
 }
 
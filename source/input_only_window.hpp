@@ -3,11 +3,11 @@
 
 
 #include "managed_window.hpp"
-#include "renderer.hpp"
+#include "scene.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
-// #include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xdamage.h>
 
 
 
@@ -25,15 +25,17 @@ public:
 
 	friend void swap(InputOnlyWindow& first, InputOnlyWindow& second);
 
+	friend class ManagedWindow;
+
 
 private:
 
 	bool visible_impl() const { return false; }
 
-	void render_impl(Renderer&) {}
+	void describe_impl(Scene&) const {}
 
 	void on_configure_notify_impl(XConfigureEvent const&) {}
-	// void on_damage_notify_impl(XDamageNotifyEvent const&) {}
+	void on_damage_notify_impl(XDamageNotifyEvent const&) {}
 	void on_graphics_expose_impl(XGraphicsExposeEvent const&) {}
 	void on_map_notify_impl(XMapEvent const&) {}
 	void on_no_expose_impl(XNoExposeEvent const&) {}
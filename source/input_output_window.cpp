@@ -1,86 +1,176 @@
 #include "input_output_window.hpp"
 
 #include "exceptions.hpp"
-#include "framebuffer_cache.hpp"
 #include "managed_window.hpp"
-#include "renderer.hpp"
-
-#include "glx/functions.hpp"
-#include "glx/pixmap.hpp"
+#include "pixmap_ledger.hpp"
+#include "scene.hpp"
 
 #include "opengl/core330.hpp"
-#include "opengl/texture.hpp"
 
-#include "utility/trace.hpp"
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
 
+#include "x11/damage.hpp"
 #include "x11/exceptions.hpp"
 #include "x11/geometry.hpp"
 #include "x11/rectangle_list.hpp"
 #include "x11/pixmap.hpp"
+#include "x11/round_trip.hpp"
 #include "x11/shape_extents.hpp"
+#include "x11/xlib.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
 #include <X11/extensions/Xcomposite.h>
-
-#include <GL/glx.h>
+#include <X11/extensions/Xdamage.h>
 
 #include <cassert>
+#include <cstddef>
 
+#include <algorithm>
+#include <tuple>
 #include <utility>
+#include <vector>
+
+
+
+
+namespace {
+
+
+struct Span {
+
+  int x;
+  int y;
+  int width;
+  int height;
+
+};
+
+
+void add_vertex(std::vector<GLfloat>& vertices, int x, int y)
+{
+  GLfloat const vertex[] = {
+    static_cast<GLfloat>(x), static_cast<GLfloat>(y), 0.0f, 1.0f,
+    static_cast<GLfloat>(x), static_cast<GLfloat>(y)
+  };
+
+  vertices.insert(vertices.end(), vertex, vertex + Scene::shape_vertex_size);
+}
+
+
+// reduces the rectangles of a shape to as few as possible, then returns two
+// triangles for each of them.  X hands out bounding shapes in bands, so
+// first the neighbours within each band are joined into spans, then spans
+// that line up across consecutive bands are stacked.  the renderer draws the
+// result with a unit rectangle geometry, so positions and texture
+// coordinates are both plain window coordinates.
+
+std::vector<GLfloat> shape_vertices(XRectangle const* begin, XRectangle const* end)
+{
+  std::vector<Span> spans;
+
+  for (auto it = begin; it != end; ++it) {
+    if (it->width > 0 && it->height > 0) {
+      Span span = { it->x, it->y, it->width, it->height };
+      spans.push_back(span);
+    }
+  }
+
+
+  // join horizontal neighbours in the same band
+
+  std::sort(spans.begin(), spans.end(), [](Span const& a, Span const& b) {
+    return std::tie(a.y, a.height, a.x) < std::tie(b.y, b.height, b.x);
+  });
+
+  std::vector<Span> rows;
+
+  for (auto const& span : spans) {
+    if (!rows.empty()) {
+      Span& last = rows.back();
+      if (last.y == span.y && last.height == span.height && span.x <= last.x + last.width) {
+        last.width = std::max(last.width, span.x + span.width - last.x);
+        continue;
+      }
+    }
+    rows.push_back(span);
+  }
+
+
+  // stack rows with the same horizontal extent that touch vertically
+
+  std::sort(rows.begin(), rows.end(), [](Span const& a, Span const& b) {
+    return std::tie(a.x, a.width, a.y) < std::tie(b.x, b.width, b.y);
+  });
+
+  spans.clear();
+
+  for (auto const& row : rows) {
+    if (!spans.empty()) {
+      Span& last = spans.back();
+      if (last.x == row.x && last.width == row.width && row.y <= last.y + last.height) {
+        last.height = std::max(last.height, row.y + row.height - last.y);
+        continue;
+      }
+    }
+    spans.push_back(row);
+  }
 
-#include <math.h>
 
+  std::vector<GLfloat> vertices;
+  vertices.reserve(spans.size() * 6 * Scene::shape_vertex_size);
 
-const int   animMax = 22; // 15;
-const float animPow = 1.1;
-const float animB   = 0.0;
-const float animC   = 1.0;
-const float animD   = 1.0;
-const float animS   = 1.60158f;
-const float animSB  = 1.1;
+  for (auto const& span : spans) {
 
-const int screenW = 3200;
-const int screenH = 1800;
+    int left = span.x;
+    int top = span.y;
+    int right = span.x + span.width;
+    int bottom = span.y + span.height;
 
+    add_vertex(vertices, left, top);
+    add_vertex(vertices, right, top);
+    add_vertex(vertices, right, bottom);
 
-InputOutputWindow::InputOutputWindow(Display* display, Window root, XCreateWindowEvent const& event, XWindowAttributes const& attributes, FramebufferCache& framebuffers)
-  : ManagedWindow(event.window)
+    add_vertex(vertices, left, top);
+    add_vertex(vertices, right, bottom);
+    add_vertex(vertices, left, bottom);
+  }
+
+  return vertices;
+}
+
+
+} // namespace
+
+
+InputOutputWindow::InputOutputWindow(Display* display, Window root, XCreateWindowEvent const& event, XWindowAttributes const& attributes, PixmapLedger& pixmaps)
+  : ManagedWindow(Kind::InputOutputWindow, event.window)
   , m_display(display)
   , m_root(root)
-  , m_framebuffer(framebuffers.find(XVisualIDFromVisual(attributes.visual), attributes.depth))
+  , m_visual_id(XVisualIDFromVisual(attributes.visual))
+  , m_depth(attributes.depth)
+  , m_damage(display, event.window, XDamageReportNonEmpty)
   , m_pixmap()
-  , m_glx_pixmap()
-  , m_texture()
-  , m_rectangles()
+  , m_pixmaps(&pixmaps)
+  , m_shape_vertices()
+  , m_shape_changes(0)
   , m_x(0)
   , m_y(0)
   , m_width(0)
   , m_height(0)
-  , m_ox(0)
-  , m_oy(0)
-  , m_owidth(0)
-  , m_oheight(0)
-  , m_animStep(animMax)
   , m_border_width(0)
-  , m_rgba(GLX::framebuffer_supports_rgba(display, m_framebuffer))
   , m_shaped(false)
   , m_mapped(false)
-  , m_texture_invalidated(true)
-  // , m_rectangles_invalidated(true)
+  , m_pixmap_stale(false)
 {
   assert(display != nullptr);
   assert(root != None);
   assert(event.window != None);
   assert(event.window != root);
 
-	m_ox      = event.x;
-	m_oy      = event.y;
-	m_owidth  = event.width;
-	m_oheight = event.height;
-
 
-  TRACE("starting management of input/output window", event.window, "visual id", XVisualIDFromVisual(attributes.visual), "depth", attributes.depth);
+  LOG_DEBUG(Events, "starting management of input/output window", event.window, "visual id", m_visual_id, "depth", m_depth);
 
   // during initialization and some ReparentNotify events, a fake
   // XCreateWindowEvent is passed to this function.  in those cases the
@@ -91,7 +181,7 @@ InputOutputWindow::InputOutputWindow(Display* display, Window root, XCreateWindo
   // event.  nothing special needs to be done.
 
   if (event.type == CreateNotify) {
-    TRACE(event.x, event.y, event.width, event.height, event.border_width);
+    LOG_DEBUG(Events, event.x, event.y, event.width, event.height, event.border_width);
     reconfigure(event.x, event.y, event.width, event.height, event.border_width);
   }
 
@@ -107,9 +197,9 @@ InputOutputWindow::InputOutputWindow(Display* display, Window root, XCreateWindo
     X11::ShapeExtents shape_extents(display, event.window);
     if (shape_extents.bounding_shaped == True && shape_extents.bounding_width > 0 && shape_extents.bounding_height > 0) {
       m_shaped = true;
-      update_shape_rectangles();
+      update_shape_vertices();
     }
-    TRACE("reparent", attributes.x, attributes.y, attributes.width, attributes.height, attributes.border_width);
+    LOG_DEBUG(Events, "reparent", attributes.x, attributes.y, attributes.width, attributes.height, attributes.border_width);
     reconfigure(attributes.x, attributes.y, attributes.width, attributes.height, attributes.border_width);
   }
 
@@ -121,10 +211,10 @@ InputOutputWindow::InputOutputWindow(Display* display, Window root, XCreateWindo
     X11::ShapeExtents shape_extents(display, event.window);
     if (shape_extents.bounding_shaped == True && shape_extents.bounding_width > 0 && shape_extents.bounding_height > 0) {
       m_shaped = true;
-      update_shape_rectangles();
+      update_shape_vertices();
     }
 
-    TRACE("init", attributes.x, attributes.y, attributes.width, attributes.height, attributes.border_width);
+    LOG_DEBUG(Events, "init", attributes.x, attributes.y, attributes.width, attributes.height, attributes.border_width);
     reconfigure(attributes.x, attributes.y, attributes.width, attributes.height, attributes.border_width);
 
     if (attributes.map_state == IsViewable) {
@@ -137,29 +227,24 @@ InputOutputWindow::InputOutputWindow(Display* display, Window root, XCreateWindo
 
 
 InputOutputWindow::InputOutputWindow(InputOutputWindow&& other)
-  : ManagedWindow(None)
+  : ManagedWindow(Kind::InputOutputWindow, None)
   , m_display(nullptr)
   , m_root(None)
-  , m_framebuffer(nullptr)
+  , m_visual_id(0)
+  , m_depth(0)
+  , m_damage()
   , m_pixmap()
-  , m_glx_pixmap()
-  , m_texture(0)
-  , m_rectangles()
+  , m_pixmaps(nullptr)
+  , m_shape_vertices()
+  , m_shape_changes(0)
   , m_x(0)
   , m_y(0)
   , m_width(0)
   , m_height(0)
-  , m_ox(0)
-  , m_oy(0)
-  , m_owidth(0)
-  , m_oheight(0)
-  , m_animStep(animMax)
   , m_border_width(0)
-  , m_rgba(false)
   , m_shaped(false)
   , m_mapped(false)
-  , m_texture_invalidated(true)
-  // , m_rectangles_invalidated(true)
+  , m_pixmap_stale(false)
 {
   swap(*this, other);
 }
@@ -178,9 +263,9 @@ InputOutputWindow::~InputOutputWindow()
 {
   if (m_display != nullptr) {
 
-    TRACE("stopping management of window", *this);
+    LOG_DEBUG(Events, "stopping management of window", static_cast<Window>(*this));
 
-    release_and_destroy();
+    release_composite_pixmap();
   }
 }
 
@@ -195,132 +280,57 @@ void swap(InputOutputWindow& first, InputOutputWindow& second)
 
   swap(first.m_display, second.m_display);
   swap(first.m_root, second.m_root);
-  swap(first.m_framebuffer, second.m_framebuffer);
+  swap(first.m_visual_id, second.m_visual_id);
+  swap(first.m_depth, second.m_depth);
+  swap(first.m_damage, second.m_damage);
   swap(first.m_pixmap, second.m_pixmap);
-  swap(first.m_glx_pixmap, second.m_glx_pixmap);
-  swap(first.m_texture, second.m_texture);
-  swap(first.m_rectangles, second.m_rectangles);
+  swap(first.m_pixmaps, second.m_pixmaps);
+  swap(first.m_shape_vertices, second.m_shape_vertices);
+  swap(first.m_shape_changes, second.m_shape_changes);
   swap(first.m_x, second.m_x);
   swap(first.m_y, second.m_y);
   swap(first.m_width, second.m_width);
   swap(first.m_height, second.m_height);
-  swap(first.m_ox, second.m_ox);
-  swap(first.m_oy, second.m_oy);
-  swap(first.m_owidth, second.m_owidth);
-  swap(first.m_oheight, second.m_oheight);
   swap(first.m_border_width, second.m_border_width);
-  swap(first.m_rgba, second.m_rgba);
   swap(first.m_shaped, second.m_shaped);
   swap(first.m_mapped, second.m_mapped);
-  swap(first.m_texture_invalidated, second.m_texture_invalidated);
-  // swap(first.m_rectangles_invalidated, second.m_rectangles_invalidated);
+  swap(first.m_pixmap_stale, second.m_pixmap_stale);
 }
 
 
 
 
-void InputOutputWindow::render_impl(Renderer& renderer)
+void InputOutputWindow::describe_impl(Scene& scene) const
 {
-  if ( (m_x + m_width  < 0 || m_x > screenW)
-    || (m_y + m_height < 0 || m_y > screenH)
-     ) return;
-
-
-  // first, check that this window is mapped and has a pixmap.  if it is
-  // mapped and _doesn't_ have a pixmap, it is likely about to be destroyed
-  // or off-screen somewhere, and it doesn't need to be drawn.
-
-  if (m_mapped && m_pixmap != None) {
-
-    // if the texture was invalidated (say, by a resize), generate a new
-    // GLXPixmap for our window's pixmap and bind the texture to it.
-
-    if (m_texture_invalidated) {
-      create_and_bind();
-    }
-
-    // bind window texture and set window uniforms
-
-    gl::BindTexture(gl::TEXTURE_2D, m_texture);
-
-    // TRACE("DRAWING", m_shaped, m_texture, m_x, m_y, m_width, m_height, m_border_width);
-    // TRACE("DRAWING", *this, m_texture, m_x, m_y, m_width, m_height, m_border_width, m_pixmap);
-
-    renderer.set_border_width(static_cast<float>(m_border_width));
+  // only windows that are mapped and have a pixmap are drawn.  if a window
+  // is mapped and _doesn't_ have a pixmap, it is likely about to be
+  // destroyed or off-screen somewhere.
 
+  if (!m_mapped || m_pixmap == None) {
+    return;
+  }
 
-    // Calculate bounds after animation
-    float x, y, w, h;
-
-    if (m_animStep < animMax) {
-      float t = (float) m_animStep / (float) animMax;
-      float tA = pow(t, animPow);
-      float tB = animC*((t=t/animD-1)*t*((animS+1)*t + animS) + 1) + animB;
-      float tC = animC*((tA=tA/animD-1)*t*((animSB+1)*tA + animSB) + 1) + animB;
-
-      x = static_cast<float>(m_ox)      * (1-tC) + static_cast<float>(m_x)      * tC;
-      y = static_cast<float>(m_oy)      * (1-tC) + static_cast<float>(m_y)      * tC;
-      w = static_cast<float>(m_owidth)  * (1-tB) + static_cast<float>(m_width)  * tB;
-      h = static_cast<float>(m_oheight) * (1-tB) + static_cast<float>(m_height) * tB;
-
-      m_animStep++;
-    } else {
-      x = m_x;
-      y = m_y;
-      w = m_width;
-      h = m_height;
-    }
-
-
-    // then either draw each subrectangle if we are shaped
-    if (m_shaped && m_rectangles.size() > 0) {
-      renderer.setShadow();
-      renderer.draw_shadow
-          ( 20
-          , x - m_border_width
-          , y - m_border_width
-          , w + 2 * m_border_width
-          , h + 2 * m_border_width
-          );
-
-      renderer.setNormal();
-      renderer.set_window_geometry(x, y, w, h);
-
-      for (auto it = m_rectangles.begin(); it != m_rectangles.end(); ++it) {
-        renderer.set_rectangle_geometry(
-          static_cast<float>(it->x),
-          static_cast<float>(it->y),
-          static_cast<float>(it->width),
-          static_cast<float>(it->height)
-        );
-        renderer.draw_quad();
-      }
-    }
-
-    // or just draw the whole window
-
-    else {
-      renderer.setShadow();
-      renderer.draw_shadow
-          ( 20
-          , x - m_border_width
-          , y - m_border_width
-          , w + 2 * m_border_width
-          , h + 2 * m_border_width
-          );
-
-      renderer.setNormal();
-      renderer.set_window_geometry(x, y, w, h);
-      renderer.set_rectangle_geometry(
-        static_cast<float>(-m_border_width),
-        static_cast<float>(-m_border_width),
-        static_cast<float>(2 * m_border_width + m_width),
-        static_cast<float>(2 * m_border_width + m_height)
-      );
-      renderer.draw_quad();
-    }
+  Scene::Window window;
+
+  window.id = *this;
+  window.pixmap = m_pixmap;
+  window.visual_id = m_visual_id;
+  window.depth = m_depth;
+  window.x = m_x;
+  window.y = m_y;
+  window.width = m_width;
+  window.height = m_height;
+  window.border_width = m_border_width;
+  window.root = false;
+  window.shaped = m_shaped;
+  window.changes = changes();
+  window.shape_changes = m_shape_changes;
 
-    gl::BindTexture(gl::TEXTURE_2D, 0);
+  if (m_shaped) {
+    scene.add(window, m_shape_vertices);
+  }
+  else {
+    scene.add(window);
   }
 }
 
@@ -328,37 +338,61 @@ void InputOutputWindow::render_impl(Renderer& renderer)
 
 void InputOutputWindow::on_configure_notify_impl(XConfigureEvent const& event)
 {
-  animate();
   reconfigure(event.x, event.y, event.width, event.height, event.border_width);
+  mark_changed();
+}
+
+
+void InputOutputWindow::on_damage_notify_impl(XDamageNotifyEvent const&)
+{
+  // the render thread's texture is bound to the window's pixmap, so it is
+  // already up to date.  all we need to do is acknowledge the damage so that
+  // the server reports the next change, and let the renderer know it has
+  // something to redraw.
+
+  X11::Xlib::DamageSubtract(m_display, m_damage, None, None);
+  mark_changed();
 }
 
 
 void InputOutputWindow::on_map_notify_impl(XMapEvent const&)
 {
-  // note: bind_composite_pixmap() may fail, in which case m_pixmap and
-  // m_glx_pixmap will remain empty.  this needs to be taken into account in
-  // render().
+  // note: bind_composite_pixmap() may fail, in which case m_pixmap will
+  // remain empty and the window is left out of the scene.
 
   bind_composite_pixmap();
-  create_and_bind();
 
   m_mapped = true;
+  m_pixmap_stale = false;
+
+  mark_changed();
 }
 
 
 void InputOutputWindow::on_shape_notify_impl(XShapeEvent const& event)
 {
   m_shaped = (event.shaped == True);
-  update_shape_rectangles();
+  update_shape_vertices();
+
+  // shaped windows aren't animated from a snapshot, so one that was waiting
+  // for its new pixmap needs it now
+
+  if (m_shaped && m_pixmap_stale) {
+    refresh_stale_pixmap();
+  }
+
+  mark_changed();
 }
 
 
 void InputOutputWindow::on_unmap_notify_impl(XUnmapEvent const&)
 {
   m_mapped = false;
+  m_pixmap_stale = false;
 
-  release_and_destroy();
   release_composite_pixmap();
+
+  mark_changed();
 }
 
 
@@ -366,69 +400,101 @@ void InputOutputWindow::on_unmap_notify_impl(XUnmapEvent const&)
 
 void InputOutputWindow::reconfigure(int x, int y, int width, int height, int border_width)
 {
-  // update the composite pixmap if we are visible and our dimensions have
-  // changed
+  bool resized = (width != m_width || height != m_height || border_width != m_border_width);
 
-  // TODO: only refresh the composite pixmap if there are no future configure
-  // events pending for this window
+  m_x = x;
+  m_y = y;
 
-  if (m_mapped) {
+  m_width = width;
+  m_height = height;
+
+  m_border_width = border_width;
+
+
+  // the render thread animates a resize from a snapshot of the pixmap it
+  // already has, so the new one isn't needed (nor its round trips paid for)
+  // until the animation settles, and the window manager says so.  shaped
+  // windows are drawn from their shape with the live texture, so they need
+  // it at once.
+
+  if (m_mapped && resized) {
+    if (m_shaped) {
+      refresh_composite_pixmap();
+    }
+    else {
+      m_pixmap_stale = true;
+    }
+  }
+}
 
-    if (width != m_width || height != m_height || border_width != m_border_width) {
 
-      bind_composite_pixmap();
+void InputOutputWindow::refresh_stale_pixmap()
+{
+  if (!m_pixmap_stale) {
+    return;
+  }
 
-      //!!
+  m_pixmap_stale = false;
 
-      // i had originally thought that even though
-      // XCompositeNameWindowPixmap (which is called by
-      // bind_composite_pixmap up there) would undoubtedly return a
-      // pixmap that is ahead of the width and height that were sent
-      // with this event, the fact that XNextEvent would be called after
-      // this function would guarantee that our local window dimensions
-      // would catch up before we drew anything.
+  if (m_mapped) {
+    refresh_composite_pixmap();
+    mark_changed();
+  }
+}
 
-      // this is not the case.  you have to resize the window quickly to
-      // see it, but the texture still wobbles a little.  the compton
-      // devs solved the problem by just querying the composite pixmap
-      // itself:
 
-      if (m_pixmap != None) {
-        X11::Geometry pixmap_geometry(m_display, m_pixmap);
+void InputOutputWindow::refresh_composite_pixmap()
+{
+  int width = m_width;
+  int height = m_height;
+  int border_width = m_border_width;
 
-        TRACE(*this, "pixmap depth", pixmap_geometry.depth);
+  bind_composite_pixmap();
 
-        if (pixmap_geometry.width && pixmap_geometry.height) {
-          width = static_cast<int>(pixmap_geometry.width) - 2 * border_width;
-          height = static_cast<int>(pixmap_geometry.height) - 2 * border_width;
-        }
-      }
+  //!!
 
-      // which is both really smart (the local window dimensions will
-      // always match the pixmap's), but really annoying (it requires an
-      // extra trip to the server AND might leave our shape data out of
-      // sync; though i think the shape issue is moot because the shape
-      // data is probably going to be out of sync with our local data
-      // more often than it is with the pixmap).
+  // i had originally thought that even though
+  // XCompositeNameWindowPixmap (which is called by
+  // bind_composite_pixmap up there) would undoubtedly return a
+  // pixmap that is ahead of the width and height that were sent
+  // with this event, the fact that XNextEvent would be called after
+  // this function would guarantee that our local window dimensions
+  // would catch up before we drew anything.
 
-      // the XGetGeometry call (in X11::Geometry's constructor) can fail
-      // also, even though the pixmap is valid.  it doesn't generate a
-      // BadDrawable, it just fails.  this is slightly tilting.
+  // this is not the case.  you have to resize the window quickly to
+  // see it, but the texture still wobbles a little.  the compton
+  // devs solved the problem by just querying the composite pixmap
+  // itself:
 
-      // i don't like it, but i haven't been able to think of a better
-      // solution.
+  if (m_pixmap != None) {
+    X11::Geometry pixmap_geometry(m_display, m_pixmap);
 
-      //!!
+    LOG_DEBUG(Events, static_cast<Window>(*this), "pixmap depth", pixmap_geometry.depth);
+
+    if (pixmap_geometry.width && pixmap_geometry.height) {
+      width = static_cast<int>(pixmap_geometry.width) - 2 * border_width;
+      height = static_cast<int>(pixmap_geometry.height) - 2 * border_width;
     }
   }
 
-  m_x = x;
-  m_y = y;
+  // which is both really smart (the local window dimensions will
+  // always match the pixmap's), but really annoying (it requires an
+  // extra trip to the server AND might leave our shape data out of
+  // sync; though i think the shape issue is moot because the shape
+  // data is probably going to be out of sync with our local data
+  // more often than it is with the pixmap).
+
+  // the XGetGeometry call (in X11::Geometry's constructor) can fail
+  // also, even though the pixmap is valid.  it doesn't generate a
+  // BadDrawable, it just fails.  this is slightly tilting.
+
+  // i don't like it, but i haven't been able to think of a better
+  // solution.
+
+  //!!
 
   m_width = width;
   m_height = height;
-
-  m_border_width = border_width;
 }
 
 
@@ -439,7 +505,14 @@ void InputOutputWindow::bind_composite_pixmap()
   // XCompositeNameWindowPixmap may fail if the window has already been
   // destroyed or if it is - for whatever reason - not visible.
 
-  X11::Pixmap pixmap(m_display, XCompositeNameWindowPixmap(m_display, *this));
+  ::Pixmap named = None;
+
+  {
+    X11::RoundTrip round_trip(Utility::Metrics::NameWindowPixmap);
+    named = X11::Xlib::CompositeNameWindowPixmap(m_display, *this);
+  }
+
+  X11::Pixmap pixmap(m_display, named);
 
   // case 1: we are already using this pixmap, so do nothing.
 
@@ -448,12 +521,13 @@ void InputOutputWindow::bind_composite_pixmap()
   }
 
 
-  // case 2: this is a new pixmap.  release the glx pixmap and texture
-  // binding and replace our current pixmap with this one.
+  // case 2: this is a new pixmap.  retire our current pixmap and replace it
+  // with this one.
 
   else if (pixmap != None) {
-    release_and_destroy();
+    release_composite_pixmap();
     m_pixmap = std::move(pixmap);
+    m_pixmaps->add();
   }
 
 
@@ -470,7 +544,7 @@ void InputOutputWindow::bind_composite_pixmap()
 void InputOutputWindow::release_composite_pixmap()
 {
   if (m_pixmap != None) {
-    release_and_destroy();
+    m_pixmaps->retire(std::move(m_pixmap));
     m_pixmap = X11::Pixmap();
   }
 }
@@ -478,79 +552,20 @@ void InputOutputWindow::release_composite_pixmap()
 
 
 
-void InputOutputWindow::create_and_bind()
-{
-  if (m_pixmap != None) {
-
-    if (m_rgba) {
-      m_glx_pixmap = GLX::Pixmap(m_display, m_framebuffer, m_pixmap, GLX::Pixmap::rgba_attributes);
-    }
-    else {
-      m_glx_pixmap = GLX::Pixmap(m_display, m_framebuffer, m_pixmap, GLX::Pixmap::rgb_attributes);
-    }
-
-    gl::BindTexture(gl::TEXTURE_2D, m_texture);
-
-    gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, gl::LINEAR);
-    gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, gl::LINEAR);
-
-    GLX::BindTexImageEXT(m_display, m_glx_pixmap, GLX_FRONT_EXT, NULL);
-
-    gl::BindTexture(gl::TEXTURE_2D, 0);
-
-    m_texture_invalidated = false;
-  }
-}
-
-
-void InputOutputWindow::release_and_destroy()
+void InputOutputWindow::update_shape_vertices()
 {
-  if (m_glx_pixmap != None) {
-
-    gl::BindTexture(gl::TEXTURE_2D, m_texture);
-    GLX::ReleaseTexImageEXT(m_display, m_glx_pixmap, GLX_FRONT_EXT);
-    gl::BindTexture(gl::TEXTURE_2D, 0);
-
-    m_glx_pixmap = GLX::Pixmap();
+  if (!m_shaped) {
+    m_shape_vertices.clear();
+    ++m_shape_changes;
+    return;
   }
 
-  m_texture_invalidated = true;
-}
-
-
-void InputOutputWindow::update_shape_rectangles()
-{
-  if (m_shaped) {
-    try {
-      X11::RectangleList rectangles(m_display, *this);
-      m_rectangles = std::move(rectangles);
-    }
-    catch (X11::InitializationError&) {
-      TRACE("WARNING", "failed to get bounding rectangles for shaped window", *this);
-    }
+  try {
+    X11::RectangleList rectangles(m_display, *this);
+    m_shape_vertices = shape_vertices(rectangles.begin(), rectangles.end());
+    ++m_shape_changes;
   }
-}
-
-void InputOutputWindow::animate() {
-  if ((m_x || m_ox || m_y || m_oy) == 0)
-    return;
-
-  if (m_animStep < animMax) {
-    float t = (float) m_animStep / (float) animMax;
-    float tA = pow(t, animPow);
-    float tB = animC*((t=t/animD-1)*t*((animS+1)*t + animS) + 1) + animB;
-    float tC = animC*((tA=tA/animD-1)*t*((animSB+1)*tA + animSB) + 1) + animB;
-
-    m_ox      = static_cast<float>(m_ox)      * (1-tC) + static_cast<float>(m_x)      * tC;
-    m_oy      = static_cast<float>(m_oy)      * (1-tC) + static_cast<float>(m_y)      * tC;
-    m_owidth  = static_cast<float>(m_owidth)  * (1-tB) + static_cast<float>(m_width)  * tB;
-    m_oheight = static_cast<float>(m_oheight) * (1-tB) + static_cast<float>(m_height) * tB;
-  } else {
-    m_ox       = m_x;
-    m_oy       = m_y;
-    m_owidth   = m_width;
-    m_oheight  = m_height;
+  catch (X11::InitializationError&) {
+    LOG_WARNING(Events, "failed to get bounding rectangles for shaped window", static_cast<Window>(*this));
   }
-
-  m_animStep = 0;
 }
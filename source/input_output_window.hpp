@@ -3,33 +3,28 @@
 
 
 #include "managed_window.hpp"
-
-#include "glx/pixmap.hpp"
+#include "pixmap_ledger.hpp"
+#include "scene.hpp"
 
 #include "opengl/core330.hpp"
-#include "opengl/texture.hpp"
 
-#include "x11/rectangle_list.hpp"
+#include "x11/damage.hpp"
 #include "x11/pixmap.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
-// #include <X11/extensions/Xdamage.h>
-
-#include <GL/glx.h>
+#include <X11/extensions/Xdamage.h>
 
+#include <vector>
 
 
 
-class FramebufferCache;
-class Renderer;
-
 
 class InputOutputWindow : public ManagedWindow {
 
 public:
 
-	InputOutputWindow(Display* display, Window root, XCreateWindowEvent const& event, XWindowAttributes const& attributes, FramebufferCache& framebuffers);
+	InputOutputWindow(Display* display, Window root, XCreateWindowEvent const& event, XWindowAttributes const& attributes, PixmapLedger& pixmaps);
 
 	InputOutputWindow(InputOutputWindow&& other);
 	InputOutputWindow& operator=(InputOutputWindow&& other);
@@ -38,6 +33,23 @@ public:
 
 	friend void swap(InputOutputWindow& first, InputOutputWindow& second);
 
+	friend class ManagedWindow;
+
+
+public:
+
+	// true if the window has been resized since its pixmap was named.  the
+	// render thread animates the resize from a snapshot of the old pixmap,
+	// so the new one is only named once the window manager has seen the
+	// window settle, with refresh_stale_pixmap().
+
+	bool pixmap_stale() const
+	{
+		return m_pixmap_stale;
+	}
+
+	void refresh_stale_pixmap();
+
 
 private:
 
@@ -49,13 +61,13 @@ private:
 
 private:
 
-	void render_impl(Renderer& renderer);
+	void describe_impl(Scene& scene) const;
 
 
 private:
 
 	void on_configure_notify_impl(XConfigureEvent const& event);
-	// void on_damage_notify_impl(XDamageNotifyEvent const&) {}
+	void on_damage_notify_impl(XDamageNotifyEvent const& event);
 	void on_graphics_expose_impl(XGraphicsExposeEvent const&) {}
 	void on_map_notify_impl(XMapEvent const&);
 	void on_no_expose_impl(XNoExposeEvent const&) {}
@@ -67,15 +79,13 @@ private:
 private:
 
 	void reconfigure(int x, int y, int width, int height, int border_width);
-	void animate();
 
 	void bind_composite_pixmap();
 	void release_composite_pixmap();
 
-	void create_and_bind();
-	void release_and_destroy();
+	void refresh_composite_pixmap();
 
-	void update_shape_rectangles();
+	void update_shape_vertices();
 
 
 private:
@@ -83,13 +93,22 @@ private:
 	Display* m_display;
 	Window m_root;
 
-	GLXFBConfig m_framebuffer;
+	VisualID m_visual_id;
+	int m_depth;
+
+	X11::Damage m_damage;
+
+	// pixmaps are given to the ledger rather than freed, because the render
+	// thread may still be drawing from them.
 
 	X11::Pixmap m_pixmap;
-	GLX::Pixmap m_glx_pixmap;
-	OpenGL::Texture m_texture;
+	PixmapLedger* m_pixmaps;
 
-	X11::RectangleList m_rectangles;
+	// the bounding shape as triangles in window coordinates, rebuilt on
+	// ShapeNotify.  empty unless the window is shaped.
+
+	std::vector<GLfloat> m_shape_vertices;
+	unsigned long m_shape_changes;
 
 	int m_x;
 	int m_y;
@@ -97,17 +116,9 @@ private:
 	int m_height;
 	int m_border_width;
 
-	int m_ox;
-	int m_oy;
-	int m_owidth;
-	int m_oheight;
-  int m_animStep;
-
-	bool m_rgba;
 	bool m_shaped;
 	bool m_mapped;
-	bool m_texture_invalidated;
-	// bool m_rectangles_invalidated;
+	bool m_pixmap_stale;
 
 };
 
@@ -3,11 +3,12 @@
 
 #include "glx/exceptions.hpp"
 
-#include "opengl/core330.hpp"
 #include "opengl/exceptions.hpp"
 
 #include "x11/exceptions.hpp"
 
+#include <X11/Xlib.h>
+
 #include <iostream>
 #include <stdexcept>
 
@@ -40,6 +41,16 @@ void error(Args const&... args)
 
 int main(int argc, char** argv)
 {
+	// each screen's event thread has a connection of its own, but the render
+	// threads of every screen share one with their texture binders, and the
+	// GL driver may use it from threads of its own.  this has to come before
+	// any other Xlib call.
+
+	if (!XInitThreads()) {
+		error("X11: could not initialize threads.");
+		return -1;
+	}
+
 	try {
 		Ortle ortle(argc, argv);
 		ortle.run();
@@ -52,34 +63,7 @@ int main(int argc, char** argv)
 	}
 
 	catch (OpenGL::StateError& e) {
-
 		error("OpenGL: ", e.what());
-
-		switch (e.code()) {
-
-			case gl::INVALID_ENUM:
-				error("OpenGL: gl::INVALID_ENUM");
-				break;
-
-			case gl::INVALID_VALUE:
-				error("OpenGL: gl::INVALID_VALUE");
-				break;
-
-			case gl::INVALID_OPERATION:
-				error("OpenGL: gl::INVALID_OPERATION");
-				break;
-
-			case gl::INVALID_FRAMEBUFFER_OPERATION:
-				error("OpenGL: gl::INVALID_FRAMEBUFFER_OPERATION");
-				break;
-
-			case gl::OUT_OF_MEMORY:
-				error("OpenGL: gl::OUT_OF_MEMORY");
-				break;
-
-			default:
-				error("OpenGL: code ", e.code());
-		}
 	}
 
 	catch (X11::InitializationError& e) {
@@ -1,21 +1,48 @@
 #include "managed_window.hpp"
 
+#include "input_only_window.hpp"
+#include "input_output_window.hpp"
+#include "root.hpp"
+#include "scene.hpp"
+
 #include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xdamage.h>
 
 #include <utility>
 
 
 
 
-ManagedWindow::ManagedWindow(Window window)
-	: m_window(window)
+// calls the given member of whichever class this window really is.  every
+// kind implements every call, so there is no default.
+
+#define DISPATCH(call) \
+	switch (m_kind) { \
+		case Kind::Root: \
+			return static_cast<Root*>(this)->call; \
+		case Kind::InputOnlyWindow: \
+			return static_cast<InputOnlyWindow*>(this)->call; \
+		case Kind::InputOutputWindow: \
+			return static_cast<InputOutputWindow*>(this)->call; \
+	}
+
+
+
+
+ManagedWindow::ManagedWindow(Kind kind, Window window)
+	: m_kind(kind)
+	, m_window(window)
+	, m_changes(1)
 {}
 
 
 
 
 ManagedWindow::ManagedWindow(ManagedWindow&& other)
-	: m_window(None)
+	: m_kind(other.m_kind)
+	, m_window(None)
+	, m_changes(1)
 {
 	swap(*this, other);
 }
@@ -34,6 +61,94 @@ void swap(ManagedWindow& first, ManagedWindow& second)
 {
 	using std::swap;
 
+	// only windows of the same kind are ever swapped, so m_kind stays put
+
 	swap(first.m_window, second.m_window);
+	swap(first.m_changes, second.m_changes);
+}
+
+
+
+
+bool ManagedWindow::visible() const
+{
+	switch (m_kind) {
+		case Kind::Root:
+			return static_cast<Root const*>(this)->visible_impl();
+		case Kind::InputOnlyWindow:
+			return static_cast<InputOnlyWindow const*>(this)->visible_impl();
+		case Kind::InputOutputWindow:
+			return static_cast<InputOutputWindow const*>(this)->visible_impl();
+	}
+	return false;
+}
+
+
+
+
+void ManagedWindow::describe(Scene& scene) const
+{
+	switch (m_kind) {
+		case Kind::Root:
+			return static_cast<Root const*>(this)->describe_impl(scene);
+		case Kind::InputOnlyWindow:
+			return static_cast<InputOnlyWindow const*>(this)->describe_impl(scene);
+		case Kind::InputOutputWindow:
+			return static_cast<InputOutputWindow const*>(this)->describe_impl(scene);
+	}
+}
+
+
+
+
+void ManagedWindow::on_configure_notify(XConfigureEvent const& event)
+{
+	DISPATCH(on_configure_notify_impl(event))
+}
+
+
+void ManagedWindow::on_damage_notify(XDamageNotifyEvent const& event)
+{
+	DISPATCH(on_damage_notify_impl(event))
+}
+
+
+void ManagedWindow::on_graphics_expose(XGraphicsExposeEvent const& event)
+{
+	DISPATCH(on_graphics_expose_impl(event))
+}
+
+
+void ManagedWindow::on_map_notify(XMapEvent const& event)
+{
+	DISPATCH(on_map_notify_impl(event))
+}
+
+
+void ManagedWindow::on_no_expose(XNoExposeEvent const& event)
+{
+	DISPATCH(on_no_expose_impl(event))
+}
+
+
+void ManagedWindow::on_property_notify(XPropertyEvent const& event)
+{
+	DISPATCH(on_property_notify_impl(event))
+}
+
+
+void ManagedWindow::on_shape_notify(XShapeEvent const& event)
+{
+	DISPATCH(on_shape_notify_impl(event))
 }
 
+
+void ManagedWindow::on_unmap_notify(XUnmapEvent const& event)
+{
+	DISPATCH(on_unmap_notify_impl(event))
+}
+
+
+
+
+#undef DISPATCH
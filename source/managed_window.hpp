@@ -2,123 +2,113 @@
 #define ORTLE_MANAGED_WINDOW_HPP
 
 
-#include "renderer.hpp"
+#include "scene.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
-// #include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xdamage.h>
 
 
 
 
+// the base of the three kinds of window in WindowManager's stack.  there are
+// no virtual functions: each window records which kind it is, and the calls
+// below switch on that to reach the derived class's *_impl function (see
+// managed_window.cpp).  derived classes make ManagedWindow a friend so their
+// *_impl functions can stay private.
+
 class ManagedWindow {
 
 public:
 
-	explicit ManagedWindow(Window window);
+	enum class Kind {
+		Root,
+		InputOnlyWindow,
+		InputOutputWindow
+	};
+
+
+public:
+
+	ManagedWindow(Kind kind, Window window);
 
 	ManagedWindow(ManagedWindow&& other);
 	ManagedWindow& operator=(ManagedWindow&& other);
 
-	virtual ~ManagedWindow() {}
-
 	friend void swap(ManagedWindow& first, ManagedWindow& second);
 
 
-public:
+protected:
 
-	operator Window() const
-	{
-		return m_window;
-	}
+	// windows are always destroyed through their own type
+
+	~ManagedWindow() {}
 
 
 public:
 
-	bool visible() const
+	operator Window() const
 	{
-		return visible_impl();
+		return m_window;
 	}
 
 
-public:
-
-	void render(Renderer& renderer)
+	Kind kind() const
 	{
-		render_impl(renderer);
+		return m_kind;
 	}
 
 
 public:
 
-	void on_configure_notify(XConfigureEvent const& event)
-	{
-		on_configure_notify_impl(event);
-	}
+	bool visible() const;
 
 
-	// void on_damage_notify(XDamageNotifyEvent const& event)
-	// {
-	// 	on_damage_notify_impl(event);
-	// }
+public:
 
+	// counts the changes to anything that affects how this window is drawn
+	// (damage, geometry, mapping, shape).  the render thread compares it with
+	// the count it last saw to know whether the window needs redrawing.
 
-	void on_graphics_expose(XGraphicsExposeEvent const& event)
+	unsigned long changes() const
 	{
-		on_graphics_expose_impl(event);
+		return m_changes;
 	}
 
 
-	void on_map_notify(XMapEvent const& event)
-	{
-		on_map_notify_impl(event);
-	}
+	// appends this window to the scene if there is anything to draw.  called
+	// on the event thread whenever a new scene is published.
 
+	void describe(Scene& scene) const;
 
-	void on_no_expose(XNoExposeEvent const& event)
-	{
-		on_no_expose_impl(event);
-	}
 
+public:
 
-	void on_property_notify(XPropertyEvent const& event)
-	{
-		on_property_notify_impl(event);
-	}
-
+	void on_configure_notify(XConfigureEvent const& event);
+	void on_damage_notify(XDamageNotifyEvent const& event);
+	void on_graphics_expose(XGraphicsExposeEvent const& event);
+	void on_map_notify(XMapEvent const& event);
+	void on_no_expose(XNoExposeEvent const& event);
+	void on_property_notify(XPropertyEvent const& event);
+	void on_shape_notify(XShapeEvent const& event);
+	void on_unmap_notify(XUnmapEvent const& event);
 
-	void on_shape_notify(XShapeEvent const& event)
-	{
-		on_shape_notify_impl(event);
-	}
 
+protected:
 
-	void on_unmap_notify(XUnmapEvent const& event)
+	void mark_changed()
 	{
-		on_unmap_notify_impl(event);
+		++m_changes;
 	}
 
 
 private:
 
-	virtual bool visible_impl() const = 0;
-
-	virtual void render_impl(Renderer& renderer) = 0;
-
-	virtual void on_configure_notify_impl(XConfigureEvent const& event) = 0;
-	// virtual void on_damage_notify_impl(XDamageNotifyEvent const& event) = 0;
-	virtual void on_graphics_expose_impl(XGraphicsExposeEvent const& event) = 0;
-	virtual void on_map_notify_impl(XMapEvent const& event) = 0;
-	virtual void on_no_expose_impl(XNoExposeEvent const& event) = 0;
-	virtual void on_property_notify_impl(XPropertyEvent const& event) = 0;
-	virtual void on_shape_notify_impl(XShapeEvent const& event) = 0;
-	virtual void on_unmap_notify_impl(XUnmapEvent const& event) = 0;
-
-
-private:
-
+	Kind m_kind;
 	Window m_window;
 
+	unsigned long m_changes;
+
 };
 
 
@@ -0,0 +1,183 @@
+#include "debug.hpp"
+
+#include "core330.hpp"
+
+#include "../glx/functions.hpp"
+
+#include "../utility/backtrace.hpp"
+#include "../utility/log.hpp"
+
+#include <unistd.h>
+
+#include <cstring>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+
+
+
+namespace {
+
+
+// the driver's message for the first error not yet taken, from any context.
+// the flag is there so that the render thread needn't lock every frame.
+
+std::atomic<bool> g_failed(false);
+
+std::mutex g_error_mutex;
+std::string g_error;
+
+
+#ifndef NDEBUG
+
+
+// from GL_KHR_debug, which glLoadGen was not asked for, and GL 4.3
+
+GLenum const l_debug_output = 0x92E0;
+GLenum const l_debug_output_synchronous = 0x8242;
+
+GLenum const l_debug_type_error = 0x824C;
+GLenum const l_debug_severity_notification = 0x826B;
+
+GLint const l_context_flag_debug_bit = 0x2;
+
+
+char const* source_name(GLenum source)
+{
+	switch (source) {
+		case 0x8246: return "api";
+		case 0x8247: return "window system";
+		case 0x8248: return "shader compiler";
+		case 0x8249: return "third party";
+		case 0x824A: return "application";
+		default: return "other";
+	}
+}
+
+
+char const* type_name(GLenum type)
+{
+	switch (type) {
+		case 0x824C: return "error";
+		case 0x824D: return "deprecated";
+		case 0x824E: return "undefined behavior";
+		case 0x824F: return "portability";
+		case 0x8250: return "performance";
+		case 0x8268: return "marker";
+		default: return "other";
+	}
+}
+
+
+char const* severity_name(GLenum severity)
+{
+	switch (severity) {
+		case 0x9146: return "high";
+		case 0x9147: return "medium";
+		case 0x9148: return "low";
+		default: return "notification";
+	}
+}
+
+
+bool has_extension(char const* name)
+{
+	GLint count = 0;
+	gl::GetIntegerv(gl::NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; ++i) {
+		char const* extension = reinterpret_cast<char const*>(gl::GetStringi(gl::EXTENSIONS, i));
+		if (extension != nullptr && std::strcmp(extension, name) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// called by the driver, on whichever thread made the offending call.  the
+// message usually names the call (e.g. "GL_INVALID_OPERATION in
+// glDrawElements"), and the backtrace says where it was made from.
+
+void APIENTRY report(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei, GLchar const* message, GLvoid*)
+{
+	if (type == l_debug_type_error) {
+
+		LOG_WARNING(Render, "OpenGL error", source_name(source), severity_name(severity), id, message);
+
+		Utility::Backtrace(STDERR_FILENO);
+
+		std::lock_guard<std::mutex> lock(g_error_mutex);
+
+		if (!g_failed.load(std::memory_order_relaxed)) {
+			g_error = message;
+			g_failed.store(true, std::memory_order_release);
+		}
+	}
+
+	else if (severity == l_debug_severity_notification) {
+		LOG_DEBUG(Render, "OpenGL", source_name(source), type_name(type), id, message);
+	}
+
+	else {
+		LOG_INFO(Render, "OpenGL", source_name(source), type_name(type), severity_name(severity), id, message);
+	}
+}
+
+
+#endif
+
+
+} // namespace
+
+
+
+
+namespace OpenGL {
+
+
+void enable_debug_output()
+{
+#ifndef NDEBUG
+
+	if (GLX::DebugMessageCallback == nullptr || !has_extension("GL_KHR_debug")) {
+		LOG_INFO(Render, "no GL_KHR_debug, OpenGL errors will go unreported");
+		return;
+	}
+
+	GLint flags = 0;
+	gl::GetIntegerv(gl::CONTEXT_FLAGS, &flags);
+
+	if ((flags & l_context_flag_debug_bit) == 0) {
+		LOG_INFO(Render, "not a debug context, some OpenGL messages may be missing");
+	}
+
+	gl::Enable(l_debug_output);
+	gl::Enable(l_debug_output_synchronous);
+
+	GLX::DebugMessageCallback(&report, nullptr);
+
+#endif
+}
+
+
+bool take_debug_error(std::string& message)
+{
+	if (!g_failed.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_error_mutex);
+
+	message.swap(g_error);
+	g_error.clear();
+	g_failed.store(false, std::memory_order_relaxed);
+
+	return true;
+}
+
+
+} // namespace OpenGL
@@ -0,0 +1,37 @@
+#ifndef ORTLE_OPENGL_DEBUG_HPP
+#define ORTLE_OPENGL_DEBUG_HPP
+
+
+#include "core330.hpp"
+
+#include <string>
+
+
+
+
+namespace OpenGL {
+
+
+// in debug builds, has the current context (created with the debug flag)
+// report through GL_KHR_debug as it goes: every message is logged, and an
+// error is logged along with a backtrace to the call that caused it, since
+// output is synchronous.  the first error is also kept for
+// take_debug_error().  release builds use a no-error context where they
+// can, and this does nothing.
+//
+// call once for each context, while it is current.
+
+void enable_debug_output();
+
+// if an error has been reported since the last call, puts the driver's
+// message for the first one (which names the error and usually the call) in
+// message and returns true.  an atomic load when there is none, which is
+// cheap enough for every frame, unlike glGetError.
+
+bool take_debug_error(std::string& message);
+
+
+} // namespace OpenGL
+
+
+#endif
@@ -5,6 +5,7 @@
 #include "core330.hpp"
 
 #include <stdexcept>
+#include <string>
 
 
 
@@ -16,21 +17,10 @@ class StateError : public std::runtime_error {
 
 public:
 
-	StateError(char const* message, GLenum code)
+	StateError(std::string const& message)
 		: std::runtime_error(message)
-		, m_code(code)
 	{}
 
-	GLenum code() const
-	{
-		return m_code;
-	}
-
-
-private:
-
-	GLenum m_code;
-
 };
 
 
@@ -0,0 +1,64 @@
+#include "framebuffer.hpp"
+
+#include "core330.hpp"
+
+#include <cassert>
+
+#include <utility>
+
+
+
+
+namespace OpenGL {
+
+
+Framebuffer::Framebuffer()
+	: m_handle(0)
+{
+	gl::GenFramebuffers(1, &m_handle);
+}
+
+
+Framebuffer::Framebuffer(GLuint handle)
+	: m_handle(handle)
+{}
+
+
+
+
+Framebuffer::Framebuffer(Framebuffer&& other)
+	: m_handle(0)
+{
+	swap(*this, other);
+}
+
+
+Framebuffer& Framebuffer::operator=(Framebuffer&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Framebuffer::~Framebuffer()
+{
+	if (m_handle != 0) {
+		gl::DeleteFramebuffers(1, &m_handle);
+	}
+}
+
+
+
+
+void swap(Framebuffer& first, Framebuffer& second)
+{
+	using std::swap;
+
+	swap(first.m_handle, second.m_handle);
+}
+
+
+} // namespace OpenGL
+
@@ -0,0 +1,47 @@
+#ifndef ORTLE_OPENGL_FRAMEBUFFER_HPP
+#define ORTLE_OPENGL_FRAMEBUFFER_HPP
+
+
+#include "core330.hpp"
+
+
+
+
+namespace OpenGL {
+
+
+class Framebuffer {
+
+public:
+
+	Framebuffer();
+	explicit Framebuffer(GLuint handle);
+
+	Framebuffer(Framebuffer&& other);
+	Framebuffer& operator=(Framebuffer&& other);
+
+	~Framebuffer();
+
+	friend void swap(Framebuffer& first, Framebuffer& second);
+
+
+public:
+
+	operator GLuint() const
+	{
+		return m_handle;
+	}
+
+
+private:
+
+	GLuint m_handle;
+
+};
+
+
+} // namespace OpenGL
+
+
+#endif
+
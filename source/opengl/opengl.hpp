@@ -7,11 +7,14 @@
 #include "buffer.hpp"
 #include "buffer_binding.hpp"
 #include "exceptions.hpp"
+#include "framebuffer.hpp"
 #include "program.hpp"
 #include "program_binding.hpp"
+#include "query.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
 #include "texture_binding.hpp"
+#include "texture_pool.hpp"
 
 
 #endif
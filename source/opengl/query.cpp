@@ -0,0 +1,64 @@
+#include "query.hpp"
+
+#include "core330.hpp"
+
+#include <cassert>
+
+#include <utility>
+
+
+
+
+namespace OpenGL {
+
+
+Query::Query()
+	: m_handle(0)
+{
+	gl::GenQueries(1, &m_handle);
+}
+
+
+Query::Query(GLuint handle)
+	: m_handle(handle)
+{}
+
+
+
+
+Query::Query(Query&& other)
+	: m_handle(0)
+{
+	swap(*this, other);
+}
+
+
+Query& Query::operator=(Query&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Query::~Query()
+{
+	if (m_handle != 0) {
+		gl::DeleteQueries(1, &m_handle);
+	}
+}
+
+
+
+
+void swap(Query& first, Query& second)
+{
+	using std::swap;
+
+	swap(first.m_handle, second.m_handle);
+}
+
+
+} // namespace OpenGL
+
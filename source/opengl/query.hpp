@@ -0,0 +1,47 @@
+#ifndef ORTLE_OPENGL_QUERY_HPP
+#define ORTLE_OPENGL_QUERY_HPP
+
+
+#include "core330.hpp"
+
+
+
+
+namespace OpenGL {
+
+
+class Query {
+
+public:
+
+	Query();
+	explicit Query(GLuint handle);
+
+	Query(Query&& other);
+	Query& operator=(Query&& other);
+
+	~Query();
+
+	friend void swap(Query& first, Query& second);
+
+
+public:
+
+	operator GLuint() const
+	{
+		return m_handle;
+	}
+
+
+private:
+
+	GLuint m_handle;
+
+};
+
+
+} // namespace OpenGL
+
+
+#endif
+
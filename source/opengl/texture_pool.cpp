@@ -0,0 +1,115 @@
+#include "texture_pool.hpp"
+
+#include "core330.hpp"
+#include "texture.hpp"
+
+#include <cstddef>
+
+#include <utility>
+#include <vector>
+
+
+
+
+namespace OpenGL {
+
+
+namespace {
+
+
+// beyond this, released textures are deleted.  a burst of menus and tooltips
+// rarely comes close.
+
+std::size_t const l_maximum_pooled_textures = 64;
+
+
+} // namespace
+
+
+
+
+TexturePool::TexturePool()
+	: m_textures()
+{}
+
+
+
+
+TexturePool::TexturePool(TexturePool&& other)
+	: m_textures()
+{
+	swap(*this, other);
+}
+
+
+TexturePool& TexturePool::operator=(TexturePool&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+TexturePool::~TexturePool()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(TexturePool& first, TexturePool& second)
+{
+	using std::swap;
+
+	swap(first.m_textures, second.m_textures);
+}
+
+
+
+
+Texture TexturePool::acquire()
+{
+	if (!m_textures.empty()) {
+		Texture texture = std::move(m_textures.back());
+		m_textures.pop_back();
+		return texture;
+	}
+
+
+	// the pool is empty, so make a new texture.  its parameters are set once
+	// here, and kept for as long as it goes back and forth.
+
+	Texture texture;
+
+	gl::BindTexture(gl::TEXTURE_2D, texture);
+
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, gl::LINEAR);
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, gl::LINEAR);
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_S, gl::CLAMP_TO_EDGE);
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_T, gl::CLAMP_TO_EDGE);
+
+	gl::BindTexture(gl::TEXTURE_2D, 0);
+
+	return texture;
+}
+
+
+void TexturePool::release(Texture&& texture)
+{
+	if (texture == 0) {
+		return;
+	}
+
+	if (m_textures.size() < l_maximum_pooled_textures) {
+		m_textures.push_back(std::move(texture));
+	}
+
+	else {
+		Texture discard = std::move(texture);
+	}
+}
+
+
+} // namespace OpenGL
@@ -0,0 +1,51 @@
+#ifndef ORTLE_OPENGL_TEXTURE_POOL_HPP
+#define ORTLE_OPENGL_TEXTURE_POOL_HPP
+
+
+#include "core330.hpp"
+#include "texture.hpp"
+
+#include <vector>
+
+
+
+
+namespace OpenGL {
+
+
+// keeps textures that are no longer in use so that new windows can take
+// them instead of generating their own.  every texture handed out by
+// acquire() has linear filtering and clamp-to-edge wrapping already set, and
+// must not have an image bound to it when it is given back.
+
+class TexturePool {
+
+public:
+
+	TexturePool();
+
+	TexturePool(TexturePool&& other);
+	TexturePool& operator=(TexturePool&& other);
+
+	~TexturePool();
+
+	friend void swap(TexturePool& first, TexturePool& second);
+
+
+public:
+
+	Texture acquire();
+	void release(Texture&& texture);
+
+
+private:
+
+	std::vector<Texture> m_textures;
+
+};
+
+
+} // namespace OpenGL
+
+
+#endif
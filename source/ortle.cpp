@@ -1,56 +1,113 @@
 #include "ortle.hpp"
 
+#include "compositor.hpp"
 #include "framebuffer_cache.hpp"
-#include "output_window.hpp"
-#include "renderer.hpp"
-#include "window_manager.hpp"
-
-#include "glx/functions.hpp"
-
-#include "opengl/core330.hpp"
-#include "opengl/exceptions.hpp"
 
 #include "utility/backtrace.hpp"
-#include "utility/trace.hpp"
+#include "utility/flight_recorder.hpp"
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
 
-#include "x11/composite_manager_atom.hpp"
-#include "x11/composite_overlay.hpp"
 #include "x11/display.hpp"
 #include "x11/error_handler.hpp"
 #include "x11/extension.hpp"
-#include "x11/geometry.hpp"
 
+#include <signal.h>
 #include <unistd.h>
 
 #include <X11/Xlib.h>
 #include <X11/Xproto.h>
-#include <X11/extensions/shape.h>
 #include <X11/extensions/shapeproto.h>
 #include <X11/extensions/Xcomposite.h>
 #include <X11/extensions/Xdamage.h>
-#include <X11/extensions/Xfixes.h>
 
+#include <cctype>
 #include <csignal>
+#include <cstdlib>
 
-#include <iostream>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
-#ifdef GHETTO_PROFILE
-	#include <chrono>
-#endif
 
 
 
+namespace {
 
 
-namespace {
+// read by every thread, and cleared by the signal handler or by whichever
+// thread fails.  lock-free atomics are safe to use in a signal handler.
+
+std::atomic<bool> g_running(true);
+
 
+// set once the XDamage extension has been queried, so that the error handler
+// can recognize its errors.
 
-volatile std::sig_atomic_t g_running = 1;
+int g_damage_error_base = -1;
 
 
 void signal_handler(int)
 {
-	g_running = 0;
+	g_running = false;
+}
+
+
+// SIGUSR1 dumps the flight recorder, and carries on
+
+void dump_handler(int)
+{
+	Utility::FlightRecorder::request_dump("SIGUSR1");
+}
+
+
+// SIGUSR2 switches logging to Debug and back
+
+void log_handler(int)
+{
+	Utility::Log::toggle_debug();
+}
+
+
+// where metrics are served: $ORTLE_METRICS if set (empty to not serve them),
+// or a socket in $XDG_RUNTIME_DIR named after the display, e.g. ortle-0.metrics
+// for :0.  nowhere if neither is set.
+
+std::string metrics_path(Display* display)
+{
+	char const* path = std::getenv("ORTLE_METRICS");
+
+	if (path != nullptr) {
+		return path;
+	}
+
+	char const* directory = std::getenv("XDG_RUNTIME_DIR");
+
+	if (directory == nullptr || *directory == '\0') {
+		return std::string();
+	}
+
+	std::string name;
+
+	for (char const* c = DisplayString(display); *c != '\0'; ++c) {
+		name += (std::isalnum(static_cast<unsigned char>(*c)) || *c == '.' ? *c : '-');
+	}
+
+	return std::string(directory) + "/ortle" + name + ".metrics";
+}
+
+
+// where the first screen's events are recorded: $ORTLE_RECORD, or nowhere
+
+std::string recording_path()
+{
+	char const* path = std::getenv("ORTLE_RECORD");
+
+	return (path != nullptr ? path : std::string());
 }
 
 
@@ -74,7 +131,16 @@ int x11_error_handler(Display*, XErrorEvent* error)
 	// destroyed.
 
 	if (error->request_code == X_GetWindowAttributes && error->error_code == BadWindow) {
-		TRACE("WARNING", "XGetWindowAttributes generated a BadWindow error");
+		LOG_DEBUG(Events, "XGetWindowAttributes generated a BadWindow error");
+		return 0;
+	}
+
+
+	// XQueryTree is used to find the top-level window of the active window,
+	// which may have been destroyed by the time we ask.
+
+	else if (error->request_code == X_QueryTree && error->error_code == BadWindow) {
+		LOG_DEBUG(Events, "XQueryTree generated a BadWindow error");
 		return 0;
 	}
 
@@ -86,7 +152,7 @@ int x11_error_handler(Display*, XErrorEvent* error)
 	// should not be drawn.
 
 	else if (error->request_code == X_CompositeNameWindowPixmap) {
-		TRACE("WARNING", "XCompositeNameWindowPixmap failed", error->error_code);
+		LOG_DEBUG(Events, "XCompositeNameWindowPixmap failed", error->error_code);
 		return 0;
 	}
 
@@ -95,7 +161,7 @@ int x11_error_handler(Display*, XErrorEvent* error)
 	// similar, if not the same, to the other two errors above.
 
 	else if (error->request_code == X_ShapeGetRectangles) {
-		TRACE("WARNING", "XShapeGetRectangles failed", error->error_code);
+		LOG_DEBUG(Events, "XShapeGetRectangles failed", error->error_code);
 		return 0;
 	}
 
@@ -109,7 +175,17 @@ int x11_error_handler(Display*, XErrorEvent* error)
 	// of a copy, eating this event should be safe.
 
 	else if (error->request_code == X_CopyArea && (error->error_code == BadDrawable || error->error_code == BadMatch)) {
-		TRACE("WARNING", "XCopyArea failed", error->error_code);
+		LOG_DEBUG(Events, "XCopyArea failed", error->error_code);
+		return 0;
+	}
+
+
+	// each managed window has a damage object, which is destroyed when we
+	// stop managing the window.  if that is because the window was destroyed,
+	// the server has already freed the damage object along with it.
+
+	else if (g_damage_error_base >= 0 && error->error_code == g_damage_error_base + BadDamage) {
+		LOG_DEBUG(Events, "XDamageDestroy failed", error->error_code);
 		return 0;
 	}
 
@@ -128,20 +204,6 @@ int x11_error_handler(Display*, XErrorEvent* error)
 
 
 
-// pending_shape_notify
-// predicate used with XCheckIfEvent to compress shape events for a window, so
-// that only the most recent event is processed.
-
-Bool pending_shape_notify(Display*, XEvent* event, XPointer arg)
-{
-	XShapeEvent* shape_event = reinterpret_cast<XShapeEvent*>(arg);
-	if (event->type == shape_event->type && reinterpret_cast<XShapeEvent*>(event)->window == shape_event->window) {
-		return True;
-	}
-	return False;
-}
-
-
 } // namespace
 
 
@@ -149,491 +211,119 @@ Bool pending_shape_notify(Display*, XEvent* event, XPointer arg)
 
 Ortle::Ortle(int, char**)
 
-	: m_x11_error_handler(x11_error_handler)
-
-	, m_display(NULL)
-	, m_screen(XDefaultScreen(m_display))
-	, m_root(XRootWindow(m_display, m_screen))
-
-	, m_composite(m_display, "XComposite", 0, 4, &XCompositeQueryExtension, &XCompositeQueryVersion)
-	, m_damage(m_display, "XDamage", 1, 1, &XDamageQueryExtension, &XDamageQueryVersion)
-	, m_fixes(m_display, "XFixes", 2, 0, &XFixesQueryExtension, &XFixesQueryVersion)
-	, m_shape(m_display, "XShape", 1, 1, &XShapeQueryExtension, &XShapeQueryVersion)
-	, m_glx(m_display, "GLX", 1, 4, &glXQueryExtension, &glXQueryVersion)
+	: m_log_writer()
 
-	, m_framebuffers(m_display, m_screen)
+	, m_x11_error_handler(x11_error_handler)
 
-	, m_composite_overlay(m_display, m_root)
+	, m_render_display(NULL)
 
-	, m_output_window(m_display, m_root, m_composite_overlay, m_framebuffers)
+	, m_damage(m_render_display, "XDamage", 1, 1, &XDamageQueryExtension, &XDamageQueryVersion)
 
-	, m_composite_manager_atom(m_display, m_screen, m_output_window)
+	, m_framebuffers(m_render_display)
 
-	, m_renderer()
-
-	, m_window_manager(m_display, m_screen, m_root, m_framebuffers)
+	, m_compositors()
+	, m_metrics()
+	, m_errors()
 
 {
+	g_damage_error_base = m_damage.error_base;
+
 	std::signal(SIGHUP, signal_handler);
 	std::signal(SIGINT, signal_handler);
 	std::signal(SIGTERM, signal_handler);
+	std::signal(SIGUSR1, dump_handler);
+	std::signal(SIGUSR2, log_handler);
 
 
 #ifdef DEBUG_SYNCHRONIZE
 
-	XSynchronize(m_display, True);
+	XSynchronize(m_render_display, True);
 
 #endif
 
-}
-
-
-Ortle::~Ortle()
-{
-	// nothing to do
-}
-
-
-
-
-#ifdef GHETTO_PROFILE
-
-	void Ortle::run()
-	{
-		unsigned int last_retrace = 0;
-
-		m_output_window.reconfigure();
-		m_output_window.swap_interval(1);
-
-		X11::Geometry root_geometry(m_display, m_root);
-		m_renderer.set_viewport(root_geometry.width, root_geometry.height);
-
-		gl::ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-
-		auto start = std::chrono::high_resolution_clock::now();
-
-		auto event_ticks = start - start;
-		auto render_ticks = event_ticks;
-		auto swap_ticks = event_ticks;
-		auto wait_ticks = event_ticks;
-
-		int iteration = 0;
-
-		while (g_running) {
-
-			unsigned int current_retrace = 0;
-
-			++iteration;
-			iteration %= 60;
-
-			if (iteration == 0) {
-				TRACE("event ticks", event_ticks.count());
-				TRACE("render ticks", render_ticks.count());
-				TRACE("swap ticks", swap_ticks.count());
-				TRACE("wait ticks", wait_ticks.count());
-				TRACE("total", event_ticks.count() + render_ticks.count() + swap_ticks.count() + wait_ticks.count());
-
-				event_ticks -= event_ticks;
-				render_ticks -= render_ticks;
-				swap_ticks -= swap_ticks;
-				wait_ticks -= wait_ticks;
-			}
-
-			// usually this is done in a while loop because there can be  more than
-			// one error waiting.  but, for now at least, every openglerror is
-			// fatal.
-
-			GLenum error = gl::NO_ERROR_;
-			if ((error = gl::GetError()) != gl::NO_ERROR_) {
-				throw OpenGL::StateError("Error in OpenGL State", error);
-			}
-
-			auto p0 = std::chrono::high_resolution_clock::now();
-
-			process_pending_events();
-
-			// XSync(m_display, False);
-
-			auto p1 = std::chrono::high_resolution_clock::now();
-
-			// XSync(m_display, False);
-			// glXWaitX();
-			// gl::Flush();
-
-			gl::Clear(gl::COLOR_BUFFER_BIT);
-
-			m_renderer.render(m_window_manager.begin(), m_window_manager.end());
-
-
-			// a current problem is that everything lags when moving a window over
-			// an accelerated chromium window.  what happens is that we spend too
-			// much time in glXSwapBuffers.
-
-			// unsigned int current_retrace = 0;
-			// GLX::GetVideoSyncSGI(&current_retrace);
-
-			// option one: wait for the next retrace:
-			// this is no good because you can miss it and end up waiting a long
-			// time
-
-			// GLX::WaitVideoSyncSGI(current_retrace, 1, &current_retrace);
-
-
-			// option two: wait for the next odd frame if current is even, or wait
-			// for the next even frame is current is odd
-
-			// this is what compton does and might be as good as we can get.  it
-			// is still bad because the skipping frame is ugly.
-
-			// GLX::WaitVideoSyncSGI(2, (current_retrace + 1) % 2, &current_retrace);
-
-
-			auto p2 = std::chrono::high_resolution_clock::now();
-
-			// XSync(m_display, False);
-			// glXWaitX();
-			// gl::Flush();
-
-			// gl::Finish();
-
-			// TRACE("RETRACE", last_retrace, current_retrace);
-
-
-			m_output_window.swap_buffers();
-
-			auto p3 = std::chrono::high_resolution_clock::now();
-
-			if (GLX::WaitVideoSyncSGI) {
-
-				GLX::WaitVideoSyncSGI(1, 0, &current_retrace);
-
-				if (current_retrace == last_retrace) {
-					TRACE("WARNING", last_retrace, current_retrace);
-				}
-				else if (current_retrace > last_retrace + 1) {
-					TRACE("WARNING", last_retrace, current_retrace);
-				}
-
-				last_retrace = current_retrace;
-			}
 
-			auto p4 = std::chrono::high_resolution_clock::now();
+	// the compositors are set up one after the other on this thread, which
+	// is also where the GL and GLX function pointers are loaded, the first
+	// time a context is made current.
 
-
-			event_ticks += p1 - p0;
-			render_ticks += p2 - p1;
-			swap_ticks += p3 - p2;
-			wait_ticks += p4 - p3;
-
-			if ((p4-p0).count() > 1e9 / 45) {
-				TRACE("TICKS", "1-0", (p1 - p0).count());
-				TRACE("TICKS", "2-1", (p2 - p1).count());
-				TRACE("TICKS", "3-2", (p3 - p2).count());
-				TRACE("TICKS", "4-3", (p4 - p3).count());
-				TRACE("TICKS", "tot", (p3-p0).count());
-			}
-		}
+	for (int screen = 0; screen < XScreenCount(m_render_display); ++screen) {
+		std::string recording = (screen == 0 ? recording_path() : std::string());
+		m_compositors.push_back(std::unique_ptr<Compositor>(new Compositor(m_render_display, screen, m_framebuffers, g_running, recording)));
 	}
 
+	m_errors.resize(m_compositors.size());
 
-#else
-
-	void Ortle::run()
-	{
-		unsigned int last_retrace = 0;
-
-		m_output_window.reconfigure();
-		m_output_window.swap_interval(1);
-
-		X11::Geometry root_geometry(m_display, m_root);
-		m_renderer.set_viewport(root_geometry.width, root_geometry.height);
-
-		gl::ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-
-    // int itt = 0;
-		while (g_running) {
-      // if (itt++ % 2 != 0) {
-      //   unsigned int current_retrace = 0;
-			// 	GLX::WaitVideoSyncSGI(1, 0, &current_retrace);
-      //   continue;
-      // }
-
-			// usually this is done in a while loop because there can be  more than
-			// one error waiting.  but, for now at least, every openglerror is
-			// fatal.
-
-			GLenum error = gl::NO_ERROR_;
-			if ((error = gl::GetError()) != gl::NO_ERROR_) {
-				throw OpenGL::StateError("Error in OpenGL State", error);
-			}
-
-
-			process_pending_events();
-
-
-			gl::Clear(gl::COLOR_BUFFER_BIT);
 
-			m_renderer.render(m_window_manager.begin(), m_window_manager.end());
+	std::string path = metrics_path(m_render_display);
 
-
-			m_output_window.swap_buffers();
-
-
-			if (GLX::WaitVideoSyncSGI) {
-
-				unsigned int current_retrace = 0;
-
-				GLX::WaitVideoSyncSGI(1, 0, &current_retrace);
-
-				if (current_retrace == last_retrace) {
-					TRACE("WARNING", last_retrace, current_retrace);
-				}
-				else if (current_retrace > last_retrace + 1) {
-					TRACE("WARNING", last_retrace, current_retrace);
-				}
-
-				last_retrace = current_retrace;
-			}
-		}
-	}
-
-#endif 
-
-
-
-
-void Ortle::process_pending_events()
-{
-	while (g_running && XPending(m_display) > 0) {
-
-		XEvent event;
-		XNextEvent(m_display, &event);
-
-    // printf("%i\n", event.type);
-
-		switch (event.type) {
-
-			case CirculateNotify:
-				on_circulate_notify(event.xcirculate);
-				break;
-
-			case ClientMessage:
-				TRACE("client message", event.xclient.window, event.xclient.message_type, event.xclient.format);
-				break;
-
-			case ConfigureNotify:
-				on_configure_notify(event.xconfigure);
-				break;
-
-
-			case CreateNotify:
-				on_create_notify(event.xcreatewindow);
-				break;
-
-			case DestroyNotify:
-				on_destroy_notify(event.xdestroywindow);
-				break;
-
-			// case Expose:
-			// 	on_expose(event.xexpose);
-				// break;
-      case XDamageNotify:
-        printf("xdamage\n");
-        break;
-
-			case GraphicsExpose:
-				on_graphics_expose(event.xgraphicsexpose);
-				break;
-
-			case MapNotify:
-				on_map_notify(event.xmap);
-				break;
-
-			case NoExpose:
-				on_no_expose(event.xnoexpose);
-				break;
-
-			case PropertyNotify:
-				on_property_notify(event.xproperty);
-				break;
-
-			case ReparentNotify:
-				on_reparent_notify(event.xreparent);
-				break;
-
-			case UnmapNotify:
-				on_unmap_notify(event.xunmap);
-				break;
-
-			default:
-
-				if (event.type == ShapeNotify + m_shape.event_base) {
-					while (XCheckIfEvent(m_display, &event, &pending_shape_notify, reinterpret_cast<XPointer>(&event)) == True) {
-						TRACE("pending ShapeNotify event found, ignoring this one.");
-					}
-					on_shape_notify(reinterpret_cast<XShapeEvent&>(event));
-				}
-
-				// else if (event.type == XDamageNotify + m_damage.event_base) {
-				// 	on_damage_notify(reinterpret_cast<XDamageNotifyEvent&>(event));
-				// }
-
-				else {
-					TRACE("WARNING", "unhandled event", event.type);
-				}
-		}
+	if (!path.empty()) {
+		m_metrics = Utility::Metrics::Server(path);
 	}
 }
 
 
 
 
-void Ortle::on_circulate_notify(XCirculateEvent const& event)
-{
-	// raised when event.window is circulated either above or below all of its
-	// siblings.
-
-	TRACE(event.window, event.place);
-
-	m_window_manager.on_circulate_notify(event);
-}
-
-
-void Ortle::on_configure_notify(XConfigureEvent const& event)
-{
-	// raised when event.window is configured, which can include changing
-	// its position, size, border width, or stacking order.
-
-	TRACE(event.window, event.x, event.y, event.width, event.height, event.above);
-
-	// if it's the root window, we need to reconfigure our output window and
-	// viewport
-
-	if (event.window == m_root) {
-		m_output_window.reconfigure();
-		m_renderer.set_viewport(event.width, event.height);
-	}
-
-	// pass the event along to the window manager
-
-	m_window_manager.on_configure_notify(event);
-}
-
-
-void Ortle::on_create_notify(XCreateWindowEvent const& event)
-{
-	// raised when event.window is created
-
-	TRACE(event.window, event.parent, event.x, event.y, event.width, event.height, event.override_redirect);
-
-	m_window_manager.on_create_notify(event, m_framebuffers);
-}
-
-
-// void Ortle::on_damage_notify(XDamageNotifyEvent const& event)
-// {
-// 	TRACE(event.drawable);
-
-// 	if (event.drawable == m_root) {
-// 		m_window_manager.on_damage_notify(event);
-// 	}
-// }
-
-
-void Ortle::on_destroy_notify(XDestroyWindowEvent const& event)
-{
-	// raised when event.window is destroyed
-	
-	TRACE(event.window);
-
-	m_window_manager.on_destroy_notify(event);
-}
-
-
-// void Ortle::on_expose(XExposeEvent const& event)
-// {
-// 	TRACE(event.window, event.x, event.y, event.width, event.height);
-// }
-
-
-void Ortle::on_graphics_expose(XGraphicsExposeEvent const& event)
+Ortle::~Ortle()
 {
-	// raised when XCopyArea or XCopyPlane fails when the source of the copy
-	// is either not available (e.g. an obscured root window), or the rquested
-	// area is out of the source's bounds.
-
-	TRACE(event.drawable, event.x, event.y, event.width, event.y);
-
-	m_window_manager.on_graphics_expose(event);
+	// nothing to do
 }
 
 
-void Ortle::on_map_notify(XMapEvent const& event)
-{
-	// raised when event.window is mapped
-
-	TRACE(event.window, event.override_redirect);
-
-	m_window_manager.on_map_notify(event);
-}
 
 
-void Ortle::on_no_expose(XNoExposeEvent const& event)
+void Ortle::run()
 {
-	// raised when XCopyArea or XCopyPlane works.  this tells us that we
-	// succeeded when trying to copy the root window pixmap, and we can now
-	// draw th eroot window.
+	// every screen but the first gets an event thread of its own.  they start
+	// with every signal blocked, leaving them all to this thread.
 
-	TRACE(event.drawable);
+	sigset_t signals;
+	sigfillset(&signals);
 
-	m_window_manager.on_no_expose(event);
-}
+	sigset_t previous;
 
-void Ortle::on_property_notify(XPropertyEvent const& event)
-{
-	// raised when one of event.window's properties changes.  we are only
-	// interested when this happens on the root window, and then only when its
-	// wallpaper pixmap property changes.
+	std::vector<std::thread> threads;
 
-	TRACE(event.window, event.atom);
+	pthread_sigmask(SIG_BLOCK, &signals, &previous);
 
-	if (event.window == m_root) {
-		m_window_manager.on_property_notify(event);
+	try {
+		for (std::size_t i = 1; i < m_compositors.size(); ++i) {
+			threads.push_back(std::thread(&Ortle::run_screen, this, i));
+		}
+	}
+	catch (...) {
+		m_errors[0] = std::current_exception();
+		g_running = false;
 	}
-}
 
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
 
-void Ortle::on_reparent_notify(XReparentEvent const& event)
-{
-	// raised when event.window gets a new parent
-
-	// this is explained more in window_manager.cpp, but the short version is:
-	// we need to start managing event.window if it has been reparented to the
-	// root window, and we need to stop managing it if it has been reparented
-	// to anything else.
+	if (g_running) {
+		run_screen(0);
+	}
 
-	TRACE(event.window, event.parent, event.x, event.y);
+	for (auto& thread : threads) {
+		thread.join();
+	}
 
-	m_window_manager.on_reparent_notify(event, m_framebuffers);
+	for (auto const& error : m_errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
 }
 
 
-void Ortle::on_shape_notify(XShapeEvent const& event)
-{
-	// raised when event.window's shape changes
 
-	TRACE(event.window, "shaped", event.shaped, "extents", event.x, event.y, event.width, event.height);
 
-	m_window_manager.on_shape_notify(event);
-}
-
-
-void Ortle::on_unmap_notify(XUnmapEvent const& event)
+void Ortle::run_screen(std::size_t index)
 {
-	// raised when event.window is unmapped
-
-	TRACE(event.window);
+	try {
+		m_compositors[index]->run(index == 0 ? &m_metrics : nullptr);
+	}
 
-	m_window_manager.on_unmap_notify(event);
+	catch (...) {
+		m_errors[index] = std::current_exception();
+		g_running = false;
+	}
 }
-
@@ -2,23 +2,29 @@
 #define ORTLE_ORTLE_HPP
 
 
+#include "compositor.hpp"
 #include "framebuffer_cache.hpp"
-#include "output_window.hpp"
-#include "renderer.hpp"
-#include "window_manager.hpp"
 
-#include "x11/composite_manager_atom.hpp"
-#include "x11/composite_overlay.hpp"
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
+
 #include "x11/display.hpp"
 #include "x11/error_handler.hpp"
 #include "x11/extension.hpp"
 
-#include <X11/Xlib.h>
-#include <X11/extensions/shape.h>
-#include <X11/extensions/Xdamage.h>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <vector>
+
 
 
 
+// the process: a Compositor for every screen of the display, each handling
+// its events on a thread of its own (the first on the main thread, which
+// also takes the signals) and drawing on another.  they share the render
+// connection, the framebuffer cache and the GL and GLX function pointers,
+// all of which are set up before any of them starts.
 
 class Ortle {
 
@@ -39,48 +45,38 @@ public:
 
 private:
 
-	void process_pending_events();
-
-	void on_circulate_notify(XCirculateEvent const& event);
-	void on_configure_notify(XConfigureEvent const& event);
-	void on_create_notify(XCreateWindowEvent const& event);
-	// void on_damage_notify(XDamageNotifyEvent const& event);
-	void on_destroy_notify(XDestroyWindowEvent const& event);
-	// void on_expose(XExposeEvent const& event);
-	void on_graphics_expose(XGraphicsExposeEvent const& event);
-	void on_map_notify(XMapEvent const& event);
-	void on_no_expose(XNoExposeEvent const& event);
-	void on_property_notify(XPropertyEvent const& event);
-	void on_reparent_notify(XReparentEvent const& event);
-	void on_shape_notify(XShapeEvent const& event);
-	void on_unmap_notify(XUnmapEvent const& event);
+	void run_screen(std::size_t index);
 
 
 private:
 
+	// first, so that it prints everything logged up to the end
+
+	Utility::Log::Writer m_log_writer;
+
 	X11::ErrorHandler m_x11_error_handler;
 
-	X11::Display m_display;
-	int m_screen;
-	Window m_root;
+	// shared by the render threads of every screen and their texture
+	// binders
+
+	X11::Display m_render_display;
 
-	X11::Extension m_composite;
 	X11::Extension m_damage;
-	X11::Extension m_fixes;
-	X11::Extension m_shape;
-	X11::Extension m_glx;
 
 	FramebufferCache m_framebuffers;
 
-	X11::CompositeOverlay m_composite_overlay;
+	std::vector<std::unique_ptr<Compositor>> m_compositors;
 
-	OutputWindow m_output_window;
+	// served by the first screen's event thread, on the main thread.  only
+	// set up once every compositor is, so that a second instance on the same
+	// display fails before touching the first one's socket.
 
-	X11::CompositeManagerAtom m_composite_manager_atom;
+	Utility::Metrics::Server m_metrics;
 
-	Renderer m_renderer;
+	// the exception each compositor stopped with, if any, to be rethrown by
+	// run() once they have all stopped
 
-	WindowManager m_window_manager;
+	std::vector<std::exception_ptr> m_errors;
 
 };
 
@@ -0,0 +1,202 @@
+#include "output_layout.hpp"
+
+#include "scene.hpp"
+
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
+
+#include "x11/round_trip.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+
+#include <cassert>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+
+
+namespace {
+
+
+// for XRRGetScreenResourcesCurrent, which doesn't make the server probe the
+// monitors again
+
+int const l_randr_major = 1;
+int const l_randr_minor = 3;
+
+
+} // namespace
+
+
+
+
+OutputLayout::OutputLayout()
+	: m_display(nullptr)
+	, m_root(None)
+	, m_event_base(-1)
+	, m_outputs()
+	, m_changed(false)
+{}
+
+
+OutputLayout::OutputLayout(Display* display, Window root)
+	: OutputLayout()
+{
+	assert(display != nullptr);
+	assert(root != None);
+
+	m_display = display;
+	m_root = root;
+
+
+	int event_base = 0;
+	int error_base = 0;
+
+	int major = 0;
+	int minor = 0;
+
+	if (!XRRQueryExtension(display, &event_base, &error_base) || !XRRQueryVersion(display, &major, &minor) || major < l_randr_major || (major == l_randr_major && minor < l_randr_minor)) {
+		LOG_DEBUG(Events, "no RandR 1.3, the whole screen is drawn as one output");
+		return;
+	}
+
+	m_event_base = event_base;
+
+	XRRSelectInput(display, root, RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
+
+	query();
+}
+
+
+
+
+OutputLayout::OutputLayout(OutputLayout&& other)
+	: OutputLayout()
+{
+	swap(*this, other);
+}
+
+
+OutputLayout& OutputLayout::operator=(OutputLayout&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+OutputLayout::~OutputLayout()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(OutputLayout& first, OutputLayout& second)
+{
+	using std::swap;
+
+	swap(first.m_display, second.m_display);
+	swap(first.m_root, second.m_root);
+	swap(first.m_event_base, second.m_event_base);
+	swap(first.m_outputs, second.m_outputs);
+	swap(first.m_changed, second.m_changed);
+}
+
+
+
+
+void OutputLayout::on_randr_event(XEvent& event)
+{
+	assert(m_event_base >= 0);
+
+	// keeps Xlib's idea of the screen size up to date
+
+	XRRUpdateConfiguration(&event);
+
+	// a hotplug usually comes as several events in a row, but asking again
+	// for each is cheap next to rebuilding the outputs, which only happens
+	// if the answer is different.
+
+	query();
+}
+
+
+void OutputLayout::describe(Scene& scene) const
+{
+	for (auto const& output : m_outputs) {
+		scene.add_output(output);
+	}
+}
+
+
+
+
+void OutputLayout::query()
+{
+	XRRScreenResources* resources = nullptr;
+
+	{
+		X11::RoundTrip round_trip(Utility::Metrics::RandrGetResources);
+		resources = XRRGetScreenResourcesCurrent(m_display, m_root);
+	}
+
+	if (resources == nullptr) {
+		LOG_WARNING(Events, "could not get RandR screen resources");
+		return;
+	}
+
+	std::vector<Scene::Output> outputs;
+
+	for (int i = 0; i < resources->ncrtc; ++i) {
+
+		XRRCrtcInfo* crtc = nullptr;
+
+		{
+			X11::RoundTrip round_trip(Utility::Metrics::RandrGetCrtcInfo);
+			crtc = XRRGetCrtcInfo(m_display, resources, resources->crtcs[i]);
+		}
+
+		if (crtc == nullptr) {
+			continue;
+		}
+
+		// a CRTC without a mode or outputs is switched off
+
+		if (crtc->mode != None && crtc->noutput > 0 && crtc->width > 0 && crtc->height > 0) {
+
+			Scene::Output output = {
+				crtc->x,
+				crtc->y,
+				static_cast<int>(crtc->width),
+				static_cast<int>(crtc->height)
+			};
+
+			if (std::find(outputs.begin(), outputs.end(), output) == outputs.end()) {
+				outputs.push_back(output);
+			}
+		}
+
+		XRRFreeCrtcInfo(crtc);
+	}
+
+	XRRFreeScreenResources(resources);
+
+
+	// CRTCs come back in a fixed order, so the same monitors in the same
+	// places make the same list.
+
+	if (outputs != m_outputs) {
+
+		LOG_DEBUG(Events, "outputs changed", m_outputs.size(), "->", outputs.size());
+
+		m_outputs = std::move(outputs);
+		m_changed = true;
+	}
+}
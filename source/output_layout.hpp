@@ -0,0 +1,88 @@
+#ifndef ORTLE_OUTPUT_LAYOUT_HPP
+#define ORTLE_OUTPUT_LAYOUT_HPP
+
+
+#include "scene.hpp"
+
+#include <X11/Xlib.h>
+
+#include <vector>
+
+
+
+
+// where the monitors are.  one output for each CRTC that is driving a
+// monitor, found with RandR 1.3, and found again whenever the server says the
+// screen or a CRTC has changed (a monitor plugged in, a mode set...).  CRTCs
+// that mirror one another show the same part of the root window and make a
+// single output.  servers without RandR have no outputs, which the render
+// thread treats as one covering the whole root window.
+//
+// event thread only.
+
+class OutputLayout {
+
+public:
+
+	OutputLayout();
+	OutputLayout(Display* display, Window root);
+
+	OutputLayout(OutputLayout&& other);
+	OutputLayout& operator=(OutputLayout&& other);
+
+	~OutputLayout();
+
+	friend void swap(OutputLayout& first, OutputLayout& second);
+
+
+public:
+
+	// the base of RandR's event types, or -1 if the server has no RandR
+
+	int event_base() const
+	{
+		return m_event_base;
+	}
+
+	// takes any RandR event (screen change or notify)
+
+	void on_randr_event(XEvent& event);
+
+
+public:
+
+	// true if the outputs have changed since clear_changed() was last called
+
+	bool changed() const
+	{
+		return m_changed;
+	}
+
+	void clear_changed()
+	{
+		m_changed = false;
+	}
+
+	void describe(Scene& scene) const;
+
+
+private:
+
+	void query();
+
+
+private:
+
+	Display* m_display;
+	Window m_root;
+
+	int m_event_base;
+
+	std::vector<Scene::Output> m_outputs;
+
+	bool m_changed;
+
+};
+
+
+#endif
@@ -1,15 +1,12 @@
 #include "output_window.hpp"
 
 #include "exceptions.hpp"
-#include "framebuffer_cache.hpp"
+#include "scene.hpp"
 
-#include "glx/context.hpp"
 #include "glx/functions.hpp"
 #include "glx/window.hpp"
 
-#include "opengl/core330.hpp"
-
-#include "utility/trace.hpp"
+#include "utility/log.hpp"
 
 #include "x11/colormap.hpp"
 #include "x11/functions.hpp"
@@ -18,8 +15,6 @@
 #include "x11/window.hpp"
 
 #include <X11/Xlib.h>
-#include <X11/extensions/shape.h>
-#include <X11/extensions/Xfixes.h>
 
 #include <GL/glx.h>
 
@@ -33,35 +28,15 @@
 namespace {
 
 
-int const l_context_attributes[] = {
-
-	GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
-	GLX_CONTEXT_MINOR_VERSION_ARB, 3,
-
-	GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
-
-	GLX_RENDER_TYPE,               GLX_RGBA_TYPE,
-
-	None
-
-};
-
-
-int const l_framebuffer_attributes[] = {
-
-	GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
-	GLX_RENDER_TYPE,   GLX_RGBA_BIT,
-
-	GLX_DOUBLEBUFFER,  True,
+// predicate used with XIfEvent to wait for the output window to be mapped
 
-	GLX_RED_SIZE,      8,
-	GLX_GREEN_SIZE,    8,
-	GLX_BLUE_SIZE,     8,
-	GLX_ALPHA_SIZE,    8,
-
-	None
-
-};
+Bool map_notify(Display*, XEvent* event, XPointer arg)
+{
+	if (event->type == MapNotify && event->xmap.window == *reinterpret_cast<::Window*>(arg)) {
+		return True;
+	}
+	return False;
+}
 
 
 } // namespace
@@ -69,33 +44,33 @@ int const l_framebuffer_attributes[] = {
 
 
 
-OutputWindow::OutputWindow(Display* display, Window root, Window parent, FramebufferCache& framebuffers)
-	: m_display(display)
-	, m_root(root)
-	, m_parent(parent)
+OutputWindow::OutputWindow()
+	: m_display(nullptr)
+	, m_root(None)
+	, m_output{ 0, 0, 0, 0 }
 	, m_colormap()
 	, m_window()
 	, m_glx_window()
-	, m_glx_context()
+{}
+
+
+OutputWindow::OutputWindow(Display* display, Window root, Window parent, GLXFBConfig framebuffer, Scene::Output const& output)
+	: OutputWindow()
 {
 	assert(display != nullptr);
 	assert(root != None);
 	assert(parent != None);
+	assert(framebuffer != nullptr);
+	assert(output.width > 0 && output.height > 0);
 
+	m_display = display;
+	m_root = root;
+	m_output = output;
 
-	TRACE("creating output window on root", root);
 
-	// load glx functions
+	LOG_DEBUG(Glx, "creating output window", output.x, output.y, output.width, output.height);
 
-	GLX::load_functions();
-	
-
-	// get a framebuffer.  this may throw.
-
-	GLXFBConfig framebuffer = framebuffers.choose(l_framebuffer_attributes);
-
-
-	// find that framebuffer's visual info.  this may also throw.
+	// find the framebuffer's visual info.  this may throw.
 
 	X11::VisualInfo visual_info(display, framebuffer);
 
@@ -106,14 +81,8 @@ OutputWindow::OutputWindow(Display* display, Window root, Window parent, Framebu
 	m_colormap = X11::Colormap(display, root, visual_info->visual);
 
 
-	// get the geometry of the root window
-	// this will give us the initial width and height of our window
-
-	X11::Geometry root_geometry(display, root);
-
-
-	// get the geometry of the parent window
-	// this will give us the initial x and y coordinates for our window
+	// get the geometry of the parent window, so that the output's root
+	// coordinates can be made relative to it
 
 	X11::Geometry parent_geometry(display, parent, root);
 
@@ -127,8 +96,7 @@ OutputWindow::OutputWindow(Display* display, Window root, Window parent, Framebu
 
 	unsigned long window_attributes_mask = CWColormap | CWEventMask | CWOverrideRedirect;
 
-	// X11Window window(display, parent, 0, 0, 640, 480, 0, visual_info->depth, InputOutput, visual_info->visual, window_attributes_mask, window_attributes);
-	m_window = X11::Window(display, parent, -parent_geometry.x, -parent_geometry.y, root_geometry.width, root_geometry.height, 0, visual_info->depth, InputOutput, visual_info->visual, window_attributes_mask, window_attributes);
+	m_window = X11::Window(display, parent, output.x - parent_geometry.x, output.y - parent_geometry.y, output.width, output.height, 0, visual_info->depth, InputOutput, visual_info->visual, window_attributes_mask, window_attributes);
 
 
 	// create a glx window
@@ -136,39 +104,21 @@ OutputWindow::OutputWindow(Display* display, Window root, Window parent, Framebu
 	m_glx_window = GLX::Window(display, framebuffer, m_window);
 
 
-	// create a glx context
-
-	m_glx_context = GLX::Context(display, framebuffer, l_context_attributes);
-
-
 	// map the window
 
 	XMapWindow(display, m_window);
 
 
-	// wait for the map to happen
-
-	XEvent event;
-	while(XNextEvent(display, &event)) {
-		if (event.type == MapNotify) {
-			XMapEvent& map_event = reinterpret_cast<XMapEvent&>(event);
-			if (map_event.window == m_window) {
-				break;
-			}
-		}
-	}
-
+	// wait for the map to happen.  the connection is shared by the render
+	// threads of every screen, so only this window's event is taken off the
+	// queue, and once it has come nothing more is asked for.
 
-	// make the context current
+	::Window window = m_window;
 
-	make_context_current();
-
-
-	// load opengl functions
+	XEvent event;
+	XIfEvent(display, &event, &map_notify, reinterpret_cast<XPointer>(&window));
 
-	if (!gl::sys::LoadFunctions()) {
-		throw InitializationError("Could not load OpenGL functions.");
-	}
+	XSelectInput(display, m_window, NoEventMask);
 
 
 	// disable the mouse
@@ -181,13 +131,7 @@ OutputWindow::OutputWindow(Display* display, Window root, Window parent, Framebu
 
 
 OutputWindow::OutputWindow(OutputWindow&& other)
-	: m_display(nullptr)
-	, m_root(None)
-	, m_parent(None)
-	, m_colormap()
-	, m_window()
-	, m_glx_window()
-	, m_glx_context()
+	: OutputWindow()
 {
 	swap(*this, other);
 }
@@ -204,9 +148,9 @@ OutputWindow& OutputWindow::operator=(OutputWindow&& other)
 
 OutputWindow::~OutputWindow()
 {
-	TRACE("destroying output window for root", m_root);
-
-	glXMakeContextCurrent(m_display, None, None, NULL);
+	if (m_display != nullptr) {
+		LOG_DEBUG(Glx, "destroying output window", m_output.x, m_output.y, m_output.width, m_output.height);
+	}
 }
 
 
@@ -218,66 +162,22 @@ void swap(OutputWindow& first, OutputWindow& second)
 
 	swap(first.m_display, second.m_display);
 	swap(first.m_root, second.m_root);
-	swap(first.m_parent, second.m_parent);
+	swap(first.m_output, second.m_output);
 	
 	swap(first.m_colormap, second.m_colormap);
 	swap(first.m_window, second.m_window);
 
 	swap(first.m_glx_window, second.m_glx_window);
-	swap(first.m_glx_context, second.m_glx_context);
-}
-
-
-
-
-void OutputWindow::reconfigure()
-{
-	assert(m_display != nullptr);
-
-
-	// get the geometry of the root window
-	// this will give us the initial width and height of our window
-
-	X11::Geometry root_geometry(m_display, m_root);
-
-
-	// get the geometry of the parent window
-	// this will give us the initial x and y coordinates for our window
-
-	X11::Geometry parent_geometry(m_display, m_parent, m_root);
-
-
-
-	// actually move and resize the window
-
-	set_position(-parent_geometry.x, -parent_geometry.y);
-	set_size(root_geometry.width, root_geometry.height);
 }
 
 
-void OutputWindow::set_size(unsigned int width, unsigned int height)
-{
-	assert(m_display != nullptr);
 
-	XResizeWindow(m_display, m_window, width, height);
-}
 
-
-void OutputWindow::set_position(int x, int y)
+void OutputWindow::make_current(GLXContext context)
 {
 	assert(m_display != nullptr);
 
-	XMoveWindow(m_display, m_window, x, y);
-}
-
-
-
-
-void OutputWindow::make_context_current()
-{
-	assert(m_display != nullptr);
-
-	glXMakeContextCurrent(m_display, m_glx_window, m_glx_window, m_glx_context);
+	glXMakeContextCurrent(m_display, m_glx_window, m_glx_window, context);
 }
 
 
@@ -293,6 +193,9 @@ void OutputWindow::swap_interval(int interval)
 {
 	assert(m_display != nullptr);
 
+	// the MESA flavour applies to the current drawable, so the context has
+	// to be current on this window for it.
+
 	if (GLX::SwapIntervalEXT) {
 		GLX::SwapIntervalEXT(m_display, m_glx_window, interval);
 	}
@@ -303,4 +206,3 @@ void OutputWindow::swap_interval(int interval)
 		throw InitializationError("GLX extension GLX_MESA_swap_control or GLX_EXT_swap_control required.");
 	}
 }
-
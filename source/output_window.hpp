@@ -2,7 +2,8 @@
 #define ORTLE_OUTPUT_WINDOW_HPP
 
 
-#include "glx/context.hpp"
+#include "scene.hpp"
+
 #include "glx/window.hpp"
 
 #include "x11/colormap.hpp"
@@ -10,17 +11,21 @@
 
 #include <X11/Xlib.h>
 
+#include <GL/glx.h>
 
 
 
-class FramebufferCache;
 
+// the window one output is drawn to, covering that output's part of the
+// screen, so that each output has a drawable (and so a swap chain and retrace
+// counter) of its own.  the context is the Presenter's.
 
 class OutputWindow {
 
 public:
 
-	OutputWindow(Display* display, Window root, Window parent, FramebufferCache& framebuffers);
+	OutputWindow();
+	OutputWindow(Display* display, Window root, Window parent, GLXFBConfig framebuffer, Scene::Output const& output);
 
 	OutputWindow(OutputWindow&& other);
 	OutputWindow& operator=(OutputWindow&& other);
@@ -37,11 +42,20 @@ public:
 
 public:
 
-	void reconfigure();
-	void set_position(int x, int y);
-	void set_size(unsigned int width, unsigned int height);
+	// the part of the root window shown, in root coordinates
+
+	Scene::Output const& output() const
+	{
+		return m_output;
+	}
+
+	GLXWindow drawable() const
+	{
+		return m_glx_window;
+	}
+
+	void make_current(GLXContext context);
 
-	void make_context_current();
 	void swap_buffers();
 	void swap_interval(int interval);
 
@@ -50,17 +64,16 @@ private:
 
 	Display* m_display;
 	Window m_root;
-	Window m_parent;
+
+	Scene::Output m_output;
 
 	X11::Colormap m_colormap;
 	X11::Window m_window;
 	
 	GLX::Window m_glx_window;
-	GLX::Context m_glx_context;
 
 };
 
 
 
 #endif
-
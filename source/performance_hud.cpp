@@ -0,0 +1,377 @@
+#include "performance_hud.hpp"
+
+#include "draw_list.hpp"
+#include "scene.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/buffer.hpp"
+#include "opengl/program.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/vertex_array.hpp"
+
+#include <cstddef>
+#include <cstdio>
+
+#include <algorithm>
+#include <vector>
+
+
+
+
+namespace {
+
+
+char const* l_vertex_shader_source = R"(
+
+#version 330
+
+uniform mat4 u_projection;
+
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec4 in_color;
+
+smooth out vec4 s_color;
+
+void main()
+{
+	s_color = in_color;
+	gl_Position = u_projection * vec4(in_position, 0.0, 1.0);
+}
+
+)";
+
+
+char const* l_fragment_shader_source = R"(
+
+#version 330
+
+smooth in vec4 s_color;
+
+out vec4 out_color;
+
+void main()
+{
+	out_color = s_color;
+}
+
+)";
+
+
+// position (x, y) then color (r, g, b, a)
+
+std::size_t const l_vertex_size = 6;
+
+
+// frames in the graph, and averaged for the numbers
+
+std::size_t const l_history = 120;
+std::size_t const l_averaged = 30;
+
+
+// layout, in pixels
+
+float const l_margin = 16.0f;
+float const l_padding = 8.0f;
+
+float const l_bar_width = 2.0f;
+float const l_graph_height = 64.0f;
+
+float const l_row_height = 14.0f;
+float const l_swatch_size = 10.0f;
+float const l_cpu_column = 20.0f;
+float const l_gpu_column = 110.0f;
+
+float const l_panel_width = l_history * l_bar_width + 2.0f * l_padding;
+float const l_panel_height = l_graph_height + 7.0f * l_row_height + 3.0f * l_padding;
+
+
+// the graph's full height is a 30 Hz frame, and its line a 60 Hz one
+
+double const l_graph_scale = 1.0 / 30.0;
+double const l_target_interval = 1.0 / 60.0;
+
+
+// digits are 3 x 5 cells of this size, one row per byte, high bit on the
+// left
+
+float const l_cell = 2.0f;
+float const l_glyph_advance = 4.0f * l_cell;
+
+unsigned char const l_digits[10][5] = {
+	{ 7, 5, 5, 5, 7 },
+	{ 2, 6, 2, 2, 7 },
+	{ 7, 1, 7, 4, 7 },
+	{ 7, 1, 7, 1, 7 },
+	{ 5, 5, 7, 1, 1 },
+	{ 7, 4, 7, 1, 7 },
+	{ 7, 4, 7, 5, 7 },
+	{ 7, 1, 1, 1, 1 },
+	{ 7, 5, 7, 5, 7 },
+	{ 7, 5, 7, 1, 7 }
+};
+
+unsigned char const l_point[5] = { 0, 0, 0, 0, 2 };
+unsigned char const l_minus[5] = { 0, 0, 7, 0, 0 };
+
+
+} // namespace
+
+
+
+
+PerformanceHud::PerformanceHud()
+	: m_program(0)
+	, m_u_projection(0)
+	, m_buffer()
+	, m_vertex_array()
+	, m_frames(l_history)
+	, m_next(0)
+	, m_count(0)
+	, m_vertices()
+{
+	OpenGL::Shader vertex_shader(gl::VERTEX_SHADER, l_vertex_shader_source);
+	OpenGL::Shader fragment_shader(gl::FRAGMENT_SHADER, l_fragment_shader_source);
+
+	m_program = OpenGL::Program{ &vertex_shader, &fragment_shader };
+
+	m_u_projection = gl::GetUniformLocation(m_program, "u_projection");
+
+
+	gl::BindVertexArray(m_vertex_array);
+	gl::BindBuffer(gl::ARRAY_BUFFER, m_buffer);
+
+	gl::EnableVertexAttribArray(0);
+	gl::VertexAttribPointer(0, 2, gl::FLOAT, gl::FALSE_, l_vertex_size * sizeof(GLfloat), 0);
+
+	gl::EnableVertexAttribArray(1);
+	gl::VertexAttribPointer(1, 4, gl::FLOAT, gl::FALSE_, l_vertex_size * sizeof(GLfloat), reinterpret_cast<GLvoid*>(2 * sizeof(GLfloat)));
+
+	gl::BindBuffer(gl::ARRAY_BUFFER, 0);
+	gl::BindVertexArray(0);
+}
+
+
+
+
+PerformanceHud::~PerformanceHud()
+{
+	// nothing to do
+}
+
+
+
+
+void PerformanceHud::add_frame(Frame const& frame)
+{
+	m_frames[m_next] = frame;
+	m_next = (m_next + 1) % m_frames.size();
+	m_count = std::min(m_count + 1, m_frames.size());
+}
+
+
+void PerformanceHud::draw(GLfloat const* projection, Scene::Output const& area)
+{
+	static Color const background = { 0.0f, 0.0f, 0.0f, 0.6f };
+	static Color const line = { 1.0f, 1.0f, 1.0f, 0.5f };
+	static Color const text = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	static Color const good = { 0.2f, 0.8f, 0.2f, 0.9f };
+	static Color const late = { 0.9f, 0.8f, 0.1f, 0.9f };
+	static Color const missed = { 0.9f, 0.2f, 0.2f, 0.9f };
+
+	static Color const phases[PhaseCount] = {
+		{ 0.3f, 0.5f, 1.0f, 1.0f },
+		{ 0.2f, 0.8f, 0.2f, 1.0f },
+		{ 0.2f, 0.8f, 0.8f, 1.0f },
+		{ 0.6f, 0.6f, 0.6f, 1.0f },
+		{ 1.0f, 0.6f, 0.2f, 1.0f }
+	};
+
+	float left = static_cast<float>(area.x) + l_margin;
+	float top = static_cast<float>(area.y) + l_margin;
+
+	add_rectangle(left, top, l_panel_width, l_panel_height, background);
+
+
+	// the graph, oldest frame on the left
+
+	float graph_left = left + l_padding;
+	float graph_bottom = top + l_padding + l_graph_height;
+
+	for (std::size_t i = 0; i < m_count; ++i) {
+
+		Frame const& frame = m_frames[(m_next + m_frames.size() - m_count + i) % m_frames.size()];
+
+		float height = static_cast<float>(std::min(frame.interval / l_graph_scale, 1.0)) * l_graph_height;
+
+		Color const& color = (frame.interval <= l_target_interval * 1.1 ? good : frame.interval <= 2.0 * l_target_interval * 1.1 ? late : missed);
+
+		add_rectangle(graph_left + i * l_bar_width, graph_bottom - height, l_bar_width, height, color);
+	}
+
+	float target = static_cast<float>(l_target_interval / l_graph_scale) * l_graph_height;
+
+	add_rectangle(graph_left, graph_bottom - target, l_history * l_bar_width, 1.0f, line);
+
+
+	// then a row for each phase, the draw calls and the slowest window
+
+	Frame frame = average();
+
+	float y = graph_bottom + l_padding;
+
+	for (int phase = 0; phase < PhaseCount; ++phase) {
+		add_rectangle(graph_left, y, l_swatch_size, l_swatch_size, phases[phase]);
+		add_number(graph_left + l_cpu_column, y, frame.cpu[phase] * 1000.0, 2, text);
+		add_number(graph_left + l_gpu_column, y, frame.gpu[phase] * 1000.0, 2, text);
+		y += l_row_height;
+	}
+
+	add_rectangle(graph_left, y, l_swatch_size, l_swatch_size, text);
+	add_number(graph_left + l_cpu_column, y, frame.draw_calls, 0, text);
+	y += l_row_height;
+
+	add_rectangle(graph_left, y, l_swatch_size, l_swatch_size, phases[Windows]);
+	add_number(graph_left + l_cpu_column, y, static_cast<double>(frame.slowest_window), 0, text);
+	add_number(graph_left + l_gpu_column, y, frame.slowest_window_time * 1000.0, 2, text);
+
+	flush(projection);
+}
+
+
+void PerformanceHud::draw_damage(GLfloat const* projection, std::vector<DrawList::Quad> const& areas)
+{
+	static Color const tint = { 1.0f, 0.0f, 1.0f, 0.25f };
+
+	for (auto const& area : areas) {
+		add_rectangle(area.x, area.y, area.width, area.height, tint);
+	}
+
+	flush(projection);
+}
+
+
+
+
+void PerformanceHud::add_rectangle(float x, float y, float width, float height, Color const& color)
+{
+	GLfloat const corners[6][2] = {
+		{ x, y },
+		{ x + width, y },
+		{ x + width, y + height },
+		{ x, y },
+		{ x + width, y + height },
+		{ x, y + height }
+	};
+
+	for (auto const& corner : corners) {
+		m_vertices.insert(m_vertices.end(), { corner[0], corner[1], color.red, color.green, color.blue, color.alpha });
+	}
+}
+
+
+float PerformanceHud::add_number(float x, float y, double value, int decimals, Color const& color)
+{
+	// unknown values are negative, and shown as a dash
+
+	if (value < 0.0) {
+		return add_glyph(x, y, l_minus, color);
+	}
+
+	char digits[32];
+	std::snprintf(digits, sizeof(digits), "%.*f", decimals, value);
+
+	for (char const* c = digits; *c != '\0'; ++c) {
+		if (*c >= '0' && *c <= '9') {
+			x = add_glyph(x, y, l_digits[*c - '0'], color);
+		}
+		else if (*c == '.') {
+			x = add_glyph(x, y, l_point, color);
+		}
+	}
+
+	return x;
+}
+
+
+float PerformanceHud::add_glyph(float x, float y, unsigned char const* rows, Color const& color)
+{
+	for (int row = 0; row < 5; ++row) {
+		for (int column = 0; column < 3; ++column) {
+			if (rows[row] & (4 >> column)) {
+				add_rectangle(x + column * l_cell, y + row * l_cell, l_cell, l_cell, color);
+			}
+		}
+	}
+
+	return x + l_glyph_advance;
+}
+
+
+void PerformanceHud::flush(GLfloat const* projection)
+{
+	if (m_vertices.empty()) {
+		return;
+	}
+
+	gl::UseProgram(m_program);
+	gl::UniformMatrix4fv(m_u_projection, 1, gl::FALSE_, projection);
+
+	gl::BindVertexArray(m_vertex_array);
+
+	gl::BindBuffer(gl::ARRAY_BUFFER, m_buffer);
+	gl::BufferData(gl::ARRAY_BUFFER, m_vertices.size() * sizeof(GLfloat), m_vertices.data(), gl::STREAM_DRAW);
+	gl::BindBuffer(gl::ARRAY_BUFFER, 0);
+
+	gl::DrawArrays(gl::TRIANGLES, 0, static_cast<GLsizei>(m_vertices.size() / l_vertex_size));
+
+	gl::BindVertexArray(0);
+	gl::UseProgram(0);
+
+	m_vertices.clear();
+}
+
+
+PerformanceHud::Frame PerformanceHud::average() const
+{
+	Frame average = {};
+
+	std::size_t count = std::min(m_count, l_averaged);
+	std::size_t gpu_counts[PhaseCount] = {};
+
+	for (std::size_t i = 0; i < count; ++i) {
+
+		Frame const& frame = m_frames[(m_next + m_frames.size() - 1 - i) % m_frames.size()];
+
+		average.interval += frame.interval;
+		average.draw_calls += frame.draw_calls;
+
+		for (int phase = 0; phase < PhaseCount; ++phase) {
+
+			average.cpu[phase] += frame.cpu[phase];
+
+			if (frame.gpu[phase] >= 0.0) {
+				average.gpu[phase] += frame.gpu[phase];
+				++gpu_counts[phase];
+			}
+		}
+
+		if (frame.slowest_window_time > average.slowest_window_time) {
+			average.slowest_window = frame.slowest_window;
+			average.slowest_window_time = frame.slowest_window_time;
+		}
+	}
+
+	if (count > 0) {
+
+		average.interval /= count;
+		average.draw_calls /= count;
+
+		for (int phase = 0; phase < PhaseCount; ++phase) {
+			average.cpu[phase] /= count;
+			average.gpu[phase] = (gpu_counts[phase] > 0 ? average.gpu[phase] / gpu_counts[phase] : -1.0);
+		}
+	}
+
+	return average;
+}
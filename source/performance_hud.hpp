@@ -0,0 +1,130 @@
+#ifndef ORTLE_PERFORMANCE_HUD_HPP
+#define ORTLE_PERFORMANCE_HUD_HPP
+
+
+#include "draw_list.hpp"
+#include "scene.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/buffer.hpp"
+#include "opengl/program.hpp"
+#include "opengl/vertex_array.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+
+
+// an overlay, drawn by the Renderer in the top left corner of the first
+// output, of how long recent frames took:
+//
+//   - a graph of the time between frames, one bar per frame, green within
+//     60 Hz, yellow within 30 Hz and red beyond, under a line at 60 Hz
+//   - for each phase of a frame, a swatch of its color followed by its CPU
+//     and GPU time in milliseconds, averaged over the last half second
+//   - the number of draw calls per frame, and the window whose draw took
+//     longest on the GPU with its time
+//
+// it can also tint the areas redrawn in the current frame.  there is no
+// font, only digits drawn from a few rectangles each.  everything is batched
+// into a single draw call.  render thread only.
+
+class PerformanceHud {
+
+public:
+
+	enum Phase {
+		Prepare,
+		Draw,
+		Windows,
+		Hud,
+		Swap,
+		PhaseCount
+	};
+
+
+	struct Frame {
+
+		// in seconds.  GPU times are negative when unknown.
+
+		double interval;
+
+		double cpu[PhaseCount];
+		double gpu[PhaseCount];
+
+		unsigned int draw_calls;
+
+		unsigned long slowest_window;
+		double slowest_window_time;
+
+	};
+
+
+public:
+
+	PerformanceHud();
+
+	PerformanceHud(PerformanceHud&&) = delete;
+	PerformanceHud& operator=(PerformanceHud&&) = delete;
+
+	~PerformanceHud();
+
+
+public:
+
+	void add_frame(Frame const& frame);
+
+	// the projection is the one the output is being drawn with, mapping root
+	// coordinates onto it.  the overlay leaves blending on and the program,
+	// vertex array and buffer bindings at zero.
+
+	void draw(GLfloat const* projection, Scene::Output const& area);
+	void draw_damage(GLfloat const* projection, std::vector<DrawList::Quad> const& areas);
+
+
+private:
+
+	struct Color {
+		GLfloat red;
+		GLfloat green;
+		GLfloat blue;
+		GLfloat alpha;
+	};
+
+
+private:
+
+	void add_rectangle(float x, float y, float width, float height, Color const& color);
+
+	// returns the x just past the last digit
+
+	float add_number(float x, float y, double value, int decimals, Color const& color);
+	float add_glyph(float x, float y, unsigned char const* rows, Color const& color);
+
+	void flush(GLfloat const* projection);
+
+	Frame average() const;
+
+
+private:
+
+	OpenGL::Program m_program;
+	GLint m_u_projection;
+
+	OpenGL::Buffer m_buffer;
+	OpenGL::VertexArray m_vertex_array;
+
+	// a ring of the most recent frames, m_next being the oldest once it is
+	// full
+
+	std::vector<Frame> m_frames;
+	std::size_t m_next;
+	std::size_t m_count;
+
+	std::vector<GLfloat> m_vertices;
+
+};
+
+
+#endif
@@ -0,0 +1,98 @@
+#include "pixmap_ledger.hpp"
+
+#include "utility/log.hpp"
+
+#include "x11/pixmap.hpp"
+
+#include <X11/Xlib.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+
+
+PixmapLedger::PixmapLedger()
+	: m_retired()
+	, m_published(0)
+	, m_added(false)
+{}
+
+
+
+
+PixmapLedger::PixmapLedger(PixmapLedger&& other)
+	: PixmapLedger()
+{
+	swap(*this, other);
+}
+
+
+PixmapLedger& PixmapLedger::operator=(PixmapLedger&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+PixmapLedger::~PixmapLedger()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(PixmapLedger& first, PixmapLedger& second)
+{
+	using std::swap;
+
+	swap(first.m_retired, second.m_retired);
+	swap(first.m_published, second.m_published);
+	swap(first.m_added, second.m_added);
+}
+
+
+
+
+void PixmapLedger::retire(X11::Pixmap&& pixmap)
+{
+	if (pixmap == None) {
+		return;
+	}
+
+	// the next scene to be published is the first one without this pixmap
+
+	Entry entry = { m_published + 1, std::move(pixmap) };
+	m_retired.push_back(std::move(entry));
+}
+
+
+
+
+bool PixmapLedger::take_added()
+{
+	bool added = m_added;
+	m_added = false;
+	return added;
+}
+
+
+void PixmapLedger::published(unsigned long serial)
+{
+	m_published = serial;
+}
+
+
+void PixmapLedger::collect(unsigned long acknowledged)
+{
+	auto end = std::find_if(m_retired.begin(), m_retired.end(), [=](Entry const& entry) { return entry.serial > acknowledged; });
+
+	if (end != m_retired.begin()) {
+		LOG_DEBUG(Events, "freeing retired pixmaps", end - m_retired.begin());
+		m_retired.erase(m_retired.begin(), end);
+	}
+}
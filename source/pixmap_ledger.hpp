@@ -0,0 +1,86 @@
+#ifndef ORTLE_PIXMAP_LEDGER_HPP
+#define ORTLE_PIXMAP_LEDGER_HPP
+
+
+#include "x11/pixmap.hpp"
+
+#include <X11/Xlib.h>
+
+#include <vector>
+
+
+
+
+// keeps track of the pixmaps the event thread hands to the render thread.
+// the render thread binds them over its own connection to the server, so a
+// new pixmap has to reach the server before the scene naming it is
+// published, and an old one must not be freed while a scene the render
+// thread might still read names it.  retired pixmaps are therefore held here
+// until the render thread acknowledges a scene published after they were
+// retired.
+
+class PixmapLedger {
+
+public:
+
+	PixmapLedger();
+
+	PixmapLedger(PixmapLedger&& other);
+	PixmapLedger& operator=(PixmapLedger&& other);
+
+	~PixmapLedger();
+
+	friend void swap(PixmapLedger& first, PixmapLedger& second);
+
+
+public:
+
+	// called by windows whenever they create or name a pixmap, and give one
+	// up, respectively.
+
+	void add()
+	{
+		m_added = true;
+	}
+
+	void retire(X11::Pixmap&& pixmap);
+
+
+public:
+
+	// returns true (once) if a pixmap was added since the last call, in
+	// which case the server must be synchronized with before publishing.
+
+	bool take_added();
+
+	void published(unsigned long serial);
+
+	// frees every pixmap that no scene up to and including the acknowledged
+	// one refers to.
+
+	void collect(unsigned long acknowledged);
+
+
+private:
+
+	struct Entry {
+
+		unsigned long serial;
+		X11::Pixmap pixmap;
+
+	};
+
+
+private:
+
+	// in the order they were retired, and so by serial
+
+	std::vector<Entry> m_retired;
+
+	unsigned long m_published;
+	bool m_added;
+
+};
+
+
+#endif
@@ -0,0 +1,479 @@
+#include "presenter.hpp"
+
+#include "exceptions.hpp"
+#include "framebuffer_cache.hpp"
+#include "output_window.hpp"
+#include "scene.hpp"
+
+#include "glx/context.hpp"
+#include "glx/functions.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/debug.hpp"
+
+#include "utility/log.hpp"
+
+#include "x11/geometry.hpp"
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+
+
+namespace {
+
+
+// from GLX_ARB_create_context_no_error, for older headers
+
+#ifndef GLX_CONTEXT_OPENGL_NO_ERROR_ARB
+#define GLX_CONTEXT_OPENGL_NO_ERROR_ARB 0x31B3
+#endif
+
+
+#ifdef NDEBUG
+bool const l_debug = false;
+#else
+bool const l_debug = true;
+#endif
+
+
+int const l_framebuffer_attributes[] = {
+
+	GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
+	GLX_RENDER_TYPE,   GLX_RGBA_BIT,
+
+	GLX_DOUBLEBUFFER,  True,
+
+	GLX_RED_SIZE,      8,
+	GLX_GREEN_SIZE,    8,
+	GLX_BLUE_SIZE,     8,
+	GLX_ALPHA_SIZE,    8,
+
+	None
+
+};
+
+
+// for outputs whose rate can't be had, and for pacing without a retrace
+// counter
+
+int64_t const l_default_period = 1000000 / 60;
+
+
+bool has_glx_extension(Display* display, int screen, char const* name)
+{
+	char const* extensions = glXQueryExtensionsString(display, screen);
+
+	if (extensions == nullptr) {
+		return false;
+	}
+
+	std::istringstream stream(extensions);
+	std::string extension;
+
+	while (stream >> extension) {
+		if (extension == name) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// debug builds ask for a debug context, whose errors are reported as they
+// happen (see OpenGL::enable_debug_output).  release builds check for no
+// errors at all, so where they can they tell the driver not to either.
+
+std::vector<int> context_attributes(Display* display, int screen)
+{
+	std::vector<int> attributes = {
+		GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+		GLX_CONTEXT_MINOR_VERSION_ARB, 3,
+		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+		GLX_RENDER_TYPE,               GLX_RGBA_TYPE
+	};
+
+	if (l_debug) {
+		attributes.push_back(GLX_CONTEXT_FLAGS_ARB);
+		attributes.push_back(GLX_CONTEXT_DEBUG_BIT_ARB);
+	}
+	else if (has_glx_extension(display, screen, "GLX_ARB_create_context_no_error")) {
+		attributes.push_back(GLX_CONTEXT_OPENGL_NO_ERROR_ARB);
+		attributes.push_back(True);
+	}
+	else {
+		LOG_DEBUG(Glx, "no GLX_ARB_create_context_no_error, the driver still checks for OpenGL errors");
+	}
+
+	attributes.push_back(None);
+
+	return attributes;
+}
+
+
+} // namespace
+
+
+
+
+Presenter::Presenter()
+	: m_display(nullptr)
+	, m_root(None)
+	, m_parent(None)
+	, m_framebuffer(nullptr)
+	, m_context_attributes()
+	, m_context()
+	, m_windows()
+	, m_timings()
+	, m_pacing(0)
+	, m_timed(false)
+	, m_presented(false)
+{}
+
+
+Presenter::Presenter(Display* display, int screen, Window root, Window parent, FramebufferCache& framebuffers)
+	: Presenter()
+{
+	assert(display != nullptr);
+	assert(root != None);
+	assert(parent != None);
+
+	m_display = display;
+	m_root = root;
+	m_parent = parent;
+
+
+	LOG_DEBUG(Glx, "creating presenter on root", root);
+
+	// load glx functions
+
+	GLX::load_functions();
+
+
+	// get a framebuffer.  this may throw.
+
+	m_framebuffer = framebuffers.choose(screen, l_framebuffer_attributes);
+
+
+	// create a glx context
+
+	m_context_attributes = context_attributes(display, screen);
+	m_context = GLX::Context(display, m_framebuffer, m_context_attributes.data());
+
+
+	// until the first scene says where the outputs are, draw to one window
+	// covering the whole root window.
+
+	X11::Geometry root_geometry(display, root);
+
+	Scene::Output screen_output = { 0, 0, static_cast<int>(root_geometry.width), static_cast<int>(root_geometry.height) };
+
+	m_timed = (GLX::GetSyncValuesOML != nullptr && has_glx_extension(display, screen, "GLX_OML_sync_control"));
+
+	if (!m_timed) {
+		LOG_DEBUG(Glx, "no GLX_OML_sync_control, every output is presented with every frame");
+	}
+
+	create_windows(std::vector<Scene::Output>(1, screen_output));
+
+
+	// load opengl functions
+
+	if (!gl::sys::LoadFunctions()) {
+		throw InitializationError("Could not load OpenGL functions.");
+	}
+
+	OpenGL::enable_debug_output();
+}
+
+
+
+
+Presenter::Presenter(Presenter&& other)
+	: Presenter()
+{
+	swap(*this, other);
+}
+
+
+Presenter& Presenter::operator=(Presenter&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Presenter::~Presenter()
+{
+	if (m_display != nullptr) {
+		LOG_DEBUG(Glx, "destroying presenter for root", m_root);
+		glXMakeContextCurrent(m_display, None, None, NULL);
+	}
+}
+
+
+
+
+void swap(Presenter& first, Presenter& second)
+{
+	using std::swap;
+
+	swap(first.m_display, second.m_display);
+	swap(first.m_root, second.m_root);
+	swap(first.m_parent, second.m_parent);
+	swap(first.m_framebuffer, second.m_framebuffer);
+	swap(first.m_context_attributes, second.m_context_attributes);
+	swap(first.m_context, second.m_context);
+	swap(first.m_windows, second.m_windows);
+	swap(first.m_timings, second.m_timings);
+	swap(first.m_pacing, second.m_pacing);
+	swap(first.m_timed, second.m_timed);
+	swap(first.m_presented, second.m_presented);
+}
+
+
+
+
+void Presenter::make_context_current()
+{
+	assert(m_display != nullptr);
+	assert(!m_windows.empty());
+
+	m_windows.front().make_current(m_context);
+}
+
+
+void Presenter::release_context()
+{
+	assert(m_display != nullptr);
+
+	glXMakeContextCurrent(m_display, None, None, NULL);
+}
+
+
+GLX::Context Presenter::create_shared_context() const
+{
+	assert(m_display != nullptr);
+
+	return GLX::Context(m_display, m_framebuffer, m_context, m_context_attributes.data());
+}
+
+
+
+
+bool Presenter::update(Scene const& scene)
+{
+	// this is called every frame, so the outputs are only copied if they
+	// have changed.
+
+	std::vector<Scene::Output> const& outputs = scene.outputs();
+
+	if (outputs.empty()) {
+
+		if (scene.width() <= 0 || scene.height() <= 0) {
+			return false;
+		}
+
+		Scene::Output screen_output = { 0, 0, scene.width(), scene.height() };
+
+		if (m_windows.size() == 1 && m_windows.front().output() == screen_output) {
+			return false;
+		}
+
+		LOG_DEBUG(Glx, "resizing output window", scene.width(), scene.height());
+
+		create_windows(std::vector<Scene::Output>(1, screen_output));
+
+		return true;
+	}
+
+	bool same = (outputs.size() == m_windows.size());
+
+	for (std::size_t i = 0; same && i < outputs.size(); ++i) {
+		same = (outputs[i] == m_windows[i].output());
+	}
+
+	if (same) {
+		return false;
+	}
+
+	LOG_DEBUG(Glx, "rebuilding output windows", m_windows.size(), "->", outputs.size());
+
+	create_windows(outputs);
+
+	return true;
+}
+
+
+bool Presenter::ready(std::size_t index) const
+{
+	assert(index < m_windows.size());
+
+	return !m_timed || m_timings[index].msc >= m_timings[index].target;
+}
+
+
+void Presenter::begin(std::size_t index)
+{
+	assert(index < m_windows.size());
+
+	if (m_windows.size() > 1) {
+		m_windows[index].make_current(m_context);
+	}
+}
+
+
+void Presenter::present(std::size_t index)
+{
+	assert(index < m_windows.size());
+
+	if (m_timed) {
+
+		// shown at the retrace after the one we just woke up for, the same
+		// as a swap interval of one would
+
+		Timing& timing = m_timings[index];
+
+		timing.target = timing.msc + 1;
+
+		GLX::SwapBuffersMscOML(m_display, m_windows[index].drawable(), timing.target, 0, 0);
+	}
+	else {
+		m_windows[index].swap_buffers();
+	}
+
+	m_presented = true;
+}
+
+
+bool Presenter::wait(unsigned int& retrace)
+{
+	assert(!m_windows.empty());
+
+	bool presented = m_presented;
+	m_presented = false;
+
+	if (m_timed) {
+
+		// the output whose next retrace comes first
+
+		std::size_t next = 0;
+
+		for (std::size_t i = 1; i < m_timings.size(); ++i) {
+			if (m_timings[i].ust + m_timings[i].period < m_timings[next].ust + m_timings[next].period) {
+				next = i;
+			}
+		}
+
+		Timing& timing = m_timings[next];
+
+		int64_t sbc = 0;
+
+		GLX::WaitForMscOML(m_display, m_windows[next].drawable(), timing.msc + 1, 0, 0, &timing.ust, &timing.msc, &sbc);
+
+		sample();
+
+		retrace = static_cast<unsigned int>(m_timings[m_pacing].msc);
+
+		return true;
+	}
+
+	if (GLX::WaitVideoSyncSGI) {
+		GLX::WaitVideoSyncSGI(1, 0, &retrace);
+		return true;
+	}
+
+
+	// without a counter, a swap is the only thing that holds us back, so
+	// don't go round again straight away if nothing was presented.
+
+	if (!presented) {
+		std::this_thread::sleep_for(std::chrono::microseconds(l_default_period));
+	}
+
+	return false;
+}
+
+
+
+
+void Presenter::create_windows(std::vector<Scene::Output> const& outputs)
+{
+	assert(!outputs.empty());
+
+	std::vector<OutputWindow> windows;
+
+	for (auto const& output : outputs) {
+		windows.push_back(OutputWindow(m_display, m_root, m_parent, m_framebuffer, output));
+	}
+
+
+	// move the context over before the old windows go
+
+	windows.front().make_current(m_context);
+
+	m_windows.swap(windows);
+
+	windows.clear();
+
+
+	// swap intervals belong to the drawable
+
+	for (auto& window : m_windows) {
+		window.make_current(m_context);
+		window.swap_interval(1);
+	}
+
+	m_windows.front().make_current(m_context);
+
+
+	m_timings.assign(m_windows.size(), Timing{ 0, 0, 0, l_default_period });
+	m_pacing = 0;
+
+	if (m_timed) {
+
+		for (std::size_t i = 0; i < m_windows.size(); ++i) {
+
+			int32_t numerator = 0;
+			int32_t denominator = 0;
+
+			if (GLX::GetMscRateOML(m_display, m_windows[i].drawable(), &numerator, &denominator) && numerator > 0 && denominator > 0) {
+				m_timings[i].period = static_cast<int64_t>(denominator) * 1000000 / numerator;
+			}
+
+			if (m_timings[i].period < m_timings[m_pacing].period) {
+				m_pacing = i;
+			}
+		}
+
+		sample();
+	}
+}
+
+
+void Presenter::sample()
+{
+	for (std::size_t i = 0; i < m_windows.size(); ++i) {
+
+		int64_t sbc = 0;
+
+		GLX::GetSyncValuesOML(m_display, m_windows[i].drawable(), &m_timings[i].ust, &m_timings[i].msc, &sbc);
+	}
+}
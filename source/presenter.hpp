@@ -0,0 +1,161 @@
+#ifndef ORTLE_PRESENTER_HPP
+#define ORTLE_PRESENTER_HPP
+
+
+#include "output_window.hpp"
+#include "scene.hpp"
+
+#include "glx/context.hpp"
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+
+class FramebufferCache;
+
+
+// owns the context everything is drawn with, and an OutputWindow for each
+// output, and decides when each output gets a new frame.
+//
+// with GLX_OML_sync_control every output keeps its own retrace counter, and
+// is given a frame right after each of its retraces, to be shown at the
+// next, so monitors with different refresh rates each run at their own.
+// without it, every output is presented after every frame, and the first
+// output's retraces set the pace.
+//
+// the output windows are rebuilt whenever a scene comes with different
+// outputs (see OutputLayout).  everything but construction and
+// create_shared_context() happens on the render thread.
+
+class Presenter {
+
+public:
+
+	Presenter();
+	Presenter(Display* display, int screen, Window root, Window parent, FramebufferCache& framebuffers);
+
+	Presenter(Presenter&& other);
+	Presenter& operator=(Presenter&& other);
+
+	~Presenter();
+
+	friend void swap(Presenter& first, Presenter& second);
+
+
+public:
+
+	// the context is current on one thread at a time.  a thread has to
+	// release it before another can make it current.
+
+	void make_context_current();
+	void release_context();
+
+	// a new context for another thread, sharing this one's textures.  it has
+	// no drawable of its own; GL 3 contexts can be made current without one.
+
+	GLX::Context create_shared_context() const;
+
+
+public:
+
+	// rebuilds the output windows if the scene's outputs are not the ones
+	// being drawn to, and returns true if it did.
+
+	bool update(Scene const& scene);
+
+	std::size_t size() const
+	{
+		return m_windows.size();
+	}
+
+	Scene::Output const& output(std::size_t index) const
+	{
+		return m_windows[index].output();
+	}
+
+	// the output with the highest refresh rate.  animations move along with
+	// its retraces.
+
+	std::size_t pacing() const
+	{
+		return m_pacing;
+	}
+
+	// true if the output has shown the last frame presented to it, and can
+	// take another
+
+	bool ready(std::size_t index) const;
+
+	// draw an output's frame between begin() and present()
+
+	void begin(std::size_t index);
+	void present(std::size_t index);
+
+	// sleeps until the next retrace of whichever output has one first.
+	// returns false if there is no retrace counter, otherwise sets retrace to
+	// that of the pacing output.
+
+	bool wait(unsigned int& retrace);
+
+
+private:
+
+	struct Timing {
+
+		// from the last glXGetSyncValuesOML: when the output last retraced
+		// (in microseconds), and how many times it has
+
+		int64_t ust;
+		int64_t msc;
+
+		// the retrace the last frame presented is to be shown at
+
+		int64_t target;
+
+		// microseconds between retraces
+
+		int64_t period;
+
+	};
+
+
+private:
+
+	void create_windows(std::vector<Scene::Output> const& outputs);
+
+	void sample();
+
+
+private:
+
+	Display* m_display;
+	Window m_root;
+	Window m_parent;
+
+	GLXFBConfig m_framebuffer;
+
+	// shared contexts are made with the same attributes, since a no-error
+	// context can only share with another
+
+	std::vector<int> m_context_attributes;
+	GLX::Context m_context;
+
+	std::vector<OutputWindow> m_windows;
+	std::vector<Timing> m_timings;
+
+	std::size_t m_pacing;
+
+	bool m_timed;
+	bool m_presented;
+
+};
+
+
+#endif
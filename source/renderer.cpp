@@ -1,20 +1,42 @@
 #include "renderer.hpp"
 
-#include "managed_window.hpp"
-#include "window_manager.hpp"
+#include "draw_list.hpp"
+#include "framebuffer_cache.hpp"
+#include "gpu_timeline.hpp"
+#include "performance_hud.hpp"
+#include "scene.hpp"
+#include "surface.hpp"
+#include "texture_binder.hpp"
+
+#include "glx/functions.hpp"
 
 #include "opengl/core330.hpp"
 #include "opengl/buffer.hpp"
+#include "opengl/framebuffer.hpp"
 #include "opengl/program.hpp"
 #include "opengl/shader.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/texture_pool.hpp"
 #include "opengl/vertex_array.hpp"
 
-#include "utility/trace.hpp"
+#include "utility/flight_recorder.hpp"
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
 
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 
 #include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 
 
@@ -219,17 +241,59 @@ GLushort const l_index_data[] = {
 };
 
 
+// a window at the bottom of the stack is moved into the layer cache after
+// this many frames without a change.
+
+unsigned long const l_layer_idle_frames = 30;
+
+
+// caching only pays off if the layer replaces more than the root window.
+
+std::size_t const l_layer_minimum_windows = 2;
+
+
+// areas of damage kept for outputs that haven't been drawn since
+
+std::size_t const l_damage_limit = 256;
+
+
+// from GL_EXT_x11_sync_object
+
+GLenum const l_sync_x11_fence = 0x90E1;
+
+
+bool has_extension(char const* name)
+{
+	GLint count = 0;
+	gl::GetIntegerv(gl::NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; ++i) {
+		char const* extension = reinterpret_cast<char const*>(gl::GetStringi(gl::EXTENSIONS, i));
+		if (extension != nullptr && std::strcmp(extension, name) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
 } // namespace
 
 
 
 
-Renderer::Renderer()
-	: m_program(0)
+Renderer::Renderer(Display* display, int screen, FramebufferCache& framebuffers, TextureBinder& binder)
+	: m_display(display)
+	, m_screen(screen)
+	, m_framebuffers(&framebuffers)
+	, m_program(0)
 	, m_program_shadow(0)
 	, m_vertex_buffer()
 	, m_index_buffer()
 	, m_vertex_array()
+	, m_shape_vertex_array()
+	, m_framebuffer()
 	, m_u_projection_matrix(0)
 	, m_u_texture(0)
 	, m_u_border_width(0)
@@ -237,9 +301,43 @@ Renderer::Renderer()
 	, m_u_rectangle_geometry(0)
 	, m_u_shadow(0)
 	, m_projection_matrix{ 0.0f }
+	, m_width(0)
+	, m_height(0)
+	, m_screen_width(0)
+	, m_screen_height(0)
+	, m_offscreen(false)
+	, m_x_fences(false)
+	, m_shadows(true)
+	, m_animation_steps(1)
+	, m_background_interval(1)
+	, m_frame(0)
+	, m_textures()
+	, m_surfaces()
+	, m_binder(&binder)
+	, m_bindings()
+	, m_waits()
+	, m_serial(0)
+	, m_draw_list()
+	, m_output_frames()
+	, m_damage()
+	, m_redraw_frame(0)
+	, m_redraw(true)
+	, m_stack()
+	, m_layer(0)
+	, m_layer_width(0)
+	, m_layer_height(0)
+	, m_layer_frame(0)
+	, m_layer_windows()
+	, m_hud_mode(Scene::HudHidden)
+	, m_timeline()
+	, m_hud()
+	, m_hud_frame()
+	, m_hud_frame_start()
+	, m_hud_damage()
 {
+	assert(display != nullptr);
 
-	TRACE("creating new renderer");
+	LOG_DEBUG(Render, "creating new renderer");
 
 
 	OpenGL::Shader vertex_shader(gl::VERTEX_SHADER, l_vertex_shader_source);
@@ -273,6 +371,17 @@ Renderer::Renderer()
 	gl::BindBuffer(gl::ARRAY_BUFFER, 0);
 
 	gl::BindVertexArray(0);
+
+
+	// shape buffers use the same vertex layout, but each window has its own
+	// buffer, attached in draw_shape().
+
+	gl::BindVertexArray(m_shape_vertex_array);
+
+	gl::EnableVertexAttribArray(0);
+	gl::EnableVertexAttribArray(1);
+
+	gl::BindVertexArray(0);
 	
 
 	m_u_projection_matrix = gl::GetUniformLocation(m_program, "u_projection");
@@ -290,17 +399,25 @@ Renderer::Renderer()
 
 	gl::Enable(gl::BLEND);
 	gl::BlendFunc(gl::SRC_ALPHA, gl::ONE_MINUS_SRC_ALPHA);
+
+
+	m_x_fences = (GLX::ImportSyncEXT != nullptr && has_extension("GL_EXT_x11_sync_object"));
 }
 
 
 
 
 Renderer::Renderer(Renderer&& other)
-	: m_program(0)
+	: m_display(nullptr)
+	, m_screen(0)
+	, m_framebuffers(nullptr)
+	, m_program(0)
 	, m_program_shadow(0)
 	, m_vertex_buffer(0)
 	, m_index_buffer(0)
 	, m_vertex_array(0)
+	, m_shape_vertex_array(0)
+	, m_framebuffer(0)
 	, m_u_projection_matrix(0)
 	, m_u_texture(0)
 	, m_u_border_width(0)
@@ -308,6 +425,39 @@ Renderer::Renderer(Renderer&& other)
 	, m_u_rectangle_geometry(0)
 	, m_u_shadow(0)
 	, m_projection_matrix{ 0.0f }
+	, m_width(0)
+	, m_height(0)
+	, m_screen_width(0)
+	, m_screen_height(0)
+	, m_offscreen(false)
+	, m_x_fences(false)
+	, m_shadows(true)
+	, m_animation_steps(1)
+	, m_background_interval(1)
+	, m_frame(0)
+	, m_textures()
+	, m_surfaces()
+	, m_binder(nullptr)
+	, m_bindings()
+	, m_waits()
+	, m_serial(0)
+	, m_draw_list()
+	, m_output_frames()
+	, m_damage()
+	, m_redraw_frame(0)
+	, m_redraw(true)
+	, m_stack()
+	, m_layer(0)
+	, m_layer_width(0)
+	, m_layer_height(0)
+	, m_layer_frame(0)
+	, m_layer_windows()
+	, m_hud_mode(Scene::HudHidden)
+	, m_timeline()
+	, m_hud()
+	, m_hud_frame()
+	, m_hud_frame_start()
+	, m_hud_damage()
 {
 	swap(*this, other);
 }
@@ -325,7 +475,11 @@ Renderer& Renderer::operator=(Renderer&& other)
 Renderer::~Renderer()
 {
 	if (m_program != 0) {
-		TRACE("destroying renderer");
+		LOG_DEBUG(Render, "destroying renderer");
+	}
+
+	for (auto const& wait : m_waits) {
+		gl::DeleteSync(wait.sync);
 	}
 }
 
@@ -336,11 +490,16 @@ void swap(Renderer& first, Renderer& second)
 {
 	using std::swap;
 
+	swap(first.m_display, second.m_display);
+	swap(first.m_screen, second.m_screen);
+	swap(first.m_framebuffers, second.m_framebuffers);
 	swap(first.m_program, second.m_program);
 	swap(first.m_program_shadow, second.m_program_shadow);
 	swap(first.m_vertex_buffer, second.m_vertex_buffer);
 	swap(first.m_index_buffer, second.m_index_buffer);
 	swap(first.m_vertex_array, second.m_vertex_array);
+	swap(first.m_shape_vertex_array, second.m_shape_vertex_array);
+	swap(first.m_framebuffer, second.m_framebuffer);
 	swap(first.m_u_projection_matrix, second.m_u_projection_matrix);
 	swap(first.m_u_texture, second.m_u_texture);
 	swap(first.m_u_border_width, second.m_u_border_width);
@@ -348,62 +507,934 @@ void swap(Renderer& first, Renderer& second)
 	swap(first.m_u_rectangle_geometry, second.m_u_rectangle_geometry);
 	swap(first.m_u_shadow, second.m_u_shadow);
 	swap(first.m_projection_matrix, second.m_projection_matrix);
+	swap(first.m_width, second.m_width);
+	swap(first.m_height, second.m_height);
+	swap(first.m_screen_width, second.m_screen_width);
+	swap(first.m_screen_height, second.m_screen_height);
+	swap(first.m_offscreen, second.m_offscreen);
+	swap(first.m_x_fences, second.m_x_fences);
+	swap(first.m_shadows, second.m_shadows);
+	swap(first.m_animation_steps, second.m_animation_steps);
+	swap(first.m_background_interval, second.m_background_interval);
+	swap(first.m_frame, second.m_frame);
+	swap(first.m_textures, second.m_textures);
+	swap(first.m_surfaces, second.m_surfaces);
+	swap(first.m_binder, second.m_binder);
+	swap(first.m_bindings, second.m_bindings);
+	swap(first.m_waits, second.m_waits);
+	swap(first.m_serial, second.m_serial);
+	swap(first.m_draw_list, second.m_draw_list);
+	swap(first.m_output_frames, second.m_output_frames);
+	swap(first.m_damage, second.m_damage);
+	swap(first.m_redraw_frame, second.m_redraw_frame);
+	swap(first.m_redraw, second.m_redraw);
+	swap(first.m_stack, second.m_stack);
+	swap(first.m_layer, second.m_layer);
+	swap(first.m_layer_width, second.m_layer_width);
+	swap(first.m_layer_height, second.m_layer_height);
+	swap(first.m_layer_frame, second.m_layer_frame);
+	swap(first.m_layer_windows, second.m_layer_windows);
+	swap(first.m_hud_mode, second.m_hud_mode);
+	swap(first.m_timeline, second.m_timeline);
+	swap(first.m_hud, second.m_hud);
+	swap(first.m_hud_frame, second.m_hud_frame);
+	swap(first.m_hud_frame_start, second.m_hud_frame_start);
+	swap(first.m_hud_damage, second.m_hud_damage);
 }
 
 
 
-void Renderer::set_viewport(unsigned int width, unsigned int height)
+void Renderer::prepare(Scene const& scene)
 {
 	assert(m_program != 0);
+	// assert(m_program_shadow != 0);
 
-	if (width < 2) {
-		width = 2;
-	}
+	++m_frame;
 
-	if (height < 2) {
-		height = 2;
-	}
+	update_hud(scene.hud());
 
-	m_projection_matrix[0] = 2.0f / static_cast<float>(width);
-	m_projection_matrix[5] = -2.0f / static_cast<float>(height);
+	auto started = std::chrono::steady_clock::now();
+	std::size_t gpu_span = begin_gpu_span(PerformanceHud::Prepare, 0);
 
-	gl::Viewport(0, 0, width, height);
-}
 
-void Renderer::render(WindowManager::Iterator begin, WindowManager::Iterator end)
-{
-	assert(m_program != 0);
-	// assert(m_program_shadow != 0);
+	// the scene carries the size of the root window, which the layer covers
+
+	if (scene.width() > 0 && scene.height() > 0) {
+		if (static_cast<unsigned int>(scene.width()) != m_screen_width || static_cast<unsigned int>(scene.height()) != m_screen_height) {
+			m_screen_width = scene.width();
+			m_screen_height = scene.height();
+			m_redraw = true;
+		}
+	}
 
 
 	gl::ActiveTexture(gl::TEXTURE0);
 
 	gl::UseProgram(m_program_shadow);
-    gl::UniformMatrix4fv(m_u_projection_matrix, 1, gl::FALSE_, m_projection_matrix);
     gl::Uniform1i(m_u_texture, 0);
     gl::BindVertexArray(m_vertex_array);
 
 	gl::UseProgram(m_program);
-    gl::UniformMatrix4fv(m_u_projection_matrix, 1, gl::FALSE_, m_projection_matrix);
     gl::Uniform1i(m_u_texture, 0);
     gl::BindVertexArray(m_vertex_array);
 
-  int cnt = 0;
+	// the GPU must not sample any window before the server has finished
+	// drawing the damage that made this scene.  this queues a wait for that
+	// on the GPU, and does not block here.
 
-	for (auto it = begin; it != end; ++it) {
-    cnt++;
-    (*it)->render(*this);
+	if (scene.serial() != m_serial && scene.fence() != None) {
+		wait_for_x_fence(scene.fence(), scene.serial());
 	}
 
-  // printf("%i\n", cnt);
+
+	// a surface whose new texture has come back from the binder may have
+	// become visible, so that rebuilds the draw list, too.
+
+	bool adopted = adopt_bindings();
+	bool updated = (scene.serial() != m_serial || adopted);
+
+	if (updated) {
+		update_surfaces(scene, true);
+	}
+	else {
+		update_draw_list();
+	}
+
+
+	// bring the layer cache up to date, which also works out what changed
+	// in this frame
+
+	update_layer();
+
+	if (updated) {
+		Utility::Metrics::set(Utility::Metrics::TextureBytes, m_screen, static_cast<long long>(texture_bytes()));
+	}
+
+	if (m_redraw) {
+		m_redraw_frame = m_frame;
+		m_redraw = false;
+		m_damage.clear();
+	}
 
 
 	gl::BindVertexArray(0);
 
 	gl::UseProgram(0);
+
+	end_gpu_span(gpu_span);
+	add_cpu_time(PerformanceHud::Prepare, started);
+}
+
+
+bool Renderer::damaged(std::size_t output, Scene::Output const& area) const
+{
+	if (output >= m_output_frames.size()) {
+		return true;
+	}
+
+	unsigned long frame = m_output_frames[output];
+
+	if (frame == 0 || m_redraw_frame > frame) {
+		return true;
+	}
+
+	for (auto const& damage : m_damage) {
+		if (damage.frame > frame
+			&& damage.area.x < area.x + area.width && area.x < damage.area.x + damage.area.width
+			&& damage.area.y < area.y + area.height && area.y < damage.area.y + damage.area.height) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void Renderer::draw_output(std::size_t output, Scene::Output const& area)
+{
+	assert(m_program != 0);
+
+	auto started = std::chrono::steady_clock::now();
+	std::size_t gpu_span = begin_gpu_span(PerformanceHud::Draw, output);
+
+	set_viewport(area);
+
+	gl::Clear(gl::COLOR_BUFFER_BIT);
+
+	set_projection(m_projection_matrix);
+
+	gl::BindVertexArray(m_vertex_array);
+
+
+	// draw the bottom of the stack from the layer cache, if it has one, and
+	// everything above it directly.  update_layer() left exactly the windows
+	// at the bottom that the layer holds in m_layer_windows.
+
+	std::size_t first = m_layer_windows.size();
+
+	if (first > 0) {
+		draw_layer();
+	}
+
+	end_gpu_span(gpu_span);
+	add_cpu_time(PerformanceHud::Draw, started);
+
+	started = std::chrono::steady_clock::now();
+
+	draw_entries(first, m_draw_list.size());
+
+	add_cpu_time(PerformanceHud::Windows, started);
+
+
+	gl::BindVertexArray(0);
+
+	gl::UseProgram(0);
+
+
+	// the HUD goes on top of everything, and needs to know what this output
+	// last showed to tint what changed since
+
+	if (m_hud) {
+		draw_hud(output, area);
+	}
+
+
+	// damage every output has seen is no longer needed
+
+	if (output < m_output_frames.size()) {
+
+		m_output_frames[output] = m_frame;
+
+		unsigned long oldest = *std::min_element(m_output_frames.begin(), m_output_frames.end());
+
+		auto seen = [oldest] (Damage const& damage) { return damage.frame <= oldest; };
+
+		m_damage.erase(std::remove_if(m_damage.begin(), m_damage.end(), seen), m_damage.end());
+	}
+}
+
+
+void Renderer::advance_animations()
+{
+	// animations move on by one step per retrace of the fastest output
+
+	for (auto index : m_draw_list.animated()) {
+		m_draw_list.owner(index).advance(m_animation_steps);
+	}
+}
+
+
+void Renderer::set_output_count(std::size_t count)
+{
+	m_output_frames.assign(count, 0);
+	m_damage.clear();
+}
+
+
+void Renderer::set_shadows(bool shadows)
+{
+	// the layer was drawn with or without them, so it has to be redrawn
+
+	if (shadows != m_shadows) {
+		m_shadows = shadows;
+		m_layer_windows.clear();
+		m_redraw = true;
+	}
 }
 
 
+void Renderer::set_animation_steps(int steps)
+{
+	assert(steps > 0);
+
+	m_animation_steps = steps;
+}
+
+
+void Renderer::set_background_interval(unsigned long frames)
+{
+	assert(frames > 0);
+
+	m_background_interval = frames;
+}
+
+
+
+
+void Renderer::begin_offscreen(GLuint texture, unsigned int width, unsigned int height)
+{
+	assert(m_program != 0);
+	assert(texture != 0);
+	assert(!m_offscreen);
+
+	m_offscreen = true;
+
+	gl::BindFramebuffer(gl::FRAMEBUFFER, m_framebuffer);
+	gl::FramebufferTexture2D(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D, texture, 0);
+
+	gl::Viewport(0, 0, width, height);
+
+
+	// the on-screen projection flips y so that (0, 0) is the top left corner.
+	// here we leave it unflipped, which stores the top row of the image in the
+	// first row of the texture, the same way glXBindTexImageEXT does.
+
+	GLfloat projection_matrix[16];
+	std::copy(l_projection_matrix, l_projection_matrix + 16, projection_matrix);
+
+	projection_matrix[0] = 2.0f / static_cast<float>(std::max(width, 2u));
+	projection_matrix[5] = 2.0f / static_cast<float>(std::max(height, 2u));
+	projection_matrix[13] = -1.0f;
+
+	set_projection(projection_matrix);
+
+
+	// offscreen targets are copies: whatever we draw replaces what is there
+
+	gl::Disable(gl::BLEND);
+}
+
+
+void Renderer::end_offscreen()
+{
+	assert(m_program != 0);
+
+	assert(m_offscreen);
+
+	m_offscreen = false;
+
+	gl::FramebufferTexture2D(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D, 0, 0);
+	gl::BindFramebuffer(gl::FRAMEBUFFER, 0);
+
+	gl::Viewport(0, 0, m_width, m_height);
+
+	set_projection(m_projection_matrix);
+
+	gl::Enable(gl::BLEND);
+}
+
+
+
+
+void Renderer::set_viewport(Scene::Output const& area)
+{
+	assert(m_program != 0);
+
+	unsigned int width = std::max(area.width, 2);
+	unsigned int height = std::max(area.height, 2);
+
+
+	// maps the output's part of the root window onto the whole drawable,
+	// flipping y so that (0, 0) is the top left corner.
+
+	m_projection_matrix[0] = 2.0f / static_cast<float>(width);
+	m_projection_matrix[5] = -2.0f / static_cast<float>(height);
+	m_projection_matrix[12] = -1.0f - 2.0f * static_cast<float>(area.x) / static_cast<float>(width);
+	m_projection_matrix[13] = 1.0f + 2.0f * static_cast<float>(area.y) / static_cast<float>(height);
+
+	m_width = width;
+	m_height = height;
+
+	gl::Viewport(0, 0, width, height);
+}
+
+
+void Renderer::set_projection(GLfloat const* projection_matrix)
+{
+	// both programs share the vertex shader, so they share the uniform
+	// location, too.  this leaves m_program in use.
+
+	gl::UseProgram(m_program_shadow);
+	gl::UniformMatrix4fv(m_u_projection_matrix, 1, gl::FALSE_, projection_matrix);
+
+	gl::UseProgram(m_program);
+	gl::UniformMatrix4fv(m_u_projection_matrix, 1, gl::FALSE_, projection_matrix);
+}
+
+
+
+
+void Renderer::invalidate()
+{
+	m_layer_windows.clear();
+	m_redraw = true;
+}
+
+
+std::size_t Renderer::texture_bytes() const
+{
+	std::size_t bytes = 0;
+
+	if (m_layer != 0) {
+		bytes += 4 * static_cast<std::size_t>(m_layer_width) * static_cast<std::size_t>(m_layer_height);
+	}
+
+	for (auto const& surface : m_surfaces) {
+		bytes += surface.second.texture_bytes();
+	}
+
+	return bytes;
+}
+
+
+void Renderer::add_swap_time(std::chrono::steady_clock::duration time)
+{
+	if (m_hud) {
+		m_hud_frame.cpu[PerformanceHud::Swap] += std::chrono::duration<double>(time).count();
+	}
+}
+
+
+unsigned long Renderer::settled()
+{
+	unsigned long settled = m_serial;
+
+	unsigned long oldest = m_binder->oldest();
+
+	if (oldest != 0 && oldest <= m_serial) {
+		settled = oldest - 1;
+	}
+
+	collect_waits();
+
+	if (!m_waits.empty()) {
+		settled = std::min(settled, m_waits.front().serial - 1);
+	}
+
+	return settled;
+}
+
+
+
+
+void Renderer::wait_for_x_fence(XSyncFence fence, unsigned long serial)
+{
+	assert(m_x_fences);
+
+	GLsync sync = GLX::ImportSyncEXT(l_sync_x11_fence, static_cast<GLintptr>(fence), 0);
+
+	if (sync == nullptr) {
+		LOG_DEBUG(Render, "could not import x fence", fence);
+		return;
+	}
+
+	// deleting the sync right away is fine: it is only freed once nothing
+	// is waiting on it any more.
+
+	gl::WaitSync(sync, 0, gl::TIMEOUT_IGNORED);
+	gl::DeleteSync(sync);
+
+	Wait wait = { serial, gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0) };
+
+	if (wait.sync != nullptr) {
+		m_waits.push_back(wait);
+	}
+}
+
+
+void Renderer::collect_waits()
+{
+	// fences signal in the order they were inserted, so stop at the first
+	// one that hasn't.  the frame's swap usually flushed it already, but a
+	// frame that ends without one (the screen blanked) would leave it
+	// waiting for good, so ask for a flush anyway.
+
+	while (!m_waits.empty()) {
+
+		GLenum status = gl::ClientWaitSync(m_waits.front().sync, gl::SYNC_FLUSH_COMMANDS_BIT, 0);
+
+		if (status != gl::ALREADY_SIGNALED && status != gl::CONDITION_SATISFIED) {
+			break;
+		}
+
+		gl::DeleteSync(m_waits.front().sync);
+		m_waits.pop_front();
+	}
+}
+
+
+
+
+bool Renderer::adopt_bindings()
+{
+	if (!m_binder->take_finished(m_bindings)) {
+		return false;
+	}
+
+	bool adopted = false;
+
+	for (auto& binding : m_bindings) {
+
+		auto surface = m_surfaces.find(binding.window);
+
+		if (surface != m_surfaces.end() && surface->second.adopt(binding)) {
+			adopted = true;
+		}
+		else {
+			m_binder->discard(binding, m_textures);
+		}
+	}
+
+	m_bindings.clear();
+
+	return adopted;
+}
+
+
+void Renderer::follow(Scene const& scene)
+{
+	bool adopted = adopt_bindings();
+
+	if (scene.serial() != m_serial || adopted) {
+		update_surfaces(scene, false);
+	}
+}
+
+
+void Renderer::update_surfaces(Scene const& scene, bool animated)
+{
+	// bring the surface of every window in the new scene up to date (creating
+	// those of new windows), and rebuild the draw list from them on the way.
+
+	m_serial = scene.serial();
+
+	m_draw_list.clear();
+
+	for (auto const& window : scene.windows()) {
+
+		auto surface = m_surfaces.find(window.id);
+
+		if (surface == m_surfaces.end()) {
+			surface = m_surfaces.emplace(window.id, Surface(m_display, m_screen, *m_framebuffers, m_textures, *m_binder, window)).first;
+		}
+
+		surface->second.update(scene, window, *this, animated);
+
+		if (surface->second.visible()) {
+			m_draw_list.add(surface->second, surface->second.item());
+		}
+	}
+
+
+	// windows coming, going or changing places can uncover anything, on any
+	// output.  these are rare enough that everything is redrawn for them.
+
+	bool restacked = (m_stack.size() != m_draw_list.size());
+
+	for (std::size_t i = 0; !restacked && i < m_stack.size(); ++i) {
+		restacked = (m_stack[i] != m_draw_list.window(i));
+	}
+
+	if (restacked) {
+
+		m_redraw = true;
+
+		m_stack.clear();
+
+		for (std::size_t i = 0; i < m_draw_list.size(); ++i) {
+			m_stack.push_back(m_draw_list.window(i));
+		}
+	}
+
+
+	// windows that have left the scene (destroyed, unmapped...) give their
+	// textures back to the pool
+
+	for (auto it = m_surfaces.begin(); it != m_surfaces.end(); ) {
+		if (it->second.serial() != m_serial) {
+			it = m_surfaces.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+
+void Renderer::update_draw_list()
+{
+	// while the scene stays the same, the only entries that change are those
+	// of animated windows, which patch themselves.
+
+	for (auto index : m_draw_list.animated()) {
+		m_draw_list.update(index, m_draw_list.owner(index).item());
+	}
+
+	m_draw_list.prune_animated();
+}
+
+
+void Renderer::draw_entries(std::size_t begin, std::size_t end)
+{
+	DrawList const& list = m_draw_list;
+
+	for (std::size_t i = begin; i < end; ++i) {
+
+		Utility::Span span("draw window", list.window(i));
+
+		std::size_t gpu_span = begin_gpu_span(PerformanceHud::Windows, list.window(i));
+
+		// bind window texture and set window uniforms
+
+		gl::BindTexture(gl::TEXTURE_2D, list.texture(i));
+
+		float border_width = list.border_width(i);
+		DrawList::Quad const& window = list.window_geometry(i);
+
+		set_border_width(border_width);
+
+		if (m_shadows && list.shadow_size(i) > 0.0f) {
+			setShadow();
+			draw_shadow(
+				list.shadow_size(i),
+				window.x - border_width,
+				window.y - border_width,
+				window.width + 2 * border_width,
+				window.height + 2 * border_width
+			);
+			setNormal();
+		}
+
+		set_window_geometry(window.x, window.y, window.width, window.height);
+
+
+		// then either draw the shape if we are shaped, or just draw the whole
+		// window.  shape vertices are in window coordinates, so they are
+		// drawn with a unit rectangle.
+
+		if (list.shape_vertex_count(i) > 0) {
+			set_rectangle_geometry(0.0f, 0.0f, 1.0f, 1.0f);
+			draw_shape(list.shape_buffer(i), list.shape_vertex_count(i));
+		}
+
+		else {
+			DrawList::Quad const& rectangle = list.rectangle_geometry(i);
+			set_rectangle_geometry(rectangle.x, rectangle.y, rectangle.width, rectangle.height);
+			draw_quad();
+		}
+
+		end_gpu_span(gpu_span);
+	}
+
+	gl::BindTexture(gl::TEXTURE_2D, 0);
+}
+
+
+
+
+void Renderer::add_damage(DrawList::Quad const& area)
+{
+	// past a point, one redraw of everything is cheaper than checking every
+	// output against every area
+
+	if (m_redraw) {
+		return;
+	}
+
+	if (m_damage.size() >= l_damage_limit) {
+		m_redraw = true;
+		return;
+	}
+
+	Damage damage = { area, m_frame };
+	m_damage.push_back(damage);
+}
+
+
+std::size_t Renderer::update_layer()
+{
+	// stamp every entry with the last frame its window changed in, and
+	// record where it is and was as damage if that is this frame.  on the
+	// way, check that the cached layer still holds the same windows,
+	// unchanged since it was drawn, and count how many entries at the bottom
+	// of the list have been idle long enough to be cached.
+
+	std::size_t count = m_draw_list.size();
+	std::size_t cached = m_layer_windows.size();
+	std::size_t idle = 0;
+
+	bool valid = (m_layer != 0 && m_layer_width == m_screen_width && m_layer_height == m_screen_height && cached <= count);
+	bool current = true;
+	bool counting = true;
+
+	for (std::size_t i = 0; i < count; ++i) {
+
+		Surface& owner = m_draw_list.owner(i);
+
+		unsigned long change_frame = owner.update_change_frame(m_frame);
+
+		if (change_frame == m_frame) {
+
+			DrawList::Quad const& window = m_draw_list.window_geometry(i);
+			float margin = m_draw_list.border_width(i) + m_draw_list.shadow_size(i);
+
+			DrawList::Quad bounds = { window.x - margin, window.y - margin, window.width + 2.0f * margin, window.height + 2.0f * margin };
+			DrawList::Quad previous = owner.update_bounds(bounds);
+
+			add_damage(bounds);
+
+			if (previous.width > 0.0f && previous.height > 0.0f) {
+				add_damage(previous);
+			}
+		}
+
+		if (i < cached) {
+			if (m_draw_list.window(i) != m_layer_windows[i]) {
+				valid = false;
+			}
+			else if (change_frame > m_layer_frame) {
+				current = false;
+			}
+		}
+
+		if (counting && m_frame - change_frame >= l_layer_idle_frames) {
+			++idle;
+		}
+		else {
+			counting = false;
+		}
+	}
+
+
+	// the layer can be used as is.  note that if it is valid, every window
+	// in it is still idle, so idle >= cached.
+
+	if (m_background_interval == 1 && valid && current && idle == cached) {
+		return cached;
+	}
+
+
+	// while background windows are being throttled, everything below the top
+	// window goes in the layer, idle or not, and a layer that is merely out of
+	// date is kept until it is m_background_interval frames old.
+
+	if (m_background_interval > 1) {
+
+		std::size_t background = (count > 0 ? count - 1 : 0);
+
+		if (valid && cached == background && (current || m_frame - m_layer_frame < m_background_interval)) {
+			return cached;
+		}
+
+		idle = background;
+	}
+
+
+	// either something in the layer changed, or more windows have settled on
+	// top of it.  redraw it if there is enough to cache.
+
+	if (idle < l_layer_minimum_windows) {
+		m_layer_windows.clear();
+		return 0;
+	}
+
+	build_layer(idle);
+
+	return idle;
+}
+
+
+void Renderer::build_layer(std::size_t count)
+{
+	if (m_layer == 0 || m_layer_width != m_screen_width || m_layer_height != m_screen_height) {
+
+		m_layer = OpenGL::Texture();
+		m_layer_width = m_screen_width;
+		m_layer_height = m_screen_height;
+
+		gl::BindTexture(gl::TEXTURE_2D, m_layer);
+
+		gl::TexImage2D(gl::TEXTURE_2D, 0, gl::RGBA8, m_layer_width, m_layer_height, 0, gl::RGBA, gl::UNSIGNED_BYTE, nullptr);
+
+		gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, gl::NEAREST);
+		gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, gl::NEAREST);
+		gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_S, gl::CLAMP_TO_EDGE);
+		gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_T, gl::CLAMP_TO_EDGE);
+
+		gl::BindTexture(gl::TEXTURE_2D, 0);
+	}
+
+
+	// draw the windows exactly as they would be drawn on screen, blending
+	// included, over the same background.
+
+	begin_offscreen(m_layer, m_layer_width, m_layer_height);
+
+	gl::Enable(gl::BLEND);
+	gl::Clear(gl::COLOR_BUFFER_BIT);
+
+	draw_entries(0, count);
+
+	end_offscreen();
+
+
+	m_layer_windows.clear();
+
+	for (std::size_t i = 0; i < count; ++i) {
+		m_layer_windows.push_back(m_draw_list.window(i));
+	}
+
+	m_layer_frame = m_frame;
+}
+
+
+void Renderer::draw_layer()
+{
+	// the layer starts with the root window and covers the whole screen, so
+	// it replaces whatever is underneath it.
+
+	gl::Disable(gl::BLEND);
+
+	gl::BindTexture(gl::TEXTURE_2D, m_layer);
+
+	set_border_width(0.0f);
+	set_window_geometry(0.0f, 0.0f, static_cast<float>(m_layer_width), static_cast<float>(m_layer_height));
+	set_rectangle_geometry(0.0f, 0.0f, static_cast<float>(m_layer_width), static_cast<float>(m_layer_height));
+	draw_quad();
+
+	gl::BindTexture(gl::TEXTURE_2D, 0);
+
+	gl::Enable(gl::BLEND);
+}
+
+
+
+
+void Renderer::update_hud(Scene::HudMode mode)
+{
+	m_hud_mode = mode;
+
+	auto now = std::chrono::steady_clock::now();
+
+	if (mode == Scene::HudHidden) {
+
+		if (m_hud) {
+			LOG_DEBUG(Render, "hiding performance HUD");
+			m_hud.reset();
+			m_timeline.reset();
+		}
+
+		return;
+	}
+
+	if (!m_hud) {
+
+		LOG_DEBUG(Render, "showing performance HUD");
+
+		m_hud.reset(new PerformanceHud());
+		m_timeline.reset(new GpuTimeline(PerformanceHud::PhaseCount));
+
+		m_hud_frame = PerformanceHud::Frame();
+		m_hud_frame_start = now;
+
+		return;
+	}
+
+
+	// hand the frame just drawn to the HUD, with the GPU times of the newest
+	// frame whose queries have come back
+
+	m_hud_frame.interval = std::chrono::duration<double>(now - m_hud_frame_start).count();
+	m_hud_frame_start = now;
+
+	GpuTimeline::Result result;
+
+	if (m_timeline->result(result)) {
+
+		for (int phase = 0; phase < PerformanceHud::PhaseCount; ++phase) {
+			m_hud_frame.gpu[phase] = result.totals[phase];
+		}
+
+		m_hud_frame.slowest_window = result.slowest_ids[PerformanceHud::Windows];
+		m_hud_frame.slowest_window_time = result.slowest_times[PerformanceHud::Windows];
+	}
+	else {
+		std::fill(m_hud_frame.gpu, m_hud_frame.gpu + PerformanceHud::PhaseCount, -1.0);
+	}
+
+	// presenting is not something the GPU can time
+
+	m_hud_frame.gpu[PerformanceHud::Swap] = -1.0;
+
+	m_hud->add_frame(m_hud_frame);
+
+	m_hud_frame = PerformanceHud::Frame();
+
+	m_timeline->next_frame();
+}
+
+
+void Renderer::draw_hud(std::size_t output, Scene::Output const& area)
+{
+	auto started = std::chrono::steady_clock::now();
+	std::size_t gpu_span = begin_gpu_span(PerformanceHud::Hud, output);
+
+
+	// this output redrew everything, or whatever changed since it was last
+	// drawn
+
+	if (m_hud_mode == Scene::HudWithDamage) {
+
+		m_hud_damage.clear();
+
+		unsigned long frame = (output < m_output_frames.size() ? m_output_frames[output] : 0);
+
+		if (frame == 0 || m_redraw_frame > frame) {
+			DrawList::Quad whole = {
+				static_cast<float>(area.x),
+				static_cast<float>(area.y),
+				static_cast<float>(area.width),
+				static_cast<float>(area.height)
+			};
+			m_hud_damage.push_back(whole);
+		}
+		else {
+			for (auto const& damage : m_damage) {
+				if (damage.frame > frame) {
+					m_hud_damage.push_back(damage.area);
+				}
+			}
+		}
+
+		m_hud->draw_damage(m_projection_matrix, m_hud_damage);
+	}
+
+
+	// the panel only goes on the first output
+
+	if (output == 0) {
+		m_hud->draw(m_projection_matrix, area);
+	}
+
+	end_gpu_span(gpu_span);
+	add_cpu_time(PerformanceHud::Hud, started);
+}
+
+
+std::size_t Renderer::begin_gpu_span(PerformanceHud::Phase phase, unsigned long id)
+{
+	return (m_timeline ? m_timeline->begin(phase, id) : 0);
+}
+
+
+void Renderer::end_gpu_span(std::size_t span)
+{
+	if (m_timeline) {
+		m_timeline->end(span);
+	}
+}
+
+
+void Renderer::add_cpu_time(PerformanceHud::Phase phase, std::chrono::steady_clock::time_point start)
+{
+	if (m_hud) {
+		m_hud_frame.cpu[phase] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+
+
+
 void Renderer::setNormal () {
   gl::UseProgram(m_program);
 }
@@ -415,6 +1446,25 @@ void Renderer::setShadow () {
 void Renderer::draw_quad()
 {
 	gl::DrawElements(gl::TRIANGLES, 6, gl::UNSIGNED_SHORT, 0);	
+
+	++m_hud_frame.draw_calls;
+}
+
+
+void Renderer::draw_shape(GLuint buffer, GLsizei vertex_count)
+{
+	gl::BindVertexArray(m_shape_vertex_array);
+
+	gl::BindBuffer(gl::ARRAY_BUFFER, buffer);
+	gl::VertexAttribPointer(0, 4, gl::FLOAT, gl::FALSE_, 6 * sizeof(GLfloat), 0);
+	gl::VertexAttribPointer(1, 2, gl::FLOAT, gl::FALSE_, 6 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(4 * sizeof(GLfloat)));
+	gl::BindBuffer(gl::ARRAY_BUFFER, 0);
+
+	gl::DrawArrays(gl::TRIANGLES, 0, vertex_count);
+
+	++m_hud_frame.draw_calls;
+
+	gl::BindVertexArray(m_vertex_array);
 }
 
 void Renderer::draw_shadow (float size, float x, float y, float w, float h) {
@@ -472,7 +1522,7 @@ void Renderer::draw_shadow (float size, float x, float y, float w, float h) {
 
 void Renderer::set_border_width(float border_width)
 {
-	// TRACE("setting border width", border_width);
+	// LOG_DEBUG(Render, "setting border width", border_width);
 
 	gl::Uniform1f(m_u_border_width, border_width);
 }
@@ -480,7 +1530,7 @@ void Renderer::set_border_width(float border_width)
 
 void Renderer::set_window_geometry(float x, float y, float width, float height)
 {
-	// TRACE("setting window geometry", x, y, width, height);
+	// LOG_DEBUG(Render, "setting window geometry", x, y, width, height);
 
 	gl::Uniform4f(m_u_window_geometry, x, y, width, height);
 }
@@ -488,7 +1538,7 @@ void Renderer::set_window_geometry(float x, float y, float width, float height)
 
 void Renderer::set_rectangle_geometry(float x, float y, float width, float height)
 {
-	// TRACE("setting rectangle geometry", x, y, width, height);
+	// LOG_DEBUG(Render, "setting rectangle geometry", x, y, width, height);
 
 	gl::Uniform4f(m_u_rectangle_geometry, x, y, width, height);
 }
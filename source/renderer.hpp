@@ -2,21 +2,42 @@
 #define ORTLE_RENDERER_HPP
 
 
-#include "window_manager.hpp"
+#include "draw_list.hpp"
+#include "gpu_timeline.hpp"
+#include "performance_hud.hpp"
+#include "scene.hpp"
+#include "surface.hpp"
+#include "texture_binder.hpp"
 
 #include "opengl/core330.hpp"
 #include "opengl/buffer.hpp"
+#include "opengl/framebuffer.hpp"
 #include "opengl/program.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/texture_pool.hpp"
 #include "opengl/vertex_array.hpp"
 
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
 
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+
+
+class FramebufferCache;
 
 
 class Renderer {
 
 public:
 
-	Renderer();
+	Renderer(Display* display, int screen, FramebufferCache& framebuffers, TextureBinder& binder);
 
 	Renderer(Renderer&& other);
 	Renderer& operator=(Renderer&& other);
@@ -28,17 +49,82 @@ public:
 
 public:
 
-	void set_viewport(unsigned int width, unsigned int height);
+	// a frame is drawn in three steps: prepare() brings everything up to
+	// date with the given scene, then draw_output() draws each output (in
+	// its own drawable) that needs it, and advance_animations() moves
+	// animations along once per retrace of the fastest output.  the first
+	// time a scene is prepared, the surfaces of its windows are brought up to
+	// date with it.
+
+	void prepare(Scene const& scene);
+
+	// for when nothing is drawn (the screen is blanked): brings the surfaces
+	// and their texture bindings up to date with the scene, so that
+	// settled() keeps up and retired pixmaps can be freed, but builds no
+	// layer, takes no snapshots and starts no animations.  invalidate()
+	// before drawing again.
+
+	void follow(Scene const& scene);
+
+	// true if anything has changed on the given output since it was last
+	// drawn
+
+	bool damaged(std::size_t output, Scene::Output const& area) const;
+
+	void draw_output(std::size_t output, Scene::Output const& area);
+
+	void advance_animations();
+
+	// outputs are numbered from zero to count - 1.  changing the count
+	// forgets which have been drawn.
+
+	void set_output_count(std::size_t count);
+
+	// the newest scene whose pixmaps and X fence the renderer has let go of:
+	// the last scene drawn, the one before the oldest scene with a binding
+	// still outstanding, or the one before the oldest scene whose fence the
+	// GPU may not have waited on yet, whichever is older.
+
+	unsigned long settled();
+
+	// forgets the layer cache, so that the next frame draws every window
+	// afresh.
+
+	void invalidate();
+
+	// true if the context can wait on the X fences that scenes carry
+	// (GL_EXT_x11_sync_object).
+
+	bool waits_for_x_fences() const
+	{
+		return m_x_fences;
+	}
+
+	// how long presenting an output took, for the performance HUD
+
+	void add_swap_time(std::chrono::steady_clock::duration time);
+
+	// an estimate of the texture memory in use, for the metrics
+
+	std::size_t texture_bytes() const;
+
 
-	
 public:
 
-	void render(WindowManager::Iterator begin, WindowManager::Iterator end);
+	// ways of making frames cheaper, for the FrameGovernor.  shadows can be
+	// turned off, animations sped up (by taking several steps per frame), and
+	// the windows below the top one redrawn only every so many frames, from
+	// the layer cache in between.
+
+	void set_shadows(bool shadows);
+	void set_animation_steps(int steps);
+	void set_background_interval(unsigned long frames);
 
 
 public:
 
 	void draw_quad();
+	void draw_shape(GLuint buffer, GLsizei vertex_count);
 	void draw_shadow(float size, float x, float y, float w, float h);
 	void setNormal();
 	void setShadow();
@@ -50,8 +136,65 @@ public:
 	void set_shadow_side(bool t, bool r, bool b, bool l);
 
 
+public:
+
+	// redirects drawing into the given texture (which must already have
+	// storage for width x height texels) until end_offscreen is called.  the
+	// result is stored top row first, matching the window textures, so it can
+	// be drawn with the same uniforms as any other window.
+
+	void begin_offscreen(GLuint texture, unsigned int width, unsigned int height);
+	void end_offscreen();
+
+
+private:
+
+	void set_viewport(Scene::Output const& area);
+	void set_projection(GLfloat const* projection_matrix);
+
+	void wait_for_x_fence(XSyncFence fence, unsigned long serial);
+	void collect_waits();
+
+	bool adopt_bindings();
+	void update_surfaces(Scene const& scene, bool animated);
+	void update_draw_list();
+	void draw_entries(std::size_t begin, std::size_t end);
+
+	void add_damage(DrawList::Quad const& area);
+
+	std::size_t update_layer();
+	void build_layer(std::size_t count);
+	void draw_layer();
+
+	void update_hud(Scene::HudMode mode);
+	void draw_hud(std::size_t output, Scene::Output const& area);
+
+	// these do nothing unless the HUD is shown
+
+	std::size_t begin_gpu_span(PerformanceHud::Phase phase, unsigned long id);
+	void end_gpu_span(std::size_t span);
+	void add_cpu_time(PerformanceHud::Phase phase, std::chrono::steady_clock::time_point start);
+
+
 private:
 
+	// an area of the screen, in root coordinates, that changed in the given
+	// frame
+
+	struct Damage {
+
+		DrawList::Quad area;
+		unsigned long frame;
+
+	};
+
+
+private:
+
+	Display* m_display;
+	int m_screen;
+	FramebufferCache* m_framebuffers;
+
 	OpenGL::Program m_program;
 	OpenGL::Program m_program_shadow;
 
@@ -59,6 +202,9 @@ private:
 	OpenGL::Buffer m_index_buffer;
 
 	OpenGL::VertexArray m_vertex_array;
+	OpenGL::VertexArray m_shape_vertex_array;
+
+	OpenGL::Framebuffer m_framebuffer;
 
 	GLint m_u_projection_matrix;
 	GLint m_u_texture;
@@ -69,6 +215,91 @@ private:
 
 	GLfloat m_projection_matrix[16];
 
+	// the output being drawn, and the root window
+
+	unsigned int m_width;
+	unsigned int m_height;
+
+	unsigned int m_screen_width;
+	unsigned int m_screen_height;
+
+	bool m_offscreen;
+	bool m_x_fences;
+
+	bool m_shadows;
+	int m_animation_steps;
+	unsigned long m_background_interval;
+
+	unsigned long m_frame;
+
+
+	// one surface for each window in the scene last drawn, whose serial this
+	// is.  the pool is declared first so that it outlives the surfaces, which
+	// give their textures back to it.
+
+	OpenGL::TexturePool m_textures;
+
+	std::unordered_map<Window, Surface> m_surfaces;
+
+	TextureBinder* m_binder;
+	std::vector<TextureBinder::Binding> m_bindings;
+
+	// glWaitSync only queues the wait, so each is followed by a GL fence of
+	// our own, which tells when the GPU has got past it and the X fence may
+	// be triggered again.  oldest first.
+
+	struct Wait {
+		unsigned long serial;
+		GLsync sync;
+	};
+
+	std::deque<Wait> m_waits;
+
+	unsigned long m_serial;
+
+	DrawList m_draw_list;
+
+
+	// what each output needs redrawn: the frame each was last drawn in, the
+	// areas that changed since the oldest of those, and the last frame in
+	// which everything changed (windows came, went or were restacked, the
+	// screen was resized...).  m_stack is the order of the windows drawn.
+
+	std::vector<unsigned long> m_output_frames;
+	std::vector<Damage> m_damage;
+
+	unsigned long m_redraw_frame;
+	bool m_redraw;
+
+	std::vector<Window> m_stack;
+
+
+	// the layer cache: the bottom of the stack, composited once and then
+	// drawn as a single quad for as long as none of its windows change.
+
+	OpenGL::Texture m_layer;
+
+	unsigned int m_layer_width;
+	unsigned int m_layer_height;
+
+	unsigned long m_layer_frame;
+	std::vector<Window> m_layer_windows;
+
+
+	// the performance HUD, and the GPU timings it shows, which only exist
+	// while the scene asks for them.  m_hud_frame collects the times of the
+	// frame being drawn, and is handed to the HUD when the next is prepared.
+
+	Scene::HudMode m_hud_mode;
+
+	std::unique_ptr<GpuTimeline> m_timeline;
+	std::unique_ptr<PerformanceHud> m_hud;
+
+	PerformanceHud::Frame m_hud_frame;
+	std::chrono::steady_clock::time_point m_hud_frame_start;
+
+	std::vector<DrawList::Quad> m_hud_damage;
+
 };
 
 
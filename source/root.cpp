@@ -1,29 +1,22 @@
 #include "root.hpp"
 
 #include "exceptions.hpp"
-#include "framebuffer_cache.hpp"
 #include "managed_window.hpp"
-#include "renderer.hpp"
+#include "pixmap_ledger.hpp"
+#include "scene.hpp"
 
-#include "glx/functions.hpp"
-#include "glx/pixmap.hpp"
-
-#include "opengl/core330.hpp"
-#include "opengl/texture.hpp"
-
-#include "utility/trace.hpp"
+#include "utility/log.hpp"
 
 // #include "x11/damage.hpp"
 #include "x11/geometry.hpp"
 #include "x11/pixmap.hpp"
 #include "x11/wallpaper_pixmap.hpp"
+#include "x11/xlib.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
 // #include <X11/extensions/Xdamage.h>
 
-#include <GL/glx.h>
-
 #include <cassert>
 
 #include <utility>
@@ -31,19 +24,18 @@
 
 
 
-Root::Root(Display* display, int screen, Window root, FramebufferCache& framebuffers)
-	: ManagedWindow(root)
+Root::Root(Display* display, int screen, Window root, PixmapLedger& pixmaps)
+	: ManagedWindow(Kind::Root, root)
 	, m_display(display)
 	, m_screen(screen)
 	, m_root(root)
-	, m_framebuffer(framebuffers.find(XVisualIDFromVisual(XDefaultVisual(display, screen)), XDefaultDepth(display, screen)))
+	, m_visual_id(XVisualIDFromVisual(X11::Xlib::ScreenVisual(display, screen)))
+	, m_depth(X11::Xlib::ScreenDepth(display, screen))
 	// , m_damage(display, root, XDamageReportBoundingBox)
 	, m_pixmap()
-	, m_glx_pixmap()
-	, m_texture()
+	, m_pixmaps(&pixmaps)
 	, m_width(0)
 	, m_height(0)
-	, m_rgba(GLX::framebuffer_supports_rgba(display, m_framebuffer))
 	, m_waiting_for_success(false)
 {
 	assert(display != nullptr);
@@ -51,7 +43,7 @@ Root::Root(Display* display, int screen, Window root, FramebufferCache& framebuf
 	assert(root != None);
 
 
-	TRACE("starting management of root window", root);
+	LOG_DEBUG(Events, "starting management of root window", root);
 
 	X11::WallpaperPixmap::load_atoms(display);
 
@@ -60,26 +52,30 @@ Root::Root(Display* display, int screen, Window root, FramebufferCache& framebuf
 	m_width = geometry.width;
 	m_height = geometry.height;
 
-	create_and_bind();
+	create_pixmap();
 }
 
 
 
 
-Root::Root(Root&& other)
-	: ManagedWindow(None)
+Root::Root()
+	: ManagedWindow(Kind::Root, None)
 	, m_display(nullptr)
 	, m_screen(0)
 	, m_root(None)
-	, m_framebuffer(nullptr)
+	, m_visual_id(0)
+	, m_depth(0)
 	// , m_damage()
 	, m_pixmap()
-	, m_glx_pixmap()
-	, m_texture(0)
+	, m_pixmaps(nullptr)
 	, m_width(0)
 	, m_height(0)
-	, m_rgba(false)
 	, m_waiting_for_success(false)
+{}
+
+
+Root::Root(Root&& other)
+	: Root()
 {
 	swap(*this, other);
 }
@@ -97,7 +93,8 @@ Root& Root::operator=(Root&& other)
 Root::~Root()
 {
 	if (m_display != nullptr) {
-		TRACE("stopping management of root window", m_root);
+		LOG_DEBUG(Events, "stopping management of root window", m_root);
+		release_pixmap();
 	}
 }
 
@@ -114,49 +111,46 @@ void swap(Root& first, Root& second)
 	swap(first.m_screen, second.m_screen);
 	swap(first.m_root, second.m_root);
 
-	swap(first.m_framebuffer, second.m_framebuffer);
+	swap(first.m_visual_id, second.m_visual_id);
+	swap(first.m_depth, second.m_depth);
 
 	// swap(first.m_damage, second.m_damage);
 
 	swap(first.m_pixmap, second.m_pixmap);
-	swap(first.m_glx_pixmap, second.m_glx_pixmap);
-	swap(first.m_texture, second.m_texture);
+	swap(first.m_pixmaps, second.m_pixmaps);
 
 	swap(first.m_width, second.m_width);
 	swap(first.m_height, second.m_height);
 
-	swap(first.m_rgba, second.m_rgba);
 	swap(first.m_waiting_for_success, second.m_waiting_for_success);
 }
 
 
 
 
-void Root::render_impl(Renderer& renderer)
+void Root::describe_impl(Scene& scene) const
 {
-	if (m_pixmap != None && !m_waiting_for_success) {
-
-		gl::BindTexture(gl::TEXTURE_2D, m_texture);
-
-		renderer.set_border_width(0);
-
-		renderer.set_window_geometry(
-			static_cast<float>(0),
-			static_cast<float>(0),
-			static_cast<float>(m_width),
-			static_cast<float>(m_height)
-		);
-
-		renderer.set_rectangle_geometry(
-			static_cast<float>(0),
-			static_cast<float>(0),
-			static_cast<float>(m_width),
-			static_cast<float>(m_height)
-		);
+	scene.resize(m_width, m_height);
 
-		renderer.draw_quad();
+	if (m_pixmap != None && !m_waiting_for_success) {
 
-		gl::BindTexture(gl::TEXTURE_2D, 0);
+		Scene::Window window;
+
+		window.id = m_root;
+		window.pixmap = m_pixmap;
+		window.visual_id = m_visual_id;
+		window.depth = m_depth;
+		window.x = 0;
+		window.y = 0;
+		window.width = m_width;
+		window.height = m_height;
+		window.border_width = 0;
+		window.root = true;
+		window.shaped = false;
+		window.changes = changes();
+		window.shape_changes = 0;
+
+		scene.add(window);
 	}
 }
 
@@ -170,13 +164,15 @@ void Root::on_configure_notify_impl(XConfigureEvent const& event)
 
 	if (event.width != m_width || event.height != m_height) {
 
-		TRACE("handling resize of root window", m_root);
+		LOG_DEBUG(Events, "handling resize of root window", m_root);
 
 		m_width = event.width;
 		m_height = event.height;
 
-		release_and_destroy();
-		create_and_bind();
+		release_pixmap();
+		create_pixmap();
+
+		mark_changed();
 	}
 }
 
@@ -189,7 +185,7 @@ void Root::on_configure_notify_impl(XConfigureEvent const& event)
 
 // 	if (m_pixmap != None) {
 
-// 		TRACE("copying damaged area of root window", m_root, event.area.x, event.area.y, event.area.width, event.area.height);
+// 		LOG_DEBUG(Events, "copying damaged area of root window", m_root, event.area.x, event.area.y, event.area.width, event.area.height);
 
 // 		XCopyArea(
 // 			m_display, m_root, m_pixmap, XDefaultGC(m_display, m_screen),
@@ -207,10 +203,11 @@ void Root::on_graphics_expose_impl(XGraphicsExposeEvent const& event)
 {
 	if (event.drawable == m_pixmap) {
 
-		// this means that the XCopyArea step of create_and_bind() failed.
+		// this means that the XCopyArea step of create_pixmap() failed.
 		// we may as well release any resources we acquired.
 
-		release_and_destroy();
+		release_pixmap();
+		mark_changed();
 	}
 }
 
@@ -219,10 +216,11 @@ void Root::on_no_expose_impl(XNoExposeEvent const& event)
 {
 	if (event.drawable == m_pixmap) {
 
-		// this means that XCopyArea in create_and_bind() succeeded and we 
+		// this means that XCopyArea in create_pixmap() succeeded and we 
 		// can draw this window.
 
 		m_waiting_for_success = false;
+		mark_changed();
 	}
 }
 
@@ -234,53 +232,44 @@ void Root::on_property_notify_impl(XPropertyEvent const& event)
 
 
 	if (X11::WallpaperPixmap::is_compatible_atom(event.atom)) {
-		release_and_destroy();
-		create_and_bind();
+
+		// the root window has not changed size, so if we already have a
+		// pixmap (which the render thread has bound to a texture), the new
+		// wallpaper can be copied straight into it.  the render thread keeps
+		// drawing the pixmap meanwhile, so there is nothing new to wait for.
+
+		bool waiting = m_waiting_for_success;
+
+		if (m_pixmap != None && copy_wallpaper()) {
+			m_waiting_for_success = waiting;
+		}
+		else {
+			release_pixmap();
+			create_pixmap();
+		}
+
+		mark_changed();
 	}
 }
 
 
 
 
-void Root::create_and_bind()
+void Root::create_pixmap()
 {
 	if (m_pixmap == None) {
 
 		// create a pixmap the same size as the root window.  its contents
 		// are undefined.
 
-		m_pixmap = X11::Pixmap(m_display, m_root, m_width, m_height, XDefaultDepth(m_display, m_screen));
-
-
-		// look up the wallpaper pixmap (e.g. _XSETROOT_ID).  note that this is 
-		// just a random property set on the root window and doesn't 
-		// necessarily even refer to a pixmap.  
-
-		X11::WallpaperPixmap wallpaper(m_display, m_root);
+		m_pixmap = X11::Pixmap(m_display, m_root, m_width, m_height, X11::Xlib::ScreenDepth(m_display, m_screen));
 
-
-		// in spite of the previous comment, this check is still somewhat valid 
-		// as X11::WallpaperPixmap will contain None if none of the atoms are 
-		// set.
-
-		if (wallpaper == None) {
+		if (!copy_wallpaper()) {
 			m_pixmap = X11::Pixmap();
 			return;
 		}
 
-		TRACE("copying root pixmap", "source", wallpaper, "target", m_pixmap);
-
-
-		// copy the wallpaper pixmap into our pixmap.  note that we have no way
-		// of checking if this succeeds.  we instead rely on a generated 
-		// NoExpose event to tell us that it is okay to draw anything.
-
-		XCopyArea(
-			m_display, wallpaper, m_pixmap, XDefaultGC(m_display, m_screen),
-			0, 0, m_width, m_height, 0, 0
-		);
-
-		m_waiting_for_success = true;
+		m_pixmaps->add();
 
 
 		// okay, so, there can potentially be stuff that was drawn directly 
@@ -296,43 +285,52 @@ void Root::create_and_bind()
 		// 	m_display, m_root, m_pixmap, XDefaultGC(m_display, m_screen),
 		// 	0, 0, m_width, m_height, 0, 0
 		// );
+	}
+}
 
 
-		// create a glx pixmap for our pixmap
-
-		if (m_rgba) {
-			m_glx_pixmap = GLX::Pixmap(m_display, m_framebuffer, m_pixmap, GLX::Pixmap::rgba_attributes);
-		}
-		else {
-			m_glx_pixmap = GLX::Pixmap(m_display, m_framebuffer, m_pixmap, GLX::Pixmap::rgb_attributes);
-		}
+bool Root::copy_wallpaper()
+{
+	assert(m_pixmap != None);
 
 
-		// bind the glx pixmap to our texture
+	// look up the wallpaper pixmap (e.g. _XSETROOT_ID).  note that this is 
+	// just a random property set on the root window and doesn't 
+	// necessarily even refer to a pixmap.  
 
-		gl::BindTexture(gl::TEXTURE_2D, m_texture);
+	X11::WallpaperPixmap wallpaper(m_display, m_root);
 
-		gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, gl::LINEAR);
-		gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, gl::LINEAR);
 
-		GLX::BindTexImageEXT(m_display, m_glx_pixmap, GLX_FRONT_EXT, NULL);
+	// in spite of the previous comment, this check is still somewhat valid 
+	// as X11::WallpaperPixmap will contain None if none of the atoms are 
+	// set.
 
-		gl::BindTexture(gl::TEXTURE_2D, 0);
+	if (wallpaper == None) {
+		return false;
 	}
-}
 
+	LOG_DEBUG(Events, "copying root pixmap", "source", static_cast<Pixmap>(wallpaper), "target", static_cast<Pixmap>(m_pixmap));
 
-void Root::release_and_destroy()
-{
-	if (m_pixmap != None) {
 
-		gl::BindTexture(gl::TEXTURE_2D, m_texture);
-		GLX::ReleaseTexImageEXT(m_display, m_glx_pixmap, GLX_FRONT_EXT);
-		gl::BindTexture(gl::TEXTURE_2D, 0);
+	// copy the wallpaper pixmap into our pixmap.  note that we have no way
+	// of checking if this succeeds.  we instead rely on a generated 
+	// NoExpose event to tell us that it is okay to draw anything.
+
+	X11::Xlib::CopyArea(
+		m_display, wallpaper, m_pixmap, X11::Xlib::ScreenGC(m_display, m_screen),
+		0, 0, m_width, m_height, 0, 0
+	);
 
-		m_glx_pixmap = GLX::Pixmap();
+	m_waiting_for_success = true;
 
+	return true;
+}
+
+
+void Root::release_pixmap()
+{
+	if (m_pixmap != None) {
+		m_pixmaps->retire(std::move(m_pixmap));
 		m_pixmap = X11::Pixmap();
 	}
 }
-
@@ -3,11 +3,8 @@
 
 
 #include "managed_window.hpp"
-
-#include "glx/pixmap.hpp"
-
-#include "opengl/core330.hpp"
-#include "opengl/texture.hpp"
+#include "pixmap_ledger.hpp"
+#include "scene.hpp"
 
 // #include "x11/damage.hpp"
 #include "x11/pixmap.hpp"
@@ -15,22 +12,17 @@
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
-// #include <X11/extensions/Xdamage.h>
-
-#include <GL/glx.h>
-
+#include <X11/extensions/Xdamage.h>
 
 
 
-class FramebufferCache;
-class Renderer;
-
 
 class Root : public ManagedWindow {
 
 public:
 
-	Root(Display* display, int screen, Window root, FramebufferCache& framebuffers);
+	Root();
+	Root(Display* display, int screen, Window root, PixmapLedger& pixmaps);
 
 	Root(Root&& other);
 	Root& operator=(Root&& other);
@@ -39,6 +31,8 @@ public:
 
 	friend void swap(Root& first, Root& second);
 
+	friend class ManagedWindow;
+
 
 private:
 
@@ -50,13 +44,13 @@ private:
 
 private:
 
-	void render_impl(Renderer& renderer);
+	void describe_impl(Scene& scene) const;
 
 
 private:
 
 	void on_configure_notify_impl(XConfigureEvent const& event);
-	// void on_damage_notify_impl(XDamageNotifyEvent const& event);
+	void on_damage_notify_impl(XDamageNotifyEvent const&) {}
 	void on_graphics_expose_impl(XGraphicsExposeEvent const& event);
 	void on_map_notify_impl(XMapEvent const&) {}
 	void on_no_expose_impl(XNoExposeEvent const& event);
@@ -67,13 +61,9 @@ private:
 
 private:
 
-	void reconfigure(int width, int height, int border_width);
-
-	void bind_composite_pixmap();
-	void release_composite_pixmap();
-
-	void create_and_bind();
-	void release_and_destroy();
+	void create_pixmap();
+	bool copy_wallpaper();
+	void release_pixmap();
 
 
 private:
@@ -82,18 +72,17 @@ private:
 	int m_screen;
 	Window m_root;
 
-	GLXFBConfig m_framebuffer;
+	VisualID m_visual_id;
+	int m_depth;
 
 	// X11::Damage m_damage;
 
 	X11::Pixmap m_pixmap;
-	GLX::Pixmap m_glx_pixmap;
-	OpenGL::Texture m_texture;
+	PixmapLedger* m_pixmaps;
 
 	int m_width;
 	int m_height;
 
-	bool m_rgba;
 	bool m_waiting_for_success;
 
 };
@@ -0,0 +1,115 @@
+#include "scene.hpp"
+
+#include "opengl/core330.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
+
+#include <cassert>
+#include <cstddef>
+
+#include <utility>
+#include <vector>
+
+
+
+
+Scene::Scene()
+	: m_serial(0)
+	, m_fence(None)
+	, m_width(0)
+	, m_height(0)
+	, m_windows()
+	, m_shape_vertices()
+	, m_outputs()
+	, m_hud(HudHidden)
+{}
+
+
+
+
+Scene::Scene(Scene&& other)
+	: Scene()
+{
+	swap(*this, other);
+}
+
+
+Scene& Scene::operator=(Scene&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Scene::~Scene()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(Scene& first, Scene& second)
+{
+	using std::swap;
+
+	swap(first.m_serial, second.m_serial);
+	swap(first.m_fence, second.m_fence);
+	swap(first.m_width, second.m_width);
+	swap(first.m_height, second.m_height);
+	swap(first.m_windows, second.m_windows);
+	swap(first.m_shape_vertices, second.m_shape_vertices);
+	swap(first.m_outputs, second.m_outputs);
+	swap(first.m_hud, second.m_hud);
+}
+
+
+
+
+void Scene::clear()
+{
+	m_fence = None;
+
+	m_windows.clear();
+	m_shape_vertices.clear();
+	m_outputs.clear();
+}
+
+
+void Scene::resize(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+}
+
+
+
+
+void Scene::add(Window const& window)
+{
+	assert(window.pixmap != None);
+
+	m_windows.push_back(window);
+	m_windows.back().shape_begin = m_shape_vertices.size();
+	m_windows.back().shape_end = m_shape_vertices.size();
+}
+
+
+void Scene::add(Window const& window, std::vector<GLfloat> const& shape_vertices)
+{
+	add(window);
+
+	m_shape_vertices.insert(m_shape_vertices.end(), shape_vertices.begin(), shape_vertices.end());
+	m_windows.back().shape_end = m_shape_vertices.size();
+}
+
+
+void Scene::add_output(Output const& output)
+{
+	assert(output.width > 0 && output.height > 0);
+
+	m_outputs.push_back(output);
+}
@@ -0,0 +1,227 @@
+#ifndef ORTLE_SCENE_HPP
+#define ORTLE_SCENE_HPP
+
+
+#include "opengl/core330.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
+
+#include <cstddef>
+#include <vector>
+
+
+
+
+// everything the render thread needs to know about the stack, written by the
+// event thread after each batch of events and never touched again until the
+// render thread is done with it (see SceneExchange).  it only holds plain
+// values: X ids, geometry, and the vertices of window shapes.  the GL
+// resources that go with each window live with the renderer (see Surface).
+
+class Scene {
+
+public:
+
+	struct Window {
+
+		::Window id;
+
+		// the window's composite pixmap, or the root window's copy of the
+		// wallpaper.  never None: windows without one are left out.
+
+		::Pixmap pixmap;
+
+		VisualID visual_id;
+		int depth;
+
+		// the window's geometry once any animation settles.  width and
+		// height match the pixmap (minus the border).
+
+		int x;
+		int y;
+		int width;
+		int height;
+		int border_width;
+
+		// the root window is drawn without a shadow and never animates
+
+		bool root;
+		bool shaped;
+
+		// bumped whenever the window's contents or anything about how it is
+		// drawn changes, and whenever its shape changes, respectively
+
+		unsigned long changes;
+		unsigned long shape_changes;
+
+		// the window's shape as triangles in window coordinates, as a range
+		// of floats in the scene's vertex array.  empty unless the window is
+		// shaped.
+
+		std::size_t shape_begin;
+		std::size_t shape_end;
+
+	};
+
+
+	// the part of the root window a monitor shows (one per active CRTC, see
+	// OutputLayout), in root coordinates
+
+	struct Output {
+
+		int x;
+		int y;
+		int width;
+		int height;
+
+		bool operator==(Output const& other) const
+		{
+			return x == other.x && y == other.y && width == other.width && height == other.height;
+		}
+
+		bool operator!=(Output const& other) const
+		{
+			return !(*this == other);
+		}
+
+	};
+
+
+	// whether the renderer draws its PerformanceHud, and whether it also
+	// tints what it redrew (set with the _ORTLE_HUD root window property)
+
+	enum HudMode {
+		HudHidden,
+		HudShown,
+		HudWithDamage
+	};
+
+
+public:
+
+	// floats per shape vertex, laid out like the renderer's quad: position
+	// (x, y, z, w) then texture coordinates (s, t).
+
+	static std::size_t const shape_vertex_size = 6;
+
+
+public:
+
+	Scene();
+
+	Scene(Scene&& other);
+	Scene& operator=(Scene&& other);
+
+	~Scene();
+
+	friend void swap(Scene& first, Scene& second);
+
+
+public:
+
+	// clear() keeps the capacity of both arrays, so once a scene has held the
+	// busiest stack of the session, describing it again does not allocate.
+
+	void clear();
+
+	void resize(int width, int height);
+
+	void add(Window const& window);
+	void add(Window const& window, std::vector<GLfloat> const& shape_vertices);
+
+	void add_output(Output const& output);
+
+
+public:
+
+	unsigned long serial() const
+	{
+		return m_serial;
+	}
+
+	void set_serial(unsigned long serial)
+	{
+		m_serial = serial;
+	}
+
+
+	// an X fence triggered once the event thread had seen all the damage
+	// in this scene, or None (see FenceRing).
+
+	XSyncFence fence() const
+	{
+		return m_fence;
+	}
+
+	void set_fence(XSyncFence fence)
+	{
+		m_fence = fence;
+	}
+
+
+	int width() const
+	{
+		return m_width;
+	}
+
+	int height() const
+	{
+		return m_height;
+	}
+
+
+	// bottom to top
+
+	std::vector<Window> const& windows() const
+	{
+		return m_windows;
+	}
+
+
+	// empty if RandR has nothing to say, in which case the whole root
+	// window is a single output
+
+	std::vector<Output> const& outputs() const
+	{
+		return m_outputs;
+	}
+
+
+	GLfloat const* shape_vertices(Window const& window) const
+	{
+		return m_shape_vertices.data() + window.shape_begin;
+	}
+
+
+	HudMode hud() const
+	{
+		return m_hud;
+	}
+
+	void set_hud(HudMode hud)
+	{
+		m_hud = hud;
+	}
+
+
+private:
+
+	unsigned long m_serial;
+
+	XSyncFence m_fence;
+
+	int m_width;
+	int m_height;
+
+	std::vector<Window> m_windows;
+	std::vector<GLfloat> m_shape_vertices;
+
+	std::vector<Output> m_outputs;
+
+	HudMode m_hud;
+
+};
+
+
+#endif
@@ -0,0 +1,71 @@
+#include "scene_exchange.hpp"
+
+#include "scene.hpp"
+
+#include <atomic>
+
+
+
+
+namespace {
+
+
+unsigned int const l_index = 3;
+unsigned int const l_fresh = 4;
+
+
+} // namespace
+
+
+
+
+SceneExchange::SceneExchange()
+	: m_scenes()
+	, m_back(0)
+	, m_front(1)
+	, m_serial(0)
+	, m_middle(2)
+	, m_acknowledged(0)
+{}
+
+
+
+
+SceneExchange::~SceneExchange()
+{
+	// nothing to do
+}
+
+
+
+
+unsigned long SceneExchange::publish()
+{
+	m_scenes[m_back].set_serial(++m_serial);
+
+	// the release half makes everything written to the scene visible to the
+	// render thread before it can see the scene itself, and the acquire half
+	// does the same for whatever the render thread did with the scene we are
+	// taking back.
+
+	unsigned int previous = m_middle.exchange(m_back | l_fresh, std::memory_order_acq_rel);
+	m_back = previous & l_index;
+
+	return m_serial;
+}
+
+
+bool SceneExchange::acquire()
+{
+	if ((m_middle.load(std::memory_order_relaxed) & l_fresh) == 0) {
+		return false;
+	}
+
+	// the event thread may publish again in between, which only means we get
+	// an even newer scene.
+
+	unsigned int previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+	m_front = previous & l_index;
+
+	return true;
+}
@@ -0,0 +1,93 @@
+#ifndef ORTLE_SCENE_EXCHANGE_HPP
+#define ORTLE_SCENE_EXCHANGE_HPP
+
+
+#include "scene.hpp"
+
+#include <atomic>
+
+
+
+
+// hands scenes from the event thread to the render thread without either of
+// them ever waiting on the other.  there are three scenes: the one the event
+// thread is writing (back), the one the render thread is drawing (front), and
+// the most recently published one in between.  publishing swaps the back
+// scene with the middle one, and acquiring swaps the middle one with the
+// front, so each thread always has a scene of its own and the render thread
+// always gets the newest one.  scenes that are never drawn are simply
+// written over.
+
+class SceneExchange {
+
+public:
+
+	SceneExchange();
+
+	SceneExchange(SceneExchange&&) = delete;
+	SceneExchange& operator=(SceneExchange&&) = delete;
+
+	~SceneExchange();
+
+
+public:
+
+	// event thread.  publish() stamps the back scene with the next serial
+	// number, hands it over, and returns the serial.
+
+	Scene& back()
+	{
+		return m_scenes[m_back];
+	}
+
+	unsigned long publish();
+
+
+	// render thread.  acquire() returns true if a newer scene than the front
+	// one has been published, in which case it is now the front one.
+
+	bool acquire();
+
+	Scene const& front() const
+	{
+		return m_scenes[m_front];
+	}
+
+
+	// the render thread acknowledges each scene once it has let go of
+	// everything the scenes before it referred to.  the event thread uses this
+	// to know which pixmaps it can free (see PixmapLedger).
+
+	void acknowledge(unsigned long serial)
+	{
+		m_acknowledged.store(serial, std::memory_order_release);
+	}
+
+	unsigned long acknowledged() const
+	{
+		return m_acknowledged.load(std::memory_order_acquire);
+	}
+
+
+private:
+
+	Scene m_scenes[3];
+
+	// owned by the event and render thread respectively
+
+	unsigned int m_back;
+	unsigned int m_front;
+
+	unsigned long m_serial;
+
+	// the index of the middle scene, plus l_fresh (see scene_exchange.cpp)
+	// if it has been published since the render thread last took it.
+
+	std::atomic<unsigned int> m_middle;
+
+	std::atomic<unsigned long> m_acknowledged;
+
+};
+
+
+#endif
@@ -0,0 +1,543 @@
+#include "surface.hpp"
+
+#include "draw_list.hpp"
+#include "framebuffer_cache.hpp"
+#include "renderer.hpp"
+#include "scene.hpp"
+#include "texture_binder.hpp"
+
+#include "glx/functions.hpp"
+#include "glx/pixmap.hpp"
+
+#include "opengl/buffer.hpp"
+#include "opengl/core330.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/texture_pool.hpp"
+
+#include "utility/log.hpp"
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <utility>
+
+#include <math.h>
+
+
+const int   animMax = 22; // 15;
+const float animPow = 1.1;
+const float animB   = 0.0;
+const float animC   = 1.0;
+const float animD   = 1.0;
+const float animS   = 1.60158f;
+const float animSB  = 1.1;
+
+// resize animations draw a mipmapped snapshot of the window, taken just
+// before the new pixmap is bound, instead of the live texture.
+const bool  animSnapshot = true;
+
+
+// the easing curves only depend on the animation step, so they are worked
+// out once for every step rather than on every frame.
+
+struct Easing {
+
+	Easing()
+	{
+		for (int step = 0; step <= animMax; ++step) {
+			float t  = (float) step / (float) animMax;
+			float tA = pow(t, animPow);
+
+			float u = t  / animD - 1;
+			float v = tA / animD - 1;
+
+			size[step]     = animC*(u*u*((animS+1)*u + animS) + 1) + animB;
+			position[step] = animC*(v*u*((animSB+1)*v + animSB) + 1) + animB;
+		}
+	}
+
+	float size[animMax + 1];
+	float position[animMax + 1];
+
+};
+
+const Easing easing;
+
+
+
+
+Surface::Surface(Display* display, int screen, FramebufferCache& framebuffers, OpenGL::TexturePool& textures, TextureBinder& binder, Scene::Window const& window)
+	: m_display(display)
+	, m_window(window.id)
+	, m_framebuffer(framebuffers.find(screen, window.visual_id, window.depth))
+	, m_pixmap(None)
+	, m_glx_pixmap()
+	, m_textures(&textures)
+	, m_texture(0)
+	, m_binder(&binder)
+	, m_binding_pixmap(None)
+	, m_binding(0)
+	, m_snapshot(0)
+	, m_shape_buffer(0)
+	, m_shape_vertex_count(0)
+	, m_shape_changes(0)
+	, m_x(window.x)
+	, m_y(window.y)
+	, m_width(window.width)
+	, m_height(window.height)
+	, m_border_width(window.border_width)
+	, m_screen_width(0)
+	, m_screen_height(0)
+	, m_texture_width(0)
+	, m_texture_height(0)
+	, m_ox(window.x)
+	, m_oy(window.y)
+	, m_owidth(window.width)
+	, m_oheight(window.height)
+	, m_animStep(animMax)
+	, m_serial(0)
+	, m_changes(0)
+	, m_change_frame(0)
+	, m_bounds{ 0.0f, 0.0f, 0.0f, 0.0f }
+	, m_root(window.root)
+	, m_rgba(GLX::framebuffer_supports_rgba(display, m_framebuffer))
+	, m_shaped(false)
+	, m_changed(true)
+{
+	assert(display != nullptr);
+	assert(window.id != None);
+
+	LOG_DEBUG(Render, "creating surface for window", window.id);
+}
+
+
+
+
+Surface::Surface()
+	: m_display(nullptr)
+	, m_window(None)
+	, m_framebuffer(nullptr)
+	, m_pixmap(None)
+	, m_glx_pixmap()
+	, m_textures(nullptr)
+	, m_texture(0)
+	, m_binder(nullptr)
+	, m_binding_pixmap(None)
+	, m_binding(0)
+	, m_snapshot(0)
+	, m_shape_buffer(0)
+	, m_shape_vertex_count(0)
+	, m_shape_changes(0)
+	, m_x(0)
+	, m_y(0)
+	, m_width(0)
+	, m_height(0)
+	, m_border_width(0)
+	, m_screen_width(0)
+	, m_screen_height(0)
+	, m_texture_width(0)
+	, m_texture_height(0)
+	, m_ox(0)
+	, m_oy(0)
+	, m_owidth(0)
+	, m_oheight(0)
+	, m_animStep(animMax)
+	, m_serial(0)
+	, m_changes(0)
+	, m_change_frame(0)
+	, m_bounds{ 0.0f, 0.0f, 0.0f, 0.0f }
+	, m_root(false)
+	, m_rgba(false)
+	, m_shaped(false)
+	, m_changed(true)
+{}
+
+
+Surface::Surface(Surface&& other)
+	: Surface()
+{
+	swap(*this, other);
+}
+
+
+Surface& Surface::operator=(Surface&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Surface::~Surface()
+{
+	if (m_display != nullptr) {
+
+		LOG_DEBUG(Render, "destroying surface for window", m_window);
+
+		release_and_destroy();
+
+		if (m_texture != 0) {
+			m_textures->release(std::move(m_texture));
+		}
+	}
+}
+
+
+
+
+void swap(Surface& first, Surface& second)
+{
+	using std::swap;
+
+	swap(first.m_display, second.m_display);
+	swap(first.m_window, second.m_window);
+	swap(first.m_framebuffer, second.m_framebuffer);
+	swap(first.m_pixmap, second.m_pixmap);
+	swap(first.m_glx_pixmap, second.m_glx_pixmap);
+	swap(first.m_textures, second.m_textures);
+	swap(first.m_texture, second.m_texture);
+	swap(first.m_binder, second.m_binder);
+	swap(first.m_binding_pixmap, second.m_binding_pixmap);
+	swap(first.m_binding, second.m_binding);
+	swap(first.m_snapshot, second.m_snapshot);
+	swap(first.m_shape_buffer, second.m_shape_buffer);
+	swap(first.m_shape_vertex_count, second.m_shape_vertex_count);
+	swap(first.m_shape_changes, second.m_shape_changes);
+	swap(first.m_x, second.m_x);
+	swap(first.m_y, second.m_y);
+	swap(first.m_width, second.m_width);
+	swap(first.m_height, second.m_height);
+	swap(first.m_border_width, second.m_border_width);
+	swap(first.m_screen_width, second.m_screen_width);
+	swap(first.m_screen_height, second.m_screen_height);
+	swap(first.m_texture_width, second.m_texture_width);
+	swap(first.m_texture_height, second.m_texture_height);
+	swap(first.m_ox, second.m_ox);
+	swap(first.m_oy, second.m_oy);
+	swap(first.m_owidth, second.m_owidth);
+	swap(first.m_oheight, second.m_oheight);
+	swap(first.m_animStep, second.m_animStep);
+	swap(first.m_serial, second.m_serial);
+	swap(first.m_changes, second.m_changes);
+	swap(first.m_change_frame, second.m_change_frame);
+	swap(first.m_bounds, second.m_bounds);
+	swap(first.m_root, second.m_root);
+	swap(first.m_rgba, second.m_rgba);
+	swap(first.m_shaped, second.m_shaped);
+	swap(first.m_changed, second.m_changed);
+}
+
+
+
+
+void Surface::update(Scene const& scene, Scene::Window const& window, Renderer& renderer, bool animated)
+{
+	assert(m_display != nullptr);
+	assert(window.id == m_window);
+
+	m_serial = scene.serial();
+
+	m_screen_width = scene.width();
+	m_screen_height = scene.height();
+
+	if (window.changes != m_changes) {
+		m_changes = window.changes;
+		m_changed = true;
+	}
+
+
+	// a new position or size starts an animation from wherever the window
+	// is currently drawn.
+
+	bool resized = (window.width != m_width || window.height != m_height || window.border_width != m_border_width);
+	bool moved = (window.x != m_x || window.y != m_y);
+
+	if (!animated) {
+		m_animStep = animMax;
+		release_snapshot();
+	}
+
+	else if ((resized || moved) && !m_root) {
+		animate();
+	}
+
+	m_x = window.x;
+	m_y = window.y;
+	m_width = window.width;
+	m_height = window.height;
+	m_border_width = window.border_width;
+
+
+	// a resize animation has just started.  copy the window while we still
+	// have its old pixmap; the copy is what we animate.  shaped windows are
+	// drawn from their shape and keep using the live texture.
+
+	if (resized && animSnapshot && !m_shaped && m_animStep < animMax && m_snapshot == 0) {
+		capture_snapshot(renderer);
+	}
+
+
+	// the event thread names a new pixmap whenever the window is resized or
+	// mapped.  have a fresh texture bound to it, and keep drawing the old one
+	// until that is done (see adopt()).
+
+	if (window.pixmap != m_binding_pixmap) {
+		m_binding_pixmap = window.pixmap;
+		m_binding = m_binder->bind(scene.serial(), m_window, window.pixmap, m_framebuffer, m_rgba, window.width + 2 * window.border_width, window.height + 2 * window.border_width, m_textures->acquire());
+	}
+
+
+	m_shaped = window.shaped;
+
+	if (window.shape_changes != m_shape_changes) {
+		update_shape_buffer(scene, window);
+	}
+}
+
+
+bool Surface::adopt(TextureBinder::Binding& binding)
+{
+	assert(m_display != nullptr);
+	assert(binding.window == m_window);
+
+	if (binding.id != m_binding) {
+		return false;
+	}
+
+	release_and_destroy();
+
+	if (m_texture != 0) {
+		m_textures->release(std::move(m_texture));
+	}
+
+	m_texture = std::move(binding.texture);
+	m_glx_pixmap = std::move(binding.glx_pixmap);
+	m_pixmap = binding.pixmap;
+
+	m_texture_width = binding.width;
+	m_texture_height = binding.height;
+
+	m_binding = 0;
+	m_changed = true;
+
+	return true;
+}
+
+
+bool Surface::visible() const
+{
+	if ( (m_x + m_width  < 0 || m_x > m_screen_width)
+		|| (m_y + m_height < 0 || m_y > m_screen_height)
+		 ) return false;
+
+	return m_glx_pixmap != None;
+}
+
+
+std::size_t Surface::texture_bytes() const
+{
+	std::size_t texels = static_cast<std::size_t>(std::max(m_texture_width, 0)) * static_cast<std::size_t>(std::max(m_texture_height, 0));
+
+	std::size_t bytes = (m_glx_pixmap != None ? 4 * texels : 0);
+
+	// the snapshot was taken at the size the texture had then, which is
+	// usually still the size it has now
+
+	if (m_snapshot != 0) {
+		bytes += 4 * texels * 4 / 3;
+	}
+
+	return bytes;
+}
+
+
+DrawList::Item Surface::item() const
+{
+	DrawList::Item result;
+
+	// Calculate bounds after animation
+	float x, y, w, h;
+
+	if (m_animStep < animMax) {
+		float tB = easing.size[m_animStep];
+		float tC = easing.position[m_animStep];
+
+		x = static_cast<float>(m_ox)      * (1-tC) + static_cast<float>(m_x)      * tC;
+		y = static_cast<float>(m_oy)      * (1-tC) + static_cast<float>(m_y)      * tC;
+		w = static_cast<float>(m_owidth)  * (1-tB) + static_cast<float>(m_width)  * tB;
+		h = static_cast<float>(m_oheight) * (1-tB) + static_cast<float>(m_height) * tB;
+	} else {
+		x = m_x;
+		y = m_y;
+		w = m_width;
+		h = m_height;
+	}
+
+	result.texture = (m_snapshot != 0 ? m_snapshot : m_texture);
+	result.border_width = static_cast<float>(m_border_width);
+
+	result.window_geometry.x = x;
+	result.window_geometry.y = y;
+	result.window_geometry.width = w;
+	result.window_geometry.height = h;
+
+	// the snapshot is stretched over the animated size as a whole.  (shaped
+	// windows use their shape buffer instead.)
+
+	result.rectangle_geometry.x = static_cast<float>(-m_border_width);
+	result.rectangle_geometry.y = static_cast<float>(-m_border_width);
+
+	if (m_snapshot != 0) {
+		result.rectangle_geometry.width = 2 * m_border_width + w;
+		result.rectangle_geometry.height = 2 * m_border_width + h;
+	}
+	else {
+		result.rectangle_geometry.width = static_cast<float>(2 * m_border_width + m_width);
+		result.rectangle_geometry.height = static_cast<float>(2 * m_border_width + m_height);
+	}
+
+	result.shape_buffer = m_shape_buffer;
+	result.shape_vertex_count = (m_shaped ? m_shape_vertex_count : 0);
+
+	result.shadow_size = (m_root ? 0.0f : 20.0f);
+
+	result.animated = (m_animStep < animMax);
+
+	return result;
+}
+
+
+void Surface::advance(int steps)
+{
+	if (m_animStep < animMax) {
+		m_animStep = std::min(m_animStep + steps, animMax);
+		m_changed = true;
+
+		// the animation has settled, so the live texture takes over again
+
+		if (m_animStep >= animMax) {
+			release_snapshot();
+		}
+	}
+}
+
+
+
+
+void Surface::animate()
+{
+	if ((m_x || m_ox || m_y || m_oy) == 0)
+		return;
+
+	if (m_animStep < animMax) {
+		float tB = easing.size[m_animStep];
+		float tC = easing.position[m_animStep];
+
+		m_ox      = static_cast<float>(m_ox)      * (1-tC) + static_cast<float>(m_x)      * tC;
+		m_oy      = static_cast<float>(m_oy)      * (1-tC) + static_cast<float>(m_y)      * tC;
+		m_owidth  = static_cast<float>(m_owidth)  * (1-tB) + static_cast<float>(m_width)  * tB;
+		m_oheight = static_cast<float>(m_oheight) * (1-tB) + static_cast<float>(m_height) * tB;
+	} else {
+		m_ox       = m_x;
+		m_oy       = m_y;
+		m_owidth   = m_width;
+		m_oheight  = m_height;
+	}
+
+	m_animStep = 0;
+}
+
+
+
+
+void Surface::release_and_destroy()
+{
+	if (m_glx_pixmap != None) {
+
+		gl::BindTexture(gl::TEXTURE_2D, m_texture);
+		GLX::ReleaseTexImageEXT(m_display, m_glx_pixmap, GLX_FRONT_EXT);
+		gl::BindTexture(gl::TEXTURE_2D, 0);
+
+		m_glx_pixmap = GLX::Pixmap();
+	}
+
+	m_pixmap = None;
+}
+
+
+void Surface::capture_snapshot(Renderer& renderer)
+{
+	if (m_glx_pixmap == None || m_texture_width < 1 || m_texture_height < 1) {
+		return;
+	}
+
+	LOG_DEBUG(Animation, "capturing snapshot of window", m_window, m_texture_width, m_texture_height);
+
+	float width = static_cast<float>(m_texture_width);
+	float height = static_cast<float>(m_texture_height);
+
+	m_snapshot = OpenGL::Texture();
+
+	gl::BindTexture(gl::TEXTURE_2D, m_snapshot);
+
+	gl::TexImage2D(gl::TEXTURE_2D, 0, gl::RGBA8, m_texture_width, m_texture_height, 0, gl::RGBA, gl::UNSIGNED_BYTE, nullptr);
+
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, gl::LINEAR);
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, gl::LINEAR_MIPMAP_LINEAR);
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_S, gl::CLAMP_TO_EDGE);
+	gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_T, gl::CLAMP_TO_EDGE);
+
+
+	// copy the whole pixmap, border included, texel for texel
+
+	renderer.begin_offscreen(m_snapshot, m_texture_width, m_texture_height);
+
+	gl::BindTexture(gl::TEXTURE_2D, m_texture);
+
+	renderer.set_border_width(0.0f);
+	renderer.set_window_geometry(0.0f, 0.0f, width, height);
+	renderer.set_rectangle_geometry(0.0f, 0.0f, width, height);
+	renderer.draw_quad();
+
+	renderer.end_offscreen();
+
+
+	gl::BindTexture(gl::TEXTURE_2D, m_snapshot);
+	gl::GenerateMipmap(gl::TEXTURE_2D);
+	gl::BindTexture(gl::TEXTURE_2D, 0);
+}
+
+
+void Surface::release_snapshot()
+{
+	if (m_snapshot != 0) {
+		m_snapshot = OpenGL::Texture(0);
+	}
+}
+
+
+void Surface::update_shape_buffer(Scene const& scene, Scene::Window const& window)
+{
+	m_shape_changes = window.shape_changes;
+
+	std::size_t count = window.shape_end - window.shape_begin;
+
+	if (count > 0) {
+
+		if (m_shape_buffer == 0) {
+			m_shape_buffer = OpenGL::Buffer();
+		}
+
+		gl::BindBuffer(gl::ARRAY_BUFFER, m_shape_buffer);
+		gl::BufferData(gl::ARRAY_BUFFER, count * sizeof(GLfloat), scene.shape_vertices(window), gl::STATIC_DRAW);
+		gl::BindBuffer(gl::ARRAY_BUFFER, 0);
+	}
+
+	m_shape_vertex_count = static_cast<GLsizei>(count / Scene::shape_vertex_size);
+}
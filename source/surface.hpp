@@ -0,0 +1,209 @@
+#ifndef ORTLE_SURFACE_HPP
+#define ORTLE_SURFACE_HPP
+
+
+#include "draw_list.hpp"
+#include "scene.hpp"
+#include "texture_binder.hpp"
+
+#include "glx/pixmap.hpp"
+
+#include "opengl/buffer.hpp"
+#include "opengl/core330.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/texture_pool.hpp"
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+#include <cstddef>
+
+
+
+
+class FramebufferCache;
+class Renderer;
+
+
+// the render thread's side of a window: the texture bound to its pixmap, its
+// shape buffer, and its animation.  the renderer keeps one for each window in
+// the scene it is drawing, and brings it up to date from the window's
+// description each time a new scene arrives.
+
+class Surface {
+
+public:
+
+	Surface();
+	Surface(Display* display, int screen, FramebufferCache& framebuffers, OpenGL::TexturePool& textures, TextureBinder& binder, Scene::Window const& window);
+
+	Surface(Surface&& other);
+	Surface& operator=(Surface&& other);
+
+	~Surface();
+
+	friend void swap(Surface& first, Surface& second);
+
+
+public:
+
+	operator Window() const
+	{
+		return m_window;
+	}
+
+
+	// the serial of the last scene this surface was described in
+
+	unsigned long serial() const
+	{
+		return m_serial;
+	}
+
+
+public:
+
+	// unless animated, a new position or size takes effect at once, and any
+	// animation in progress is finished.
+
+	void update(Scene const& scene, Scene::Window const& window, Renderer& renderer, bool animated);
+
+	// takes over the texture of a finished binding in place of the current
+	// one, unless a newer binding has been asked for since, in which case it
+	// returns false and leaves the binding alone.
+
+	bool adopt(TextureBinder::Binding& binding);
+
+	// false if there is nothing to draw, e.g. the window is off-screen
+
+	bool visible() const;
+
+	DrawList::Item item() const;
+
+	// roughly how much texture memory the window takes: four bytes a texel
+	// for the bound pixmap, and for the snapshot and its mipmaps if there is
+	// one.
+
+	std::size_t texture_bytes() const;
+
+
+	// records the given frame number if anything that affects how this
+	// window is drawn (damage, geometry, mapping, shape, animation) has
+	// changed since the last call, and returns the last frame in which that
+	// happened.
+
+	unsigned long update_change_frame(unsigned long frame)
+	{
+		if (m_changed) {
+			m_change_frame = frame;
+			m_changed = false;
+		}
+		return m_change_frame;
+	}
+
+
+	// records the area of the screen the window covers, shadow included,
+	// and returns what it was the last time (empty the first time), so that
+	// the renderer can tell which outputs a change touched.
+
+	DrawList::Quad update_bounds(DrawList::Quad const& bounds)
+	{
+		DrawList::Quad previous = m_bounds;
+		m_bounds = bounds;
+		return previous;
+	}
+
+
+	// moves this window's animation along by the given number of steps
+	// (one per frame, unless the renderer is shedding load).  called for
+	// animated entries after each frame has been drawn.
+
+	void advance(int steps);
+
+
+private:
+
+	void animate();
+
+	void release_and_destroy();
+
+	void capture_snapshot(Renderer& renderer);
+	void release_snapshot();
+
+	void update_shape_buffer(Scene const& scene, Scene::Window const& window);
+
+
+private:
+
+	Display* m_display;
+	Window m_window;
+
+	GLXFBConfig m_framebuffer;
+
+	Pixmap m_pixmap;
+	GLX::Pixmap m_glx_pixmap;
+
+	// taken from, and given back to, this pool
+
+	OpenGL::TexturePool* m_textures;
+	OpenGL::Texture m_texture;
+
+	// new pixmaps are bound by the binder.  m_texture stays bound to the old
+	// one (and is drawn) until the binding with this id comes back.
+
+	TextureBinder* m_binder;
+
+	Pixmap m_binding_pixmap;
+	unsigned long m_binding;
+
+	// while a resize animates, this holds a mipmapped copy of the window
+	// taken when the animation started.  it is drawn in place of m_texture
+	// until the animation settles.
+
+	OpenGL::Texture m_snapshot;
+
+	OpenGL::Buffer m_shape_buffer;
+	GLsizei m_shape_vertex_count;
+	unsigned long m_shape_changes;
+
+	int m_x;
+	int m_y;
+	int m_width;
+	int m_height;
+	int m_border_width;
+
+	// the size of the root window, which covers every output, as of the
+	// last scene
+
+	int m_screen_width;
+	int m_screen_height;
+
+	// dimensions (including the border) of the pixmap currently bound to
+	// m_texture.
+
+	int m_texture_width;
+	int m_texture_height;
+
+	int m_ox;
+	int m_oy;
+	int m_owidth;
+	int m_oheight;
+	int m_animStep;
+
+	unsigned long m_serial;
+	unsigned long m_changes;
+
+	unsigned long m_change_frame;
+
+	DrawList::Quad m_bounds;
+
+	bool m_root;
+	bool m_rgba;
+	bool m_shaped;
+	bool m_changed;
+
+};
+
+
+#endif
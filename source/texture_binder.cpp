@@ -0,0 +1,272 @@
+#include "texture_binder.hpp"
+
+#include "glx/context.hpp"
+#include "glx/exceptions.hpp"
+#include "glx/functions.hpp"
+#include "glx/pixmap.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/debug.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/texture_pool.hpp"
+
+#include "utility/flight_recorder.hpp"
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
+
+#include <signal.h>
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+#include <cassert>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+
+
+TextureBinder::TextureBinder(Display* display, GLX::Context&& context)
+	: m_display(display)
+	, m_context(std::move(context))
+	, m_next_id(1)
+	, m_in_flight()
+	, m_fenced()
+	, m_mutex()
+	, m_wake()
+	, m_queue()
+	, m_bound()
+	, m_stopping(false)
+	, m_thread()
+{
+	assert(display != nullptr);
+
+	LOG_DEBUG(Glx, "starting texture binder");
+
+	m_thread = std::thread(&TextureBinder::run, this);
+}
+
+
+
+
+TextureBinder::~TextureBinder()
+{
+	LOG_DEBUG(Glx, "stopping texture binder");
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_wake.notify_one();
+	m_thread.join();
+
+
+	// whatever is left over is simply deleted.  the textures go with it, so
+	// there is no need to release their images first.
+
+	for (auto& binding : m_bound) {
+		if (binding.fence != nullptr) {
+			gl::DeleteSync(binding.fence);
+		}
+	}
+
+	for (auto& binding : m_fenced) {
+		if (binding.fence != nullptr) {
+			gl::DeleteSync(binding.fence);
+		}
+	}
+}
+
+
+
+
+unsigned long TextureBinder::bind(unsigned long serial, Window window, Pixmap pixmap, GLXFBConfig framebuffer, bool rgba, int width, int height, OpenGL::Texture&& texture)
+{
+	assert(pixmap != None);
+	assert(texture != 0);
+
+	Binding binding = {
+		m_next_id++,
+		serial,
+		window,
+		pixmap,
+		framebuffer,
+		rgba,
+		width,
+		height,
+		std::move(texture),
+		GLX::Pixmap(),
+		nullptr
+	};
+
+	unsigned long id = binding.id;
+
+	m_in_flight.push_back(serial);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::move(binding));
+	}
+
+	m_wake.notify_one();
+
+	Utility::Metrics::add(Utility::Metrics::PixmapBinds);
+
+	return id;
+}
+
+
+bool TextureBinder::take_finished(std::vector<Binding>& bindings)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto& binding : m_bound) {
+			m_fenced.push_back(std::move(binding));
+		}
+
+		m_bound.clear();
+	}
+
+
+	// fences signal in the order the worker inserted them, so stop at the
+	// first one that hasn't.  the worker flushed after each, so there is no
+	// need to ask for a flush here.
+
+	bool finished = false;
+
+	while (!m_fenced.empty()) {
+
+		Binding& binding = m_fenced.front();
+
+		if (binding.fence != nullptr) {
+
+			GLenum status = gl::ClientWaitSync(binding.fence, 0, 0);
+
+			if (status != gl::ALREADY_SIGNALED && status != gl::CONDITION_SATISFIED) {
+				break;
+			}
+
+			gl::DeleteSync(binding.fence);
+			binding.fence = nullptr;
+		}
+
+		bindings.push_back(std::move(binding));
+		m_fenced.pop_front();
+
+		m_in_flight.pop_front();
+
+		finished = true;
+	}
+
+	return finished;
+}
+
+
+void TextureBinder::discard(Binding& binding, OpenGL::TexturePool& textures)
+{
+	if (binding.glx_pixmap != None) {
+
+		gl::BindTexture(gl::TEXTURE_2D, binding.texture);
+		GLX::ReleaseTexImageEXT(m_display, binding.glx_pixmap, GLX_FRONT_EXT);
+		gl::BindTexture(gl::TEXTURE_2D, 0);
+
+		binding.glx_pixmap = GLX::Pixmap();
+	}
+
+	if (binding.texture != 0) {
+		textures.release(std::move(binding.texture));
+	}
+}
+
+
+unsigned long TextureBinder::oldest() const
+{
+	return m_in_flight.empty() ? 0 : m_in_flight.front();
+}
+
+
+
+
+void TextureBinder::run()
+{
+	// signals are for the event thread to handle
+
+	sigset_t signals;
+	sigfillset(&signals);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	Utility::FlightRecorder::name_thread("texture binder");
+
+	glXMakeContextCurrent(m_display, None, None, m_context);
+
+	OpenGL::enable_debug_output();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true) {
+
+		m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+
+		if (m_stopping) {
+			break;
+		}
+
+		Binding binding = std::move(m_queue.front());
+		m_queue.pop_front();
+
+		lock.unlock();
+
+		bind_texture(binding);
+
+		lock.lock();
+
+		m_bound.push_back(std::move(binding));
+	}
+
+	lock.unlock();
+
+	glXMakeContextCurrent(m_display, None, None, NULL);
+}
+
+
+void TextureBinder::bind_texture(Binding& binding)
+{
+	Utility::Span span("bind texture", binding.window);
+
+	// a pixmap that can't be bound leaves the window with nothing to draw,
+	// rather than taking the worker down with it.
+
+	try {
+		if (binding.rgba) {
+			binding.glx_pixmap = GLX::Pixmap(m_display, binding.framebuffer, binding.pixmap, GLX::Pixmap::rgba_attributes);
+		}
+		else {
+			binding.glx_pixmap = GLX::Pixmap(m_display, binding.framebuffer, binding.pixmap, GLX::Pixmap::rgb_attributes);
+		}
+	}
+	catch (GLX::InitializationError const& error) {
+		LOG_DEBUG(Glx, "could not bind window", binding.window, error.what());
+		return;
+	}
+
+
+	// the texture came from the pool with its filtering already set
+
+	gl::BindTexture(gl::TEXTURE_2D, binding.texture);
+
+	GLX::BindTexImageEXT(m_display, binding.glx_pixmap, GLX_FRONT_EXT, NULL);
+
+	gl::BindTexture(gl::TEXTURE_2D, 0);
+
+	binding.fence = gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	gl::Flush();
+}
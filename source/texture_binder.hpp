@@ -0,0 +1,141 @@
+#ifndef ORTLE_TEXTURE_BINDER_HPP
+#define ORTLE_TEXTURE_BINDER_HPP
+
+
+#include "glx/context.hpp"
+#include "glx/pixmap.hpp"
+
+#include "opengl/core330.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/texture_pool.hpp"
+
+#include <X11/Xlib.h>
+
+#include <GL/glx.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+
+// binds textures to window pixmaps on a thread of its own, so that the
+// render thread never waits for glXCreatePixmap or glXBindTexImageEXT in the
+// middle of a frame.  the worker has its own context, which shares textures
+// with the output window's.  each finished binding comes back with a fence
+// that signals once the worker's commands have completed, and is only handed
+// to the render thread after that; until then the render thread keeps
+// drawing whatever texture the window had before.
+//
+// everything but the worker itself is called from the render thread.
+
+class TextureBinder {
+
+public:
+
+	struct Binding {
+
+		// handed out by bind(), so that a window can tell its latest binding
+		// from older ones that were overtaken before they finished.
+
+		unsigned long id;
+
+		// the scene that named the pixmap.  the pixmap must not be freed
+		// until this binding has been handed over (see oldest()).
+
+		unsigned long serial;
+
+		::Window window;
+		::Pixmap pixmap;
+
+		GLXFBConfig framebuffer;
+		bool rgba;
+
+		// dimensions of the pixmap, border included
+
+		int width;
+		int height;
+
+		// comes from the render thread's pool.  the worker binds it, and the
+		// render thread gives it back, or releases its image first if
+		// glx_pixmap isn't None.
+
+		OpenGL::Texture texture;
+		GLX::Pixmap glx_pixmap;
+
+		GLsync fence;
+
+	};
+
+
+public:
+
+	TextureBinder(Display* display, GLX::Context&& context);
+
+	TextureBinder(TextureBinder&&) = delete;
+	TextureBinder& operator=(TextureBinder&&) = delete;
+
+	~TextureBinder();
+
+
+public:
+
+	// queues the given texture to be bound to a window's pixmap, and returns
+	// the id of the binding.
+
+	unsigned long bind(unsigned long serial, Window window, Pixmap pixmap, GLXFBConfig framebuffer, bool rgba, int width, int height, OpenGL::Texture&& texture);
+
+	// appends the bindings that are ready to be drawn to the given list, in
+	// the order they were queued, and returns false if there weren't any.
+
+	bool take_finished(std::vector<Binding>& bindings);
+
+	// releases a binding nobody wants any more and gives its texture back to
+	// the pool.
+
+	void discard(Binding& binding, OpenGL::TexturePool& textures);
+
+	// the serial of the oldest binding not yet handed over, or 0 if there
+	// are none.
+
+	unsigned long oldest() const;
+
+
+private:
+
+	void run();
+
+	void bind_texture(Binding& binding);
+
+
+private:
+
+	Display* m_display;
+	GLX::Context m_context;
+
+	// render thread only
+
+	unsigned long m_next_id;
+
+	std::deque<unsigned long> m_in_flight;
+	std::deque<Binding> m_fenced;
+
+	// shared with the worker
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+
+	std::deque<Binding> m_queue;
+	std::vector<Binding> m_bound;
+
+	bool m_stopping;
+
+	std::thread m_thread;
+
+};
+
+
+#endif
@@ -0,0 +1,319 @@
+#include "flight_recorder.hpp"
+#include "log.hpp"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+
+
+namespace {
+
+
+// records per thread.  a busy render thread writes a few thousand a second,
+// so this keeps several seconds of it.
+
+std::size_t const l_ring_size = 1 << 15;
+
+
+// the fields are atomic only so that a dump may read a record while its
+// thread is overwriting it, without that being a data race.  records that
+// might have been torn are thrown away (see copy_ring()).
+
+struct Record {
+	std::atomic<char const*> name;
+	std::atomic<unsigned long> argument;
+	std::atomic<std::int64_t> begin;
+	std::atomic<std::int64_t> end;
+};
+
+
+struct Entry {
+	char const* name;
+	unsigned long argument;
+	std::int64_t begin;
+	std::int64_t end;
+};
+
+
+// written by one thread only.  claimed is bumped before a record is written
+// and written after, so a reader can tell which records changed under it.
+
+struct Ring {
+
+	explicit Ring(unsigned int id)
+		: id(id)
+		, name()
+		, records(new Record[l_ring_size]())
+		, claimed(0)
+		, written(0)
+	{
+		// nothing to do
+	}
+
+	unsigned int id;
+
+	// guarded by the registry's mutex
+	std::string name;
+
+	std::unique_ptr<Record[]> records;
+
+	std::atomic<std::uint64_t> claimed;
+	std::atomic<std::uint64_t> written;
+
+};
+
+
+// rings are never freed, so that a dump still shows threads that have
+// finished.  there are only ever a handful of threads.
+
+struct Registry {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<Ring>> rings;
+};
+
+
+Registry& registry()
+{
+	static Registry registry;
+	return registry;
+}
+
+
+thread_local Ring* t_ring = nullptr;
+
+
+// lock-free, so it can be set from a signal handler
+
+std::atomic<char const*> g_dump_reason(nullptr);
+
+std::atomic<unsigned int> g_dump_count(0);
+
+
+
+
+Ring& this_ring()
+{
+	if (t_ring == nullptr) {
+
+		Registry& rings = registry();
+		std::lock_guard<std::mutex> lock(rings.mutex);
+
+		rings.rings.push_back(std::unique_ptr<Ring>(new Ring(rings.rings.size() + 1)));
+		t_ring = rings.rings.back().get();
+	}
+
+	return *t_ring;
+}
+
+
+std::int64_t since_epoch(Utility::FlightRecorder::Clock::time_point time)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+
+void copy_ring(Ring const& ring, std::vector<Entry>& entries)
+{
+	std::uint64_t written = ring.written.load(std::memory_order_acquire);
+	std::uint64_t first = (written > l_ring_size ? written - l_ring_size : 0);
+
+	std::size_t start = entries.size();
+
+	for (std::uint64_t i = first; i < written; ++i) {
+		Record const& record = ring.records[i % l_ring_size];
+		Entry entry = {
+			record.name.load(std::memory_order_relaxed),
+			record.argument.load(std::memory_order_relaxed),
+			record.begin.load(std::memory_order_relaxed),
+			record.end.load(std::memory_order_relaxed)
+		};
+		entries.push_back(entry);
+	}
+
+
+	// whatever the thread has started writing since was written over the
+	// oldest records, which may have been read half old and half new.
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	std::uint64_t claimed = ring.claimed.load(std::memory_order_relaxed);
+	std::uint64_t valid = (claimed > l_ring_size ? claimed - l_ring_size : 0);
+
+	if (valid > first) {
+		std::size_t torn = static_cast<std::size_t>(std::min(valid - first, written - first));
+		entries.erase(entries.begin() + start, entries.begin() + start + torn);
+	}
+}
+
+
+void write_string(std::ostream& output, std::string const& string)
+{
+	output << '"';
+
+	for (char c : string) {
+		if (c == '"' || c == '\\') {
+			output << '\\' << c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20) {
+			output << ' ';
+		}
+		else {
+			output << c;
+		}
+	}
+
+	output << '"';
+}
+
+
+// trace timestamps are in microseconds
+
+void write_microseconds(std::ostream& output, std::int64_t nanoseconds)
+{
+	std::int64_t fraction = nanoseconds % 1000;
+
+	output << nanoseconds / 1000 << '.'
+		<< static_cast<char>('0' + fraction / 100)
+		<< static_cast<char>('0' + fraction / 10 % 10)
+		<< static_cast<char>('0' + fraction % 10);
+}
+
+
+std::string dump_path()
+{
+	char const* directory = std::getenv("TMPDIR");
+
+	if (directory == nullptr || *directory == '\0') {
+		directory = "/tmp";
+	}
+
+	return std::string(directory) + "/ortle-" + std::to_string(getpid()) + "-" + std::to_string(++g_dump_count) + ".json";
+}
+
+
+} // namespace
+
+
+
+
+namespace Utility {
+
+
+namespace FlightRecorder {
+
+
+void name_thread(std::string const& name)
+{
+	Ring& ring = this_ring();
+
+	std::lock_guard<std::mutex> lock(registry().mutex);
+	ring.name = name;
+}
+
+
+void record(char const* name, unsigned long argument, Clock::time_point begin, Clock::time_point end)
+{
+	Ring& ring = this_ring();
+
+	std::uint64_t index = ring.written.load(std::memory_order_relaxed);
+
+	ring.claimed.store(index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Record& record = ring.records[index % l_ring_size];
+
+	record.name.store(name, std::memory_order_relaxed);
+	record.argument.store(argument, std::memory_order_relaxed);
+	record.begin.store(since_epoch(begin), std::memory_order_relaxed);
+	record.end.store(since_epoch(end), std::memory_order_relaxed);
+
+	ring.written.store(index + 1, std::memory_order_release);
+}
+
+
+void request_dump(char const* reason)
+{
+	g_dump_reason.store(reason);
+}
+
+
+bool dump_if_requested()
+{
+	char const* reason = g_dump_reason.exchange(nullptr);
+
+	if (reason == nullptr) {
+		return false;
+	}
+
+	std::string path = dump_path();
+
+	std::ofstream output(path);
+
+	if (!output) {
+		LOG_WARNING(Render, "flight recorder could not write", path, reason);
+		return true;
+	}
+
+	int process = getpid();
+
+	output << "{\"otherData\":{\"reason\":";
+	write_string(output, reason);
+	output << "},\n\"traceEvents\":[\n";
+
+	output << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << process << ",\"tid\":0,\"args\":{\"name\":\"ortle\"}}";
+
+
+	// the registry stays locked while the rings are copied, so no thread can
+	// register or rename itself in the meantime.  recording carries on.
+
+	Registry& rings = registry();
+	std::lock_guard<std::mutex> lock(rings.mutex);
+
+	std::vector<Entry> entries;
+	entries.reserve(l_ring_size);
+
+	for (auto const& ring : rings.rings) {
+
+		output << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << process << ",\"tid\":" << ring->id << ",\"args\":{\"name\":";
+		write_string(output, ring->name.empty() ? "thread " + std::to_string(ring->id) : ring->name);
+		output << "}}";
+
+		entries.clear();
+		copy_ring(*ring, entries);
+
+		for (auto const& entry : entries) {
+			output << ",\n{\"name\":";
+			write_string(output, entry.name);
+			output << ",\"ph\":\"X\",\"pid\":" << process << ",\"tid\":" << ring->id << ",\"ts\":";
+			write_microseconds(output, entry.begin);
+			output << ",\"dur\":";
+			write_microseconds(output, entry.end - entry.begin);
+			output << ",\"args\":{\"id\":" << entry.argument << "}}";
+		}
+	}
+
+	output << "\n]}\n";
+
+	LOG_INFO(Render, "flight recorder wrote", path, reason);
+
+	return true;
+}
+
+
+} // namespace FlightRecorder
+
+
+} // namespace Utility
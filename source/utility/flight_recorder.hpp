@@ -0,0 +1,92 @@
+#ifndef UTILITY_FLIGHT_RECORDER_HPP
+#define UTILITY_FLIGHT_RECORDER_HPP
+
+
+#include <chrono>
+#include <string>
+
+
+
+
+// an always-on record of how long things took.  each thread writes its spans
+// into a ring buffer of its own, without locks, so the last few seconds of
+// every thread are always there to be looked at.  a dump writes all of them
+// out as a Chrome trace (which Perfetto and chrome://tracing both open), so
+// that a stutter can be diagnosed after it happened rather than reproduced
+// under a profiler.
+//
+// dumps are requested from anywhere, including signal handlers, and written
+// by whichever thread next calls dump_if_requested().
+
+namespace Utility {
+
+
+namespace FlightRecorder {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+// the name the calling thread is shown with in dumps
+
+void name_thread(std::string const& name);
+
+// adds a span to the calling thread's ring, overwriting the oldest once it
+// is full.  name must be a string literal, or otherwise live forever.
+
+void record(char const* name, unsigned long argument, Clock::time_point begin, Clock::time_point end);
+
+// async-signal-safe.  reason must be a string literal.
+
+void request_dump(char const* reason);
+
+// writes a dump if one has been requested, to $TMPDIR (or /tmp), and
+// logs where.  returns false if there was nothing to do.
+
+bool dump_if_requested();
+
+
+} // namespace FlightRecorder
+
+
+
+
+// records the time from its construction to its destruction.  the argument
+// is shown alongside the name, e.g. the window or output the span was for.
+
+class Span {
+
+public:
+
+	explicit Span(char const* name, unsigned long argument = 0)
+		: m_name(name)
+		, m_argument(argument)
+		, m_begin(FlightRecorder::Clock::now())
+	{
+		// nothing to do
+	}
+
+	Span(Span const&) = delete;
+	Span& operator=(Span const&) = delete;
+
+	~Span()
+	{
+		FlightRecorder::record(m_name, m_argument, m_begin, FlightRecorder::Clock::now());
+	}
+
+
+private:
+
+	char const* m_name;
+	unsigned long m_argument;
+	FlightRecorder::Clock::time_point m_begin;
+
+};
+
+
+
+
+} // namespace Utility
+
+
+#endif
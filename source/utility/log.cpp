@@ -0,0 +1,508 @@
+#include "log.hpp"
+
+#include <signal.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+// a power of two.  messages that don't fit are counted and dropped, rather
+// than making anybody wait.
+
+std::size_t const l_queue_size = 4096;
+
+
+// how long the writer sleeps when there is nothing to print
+
+std::chrono::milliseconds const l_writer_sleep(10);
+
+
+#ifdef NDEBUG
+int const l_default_level = Utility::Log::Info;
+#else
+int const l_default_level = Utility::Log::Debug;
+#endif
+
+
+char const* const l_category_names[Utility::Log::CategoryCount] = {
+	"events",
+	"stacking",
+	"glx",
+	"render",
+	"animation"
+};
+
+
+char const* const l_level_names[] = {
+	"off",
+	"warning",
+	"info",
+	"debug"
+};
+
+
+
+
+// a bounded queue for many producers and one consumer (the writer).  each
+// slot's sequence says whose turn it is: a producer may fill slot i of lap
+// n when it is n * size + i, and the writer may empty it once the producer
+// has set it to one more than that.
+
+struct Slot {
+	std::atomic<std::size_t> sequence;
+	Utility::Log::Record record;
+};
+
+
+class Queue {
+
+public:
+
+	Queue()
+		: m_slots(new Slot[l_queue_size])
+		, m_tail(0)
+		, m_head(0)
+		, m_dropped(0)
+	{
+		for (std::size_t i = 0; i < l_queue_size; ++i) {
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+
+	void push(Utility::Log::Record const& record)
+	{
+		std::size_t position = m_tail.load(std::memory_order_relaxed);
+
+		while (true) {
+
+			Slot& slot = m_slots[position & (l_queue_size - 1)];
+
+			std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+			if (difference == 0) {
+				if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					slot.record = record;
+					slot.sequence.store(position + 1, std::memory_order_release);
+					return;
+				}
+			}
+			else if (difference < 0) {
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			else {
+				position = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+
+	// writer only
+
+	bool pop(Utility::Log::Record& record)
+	{
+		Slot& slot = m_slots[m_head & (l_queue_size - 1)];
+
+		if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) {
+			return false;
+		}
+
+		record = slot.record;
+		slot.sequence.store(m_head + l_queue_size, std::memory_order_release);
+
+		++m_head;
+
+		return true;
+	}
+
+
+	unsigned long take_dropped()
+	{
+		return m_dropped.exchange(0, std::memory_order_relaxed);
+	}
+
+
+private:
+
+	std::unique_ptr<Slot[]> m_slots;
+
+	std::atomic<std::size_t> m_tail;
+	std::size_t m_head;
+
+	std::atomic<unsigned long> m_dropped;
+
+};
+
+
+Queue& queue()
+{
+	static Queue queue;
+	return queue;
+}
+
+
+
+
+// the levels ORTLE_LOG asked for, which SIGUSR2 switches back to.  written
+// before any signal handler is installed.
+
+int g_configured[Utility::Log::CategoryCount] = {
+	l_default_level,
+	l_default_level,
+	l_default_level,
+	l_default_level,
+	l_default_level
+};
+
+std::atomic<bool> g_debugging(false);
+
+
+Clock::time_point const g_start = Clock::now();
+
+
+int parse_level(std::string const& name)
+{
+	for (std::size_t i = 0; i < sizeof(l_level_names) / sizeof(l_level_names[0]); ++i) {
+		if (name == l_level_names[i]) {
+			return static_cast<int>(i);
+		}
+	}
+
+	return -1;
+}
+
+
+// ORTLE_LOG is a comma-separated list of levels, each either for every
+// category or, given as category=level, for one.  later entries win.
+
+void configure()
+{
+	char const* setting = std::getenv("ORTLE_LOG");
+
+	if (setting == nullptr) {
+		return;
+	}
+
+	std::string entries(setting);
+	std::size_t begin = 0;
+
+	while (begin <= entries.size()) {
+
+		std::size_t end = entries.find(',', begin);
+
+		if (end == std::string::npos) {
+			end = entries.size();
+		}
+
+		std::string entry = entries.substr(begin, end - begin);
+		begin = end + 1;
+
+		if (entry.empty()) {
+			continue;
+		}
+
+		std::size_t equals = entry.find('=');
+
+		std::string category = (equals == std::string::npos ? std::string() : entry.substr(0, equals));
+		int level = parse_level(equals == std::string::npos ? entry : entry.substr(equals + 1));
+
+		bool found = category.empty();
+
+		for (int i = 0; i < Utility::Log::CategoryCount && level >= 0; ++i) {
+			if (category.empty() || category == l_category_names[i]) {
+				g_configured[i] = level;
+				found = true;
+			}
+		}
+
+		if (level < 0 || !found) {
+			std::clog << "Ortle: ORTLE_LOG: ignoring \"" << entry << "\"\n";
+		}
+	}
+
+	for (int i = 0; i < Utility::Log::CategoryCount; ++i) {
+		Utility::Log::g_levels[i].store(g_configured[i], std::memory_order_relaxed);
+	}
+}
+
+
+void print(std::ostream& output, Utility::Log::Record const& record)
+{
+	std::int64_t microseconds = record.time / 1000;
+
+	output << std::setw(6) << microseconds / 1000000 << '.' << std::setfill('0') << std::setw(6) << microseconds % 1000000 << std::setfill(' ')
+		<< ' ' << std::left << std::setw(9) << l_category_names[record.category]
+		<< std::setw(7) << l_level_names[record.level] << std::right
+		<< ' ' << record.file << " :: " << record.line << " :: " << record.function;
+
+	for (std::size_t i = 0; i < record.argument_count; ++i) {
+
+		Utility::Log::Argument const& argument = record.arguments[i];
+
+		output << " :: ";
+
+		switch (argument.type) {
+
+			case Utility::Log::Argument::Signed:
+				output << argument.signed_value;
+				break;
+
+			case Utility::Log::Argument::Unsigned:
+				output << argument.unsigned_value;
+				break;
+
+			case Utility::Log::Argument::Floating:
+				output << argument.floating_value;
+				break;
+
+			case Utility::Log::Argument::Boolean:
+				output << argument.boolean_value;
+				break;
+
+			case Utility::Log::Argument::Text:
+				output << (record.text + argument.text_offset);
+				break;
+		}
+	}
+
+	output << '\n';
+}
+
+
+} // namespace
+
+
+
+
+namespace Utility {
+
+
+namespace Log {
+
+
+std::atomic<int> g_levels[CategoryCount] = {
+	{l_default_level},
+	{l_default_level},
+	{l_default_level},
+	{l_default_level},
+	{l_default_level}
+};
+
+
+void toggle_debug()
+{
+	bool debugging = !g_debugging.load(std::memory_order_relaxed);
+	g_debugging.store(debugging, std::memory_order_relaxed);
+
+	for (int i = 0; i < CategoryCount; ++i) {
+		g_levels[i].store(debugging ? static_cast<int>(Debug) : g_configured[i], std::memory_order_relaxed);
+	}
+}
+
+
+
+
+Message::Message(Category category, Level level, char const* file, int line, char const* function)
+{
+	m_record.category = category;
+	m_record.level = level;
+	m_record.file = file;
+	m_record.line = line;
+	m_record.function = function;
+	m_record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - g_start).count();
+	m_record.argument_count = 0;
+	m_record.text_size = 0;
+}
+
+
+Message& Message::operator()()
+{
+	queue().push(m_record);
+	return *this;
+}
+
+
+
+
+void Message::add(char const* text)
+{
+	Argument* argument = next_argument(Argument::Text);
+
+	if (argument == nullptr) {
+		return;
+	}
+
+	if (text == nullptr) {
+		text = "(null)";
+	}
+
+
+	// each text ends in a null, cut short if it has to be
+
+	std::size_t space = max_text - m_record.text_size;
+	std::size_t length = std::strlen(text);
+
+	if (space == 0) {
+		--m_record.argument_count;
+		return;
+	}
+
+	if (length >= space) {
+		length = space - 1;
+	}
+
+	argument->text_offset = m_record.text_size;
+
+	std::memcpy(m_record.text + m_record.text_size, text, length);
+	m_record.text[m_record.text_size + length] = '\0';
+
+	m_record.text_size += length + 1;
+}
+
+
+void Message::add(std::string const& text)
+{
+	add(text.c_str());
+}
+
+
+void Message::add_boolean(bool value)
+{
+	Argument* argument = next_argument(Argument::Boolean);
+
+	if (argument != nullptr) {
+		argument->boolean_value = value;
+	}
+}
+
+
+void Message::add_signed(long long value)
+{
+	Argument* argument = next_argument(Argument::Signed);
+
+	if (argument != nullptr) {
+		argument->signed_value = value;
+	}
+}
+
+
+void Message::add_unsigned(unsigned long long value)
+{
+	Argument* argument = next_argument(Argument::Unsigned);
+
+	if (argument != nullptr) {
+		argument->unsigned_value = value;
+	}
+}
+
+
+void Message::add_floating(double value)
+{
+	Argument* argument = next_argument(Argument::Floating);
+
+	if (argument != nullptr) {
+		argument->floating_value = value;
+	}
+}
+
+
+Argument* Message::next_argument(Argument::Type type)
+{
+	if (m_record.argument_count == max_arguments) {
+		return nullptr;
+	}
+
+	Argument* argument = &m_record.arguments[m_record.argument_count++];
+	argument->type = type;
+
+	return argument;
+}
+
+
+
+
+Writer::Writer()
+	: m_stopping(false)
+	, m_thread()
+{
+	configure();
+
+	m_thread = std::thread(&Writer::run, this);
+}
+
+
+Writer::~Writer()
+{
+	m_stopping = true;
+	m_thread.join();
+}
+
+
+void Writer::run()
+{
+	// signals are for the event thread to handle
+
+	sigset_t signals;
+	sigfillset(&signals);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	Record record;
+
+	while (true) {
+
+		// read the flag first, so that everything queued before it was set
+		// is printed before stopping.
+
+		bool stopping = m_stopping;
+
+		bool printed = false;
+
+		while (queue().pop(record)) {
+			print(std::clog, record);
+			printed = true;
+		}
+
+		unsigned long dropped = queue().take_dropped();
+
+		if (dropped > 0) {
+			std::clog << "Ortle: log: " << dropped << " messages dropped\n";
+			printed = true;
+		}
+
+		if (printed) {
+			std::clog.flush();
+		}
+
+		if (stopping) {
+			break;
+		}
+
+		std::this_thread::sleep_for(l_writer_sleep);
+	}
+}
+
+
+} // namespace Log
+
+
+} // namespace Utility
@@ -0,0 +1,251 @@
+#ifndef UTILITY_LOG_HPP
+#define UTILITY_LOG_HPP
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+
+
+
+// logging that stays out of the way of the event and render threads.  a
+// message is only a check of its category's level unless that level lets it
+// through, in which case its arguments are copied (not formatted) into a
+// lock-free queue.  a writer thread formats and prints them.
+//
+// each category's level starts at Debug in debug builds and Info otherwise,
+// and can be set with the ORTLE_LOG environment variable, e.g.
+//
+//   ORTLE_LOG=warning,render=debug,animation=off
+//
+// SIGUSR2 switches every category to Debug and back.
+
+namespace Utility {
+
+
+namespace Log {
+
+
+enum Category {
+	Events,
+	Stacking,
+	Glx,
+	Render,
+	Animation,
+	CategoryCount
+};
+
+
+enum Level {
+	Off,
+	Warning,
+	Info,
+	Debug
+};
+
+
+// a message with more arguments than this drops the rest, and one with more
+// text than this is cut short.
+
+std::size_t const max_arguments = 12;
+std::size_t const max_text = 192;
+
+
+struct Argument {
+
+	enum Type {
+		Signed,
+		Unsigned,
+		Floating,
+		Boolean,
+		Text
+	};
+
+	Type type;
+
+	union {
+		long long signed_value;
+		unsigned long long unsigned_value;
+		double floating_value;
+		bool boolean_value;
+		std::size_t text_offset;
+	};
+
+};
+
+
+struct Record {
+
+	Category category;
+	Level level;
+
+	// string literals, so they don't need copying
+	char const* file;
+	int line;
+	char const* function;
+
+	std::int64_t time;
+
+	std::size_t argument_count;
+	Argument arguments[max_arguments];
+
+	std::size_t text_size;
+	char text[max_text];
+
+};
+
+
+
+
+// the level of each category.  only here so that enabled() can be inlined.
+
+extern std::atomic<int> g_levels[CategoryCount];
+
+
+inline bool enabled(Category category, Level level)
+{
+	return level <= g_levels[category].load(std::memory_order_relaxed);
+}
+
+
+// async-signal-safe
+
+void toggle_debug();
+
+
+
+
+class Message {
+
+public:
+
+	Message(Category category, Level level, char const* file, int line, char const* function);
+
+	Message(Message const&) = delete;
+	Message& operator=(Message const&) = delete;
+
+
+public:
+
+	template<typename T, typename... U>
+	Message& operator()(T const& first, U const&... rest)
+	{
+		add(first);
+		return operator()(rest...);
+	}
+
+	// queues the message, or drops it if the queue is full
+
+	Message& operator()();
+
+
+private:
+
+	// numbers are only taken as themselves, so that nothing is logged as
+	// a bool by way of a conversion operator.
+
+	void add(char const* text);
+	void add(std::string const& text);
+
+	template<typename T>
+	typename std::enable_if<std::is_same<T, bool>::value>::type add(T value)
+	{
+		add_boolean(value);
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type add(T value)
+	{
+		add_signed(value);
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value>::type add(T value)
+	{
+		add_unsigned(value);
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_enum<T>::value>::type add(T value)
+	{
+		add_signed(static_cast<long long>(value));
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_floating_point<T>::value>::type add(T value)
+	{
+		add_floating(value);
+	}
+
+	void add_boolean(bool value);
+	void add_signed(long long value);
+	void add_unsigned(unsigned long long value);
+	void add_floating(double value);
+
+	Argument* next_argument(Argument::Type type);
+
+
+private:
+
+	Record m_record;
+
+};
+
+
+
+
+// formats and prints queued messages on a thread of its own, and prints
+// whatever is left when it is destroyed.  there should be one, made before
+// anything else, which reads ORTLE_LOG.  messages queued before it starts
+// wait for it.
+
+class Writer {
+
+public:
+
+	Writer();
+
+	Writer(Writer&&) = delete;
+	Writer& operator=(Writer&&) = delete;
+
+	~Writer();
+
+
+private:
+
+	void run();
+
+
+private:
+
+	std::atomic<bool> m_stopping;
+	std::thread m_thread;
+
+};
+
+
+} // namespace Log
+
+
+} // namespace Utility
+
+
+
+
+#define LOG(category, level, ...) \
+	do { \
+		if (Utility::Log::enabled(Utility::Log::category, Utility::Log::level)) { \
+			Utility::Log::Message(Utility::Log::category, Utility::Log::level, __FILE__, __LINE__, __func__)(__VA_ARGS__); \
+		} \
+	} while (false)
+
+#define LOG_WARNING(category, ...) LOG(category, Warning, __VA_ARGS__)
+#define LOG_INFO(category, ...) LOG(category, Info, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) LOG(category, Debug, __VA_ARGS__)
+
+
+#endif
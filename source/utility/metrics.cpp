@@ -0,0 +1,573 @@
+#include "metrics.hpp"
+
+#include "log.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+// gauges are kept for this many screens
+
+int const l_screen_count = 8;
+
+
+// the frames the quantiles are worked out from
+
+std::size_t const l_frame_samples = 1024;
+
+double const l_quantiles[] = { 0.5, 0.95, 0.99 };
+
+
+// the server drops clients past this many, and those that haven't sent
+// their request in this long.  requests are short, so a long one is not
+// waited for either.
+
+std::size_t const l_max_clients = 8;
+std::chrono::seconds const l_client_timeout(1);
+std::size_t const l_max_request = 4096;
+
+
+struct Description {
+	char const* name;
+	char const* help;
+};
+
+
+Description const l_counters[Utility::Metrics::CounterCount] = {
+	{ "ortle_retraces_dropped_total", "Retraces that passed without a new frame on a single output." },
+	{ "ortle_retraces_duplicated_total", "Times the render thread woke up twice on the same retrace." },
+	{ "ortle_pixmap_binds_total", "Window pixmaps bound to textures." }
+};
+
+
+Description const l_gauges[Utility::Metrics::GaugeCount] = {
+	{ "ortle_windows_managed", "Windows in the stack, root included." },
+	{ "ortle_windows_visible", "Windows in the latest scene, i.e. that can be drawn." },
+	{ "ortle_texture_bytes", "Estimated texture memory of windows, snapshots and the layer cache." }
+};
+
+
+char const* const l_round_trip_names[Utility::Metrics::RoundTripSiteCount] = {
+	"XGetGeometry in X11::Geometry",
+	"XTranslateCoordinates in X11::Geometry",
+	"XGetWindowAttributes in WindowManager::add_before",
+	"XQueryTree in X11::top_level_window",
+	"XShapeGetRectangles in X11::RectangleList",
+	"XShapeQueryExtents in X11::ShapeExtents",
+	"XCompositeNameWindowPixmap in InputOutputWindow",
+	"XGetWindowProperty in X11::WallpaperPixmap",
+	"XGetWindowProperty in WindowManager::update_active_window",
+	"XGetWindowProperty in WindowManager::update_hud",
+	"XSync in Compositor::publish_scene",
+	"XRRGetScreenResourcesCurrent in OutputLayout",
+	"XRRGetCrtcInfo in OutputLayout",
+	"DPMSInfo in BlankingMonitor"
+};
+
+
+char const* const l_event_names[Utility::Metrics::EventCount] = {
+	"circulate",
+	"client_message",
+	"configure",
+	"create",
+	"damage",
+	"destroy",
+	"graphics_expose",
+	"map",
+	"no_expose",
+	"property",
+	"randr",
+	"reparent",
+	"screen_saver",
+	"shape",
+	"unmap",
+	"other"
+};
+
+
+
+
+std::atomic<unsigned long> g_counters[Utility::Metrics::CounterCount];
+std::atomic<unsigned long> g_events[Utility::Metrics::EventCount];
+
+
+// for each site: calls, and the total and longest time taken in nanoseconds
+
+std::atomic<unsigned long> g_round_trips[Utility::Metrics::RoundTripSiteCount];
+std::atomic<std::uint64_t> g_round_trip_time[Utility::Metrics::RoundTripSiteCount];
+std::atomic<std::uint64_t> g_round_trip_longest[Utility::Metrics::RoundTripSiteCount];
+
+
+// -1 until set
+
+std::atomic<long long> g_gauges[Utility::Metrics::GaugeCount][l_screen_count];
+
+struct GaugeInitializer {
+	GaugeInitializer()
+	{
+		for (auto& gauge : g_gauges) {
+			for (auto& screen : gauge) {
+				screen.store(-1, std::memory_order_relaxed);
+			}
+		}
+	}
+} const g_gauge_initializer;
+
+
+// frame times in microseconds, a ring written by every render thread
+
+std::atomic<std::uint32_t> g_frames[l_frame_samples];
+std::atomic<std::uint64_t> g_frame_count(0);
+std::atomic<std::uint64_t> g_frame_total(0);
+
+
+
+
+void describe(std::ostream& output, char const* name, char const* type, char const* help)
+{
+	output << "# HELP " << name << ' ' << help << '\n'
+		<< "# TYPE " << name << ' ' << type << '\n';
+}
+
+
+void format_frames(std::ostream& output)
+{
+	describe(output, "ortle_frame_seconds", "summary", "Time to draw and present a frame, quantiles over the most recent frames.");
+
+	std::uint64_t count = g_frame_count.load(std::memory_order_relaxed);
+	std::uint64_t total = g_frame_total.load(std::memory_order_relaxed);
+
+	std::vector<std::uint32_t> samples(static_cast<std::size_t>(std::min<std::uint64_t>(count, l_frame_samples)));
+
+	for (std::size_t i = 0; i < samples.size(); ++i) {
+		samples[i] = g_frames[i].load(std::memory_order_relaxed);
+	}
+
+	for (double quantile : l_quantiles) {
+
+		output << "ortle_frame_seconds{quantile=\"" << quantile << "\"} ";
+
+		if (samples.empty()) {
+			output << "NaN\n";
+			continue;
+		}
+
+		auto nth = samples.begin() + static_cast<std::ptrdiff_t>(quantile * static_cast<double>(samples.size() - 1) + 0.5);
+		std::nth_element(samples.begin(), nth, samples.end());
+
+		output << static_cast<double>(*nth) * 1e-6 << '\n';
+	}
+
+	output << "ortle_frame_seconds_sum " << static_cast<double>(total) * 1e-6 << '\n'
+		<< "ortle_frame_seconds_count " << count << '\n';
+}
+
+
+void format_round_trips(std::ostream& output)
+{
+	describe(output, "ortle_x_round_trips_total", "counter", "Blocking X requests, by call site.");
+
+	for (int i = 0; i < Utility::Metrics::RoundTripSiteCount; ++i) {
+		output << "ortle_x_round_trips_total{site=\"" << l_round_trip_names[i] << "\"} " << g_round_trips[i].load(std::memory_order_relaxed) << '\n';
+	}
+
+	describe(output, "ortle_x_round_trip_seconds_total", "counter", "Time spent waiting on blocking X requests, by call site.");
+
+	for (int i = 0; i < Utility::Metrics::RoundTripSiteCount; ++i) {
+		output << "ortle_x_round_trip_seconds_total{site=\"" << l_round_trip_names[i] << "\"} " << static_cast<double>(g_round_trip_time[i].load(std::memory_order_relaxed)) * 1e-9 << '\n';
+	}
+
+	describe(output, "ortle_x_round_trip_longest_seconds", "gauge", "The longest single blocking X request, by call site.");
+
+	for (int i = 0; i < Utility::Metrics::RoundTripSiteCount; ++i) {
+		output << "ortle_x_round_trip_longest_seconds{site=\"" << l_round_trip_names[i] << "\"} " << static_cast<double>(g_round_trip_longest[i].load(std::memory_order_relaxed)) * 1e-9 << '\n';
+	}
+}
+
+
+} // namespace
+
+
+
+
+namespace Utility {
+
+
+namespace Metrics {
+
+
+void add(Counter counter, unsigned long amount)
+{
+	g_counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+
+void set(Gauge gauge, int screen, long long value)
+{
+	if (screen >= 0 && screen < l_screen_count) {
+		g_gauges[gauge][screen].store(value, std::memory_order_relaxed);
+	}
+}
+
+
+void count_event(Event event)
+{
+	g_events[event].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void add_round_trip(RoundTripSite site, std::chrono::steady_clock::duration time)
+{
+	auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+
+	std::uint64_t sample = static_cast<std::uint64_t>(std::max<long long>(nanoseconds, 0));
+
+	g_round_trips[site].fetch_add(1, std::memory_order_relaxed);
+	g_round_trip_time[site].fetch_add(sample, std::memory_order_relaxed);
+
+	std::uint64_t longest = g_round_trip_longest[site].load(std::memory_order_relaxed);
+
+	while (sample > longest && !g_round_trip_longest[site].compare_exchange_weak(longest, sample, std::memory_order_relaxed)) {
+		// longest has been reloaded
+	}
+}
+
+
+char const* round_trip_name(RoundTripSite site)
+{
+	return l_round_trip_names[site];
+}
+
+
+void observe_frame(std::chrono::steady_clock::duration time)
+{
+	auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+
+	std::uint32_t sample = static_cast<std::uint32_t>(std::max<long long>(microseconds, 0));
+
+	std::uint64_t index = g_frame_count.fetch_add(1, std::memory_order_relaxed);
+
+	g_frames[index % l_frame_samples].store(sample, std::memory_order_relaxed);
+	g_frame_total.fetch_add(sample, std::memory_order_relaxed);
+}
+
+
+std::string format()
+{
+	std::ostringstream output;
+
+	format_frames(output);
+
+	for (int i = 0; i < CounterCount; ++i) {
+		describe(output, l_counters[i].name, "counter", l_counters[i].help);
+		output << l_counters[i].name << ' ' << g_counters[i].load(std::memory_order_relaxed) << '\n';
+	}
+
+	describe(output, "ortle_x_events_total", "counter", "X events handled, by type.");
+
+	for (int i = 0; i < EventCount; ++i) {
+		output << "ortle_x_events_total{type=\"" << l_event_names[i] << "\"} " << g_events[i].load(std::memory_order_relaxed) << '\n';
+	}
+
+	format_round_trips(output);
+
+	for (int i = 0; i < GaugeCount; ++i) {
+
+		describe(output, l_gauges[i].name, "gauge", l_gauges[i].help);
+
+		for (int screen = 0; screen < l_screen_count; ++screen) {
+
+			long long value = g_gauges[i][screen].load(std::memory_order_relaxed);
+
+			if (value >= 0) {
+				output << l_gauges[i].name << "{screen=\"" << screen << "\"} " << value << '\n';
+			}
+		}
+	}
+
+	return output.str();
+}
+
+
+
+
+Server::Server()
+	: m_path()
+	, m_descriptor(-1)
+	, m_clients()
+{}
+
+
+Server::Server(std::string const& path)
+	: Server()
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (path.size() >= sizeof(address.sun_path)) {
+		LOG_WARNING(Events, "metrics socket path is too long, not serving metrics", path);
+		return;
+	}
+
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+
+	// only a socket is replaced.  compositors on the same display would
+	// already have failed to take the composite manager selection.
+
+	struct stat status;
+
+	if (lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+		unlink(path.c_str());
+	}
+
+	int descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (descriptor < 0) {
+		LOG_WARNING(Events, "could not create metrics socket", std::strerror(errno));
+		return;
+	}
+
+	if (bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(descriptor, static_cast<int>(l_max_clients)) != 0) {
+		LOG_WARNING(Events, "could not listen for metrics", path, std::strerror(errno));
+		close(descriptor);
+		return;
+	}
+
+	LOG_INFO(Events, "serving metrics at", path);
+
+	m_path = path;
+	m_descriptor = descriptor;
+}
+
+
+
+
+Server::Server(Server&& other)
+	: Server()
+{
+	swap(*this, other);
+}
+
+
+Server& Server::operator=(Server&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Server::~Server()
+{
+	for (auto const& client : m_clients) {
+		close(client.descriptor);
+	}
+
+	if (m_descriptor >= 0) {
+		close(m_descriptor);
+		unlink(m_path.c_str());
+	}
+}
+
+
+
+
+void swap(Server& first, Server& second)
+{
+	using std::swap;
+
+	swap(first.m_path, second.m_path);
+	swap(first.m_descriptor, second.m_descriptor);
+	swap(first.m_clients, second.m_clients);
+}
+
+
+
+
+void Server::add_descriptors(std::vector<pollfd>& descriptors) const
+{
+	if (m_descriptor < 0) {
+		return;
+	}
+
+	pollfd descriptor;
+	descriptor.fd = m_descriptor;
+	descriptor.events = POLLIN;
+	descriptor.revents = 0;
+
+	descriptors.push_back(descriptor);
+
+	for (auto const& client : m_clients) {
+		descriptor.fd = client.descriptor;
+		descriptors.push_back(descriptor);
+	}
+}
+
+
+void Server::serve()
+{
+	if (m_descriptor < 0) {
+		return;
+	}
+
+	accept_clients();
+
+	auto done = [this] (Client& client) {
+
+		if (read_request(client)) {
+			close(client.descriptor);
+			return true;
+		}
+
+		return false;
+	};
+
+	m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(), done), m_clients.end());
+}
+
+
+
+
+void Server::accept_clients()
+{
+	while (true) {
+
+		int descriptor = accept4(m_descriptor, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (descriptor < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				LOG_DEBUG(Events, "could not accept metrics client", std::strerror(errno));
+			}
+			return;
+		}
+
+		if (m_clients.size() >= l_max_clients) {
+			LOG_DEBUG(Events, "too many metrics clients, dropping one");
+			close(descriptor);
+			continue;
+		}
+
+		Client client = { descriptor, std::string(), Clock::now() };
+		m_clients.push_back(std::move(client));
+	}
+}
+
+
+bool Server::read_request(Client& client)
+{
+	char buffer[512];
+
+	while (true) {
+
+		ssize_t size = recv(client.descriptor, buffer, sizeof(buffer), 0);
+
+		if (size > 0) {
+			client.request.append(buffer, static_cast<std::size_t>(size));
+
+			if (client.request.size() > l_max_request) {
+				LOG_DEBUG(Events, "metrics request too long, dropping client");
+				return true;
+			}
+
+			continue;
+		}
+
+		// the client has said all it will
+
+		if (size == 0) {
+			break;
+		}
+
+		if (errno == EINTR) {
+			continue;
+		}
+
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			return true;
+		}
+
+
+		// nothing more for now.  the request isn't read any further than
+		// its headers, which end with a blank line.
+
+		if (client.request.find("\r\n\r\n") != std::string::npos || client.request.find("\n\n") != std::string::npos) {
+			break;
+		}
+
+		if (Clock::now() - client.accepted > l_client_timeout) {
+			LOG_DEBUG(Events, "metrics client timed out");
+			return true;
+		}
+
+		return false;
+	}
+
+	answer(client);
+
+	return true;
+}
+
+
+void Server::answer(Client& client)
+{
+	bool found = (client.request.compare(0, 4, "GET ") == 0);
+
+	std::string body = (found ? format() : std::string("only GET is supported\n"));
+
+	std::ostringstream response;
+
+	response << (found ? "HTTP/1.0 200 OK\r\n" : "HTTP/1.0 405 Method Not Allowed\r\n")
+		<< "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+		<< "Content-Length: " << body.size() << "\r\n"
+		<< "Connection: close\r\n"
+		<< "\r\n"
+		<< body;
+
+	std::string text = response.str();
+
+
+	// a few kilobytes fit in any socket's buffer, so a client that can't
+	// take it all at once isn't waited for
+
+	ssize_t sent = send(client.descriptor, text.data(), text.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+
+	if (sent < 0 || static_cast<std::size_t>(sent) != text.size()) {
+		LOG_DEBUG(Events, "could not send all of the metrics", sent, text.size());
+	}
+
+	shutdown(client.descriptor, SHUT_WR);
+}
+
+
+} // namespace Metrics
+
+
+} // namespace Utility
@@ -0,0 +1,196 @@
+#ifndef UTILITY_METRICS_HPP
+#define UTILITY_METRICS_HPP
+
+
+#include <poll.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+
+
+// counters and gauges describing how the compositor is doing, for
+// monitoring rather than debugging.  any thread can update them; each update
+// is a relaxed atomic operation, so the render thread never waits on them.
+// a Server hands them out in the Prometheus text format, e.g.
+//
+//   curl --unix-socket $XDG_RUNTIME_DIR/ortle-0.metrics http://ortle/metrics
+//
+// rates (events or bindings per second) are left to the scraper, which
+// works them out from the counters.
+
+namespace Utility {
+
+
+namespace Metrics {
+
+
+enum Counter {
+	DroppedRetraces,
+	DuplicateRetraces,
+	PixmapBinds,
+	CounterCount
+};
+
+
+// per screen
+
+enum Gauge {
+	ManagedWindows,
+	VisibleWindows,
+	TextureBytes,
+	GaugeCount
+};
+
+
+// the events the compositor handles, core and extension alike
+
+enum Event {
+	CirculateEvent,
+	ClientMessageEvent,
+	ConfigureEvent,
+	CreateEvent,
+	DamageEvent,
+	DestroyEvent,
+	GraphicsExposeEvent,
+	MapEvent,
+	NoExposeEvent,
+	PropertyEvent,
+	RandrEvent,
+	ReparentEvent,
+	ScreenSaverEvent,
+	ShapeEvent,
+	UnmapEvent,
+	OtherEvent,
+	EventCount
+};
+
+
+// the places the compositor waits on the server for a reply (see
+// X11::RoundTrip).  XCompositeNameWindowPixmap has no reply, but is counted
+// all the same, since it is where each new pixmap comes from.
+
+enum RoundTripSite {
+	GetGeometry,
+	TranslateCoordinates,
+	GetWindowAttributes,
+	QueryTopLevelWindow,
+	ShapeGetRectangles,
+	ShapeQueryExtents,
+	NameWindowPixmap,
+	GetWallpaperProperty,
+	GetActiveWindowProperty,
+	GetHudProperty,
+	SyncPixmaps,
+	RandrGetResources,
+	RandrGetCrtcInfo,
+	DpmsGetInfo,
+	RoundTripSiteCount
+};
+
+
+void add(Counter counter, unsigned long amount = 1);
+
+// screens past the first few are left out
+
+void set(Gauge gauge, int screen, long long value);
+
+void count_event(Event event);
+
+void add_round_trip(RoundTripSite site, std::chrono::steady_clock::duration time);
+
+// e.g. "XGetGeometry in X11::Geometry", which lives forever
+
+char const* round_trip_name(RoundTripSite site);
+
+// the time taken to draw and present a frame.  the most recent frames are
+// kept for the quantiles.
+
+void observe_frame(std::chrono::steady_clock::duration time);
+
+// everything, in the Prometheus text format
+
+std::string format();
+
+
+
+
+// answers HTTP requests for the metrics on a Unix domain socket.  it never
+// blocks: whoever owns it polls its descriptors along with their own, and
+// calls serve() when they wake.  clients that are slow to ask, or to read
+// the answer, are dropped.
+
+class Server {
+
+public:
+
+	// not listening
+
+	Server();
+
+	// listens at the given path, replacing any socket left there by a
+	// previous run.  if that fails, it says so and doesn't listen.
+
+	explicit Server(std::string const& path);
+
+	Server(Server&& other);
+	Server& operator=(Server&& other);
+
+	~Server();
+
+	friend void swap(Server& first, Server& second);
+
+
+public:
+
+	// appends the listening socket and every client still waiting for an
+	// answer, to be polled for input
+
+	void add_descriptors(std::vector<pollfd>& descriptors) const;
+
+	// accepts whoever is waiting, and answers every client whose request has
+	// arrived
+
+	void serve();
+
+
+private:
+
+	struct Client {
+
+		int descriptor;
+		std::string request;
+		std::chrono::steady_clock::time_point accepted;
+
+	};
+
+
+private:
+
+	void accept_clients();
+
+	// returns true once the client is done with, answered or not
+
+	bool read_request(Client& client);
+	void answer(Client& client);
+
+
+private:
+
+	std::string m_path;
+	int m_descriptor;
+
+	std::vector<Client> m_clients;
+
+};
+
+
+} // namespace Metrics
+
+
+} // namespace Utility
+
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef UTILITY_SLOT_MAP_HPP
+#define UTILITY_SLOT_MAP_HPP
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+
+namespace Utility {
+
+
+
+
+// a pool of T, addressed by (index, generation) ids.  elements are stored in
+// fixed-size chunks which are never moved or freed until the map is
+// destroyed, so pointers to elements stay valid until they are erased, and a
+// slot freed by erase() is reused by the next emplace() without touching the
+// heap.  the generation of a slot is bumped on every emplace and erase, which
+// makes ids of erased elements detectably stale.
+
+template<typename T, std::size_t ChunkSize = 64>
+class SlotMap {
+
+public:
+
+	struct Id {
+
+		std::uint32_t index;
+		std::uint32_t generation;
+
+	};
+
+
+public:
+
+	SlotMap()
+		: m_chunks()
+		, m_generations()
+		, m_free()
+		, m_size(0)
+	{}
+
+
+	SlotMap(SlotMap&& other)
+		: SlotMap()
+	{
+		swap(*this, other);
+	}
+
+
+	SlotMap& operator=(SlotMap&& other)
+	{
+		swap(*this, other);
+		return *this;
+	}
+
+
+	~SlotMap()
+	{
+		for (std::uint32_t index = 0; index < m_generations.size(); ++index) {
+			if (occupied(index)) {
+				slot(index)->~T();
+			}
+		}
+	}
+
+
+	friend void swap(SlotMap& first, SlotMap& second)
+	{
+		using std::swap;
+
+		swap(first.m_chunks, second.m_chunks);
+		swap(first.m_generations, second.m_generations);
+		swap(first.m_free, second.m_free);
+		swap(first.m_size, second.m_size);
+	}
+
+
+public:
+
+	template<typename... Arguments>
+	Id emplace(Arguments&&... arguments)
+	{
+		if (m_free.empty()) {
+			grow();
+		}
+
+		std::uint32_t index = m_free.back();
+
+		// if the constructor throws, the slot simply stays on the free list
+
+		new (slot(index)) T(std::forward<Arguments>(arguments)...);
+
+		m_free.pop_back();
+		++m_generations[index];
+		++m_size;
+
+		Id id = { index, m_generations[index] };
+		return id;
+	}
+
+
+	void erase(Id id)
+	{
+		assert(find(id) != nullptr);
+
+		slot(id.index)->~T();
+
+		++m_generations[id.index];
+		--m_size;
+
+		// grow() reserved room for every slot, so this does not allocate
+
+		m_free.push_back(id.index);
+	}
+
+
+	// returns nullptr if the element has been erased
+
+	T* find(Id id)
+	{
+		if (id.index >= m_generations.size() || m_generations[id.index] != id.generation || !occupied(id.index)) {
+			return nullptr;
+		}
+		return slot(id.index);
+	}
+
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+
+private:
+
+	using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	struct Chunk {
+
+		Storage slots[ChunkSize];
+
+	};
+
+
+	// a slot is occupied while its generation is odd
+
+	bool occupied(std::uint32_t index) const
+	{
+		return (m_generations[index] & 1) != 0;
+	}
+
+
+	T* slot(std::uint32_t index)
+	{
+		return reinterpret_cast<T*>(&m_chunks[index / ChunkSize]->slots[index % ChunkSize]);
+	}
+
+
+	void grow()
+	{
+		std::uint32_t first = static_cast<std::uint32_t>(m_generations.size());
+
+		m_chunks.emplace_back(new Chunk);
+		m_generations.resize(first + ChunkSize, 0);
+		m_free.reserve(m_generations.size());
+
+		// hand out low indices first
+
+		for (std::uint32_t index = first + ChunkSize; index > first; --index) {
+			m_free.push_back(index - 1);
+		}
+	}
+
+
+private:
+
+	std::vector<std::unique_ptr<Chunk>> m_chunks;
+	std::vector<std::uint32_t> m_generations;
+	std::vector<std::uint32_t> m_free;
+	std::size_t m_size;
+
+};
+
+
+
+
+} // namespace Utility
+
+
+#endif
@@ -1,25 +1,32 @@
 #include "window_manager.hpp"
 
 #include "exceptions.hpp"
-#include "framebuffer_cache.hpp"
 #include "input_only_window.hpp"
 #include "input_output_window.hpp"
 #include "managed_window.hpp"
+#include "pixmap_ledger.hpp"
 #include "root.hpp"
+#include "scene.hpp"
 
-#include "utility/trace.hpp"
+#include "utility/log.hpp"
+#include "utility/metrics.hpp"
 
 #include "x11/functions.hpp"
+#include "x11/round_trip.hpp"
+#include "x11/xlib.hpp"
 
+#include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
 #include <X11/extensions/Xcomposite.h>
 #include <X11/extensions/Xdamage.h>
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 
 #include <algorithm>
-#include <memory>
+#include <chrono>
 #include <utility>
 #include <vector>
 
@@ -29,10 +36,24 @@
 namespace {
 
 
+// background windows are redrawn at about 30 Hz
+
+std::chrono::milliseconds const l_background_damage_interval(33);
+
+
+// how long a resized window draws a snapshot of its old pixmap before the new
+// one is named.  a resize animation is 22 frames, a little under 370 ms at
+// 60 Hz; if the new pixmap arrives before it ends, the snapshot is still
+// drawn until it does.  an interactive resize keeps putting it off, so
+// dragging a window's edge costs no round trips until it is let go.
+
+std::chrono::milliseconds const l_resize_settle_time(400);
+
+
 template<typename Iterator>
 inline Iterator find(Iterator begin, Iterator end, Window window)
 {
-	return std::find_if(begin, end, [=](std::unique_ptr<ManagedWindow> const& w) { return *w == window; });
+	return std::find_if(begin, end, [=](WindowManager::Entry const& entry) { return entry.id == window; });
 }
 
 
@@ -62,26 +83,40 @@ inline void move_before(Container& container, Iterator item, Iterator target)
 
 
 
-WindowManager::WindowManager(Display* display, int screen, Window root, FramebufferCache& framebuffers)
+WindowManager::WindowManager(Display* display, int screen, Window root, PixmapLedger& pixmaps)
 	: m_display(display)
 	, m_screen(0)
 	, m_root(root)
+	, m_root_window()
+	, m_input_only_windows()
+	, m_input_output_windows()
 	, m_windows()
+	, m_changed(true)
+	, m_net_active_window(X11::Xlib::InternAtom(display, "_NET_ACTIVE_WINDOW", False))
+	, m_active_window(None)
+	, m_ortle_hud(X11::Xlib::InternAtom(display, "_ORTLE_HUD", False))
+	, m_hud(Scene::HudHidden)
+	, m_held_damage()
+	, m_damage_flushed()
+	, m_resizes()
 {
 	assert(display != nullptr);
 	assert(screen >= 0);
 	assert(root != None);
 
 
-	TRACE("creating window manager on root", root);
+	LOG_DEBUG(Stacking, "creating window manager on root", root);
 
-	XGrabServer(display);
+	X11::Xlib::GrabServer(display);
 
-	m_windows.emplace(m_windows.begin(), new Root(display, screen, root, framebuffers));
+	m_root_window = Root(display, screen, root, pixmaps);
 
-	XCompositeRedirectSubwindows(m_display, m_root, CompositeRedirectManual);
+	Entry entry = { root, &m_root_window, 0, 0 };
+	m_windows.push_back(entry);
 
-	XSelectInput(m_display, m_root, PropertyChangeMask | StructureNotifyMask | SubstructureNotifyMask);
+	X11::Xlib::CompositeRedirectSubwindows(m_display, m_root, CompositeRedirectManual);
+
+	X11::Xlib::SelectInput(m_display, m_root, PropertyChangeMask | StructureNotifyMask | SubstructureNotifyMask);
 
 
 	Window tree_root;
@@ -89,7 +124,7 @@ WindowManager::WindowManager(Display* display, int screen, Window root, Framebuf
 	Window* tree_children;
 	unsigned int count;
 
-	if (XQueryTree(display, root, &tree_root, &tree_parent, &tree_children, &count)) {
+	if (X11::Xlib::QueryTree(display, root, &tree_root, &tree_parent, &tree_children, &count)) {
 
 		assert(root == tree_root);
 
@@ -98,13 +133,16 @@ WindowManager::WindowManager(Display* display, int screen, Window root, Framebuf
 			fake_event.type = -1;
 			fake_event.parent = root;
 			fake_event.window = tree_children[i];
-			add_before(m_windows.end(), fake_event, framebuffers);
+			add_before(m_windows.end(), fake_event, pixmaps);
 
 		}
 		XFree(tree_children);
 	}
 
-	XUngrabServer(display);
+	X11::Xlib::UngrabServer(display);
+
+	update_active_window();
+	update_hud();
 }
 
 
@@ -114,7 +152,18 @@ WindowManager::WindowManager(WindowManager&& other)
 	: m_display(nullptr)
 	, m_screen(0)
 	, m_root(None)
+	, m_root_window()
+	, m_input_only_windows()
+	, m_input_output_windows()
 	, m_windows()
+	, m_changed(true)
+	, m_net_active_window(None)
+	, m_active_window(None)
+	, m_ortle_hud(None)
+	, m_hud(Scene::HudHidden)
+	, m_held_damage()
+	, m_damage_flushed()
+	, m_resizes()
 {
 	swap(*this, other);
 }
@@ -133,9 +182,9 @@ WindowManager::~WindowManager()
 {
 	if (m_display != nullptr) {
 
-		TRACE("destroying window manager on root", m_root);
+		LOG_DEBUG(Stacking, "destroying window manager on root", m_root);
 
-		XCompositeUnredirectSubwindows(m_display, m_root, CompositeRedirectManual);
+		X11::Xlib::CompositeUnredirectSubwindows(m_display, m_root, CompositeRedirectManual);
 	}
 }
 
@@ -149,22 +198,157 @@ void swap(WindowManager& first, WindowManager& second)
 	swap(first.m_display, second.m_display);
 	swap(first.m_screen, second.m_screen);
 	swap(first.m_root, second.m_root);
+	swap(first.m_root_window, second.m_root_window);
+	swap(first.m_input_only_windows, second.m_input_only_windows);
+	swap(first.m_input_output_windows, second.m_input_output_windows);
 	swap(first.m_windows, second.m_windows);
+
+	// the root window does not move with its pool, so point each stack at
+	// its new one
+
+	if (!first.m_windows.empty()) {
+		first.m_windows.front().window = &first.m_root_window;
+	}
+	if (!second.m_windows.empty()) {
+		second.m_windows.front().window = &second.m_root_window;
+	}
+	swap(first.m_changed, second.m_changed);
+	swap(first.m_net_active_window, second.m_net_active_window);
+	swap(first.m_active_window, second.m_active_window);
+	swap(first.m_ortle_hud, second.m_ortle_hud);
+	swap(first.m_hud, second.m_hud);
+	swap(first.m_held_damage, second.m_held_damage);
+	swap(first.m_damage_flushed, second.m_damage_flushed);
+	swap(first.m_resizes, second.m_resizes);
+}
+
+
+
+
+void WindowManager::describe(Scene& scene) const
+{
+	scene.clear();
+
+	for (auto const& entry : m_windows) {
+		entry.window->describe(scene);
+	}
+
+	scene.set_hud(m_hud);
 }
 
 
 
 
-void WindowManager::add_before(Iterator target, XCreateWindowEvent const& event, FramebufferCache& framebuffers)
+void WindowManager::flush_damage(std::chrono::steady_clock::time_point now)
+{
+	if (m_held_damage.empty()) {
+		return;
+	}
+
+	if (now - m_damage_flushed < l_background_damage_interval) {
+		return;
+	}
+
+	release_held_damage();
+
+	m_damage_flushed = now;
+}
+
+
+int WindowManager::damage_timeout() const
+{
+	if (m_held_damage.empty()) {
+		return -1;
+	}
+
+	auto elapsed = std::chrono::steady_clock::now() - m_damage_flushed;
+
+	if (elapsed >= l_background_damage_interval) {
+		return 0;
+	}
+
+	// round up, so that the wait doesn't end just short of the interval
+
+	auto remaining = l_background_damage_interval - elapsed;
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count()) + 1;
+}
+
+
+
+
+void WindowManager::settle_resizes(std::chrono::steady_clock::time_point now)
+{
+	std::size_t kept = 0;
+
+	for (std::size_t i = 0; i < m_resizes.size(); ++i) {
+
+		Resize resize = m_resizes[i];
+
+		if (resize.resized == std::chrono::steady_clock::time_point()) {
+			resize.resized = now;
+		}
+
+		if (now - resize.resized < l_resize_settle_time) {
+			m_resizes[kept++] = resize;
+			continue;
+		}
+
+		// the window may have been destroyed while it was settling
+
+		auto window = find(m_windows.begin(), m_windows.end(), resize.window);
+
+		if (window != m_windows.end() && window->window->kind() == ManagedWindow::Kind::InputOutputWindow) {
+			static_cast<InputOutputWindow*>(window->window)->refresh_stale_pixmap();
+			m_changed = true;
+		}
+	}
+
+	m_resizes.resize(kept);
+}
+
+
+int WindowManager::resize_timeout() const
+{
+	if (m_resizes.empty()) {
+		return -1;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	auto remaining = std::chrono::steady_clock::duration(l_resize_settle_time);
+
+	for (auto const& resize : m_resizes) {
+		if (resize.resized != std::chrono::steady_clock::time_point()) {
+			remaining = std::min(remaining, resize.resized + l_resize_settle_time - now);
+		}
+	}
+
+	if (remaining <= std::chrono::steady_clock::duration::zero()) {
+		return 0;
+	}
+
+	// round up, so that the wait doesn't end just short of the settle time
+
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count()) + 1;
+}
+
+
+
+
+void WindowManager::add_before(Iterator target, XCreateWindowEvent const& event, PixmapLedger& pixmaps)
 {
 	assert(event.window != None);
 	assert(event.parent != None);
 
 
-	TRACE("starting management of window", event.window);
+	LOG_DEBUG(Stacking, "starting management of window", event.window);
 
 	XWindowAttributes attributes;
-	if (!XGetWindowAttributes(m_display, event.window, &attributes)) {
+	Status found = 0;
+	{
+		X11::RoundTrip round_trip(Utility::Metrics::GetWindowAttributes);
+		found = X11::Xlib::GetWindowAttributes(m_display, event.window, &attributes);
+	}
+	if (!found) {
 		// this window is about to be destroyed.  treat it as an inputonly
 		// window so the renderer ignores it, and we can still use it for
 		// stacking
@@ -173,18 +357,35 @@ void WindowManager::add_before(Iterator target, XCreateWindowEvent const& event,
 
 	if (find(m_windows.begin(), m_windows.end(), event.window) != m_windows.end()) {
 		// we are already managing this window.  this should not happen.
-		TRACE("duplicate manage request for window", event.window);
+		LOG_DEBUG(Stacking, "duplicate manage request for window", event.window);
 		return;
 	}
 
 
+	// the pools reuse the slots of removed windows, and the stack keeps its
+	// capacity, so once they have grown to fit the busiest moment of the
+	// session, adding a window does not allocate.
+
+	Entry entry;
+	entry.id = event.window;
+
 	if (attributes.c_class == InputOutput) {
-		XShapeSelectInput(m_display, event.window, ShapeNotifyMask);
-		m_windows.emplace(target, new InputOutputWindow(m_display, m_root, event, attributes, framebuffers));
+		X11::Xlib::ShapeSelectInput(m_display, event.window, ShapeNotifyMask);
+		auto slot = m_input_output_windows.emplace(m_display, m_root, event, attributes, pixmaps);
+		entry.window = m_input_output_windows.find(slot);
+		entry.slot = slot.index;
+		entry.generation = slot.generation;
 	}
 	else {
-		m_windows.emplace(target, new InputOnlyWindow(event));
+		auto slot = m_input_only_windows.emplace(event);
+		entry.window = m_input_only_windows.find(slot);
+		entry.slot = slot.index;
+		entry.generation = slot.generation;
 	}
+
+	m_windows.insert(target, entry);
+
+	m_changed = true;
 }
 
 
@@ -205,14 +406,151 @@ void WindowManager::move_before(Iterator target, Iterator window)
 		auto it = std::move_backward(target, window, window + 1);
 		*(--it) = std::move(temp);
 	}
+
+	m_changed = true;
 }
 
 
 void WindowManager::remove(Iterator target)
 {
-	TRACE("stopping management of window", **target);
+	LOG_DEBUG(Stacking, "stopping management of window", target->id);
+
+	switch (target->window->kind()) {
+
+		case ManagedWindow::Kind::InputOnlyWindow: {
+			Utility::SlotMap<InputOnlyWindow>::Id slot = { target->slot, target->generation };
+			m_input_only_windows.erase(slot);
+			break;
+		}
+
+		case ManagedWindow::Kind::InputOutputWindow: {
+			Utility::SlotMap<InputOutputWindow>::Id slot = { target->slot, target->generation };
+			m_input_output_windows.erase(slot);
+			break;
+		}
+
+		case ManagedWindow::Kind::Root:
+			assert(false);
+			return;
+	}
 
 	m_windows.erase(target);
+
+	m_changed = true;
+}
+
+
+
+void WindowManager::release_held_damage()
+{
+	for (auto const& event : m_held_damage) {
+
+		auto window = find(m_windows.begin(), m_windows.end(), event.drawable);
+
+		// the window may have been destroyed while its damage was held
+
+		if (window != m_windows.end()) {
+			window->window->on_damage_notify(event);
+			m_changed = true;
+		}
+	}
+
+	m_held_damage.clear();
+}
+
+
+void WindowManager::update_active_window()
+{
+	Window active = None;
+
+	Atom type = None;
+	int format = 0;
+	unsigned long count = 0;
+	unsigned long remaining = 0;
+	unsigned char* data = nullptr;
+
+	int status = BadImplementation;
+
+	{
+		X11::RoundTrip round_trip(Utility::Metrics::GetActiveWindowProperty);
+		status = X11::Xlib::GetWindowProperty(m_display, m_root, m_net_active_window, 0, 1, False, XA_WINDOW, &type, &format, &count, &remaining, &data);
+	}
+
+	if (status == Success && data != nullptr) {
+
+		if (type == XA_WINDOW && format == 32 && count == 1) {
+			active = *reinterpret_cast<Window*>(data);
+		}
+
+		XFree(data);
+	}
+
+
+	// the window manager names the client window, but what we draw is the
+	// top-level window it has been reparented into
+
+	if (active != None) {
+		active = X11::top_level_window(m_display, m_root, active);
+	}
+
+	if (active != m_active_window) {
+
+		LOG_DEBUG(Stacking, "active window is now", active);
+
+		m_active_window = active;
+
+
+		// whatever was held back may now belong to the active window, and
+		// otherwise would only have waited a few more milliseconds
+
+		release_held_damage();
+	}
+}
+
+
+void WindowManager::update_hud()
+{
+	Scene::HudMode hud = Scene::HudHidden;
+
+	Atom type = None;
+	int format = 0;
+	unsigned long count = 0;
+	unsigned long remaining = 0;
+	unsigned char* data = nullptr;
+
+	int status = BadImplementation;
+
+	{
+		X11::RoundTrip round_trip(Utility::Metrics::GetHudProperty);
+		status = X11::Xlib::GetWindowProperty(m_display, m_root, m_ortle_hud, 0, 1, False, XA_CARDINAL, &type, &format, &count, &remaining, &data);
+	}
+
+	if (status == Success && data != nullptr) {
+
+		if (type == XA_CARDINAL && format == 32 && count == 1) {
+
+			// format 32 properties come back as longs
+
+			unsigned long value = *reinterpret_cast<unsigned long*>(data);
+
+			if (value == 1) {
+				hud = Scene::HudShown;
+			}
+			else if (value >= 2) {
+				hud = Scene::HudWithDamage;
+			}
+		}
+
+		XFree(data);
+	}
+
+	if (hud != m_hud) {
+
+		LOG_DEBUG(Render, "performance HUD is now", static_cast<int>(hud));
+
+		m_hud = hud;
+		m_changed = true;
+	}
 }
 
 
@@ -234,7 +572,7 @@ void WindowManager::on_circulate_notify(XCirculateEvent const& event)
 		}
 	}
 	else {
-		TRACE("WARNING", "XCirculateEvent.window missing from stack", event.window);
+		LOG_WARNING(Stacking, "XCirculateEvent.window missing from stack", event.window);
 	}
 }
 
@@ -251,7 +589,24 @@ void WindowManager::on_configure_notify(XConfigureEvent const& event)
 		// any adjustment to the stack may invalidate these iterators, so we 
 		// pass along the configure event before adjusting the stack
 
-		(*window)->on_configure_notify(event);
+		window->window->on_configure_notify(event);
+		m_changed = true;
+
+		// a resize starts the wait for the window's new pixmap, and anything
+		// else that reconfigures it while it waits starts it over
+
+		if (window->window->kind() == ManagedWindow::Kind::InputOutputWindow && static_cast<InputOutputWindow*>(window->window)->pixmap_stale()) {
+
+			auto resize = std::find_if(m_resizes.begin(), m_resizes.end(), [&](Resize const& r) { return r.window == event.window; });
+
+			if (resize != m_resizes.end()) {
+				resize->resized = std::chrono::steady_clock::time_point();
+			}
+			else {
+				Resize added = { event.window, std::chrono::steady_clock::time_point() };
+				m_resizes.push_back(added);
+			}
+		}
 
 		
 		// now we try to restack the window if it is necessary
@@ -282,41 +637,53 @@ void WindowManager::on_configure_notify(XConfigureEvent const& event)
 		}
 
 		else {
-			TRACE("WARNING", "XConfigureEvent.above missing from the stack", event.above);
+			LOG_WARNING(Stacking, "XConfigureEvent.above missing from the stack", event.above);
 		}
 	}
 }
 
 
-void WindowManager::on_create_notify(XCreateWindowEvent const& event, FramebufferCache& framebuffers)
+void WindowManager::on_create_notify(XCreateWindowEvent const& event, PixmapLedger& pixmaps)
 {
 	// only consider windows parented to the root window.  this check should 
 	// be unnecessary, but i've received some errant UnmapNotifies from windows 
 	// that are not my business, so maybe i'll get some here, too.
 
 	if (event.parent == m_root) {
-		add_before(m_windows.end(), event, framebuffers);
+		add_before(m_windows.end(), event, pixmaps);
 	}
 	else {
-		TRACE("WARNING", "XCreateWindowEvent.parent is not the root window", "event.window", event.window, "event.parent", event.parent);
+		LOG_WARNING(Stacking, "XCreateWindowEvent.parent is not the root window", "event.window", event.window, "event.parent", event.parent);
 	}
 }
 
 
-// void WindowManager::on_damage_notify(XDamageNotifyEvent const& event)
-// {
-// 	auto begin = m_windows.begin();
-// 	auto end = m_windows.end();
+void WindowManager::on_damage_notify(XDamageNotifyEvent const& event)
+{
+	auto begin = m_windows.begin();
+	auto end = m_windows.end();
+
+	auto window = find(begin, end, event.drawable);
+
+	if (window == end) {
+		LOG_WARNING(Stacking, "XDamageNotifyEvent.drawable missing from stack", event.drawable);
+		return;
+	}
+
+
+	// damage to background windows waits for the next batch.  the server
+	// reports nothing more for a window until its damage is subtracted, so
+	// each window is held at most once, and the client's drawing in the
+	// meantime is picked up with it.
 
-// 	auto window = find(begin, end, event.drawable);
+	if (m_active_window != None && event.drawable != m_active_window) {
+		m_held_damage.push_back(event);
+		return;
+	}
 
-// 	if (window != end) {
-// 		(*window)->on_damage_notify(event);
-// 	}
-// 	else {
-// 		TRACE("WARNING", "XDamageNotifyEvent.drawable missing from stack", event.drawable);
-// 	}
-// }
+	window->window->on_damage_notify(event);
+	m_changed = true;
+}
 
 
 void WindowManager::on_destroy_notify(XDestroyWindowEvent const& event)
@@ -330,7 +697,7 @@ void WindowManager::on_destroy_notify(XDestroyWindowEvent const& event)
 		remove(window);
 	}
 	else {
-		TRACE("WARNING", "XDestroyWindowEvent.window missing from stack", event.window);
+		LOG_WARNING(Stacking, "XDestroyWindowEvent.window missing from stack", event.window);
 	}
 }
 
@@ -339,7 +706,8 @@ void WindowManager::on_graphics_expose(XGraphicsExposeEvent const& event)
 {
 	assert(m_windows.begin() != m_windows.end());
 
-	(*m_windows.begin())->on_graphics_expose(event);
+	m_windows.begin()->window->on_graphics_expose(event);
+	m_changed = true;
 }
 
 
@@ -351,10 +719,11 @@ void WindowManager::on_map_notify(XMapEvent const& event)
 	auto window = find(begin, end, event.window);
 
 	if (window != end) {
-		(*window)->on_map_notify(event);
+		window->window->on_map_notify(event);
+		m_changed = true;
 	}
 	else {
-		TRACE("WARNING", "XMapEvent.window missing from stack", event.window);
+		LOG_WARNING(Stacking, "XMapEvent.window missing from stack", event.window);
 	}
 }
 
@@ -363,7 +732,8 @@ void WindowManager::on_no_expose(XNoExposeEvent const& event)
 {
 	assert(m_windows.begin() != m_windows.end());
 
-	(*m_windows.begin())->on_no_expose(event);
+	m_windows.begin()->window->on_no_expose(event);
+	m_changed = true;
 }
 
 
@@ -375,15 +745,24 @@ void WindowManager::on_property_notify(XPropertyEvent const& event)
 	auto window = find(begin, end, event.window);
 
 	if (window != end) {
-		(*window)->on_property_notify(event);
+		window->window->on_property_notify(event);
+		m_changed = true;
 	}
 	else {
-		TRACE("WARNING", "XPropertyEvent.window missing from stack", event.window);
+		LOG_WARNING(Stacking, "XPropertyEvent.window missing from stack", event.window);
+	}
+
+	if (event.window == m_root && event.atom == m_net_active_window) {
+		update_active_window();
+	}
+
+	if (event.window == m_root && event.atom == m_ortle_hud) {
+		update_hud();
 	}
 }
 
 
-void WindowManager::on_reparent_notify(XReparentEvent const& event, FramebufferCache& framebuffers)
+void WindowManager::on_reparent_notify(XReparentEvent const& event, PixmapLedger& pixmaps)
 {
 	// we are interested in two cases when a window is reparented.  first, when
 	// the window has been reparented to the root window, and we're not 
@@ -414,7 +793,7 @@ void WindowManager::on_reparent_notify(XReparentEvent const& event, FramebufferC
 			fake_event.parent = event.parent;
 			fake_event.window = event.window;
 
-			add_before(end, fake_event, framebuffers);
+			add_before(end, fake_event, pixmaps);
 		}
 	}
 
@@ -425,7 +804,7 @@ void WindowManager::on_reparent_notify(XReparentEvent const& event, FramebufferC
 
 	else {
 		if (window != end) {
-			XShapeSelectInput(m_display, **window, NoEventMask);
+			X11::Xlib::ShapeSelectInput(m_display, window->id, NoEventMask);
 			remove(window);
 		}
 	}
@@ -447,10 +826,11 @@ void WindowManager::on_shape_notify(XShapeEvent const& event)
 	auto window = find(begin, end, event.window);
 
 	if (window != end) {
-		(*window)->on_shape_notify(event);
+		window->window->on_shape_notify(event);
+		m_changed = true;
 	}
 	else {
-		TRACE("WARNING", "XShapeEvent.window missing from stack", event.window);
+		LOG_WARNING(Stacking, "XShapeEvent.window missing from stack", event.window);
 	}
 }
 
@@ -463,10 +843,11 @@ void WindowManager::on_unmap_notify(XUnmapEvent const& event)
 	auto window = find(begin, end, event.window);
 
 	if (window != end) {
-		(*window)->on_unmap_notify(event);
+		window->window->on_unmap_notify(event);
+		m_changed = true;
 	}
 	else {
-		TRACE("WARNING", "XUnmapEvent.window missing from stack", event.window);
+		LOG_WARNING(Stacking, "XUnmapEvent.window missing from stack", event.window);
 	}
 }
 
@@ -2,31 +2,53 @@
 #define ORTLE_WINDOW_MANAGER_HPP
 
 
+#include "input_only_window.hpp"
+#include "input_output_window.hpp"
+#include "managed_window.hpp"
+#include "pixmap_ledger.hpp"
+#include "root.hpp"
+#include "scene.hpp"
+
+#include "utility/slot_map.hpp"
+
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
 #include <X11/extensions/Xdamage.h>
 
-#include <memory>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 
 
 
-class FramebufferCache;
-class ManagedWindow;
-
-
 class WindowManager {
 
 public:
 
-	using Container = std::vector<std::unique_ptr<ManagedWindow>>;
+	// the stack holds, from bottom to top, each window's id alongside a
+	// pointer to it, so that looking a window up by id only reads the stack.
+	// the windows themselves live in the pools below, by kind; slot says
+	// where (the root window is not pooled).
+
+	struct Entry {
+
+		Window id;
+		ManagedWindow* window;
+
+		std::uint32_t slot;
+		std::uint32_t generation;
+
+	};
+
+	using Container = std::vector<Entry>;
 	using Iterator = Container::iterator;
 
 
 public:
 
-	WindowManager(Display* display, int screen, Window root, FramebufferCache& framebuffers);
+	WindowManager(Display* display, int screen, Window root, PixmapLedger& pixmaps);
 
 	WindowManager(WindowManager&& other);
 	WindowManager& operator=(WindowManager&& other);
@@ -48,28 +70,85 @@ public:
 	}
 
 
+	// true if anything has changed since clear_changed() was last called,
+	// i.e. windows were added, removed, restacked, damaged, moved, resized,
+	// mapped, unmapped or reshaped, and a new scene should be published.
+
+	bool changed() const {
+		return m_changed;
+	}
+
+
+	void clear_changed() {
+		m_changed = false;
+	}
+
+
+	// the number of windows in the stack, the root included
+
+	std::size_t size() const {
+		return m_windows.size();
+	}
+
+
+	// replaces the contents of the given scene with the windows in the
+	// stack, bottom to top.
+
+	void describe(Scene& scene) const;
+
+
+	// damage to windows other than the active one (_NET_ACTIVE_WINDOW) is
+	// held back and handled in batches, at most l_background_damage_interval
+	// apart (see window_manager.cpp).  flush_damage() handles the held back
+	// damage if the interval is up at now (a replay runs on recorded time),
+	// and damage_timeout() returns the number of milliseconds until it will
+	// be, or -1 if there is none.
+	//
+	// this only throttles how often new scenes are published for background
+	// windows.  animations are moved along by the render thread every frame
+	// regardless.
+
+	void flush_damage(std::chrono::steady_clock::time_point now);
+	int damage_timeout() const;
+
+
+	// a resized window keeps its old pixmap, which the render thread
+	// animates from a snapshot of, until l_resize_settle_time has passed
+	// since its last resize (see window_manager.cpp).  settle_resizes() names
+	// the new pixmaps of windows that have settled at now, and
+	// resize_timeout() returns the number of milliseconds until the next one
+	// will have, or -1 if none are waiting.
+
+	void settle_resizes(std::chrono::steady_clock::time_point now);
+	int resize_timeout() const;
+
+
 public:
 
 	void on_circulate_notify(XCirculateEvent const& event);
 	void on_configure_notify(XConfigureEvent const& event);
-	void on_create_notify(XCreateWindowEvent const& event, FramebufferCache& framebuffers);
+	void on_create_notify(XCreateWindowEvent const& event, PixmapLedger& pixmaps);
 	void on_damage_notify(XDamageNotifyEvent const& event);
 	void on_destroy_notify(XDestroyWindowEvent const& event);
 	void on_graphics_expose(XGraphicsExposeEvent const& event);
 	void on_map_notify(XMapEvent const& event);
 	void on_no_expose(XNoExposeEvent const& event);
 	void on_property_notify(XPropertyEvent const& event);
-	void on_reparent_notify(XReparentEvent const& event, FramebufferCache& framebuffers);
+	void on_reparent_notify(XReparentEvent const& event, PixmapLedger& pixmaps);
 	void on_shape_notify(XShapeEvent const& event);
 	void on_unmap_notify(XUnmapEvent const& event);
 
 
 private:
 
-	void add_before(Iterator target, XCreateWindowEvent const& event, FramebufferCache& framebuffers);
+	void add_before(Iterator target, XCreateWindowEvent const& event, PixmapLedger& pixmaps);
 	void move_before(Iterator target, Iterator window);
 	void remove(Iterator target);
 
+	void release_held_damage();
+	void update_active_window();
+	void update_hud();
+
 
 private:
 
@@ -77,8 +156,46 @@ private:
 	int m_screen;
 	Window m_root;
 
+	Root m_root_window;
+
+	Utility::SlotMap<InputOnlyWindow> m_input_only_windows;
+	Utility::SlotMap<InputOutputWindow> m_input_output_windows;
+
 	Container m_windows;
 
+	bool m_changed;
+
+
+	// the top-level window that contains the active window, or None if the
+	// window manager doesn't say, in which case nothing is held back.
+
+	Atom m_net_active_window;
+	Window m_active_window;
+
+
+	// read from the root window's _ORTLE_HUD property: 0 or unset hides the
+	// performance HUD, 1 shows it, 2 also tints what was redrawn.
+
+	Atom m_ortle_hud;
+	Scene::HudMode m_hud;
+
+	std::vector<XDamageNotifyEvent> m_held_damage;
+	std::chrono::steady_clock::time_point m_damage_flushed;
+
+
+	// windows waiting to name a new pixmap, and when they were last resized.
+	// resizes are timed by the next settle_resizes() call, so that a replay
+	// times them the same way; until then, the time is zero.
+
+	struct Resize {
+
+		Window window;
+		std::chrono::steady_clock::time_point resized;
+
+	};
+
+	std::vector<Resize> m_resizes;
+
 };
 
 
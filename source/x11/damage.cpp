@@ -1,8 +1,9 @@
 #include "damage.hpp"
 
 #include "exceptions.hpp"
+#include "xlib.hpp"
 
-#include "../utility/trace.hpp"
+#include "../utility/log.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/Xdamage.h>
@@ -34,9 +35,9 @@ Damage::Damage(::Display* display, ::Drawable drawable, int level)
 	assert(drawable != None);
 
 
-	// TRACE("creating damage for drawable", drawable);
+	// LOG_DEBUG(Events, "creating damage for drawable", drawable);
 
-	::Damage damage = XDamageCreate(display, drawable, level);
+	::Damage damage = Xlib::DamageCreate(display, drawable, level);
 
 	if (!damage) {
 		throw InitializationError("Failed to create new Damage.");
@@ -68,9 +69,9 @@ Damage::~Damage()
 {
 	if (m_display != nullptr) {
 
-		// TRACE("destroying damage", m_damage);
+		// LOG_DEBUG(Events, "destroying damage", m_damage);
 
-		XDamageDestroy(m_display, m_damage);
+		Xlib::DamageDestroy(m_display, m_damage);
 	}
 }
 
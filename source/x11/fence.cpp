@@ -0,0 +1,97 @@
+#include "fence.hpp"
+
+#include "exceptions.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
+
+#include <cassert>
+
+#include <utility>
+
+
+
+
+namespace X11 {
+
+
+Fence::Fence()
+	: m_display(nullptr)
+	, m_fence(None)
+{}
+
+
+Fence::Fence(::Display* display, ::Drawable drawable)
+	: m_display(display)
+	, m_fence(None)
+{
+	assert(display != nullptr);
+	assert(drawable != None);
+
+
+	::XSyncFence fence = XSyncCreateFence(display, drawable, False);
+
+	if (!fence) {
+		throw InitializationError("Could not create a new X Sync Fence.");
+	}
+
+	m_fence = fence;
+}
+
+
+
+
+Fence::Fence(Fence&& other)
+	: Fence()
+{
+	swap(*this, other);
+}
+
+
+Fence& Fence::operator=(Fence&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Fence::~Fence()
+{
+	if (m_display != nullptr && m_fence != None) {
+		XSyncDestroyFence(m_display, m_fence);
+	}
+}
+
+
+
+
+void swap(Fence& first, Fence& second)
+{
+	using std::swap;
+
+	swap(first.m_display, second.m_display);
+	swap(first.m_fence, second.m_fence);
+}
+
+
+
+
+void Fence::trigger()
+{
+	assert(m_display != nullptr);
+
+	XSyncTriggerFence(m_display, m_fence);
+}
+
+
+void Fence::reset()
+{
+	assert(m_display != nullptr);
+
+	XSyncResetFence(m_display, m_fence);
+}
+
+
+} // namespace X11
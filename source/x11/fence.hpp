@@ -0,0 +1,58 @@
+#ifndef ORTLE_X11_FENCE_HPP
+#define ORTLE_X11_FENCE_HPP
+
+
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
+
+
+
+
+namespace X11 {
+
+
+class Fence {
+
+public:
+
+	Fence();
+	Fence(::Display* display, ::Drawable drawable);
+
+	Fence(Fence&& other);
+	Fence& operator=(Fence&& other);
+
+	~Fence();
+
+	friend void swap(Fence& first, Fence& second);
+
+
+public:
+
+	operator ::XSyncFence() const
+	{
+		return m_fence;
+	}
+
+
+public:
+
+	// a fence is triggered once the server has finished all the rendering
+	// requested before it, and has to be reset before it can be triggered
+	// again.
+
+	void trigger();
+	void reset();
+
+
+private:
+
+	::Display* m_display;
+	::XSyncFence m_fence;
+
+};
+
+
+} // namespace X11
+
+
+#endif
@@ -1,5 +1,10 @@
 #include "functions.hpp"
 
+#include "round_trip.hpp"
+#include "xlib.hpp"
+
+#include "../utility/metrics.hpp"
+
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
 #include <X11/extensions/Xfixes.h>
@@ -18,5 +23,40 @@ void set_click_through(::Display* display, ::Window window)
 }
 
 
+::Window top_level_window(::Display* display, ::Window root, ::Window window)
+{
+	while (window != None && window != root) {
+
+		::Window tree_root;
+		::Window tree_parent;
+		::Window* tree_children;
+		unsigned int count;
+
+		bool found = false;
+
+		{
+			RoundTrip round_trip(Utility::Metrics::QueryTopLevelWindow);
+			found = Xlib::QueryTree(display, window, &tree_root, &tree_parent, &tree_children, &count);
+		}
+
+		if (!found) {
+			return None;
+		}
+
+		if (tree_children != nullptr) {
+			XFree(tree_children);
+		}
+
+		if (tree_parent == root) {
+			return window;
+		}
+
+		window = tree_parent;
+	}
+
+	return None;
+}
+
+
 } // namespace X11
 
@@ -18,6 +18,16 @@ namespace X11 {
 void set_click_through(::Display* display, ::Window window);
 
 
+/// top_level_window
+
+/// Returns the ancestor of the given window that is a child of the root
+/// window (or the window itself, if it is one).  Returns None if there is no
+/// such window, e.g. because the window has been destroyed.  This walks the
+/// tree with XQueryTree, one round trip per level.
+
+::Window top_level_window(::Display* display, ::Window root, ::Window window);
+
+
 } // namespace X11
 
 
@@ -1,6 +1,10 @@
 #include "geometry.hpp"
 
-#include "../utility/trace.hpp"
+#include "round_trip.hpp"
+#include "xlib.hpp"
+
+#include "../utility/log.hpp"
+#include "../utility/metrics.hpp"
 
 #include <X11/Xlib.h>
 
@@ -26,14 +30,22 @@ Geometry::Geometry(::Display* display, ::Drawable target, ::Window relative)
 	assert(target != None);
 
 
-	if (!XGetGeometry(display, target, &root, &x, &y, &width, &height, &border_width, &depth)) {
-		TRACE("WARNING", "failed to get geometry for drawable", target);
+	bool found = false;
+
+	{
+		RoundTrip round_trip(Utility::Metrics::GetGeometry);
+		found = Xlib::GetGeometry(display, target, &root, &x, &y, &width, &height, &border_width, &depth);
+	}
+
+	if (!found) {
+		LOG_WARNING(Events, "failed to get geometry for drawable", target);
 		return;
 	}
 
 	if (relative != None) {
+		RoundTrip round_trip(Utility::Metrics::TranslateCoordinates);
 		Window dummy = None;
-		XTranslateCoordinates(display, target, relative, -border_width, -border_width, &x, &y, &dummy);
+		Xlib::TranslateCoordinates(display, target, relative, -border_width, -border_width, &x, &y, &dummy);
 	}
 }
 
@@ -1,6 +1,7 @@
 #include "pixmap.hpp"
 
 #include "exceptions.hpp"
+#include "xlib.hpp"
 
 #include <X11/Xlib.h>
 
@@ -29,7 +30,7 @@ Pixmap::Pixmap(::Display* display, ::Window window, unsigned int width, unsigned
 	assert(depth > 0);
 
 
-	::Pixmap pixmap = XCreatePixmap(display, window, width, height, depth);
+	::Pixmap pixmap = Xlib::CreatePixmap(display, window, width, height, depth);
 
 	if (!pixmap) {
 		throw InitializationError("Could not create a new X Pixmap.");
@@ -68,7 +69,7 @@ Pixmap& Pixmap::operator=(Pixmap&& other)
 Pixmap::~Pixmap()
 {
 	if (m_display != nullptr && m_pixmap != None) {
-		XFreePixmap(m_display, m_pixmap);
+		Xlib::FreePixmap(m_display, m_pixmap);
 	}
 }
 
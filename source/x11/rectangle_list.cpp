@@ -1,6 +1,10 @@
 #include "rectangle_list.hpp"
 
 #include "exceptions.hpp"
+#include "round_trip.hpp"
+#include "xlib.hpp"
+
+#include "../utility/metrics.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
@@ -36,7 +40,12 @@ RectangleList::RectangleList(::Display* display, ::Window window)
 	int count;
 	int ordering;
 
-	::XRectangle* rectangles = XShapeGetRectangles(display, window, ShapeBounding, &count, &ordering);
+	::XRectangle* rectangles = nullptr;
+
+	{
+		RoundTrip round_trip(Utility::Metrics::ShapeGetRectangles);
+		rectangles = Xlib::ShapeGetRectangles(display, window, ShapeBounding, &count, &ordering);
+	}
 
 	if (!rectangles) {
 		throw InitializationError("Failed to get list of bounding rectangles.");
@@ -0,0 +1,812 @@
+#include "region.hpp"
+
+#include "region_arena.hpp"
+
+#include <X11/Xlib.h>
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+
+
+
+namespace X11 {
+
+
+namespace {
+
+
+using Box = Region::Box;
+
+
+// the kernels below do the bulk work of combining regions: copying a band
+// with new vertical bounds, checking whether two bands can be merged,
+// translating and measuring.  a box is four ints, so it fits in one SSE2
+// register, and two fit in one AVX2 register.  which version is used is
+// decided at compile time (-mavx2, or SSE2 on any x86-64).
+
+#if defined(__SSE2__)
+
+inline __m128i load(Box const* box)
+{
+	return _mm_loadu_si128(reinterpret_cast<__m128i const*>(box));
+}
+
+inline void store(Box* box, __m128i value)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(box), value);
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+inline __m256i load2(Box const* box)
+{
+	return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(box));
+}
+
+inline void store2(Box* box, __m256i value)
+{
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(box), value);
+}
+
+#endif
+
+
+// copies a band's boxes, replacing their top and bottom
+
+void copy_band(Box const* source, std::size_t count, Box* target, int y1, int y2)
+{
+	std::size_t i = 0;
+
+#if defined(__AVX2__)
+
+	__m256i const keep2 = _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+	__m256i const bounds2 = _mm256_set_epi32(y2, 0, y1, 0, y2, 0, y1, 0);
+
+	for (; i + 2 <= count; i += 2) {
+		store2(target + i, _mm256_or_si256(_mm256_and_si256(load2(source + i), keep2), bounds2));
+	}
+
+#endif
+
+#if defined(__SSE2__)
+
+	__m128i const keep = _mm_set_epi32(0, -1, 0, -1);
+	__m128i const bounds = _mm_set_epi32(y2, 0, y1, 0);
+
+	for (; i < count; ++i) {
+		store(target + i, _mm_or_si128(_mm_and_si128(load(source + i), keep), bounds));
+	}
+
+#else
+
+	for (; i < count; ++i) {
+		target[i].x1 = source[i].x1;
+		target[i].y1 = y1;
+		target[i].x2 = source[i].x2;
+		target[i].y2 = y2;
+	}
+
+#endif
+}
+
+
+// true if two bands of the same size cover the same columns
+
+bool same_spans(Box const* a, Box const* b, std::size_t count)
+{
+	std::size_t i = 0;
+
+#if defined(__AVX2__)
+
+	for (; i + 2 <= count; i += 2) {
+		int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi32(load2(a + i), load2(b + i)));
+		if ((mask & 0x0F0F0F0F) != 0x0F0F0F0F) {
+			return false;
+		}
+	}
+
+#endif
+
+#if defined(__SSE2__)
+
+	for (; i < count; ++i) {
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(load(a + i), load(b + i)));
+		if ((mask & 0x0F0F) != 0x0F0F) {
+			return false;
+		}
+	}
+
+#else
+
+	for (; i < count; ++i) {
+		if (a[i].x1 != b[i].x1 || a[i].x2 != b[i].x2) {
+			return false;
+		}
+	}
+
+#endif
+
+	return true;
+}
+
+
+void translate_boxes(Box* boxes, std::size_t count, int dx, int dy)
+{
+	std::size_t i = 0;
+
+#if defined(__AVX2__)
+
+	__m256i const offset2 = _mm256_set_epi32(dy, dx, dy, dx, dy, dx, dy, dx);
+
+	for (; i + 2 <= count; i += 2) {
+		store2(boxes + i, _mm256_add_epi32(load2(boxes + i), offset2));
+	}
+
+#endif
+
+#if defined(__SSE2__)
+
+	__m128i const offset = _mm_set_epi32(dy, dx, dy, dx);
+
+	for (; i < count; ++i) {
+		store(boxes + i, _mm_add_epi32(load(boxes + i), offset));
+	}
+
+#else
+
+	for (; i < count; ++i) {
+		boxes[i].x1 += dx;
+		boxes[i].y1 += dy;
+		boxes[i].x2 += dx;
+		boxes[i].y2 += dy;
+	}
+
+#endif
+}
+
+
+// the bounding box of a banded list, which must not be empty.  the top and
+// bottom come from the first and last band; only left and right need a scan.
+
+Box measure(Box const* boxes, std::size_t count)
+{
+	assert(count > 0);
+
+	Box extents = { boxes[0].x1, boxes[0].y1, boxes[0].x2, boxes[count - 1].y2 };
+
+	std::size_t i = 0;
+
+#if defined(__AVX2__)
+
+	if (count >= 2) {
+
+		__m256i minimum = load2(boxes);
+		__m256i maximum = minimum;
+
+		for (i = 2; i + 2 <= count; i += 2) {
+			__m256i value = load2(boxes + i);
+			minimum = _mm256_min_epi32(minimum, value);
+			maximum = _mm256_max_epi32(maximum, value);
+		}
+
+		alignas(32) int lowest[8];
+		alignas(32) int highest[8];
+
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lowest), minimum);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(highest), maximum);
+
+		extents.x1 = std::min(lowest[0], lowest[4]);
+		extents.x2 = std::max(highest[2], highest[6]);
+	}
+
+#elif defined(__SSE2__)
+
+	// SSE2 has no 32-bit min/max, so they are built from a compare
+
+	__m128i minimum = load(boxes);
+	__m128i maximum = minimum;
+
+	for (i = 1; i < count; ++i) {
+		__m128i value = load(boxes + i);
+		__m128i less = _mm_cmplt_epi32(value, minimum);
+		__m128i greater = _mm_cmpgt_epi32(value, maximum);
+		minimum = _mm_or_si128(_mm_and_si128(less, value), _mm_andnot_si128(less, minimum));
+		maximum = _mm_or_si128(_mm_and_si128(greater, value), _mm_andnot_si128(greater, maximum));
+	}
+
+	alignas(16) int lowest[4];
+	alignas(16) int highest[4];
+
+	_mm_store_si128(reinterpret_cast<__m128i*>(lowest), minimum);
+	_mm_store_si128(reinterpret_cast<__m128i*>(highest), maximum);
+
+	extents.x1 = lowest[0];
+	extents.x2 = highest[2];
+
+#endif
+
+	for (; i < count; ++i) {
+		extents.x1 = std::min(extents.x1, boxes[i].x1);
+		extents.x2 = std::max(extents.x2, boxes[i].x2);
+	}
+
+	return extents;
+}
+
+
+inline Box const* band_end(Box const* band, Box const* end)
+{
+	int y1 = band->y1;
+
+	while (band != end && band->y1 == y1) {
+		++band;
+	}
+
+	return band;
+}
+
+
+
+
+// collects the boxes of a new region, one band at a time, merging each band
+// into the one above it when they cover the same columns.
+
+class Builder {
+
+public:
+
+	Builder(RegionArena& arena, std::size_t capacity)
+		: m_arena(arena)
+		, m_boxes(arena.allocate(std::max<std::size_t>(capacity, 1)))
+		, m_count(0)
+		, m_capacity(std::max<std::size_t>(capacity, 1))
+		, m_previous_band(0)
+		, m_current_band(0)
+		, m_has_previous_band(false)
+	{}
+
+
+	Box* boxes() const
+	{
+		return m_boxes;
+	}
+
+	std::size_t count() const
+	{
+		return m_count;
+	}
+
+
+	void begin_band()
+	{
+		m_current_band = m_count;
+	}
+
+
+	void add(int x1, int y1, int x2, int y2)
+	{
+		reserve(1);
+
+		Box& box = m_boxes[m_count++];
+
+		box.x1 = x1;
+		box.y1 = y1;
+		box.x2 = x2;
+		box.y2 = y2;
+	}
+
+
+	// extends the last box of the band if the new one touches it
+
+	void add_span(int x1, int y1, int x2, int y2)
+	{
+		if (m_count > m_current_band && m_boxes[m_count - 1].x2 >= x1) {
+			Box& last = m_boxes[m_count - 1];
+			last.x2 = std::max(last.x2, x2);
+		}
+		else {
+			add(x1, y1, x2, y2);
+		}
+	}
+
+
+	void add_band(Box const* begin, Box const* end, int y1, int y2)
+	{
+		std::size_t count = end - begin;
+
+		reserve(count);
+		copy_band(begin, count, m_boxes + m_count, y1, y2);
+		m_count += count;
+	}
+
+
+	void end_band()
+	{
+		std::size_t count = m_count - m_current_band;
+
+		if (count == 0) {
+			return;
+		}
+
+		if (m_has_previous_band && m_current_band - m_previous_band == count) {
+
+			Box* previous = m_boxes + m_previous_band;
+			Box* current = m_boxes + m_current_band;
+
+			if (previous->y2 == current->y1 && same_spans(previous, current, count)) {
+
+				for (std::size_t i = 0; i < count; ++i) {
+					previous[i].y2 = current->y2;
+				}
+
+				m_count = m_current_band;
+				return;
+			}
+		}
+
+		m_previous_band = m_current_band;
+		m_has_previous_band = true;
+	}
+
+
+private:
+
+	void reserve(std::size_t count)
+	{
+		if (m_count + count <= m_capacity) {
+			return;
+		}
+
+		// the old boxes stay in the arena until it is reset
+
+		std::size_t capacity = std::max(2 * m_capacity, m_count + count);
+		Box* boxes = m_arena.allocate(capacity);
+
+		std::copy(m_boxes, m_boxes + m_count, boxes);
+
+		m_boxes = boxes;
+		m_capacity = capacity;
+	}
+
+
+private:
+
+	RegionArena& m_arena;
+
+	Box* m_boxes;
+	std::size_t m_count;
+	std::size_t m_capacity;
+
+	std::size_t m_previous_band;
+	std::size_t m_current_band;
+	bool m_has_previous_band;
+
+};
+
+
+
+
+// the three ways of combining two bands that overlap vertically, over the
+// rows [y1, y2).  spans of each band are sorted and disjoint.
+
+void unite_bands(Builder& builder, Box const* a, Box const* a_end, Box const* b, Box const* b_end, int y1, int y2)
+{
+	while (a != a_end || b != b_end) {
+
+		Box const* next;
+
+		if (b == b_end || (a != a_end && a->x1 <= b->x1)) {
+			next = a++;
+		}
+		else {
+			next = b++;
+		}
+
+		builder.add_span(next->x1, y1, next->x2, y2);
+	}
+}
+
+
+void intersect_bands(Builder& builder, Box const* a, Box const* a_end, Box const* b, Box const* b_end, int y1, int y2)
+{
+	while (a != a_end && b != b_end) {
+
+		int x1 = std::max(a->x1, b->x1);
+		int x2 = std::min(a->x2, b->x2);
+
+		if (x1 < x2) {
+			builder.add(x1, y1, x2, y2);
+		}
+
+		if (a->x2 < b->x2) {
+			++a;
+		}
+		else if (b->x2 < a->x2) {
+			++b;
+		}
+		else {
+			++a;
+			++b;
+		}
+	}
+}
+
+
+void subtract_bands(Builder& builder, Box const* a, Box const* a_end, Box const* b, Box const* b_end, int y1, int y2)
+{
+	for (; a != a_end; ++a) {
+
+		int x = a->x1;
+
+		// skip what lies entirely to the left of this span.  a span of b
+		// that reaches past this one is kept for the next.
+
+		while (b != b_end && b->x2 <= x) {
+			++b;
+		}
+
+		for (Box const* cut = b; cut != b_end && cut->x1 < a->x2; ++cut) {
+
+			if (cut->x1 > x) {
+				builder.add(x, y1, cut->x1, y2);
+			}
+
+			x = std::max(x, cut->x2);
+
+			if (x >= a->x2) {
+				break;
+			}
+		}
+
+		if (x < a->x2) {
+			builder.add(x, y1, a->x2, y2);
+		}
+	}
+}
+
+
+void combine_bands(Region::Operation operation, Builder& builder, Box const* a, Box const* a_end, Box const* b, Box const* b_end, int y1, int y2)
+{
+	builder.begin_band();
+
+	switch (operation) {
+		case Region::Operation::Unite:
+			unite_bands(builder, a, a_end, b, b_end, y1, y2);
+			break;
+		case Region::Operation::Intersect:
+			intersect_bands(builder, a, a_end, b, b_end, y1, y2);
+			break;
+		case Region::Operation::Subtract:
+			subtract_bands(builder, a, a_end, b, b_end, y1, y2);
+			break;
+	}
+
+	builder.end_band();
+}
+
+
+void copy_clipped_band(Builder& builder, Box const* begin, Box const* end, int y1, int y2)
+{
+	builder.begin_band();
+	builder.add_band(begin, end, y1, y2);
+	builder.end_band();
+}
+
+
+inline bool overlap(Box const& a, Box const& b)
+{
+	return a.x1 < b.x2 && b.x1 < a.x2 && a.y1 < b.y2 && b.y1 < a.y2;
+}
+
+
+} // namespace
+
+
+
+
+Region::Region()
+	: m_arena(nullptr)
+	, m_boxes(nullptr)
+	, m_count(0)
+	, m_extents{ 0, 0, 0, 0 }
+{}
+
+
+Region::Region(RegionArena& arena)
+	: m_arena(&arena)
+	, m_boxes(nullptr)
+	, m_count(0)
+	, m_extents{ 0, 0, 0, 0 }
+{}
+
+
+Region::Region(RegionArena& arena, int x, int y, int width, int height)
+	: Region(arena)
+{
+	if (width > 0 && height > 0) {
+
+		m_boxes = arena.allocate(1);
+		m_count = 1;
+
+		m_extents.x1 = x;
+		m_extents.y1 = y;
+		m_extents.x2 = x + width;
+		m_extents.y2 = y + height;
+
+		m_boxes[0] = m_extents;
+	}
+}
+
+
+Region::Region(RegionArena& arena, ::XRectangle const* begin, ::XRectangle const* end)
+	: Region(arena)
+{
+	// unite the rectangles pairwise, then the pairs pairwise and so on, which
+	// keeps each union small compared to adding one rectangle at a time.
+
+	std::size_t count = end - begin;
+
+	if (count == 0) {
+		return;
+	}
+
+	if (count == 1) {
+		*this = Region(arena, begin->x, begin->y, begin->width, begin->height);
+		return;
+	}
+
+	Region other(arena, begin + count / 2, end);
+
+	*this = Region(arena, begin, begin + count / 2);
+	unite(other);
+}
+
+
+
+
+Region::Region(Region&& other)
+	: Region()
+{
+	swap(*this, other);
+}
+
+
+Region& Region::operator=(Region&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+Region::~Region()
+{
+	// nothing to do: the boxes belong to the arena
+}
+
+
+
+
+void swap(Region& first, Region& second)
+{
+	using std::swap;
+
+	swap(first.m_arena, second.m_arena);
+	swap(first.m_boxes, second.m_boxes);
+	swap(first.m_count, second.m_count);
+	swap(first.m_extents, second.m_extents);
+}
+
+
+
+
+void Region::clear()
+{
+	m_boxes = nullptr;
+	m_count = 0;
+	m_extents = Box{ 0, 0, 0, 0 };
+}
+
+
+void Region::translate(int dx, int dy)
+{
+	if (m_count > 0) {
+
+		translate_boxes(m_boxes, m_count, dx, dy);
+
+		m_extents.x1 += dx;
+		m_extents.y1 += dy;
+		m_extents.x2 += dx;
+		m_extents.y2 += dy;
+	}
+}
+
+
+
+
+void Region::unite(Region const& other)
+{
+	combine(Operation::Unite, other);
+}
+
+
+void Region::intersect(Region const& other)
+{
+	combine(Operation::Intersect, other);
+}
+
+
+void Region::subtract(Region const& other)
+{
+	combine(Operation::Subtract, other);
+}
+
+
+void Region::unite(int x, int y, int width, int height)
+{
+	RegionArena* arena = m_arena;
+
+	if (arena != nullptr) {
+		unite(Region(*arena, x, y, width, height));
+	}
+}
+
+
+
+
+void Region::combine(Operation operation, Region const& other)
+{
+	// the cases that need no work, or only a copy
+
+	if (other.empty()) {
+		if (operation == Operation::Intersect) {
+			clear();
+		}
+		return;
+	}
+
+	if (empty()) {
+
+		if (operation == Operation::Unite) {
+
+			if (m_arena == nullptr) {
+				m_arena = other.m_arena;
+			}
+
+			m_boxes = m_arena->allocate(other.m_count);
+			m_count = other.m_count;
+			m_extents = other.m_extents;
+
+			std::copy(other.begin(), other.end(), m_boxes);
+		}
+		return;
+	}
+
+	if (!overlap(m_extents, other.m_extents)) {
+
+		if (operation == Operation::Intersect) {
+			clear();
+			return;
+		}
+
+		if (operation == Operation::Subtract) {
+			return;
+		}
+	}
+
+
+	// otherwise, walk down both regions a band at a time.  where only one of
+	// them has a band, that band is copied (if the operation keeps it);
+	// where both do, their overlap is combined.
+
+	bool keep_this = (operation != Operation::Intersect);
+	bool keep_other = (operation == Operation::Unite);
+
+	Builder builder(*m_arena, m_count + other.m_count);
+
+	Box const* a = begin();
+	Box const* a_end = end();
+	Box const* b = other.begin();
+	Box const* b_end = other.end();
+
+	int bottom = std::min(a->y1, b->y1);
+
+	while (a != a_end && b != b_end) {
+
+		Box const* a_band_end = band_end(a, a_end);
+		Box const* b_band_end = band_end(b, b_end);
+
+		int top;
+
+		if (a->y1 < b->y1) {
+			if (keep_this) {
+				int y1 = std::max(a->y1, bottom);
+				int y2 = std::min(a->y2, b->y1);
+				if (y1 < y2) {
+					copy_clipped_band(builder, a, a_band_end, y1, y2);
+				}
+			}
+			top = b->y1;
+		}
+
+		else if (b->y1 < a->y1) {
+			if (keep_other) {
+				int y1 = std::max(b->y1, bottom);
+				int y2 = std::min(b->y2, a->y1);
+				if (y1 < y2) {
+					copy_clipped_band(builder, b, b_band_end, y1, y2);
+				}
+			}
+			top = a->y1;
+		}
+
+		else {
+			top = a->y1;
+		}
+
+		bottom = std::min(a->y2, b->y2);
+
+		if (top < bottom) {
+			combine_bands(operation, builder, a, a_band_end, b, b_band_end, top, bottom);
+		}
+
+		if (a->y2 == bottom) {
+			a = a_band_end;
+		}
+
+		if (b->y2 == bottom) {
+			b = b_band_end;
+		}
+	}
+
+
+	// whatever is left of either region no longer overlaps the other
+
+	Box const* rest = nullptr;
+	Box const* rest_end = nullptr;
+
+	if (a != a_end && keep_this) {
+		rest = a;
+		rest_end = a_end;
+	}
+	else if (b != b_end && keep_other) {
+		rest = b;
+		rest_end = b_end;
+	}
+
+	while (rest != rest_end) {
+
+		Box const* rest_band_end = band_end(rest, rest_end);
+
+		copy_clipped_band(builder, rest, rest_band_end, std::max(rest->y1, bottom), rest->y2);
+
+		rest = rest_band_end;
+	}
+
+
+	m_boxes = builder.boxes();
+	m_count = builder.count();
+
+	if (m_count > 0) {
+		m_extents = measure(m_boxes, m_count);
+	}
+	else {
+		m_extents = Box{ 0, 0, 0, 0 };
+	}
+}
+
+
+} // namespace X11
@@ -0,0 +1,130 @@
+#ifndef ORTLE_X11_REGION_HPP
+#define ORTLE_X11_REGION_HPP
+
+
+#include <X11/Xlib.h>
+
+#include <cstddef>
+
+
+
+
+namespace X11 {
+
+
+class RegionArena;
+
+
+// a set of pixels, stored the way pixman and the X server store regions: a
+// list of boxes sorted into horizontal bands.  every box in a band has the
+// same top and bottom, boxes within a band are sorted left to right and
+// never touch, and two adjacent bands never have the same horizontal spans
+// (they would have been merged into one band).
+//
+// a region does not own its boxes.  they are allocated from a RegionArena,
+// and are only valid until the arena is reset.  the arena is meant to be
+// reset once per frame, so that regions are built and combined every frame
+// without allocating.
+
+class Region {
+
+public:
+
+	// x2 and y2 are exclusive
+
+	struct Box {
+
+		int x1;
+		int y1;
+		int x2;
+		int y2;
+
+	};
+
+
+public:
+
+	Region();
+	explicit Region(RegionArena& arena);
+	Region(RegionArena& arena, int x, int y, int width, int height);
+	Region(RegionArena& arena, ::XRectangle const* begin, ::XRectangle const* end);
+
+	Region(Region&& other);
+	Region& operator=(Region&& other);
+
+	~Region();
+
+	friend void swap(Region& first, Region& second);
+
+
+public:
+
+	bool empty() const
+	{
+		return m_count == 0;
+	}
+
+	std::size_t size() const
+	{
+		return m_count;
+	}
+
+	Box const& extents() const
+	{
+		return m_extents;
+	}
+
+	Box const* begin() const
+	{
+		return m_boxes;
+	}
+
+	Box const* end() const
+	{
+		return m_boxes + m_count;
+	}
+
+
+public:
+
+	void clear();
+
+	void translate(int dx, int dy);
+
+	void unite(Region const& other);
+	void intersect(Region const& other);
+	void subtract(Region const& other);
+
+	void unite(int x, int y, int width, int height);
+
+
+public:
+
+	enum class Operation {
+		Unite,
+		Intersect,
+		Subtract
+	};
+
+
+private:
+
+	void combine(Operation operation, Region const& other);
+
+
+private:
+
+	RegionArena* m_arena;
+
+	Box* m_boxes;
+	std::size_t m_count;
+
+	Box m_extents;
+
+};
+
+
+} // namespace X11
+
+
+#endif
@@ -0,0 +1,133 @@
+#include "region_arena.hpp"
+
+#include "region.hpp"
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+
+
+namespace X11 {
+
+
+namespace {
+
+
+std::size_t const l_default_capacity = 1024;
+
+
+} // namespace
+
+
+
+
+RegionArena::RegionArena()
+	: RegionArena(l_default_capacity)
+{}
+
+
+RegionArena::RegionArena(std::size_t capacity)
+	: m_blocks()
+	, m_used(0)
+{
+	add_block(std::max<std::size_t>(capacity, 1));
+}
+
+
+
+
+RegionArena::RegionArena(RegionArena&& other)
+	: m_blocks()
+	, m_used(0)
+{
+	swap(*this, other);
+}
+
+
+RegionArena& RegionArena::operator=(RegionArena&& other)
+{
+	swap(*this, other);
+	return *this;
+}
+
+
+
+
+RegionArena::~RegionArena()
+{
+	// nothing to do
+}
+
+
+
+
+void swap(RegionArena& first, RegionArena& second)
+{
+	using std::swap;
+
+	swap(first.m_blocks, second.m_blocks);
+	swap(first.m_used, second.m_used);
+}
+
+
+
+
+Region::Box* RegionArena::allocate(std::size_t count)
+{
+	assert(!m_blocks.empty());
+
+	if (m_used + count > m_blocks.back().capacity) {
+		add_block(std::max(count, 2 * m_blocks.back().capacity));
+	}
+
+	Region::Box* boxes = m_blocks.back().boxes.get() + m_used;
+	m_used += count;
+
+	return boxes;
+}
+
+
+void RegionArena::reset()
+{
+	if (m_blocks.size() > 1) {
+		std::size_t total = capacity();
+		m_blocks.clear();
+		add_block(total);
+	}
+
+	m_used = 0;
+}
+
+
+
+
+std::size_t RegionArena::capacity() const
+{
+	std::size_t total = 0;
+
+	for (auto const& block : m_blocks) {
+		total += block.capacity;
+	}
+
+	return total;
+}
+
+
+
+
+void RegionArena::add_block(std::size_t capacity)
+{
+	Block block = { std::unique_ptr<Region::Box[]>(new Region::Box[capacity]), capacity };
+
+	m_blocks.push_back(std::move(block));
+	m_used = 0;
+}
+
+
+} // namespace X11
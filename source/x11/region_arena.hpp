@@ -0,0 +1,75 @@
+#ifndef ORTLE_X11_REGION_ARENA_HPP
+#define ORTLE_X11_REGION_ARENA_HPP
+
+
+#include "region.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+
+
+namespace X11 {
+
+
+// storage for the boxes of any number of regions.  allocate() hands out
+// space from a block until it runs out, and reset() takes all of it back at
+// once.  when a frame needed more than one block, reset() replaces them with
+// a single block big enough for all of it, so that after the first few
+// frames the arena stops allocating altogether.
+
+class RegionArena {
+
+public:
+
+	RegionArena();
+	explicit RegionArena(std::size_t capacity);
+
+	RegionArena(RegionArena&& other);
+	RegionArena& operator=(RegionArena&& other);
+
+	~RegionArena();
+
+	friend void swap(RegionArena& first, RegionArena& second);
+
+
+public:
+
+	Region::Box* allocate(std::size_t count);
+
+	// invalidates every region allocated from this arena
+	void reset();
+
+
+public:
+
+	std::size_t capacity() const;
+
+
+private:
+
+	struct Block {
+
+		std::unique_ptr<Region::Box[]> boxes;
+		std::size_t capacity;
+
+	};
+
+
+	void add_block(std::size_t capacity);
+
+
+private:
+
+	std::vector<Block> m_blocks;
+	std::size_t m_used;
+
+};
+
+
+} // namespace X11
+
+
+#endif
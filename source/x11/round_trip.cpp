@@ -0,0 +1,76 @@
+#include "round_trip.hpp"
+
+#include "../utility/flight_recorder.hpp"
+#include "../utility/metrics.hpp"
+
+#include <chrono>
+
+
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+// the calling thread's tally, by site
+
+thread_local unsigned long t_counts[Utility::Metrics::RoundTripSiteCount];
+thread_local Clock::duration::rep t_times[Utility::Metrics::RoundTripSiteCount];
+
+
+} // namespace
+
+
+
+
+namespace X11 {
+
+
+RoundTrip::RoundTrip(Utility::Metrics::RoundTripSite site)
+	: m_site(site)
+	, m_begin(Clock::now())
+{}
+
+
+RoundTrip::~RoundTrip()
+{
+	Clock::time_point end = Clock::now();
+
+	Utility::FlightRecorder::record(Utility::Metrics::round_trip_name(m_site), 0, m_begin, end);
+	Utility::Metrics::add_round_trip(m_site, end - m_begin);
+
+	++t_counts[m_site];
+	t_times[m_site] += (end - m_begin).count();
+}
+
+
+
+
+RoundTrips take_round_trips()
+{
+	RoundTrips result = { 0, Clock::duration::zero(), Utility::Metrics::GetGeometry, 0, Clock::duration::zero() };
+
+	for (int i = 0; i < Utility::Metrics::RoundTripSiteCount; ++i) {
+
+		Clock::duration time(t_times[i]);
+
+		result.count += t_counts[i];
+		result.time += time;
+
+		if (t_counts[i] > 0 && (result.worst_count == 0 || time > result.worst_time)) {
+			result.worst_site = static_cast<Utility::Metrics::RoundTripSite>(i);
+			result.worst_count = t_counts[i];
+			result.worst_time = time;
+		}
+
+		t_counts[i] = 0;
+		t_times[i] = 0;
+	}
+
+	return result;
+}
+
+
+} // namespace X11
@@ -0,0 +1,67 @@
+#ifndef ORTLE_X11_ROUND_TRIP_HPP
+#define ORTLE_X11_ROUND_TRIP_HPP
+
+
+#include "../utility/metrics.hpp"
+
+#include <chrono>
+
+
+
+
+namespace X11 {
+
+
+// wraps a blocking Xlib call, e.g.
+//
+//   X11::RoundTrip round_trip(Utility::Metrics::GetGeometry);
+//   XGetGeometry(...);
+//
+// and from its construction to its destruction times it.  each one is a
+// span in the flight recorder, named after its site, is added to the
+// metrics, and is added to the calling thread's tally (see take_round_trips).
+
+class RoundTrip {
+
+public:
+
+	explicit RoundTrip(Utility::Metrics::RoundTripSite site);
+
+	RoundTrip(RoundTrip const&) = delete;
+	RoundTrip& operator=(RoundTrip const&) = delete;
+
+	~RoundTrip();
+
+
+private:
+
+	Utility::Metrics::RoundTripSite m_site;
+	std::chrono::steady_clock::time_point m_begin;
+
+};
+
+
+
+
+// the calling thread's round trips since it last asked, and the site that
+// took longest in total
+
+struct RoundTrips {
+
+	unsigned long count;
+	std::chrono::steady_clock::duration time;
+
+	Utility::Metrics::RoundTripSite worst_site;
+	unsigned long worst_count;
+	std::chrono::steady_clock::duration worst_time;
+
+};
+
+
+RoundTrips take_round_trips();
+
+
+} // namespace X11
+
+
+#endif
@@ -1,5 +1,10 @@
 #include "shape_extents.hpp"
 
+#include "round_trip.hpp"
+#include "xlib.hpp"
+
+#include "../utility/metrics.hpp"
+
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
 
@@ -18,7 +23,9 @@ ShapeExtents::ShapeExtents(::Display* display, ::Window target)
 	assert(target != None);
 
 
-	XShapeQueryExtents(
+	RoundTrip round_trip(Utility::Metrics::ShapeQueryExtents);
+
+	Xlib::ShapeQueryExtents(
 		display, target,
 		&bounding_shaped, &bounding_x, &bounding_y, &bounding_width, &bounding_height,
 		&clip_shaped, &clip_x, &clip_y, &clip_width, &clip_height
@@ -1,6 +1,10 @@
 #include "wallpaper_pixmap.hpp"
 
 #include "exceptions.hpp"
+#include "round_trip.hpp"
+#include "xlib.hpp"
+
+#include "../utility/metrics.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
@@ -32,7 +36,12 @@ namespace {
 		unsigned long count;
 		unsigned long bytes;
 		unsigned char* data;
-		if (XGetWindowProperty(display, root, atom, 0l, 1l, False, AnyPropertyType, &type, &format, &count, &bytes, &data) == Success) {
+		int status = BadImplementation;
+		{
+			X11::RoundTrip round_trip(Utility::Metrics::GetWallpaperProperty);
+			status = X11::Xlib::GetWindowProperty(display, root, atom, 0l, 1l, False, AnyPropertyType, &type, &format, &count, &bytes, &data);
+		}
+		if (status == Success) {
 			if ((type == XA_PIXMAP) && (format == 32) && (count == 1l) && (bytes == 0l)) {
 				result = *(reinterpret_cast<::Pixmap*>(data));
 			}
@@ -85,9 +94,9 @@ bool WallpaperPixmap::is_compatible_atom(::Atom atom)
 
 void WallpaperPixmap::load_atoms(::Display* display)
 {
-	l_esetroot_pmap_id = XInternAtom(display, "ESETROOT_PMAP_ID", True);
-	l_xrootpmap_id = XInternAtom(display, "_XROOTPMAP_ID", True);
-	l_xsetroot_id = XInternAtom(display, "_XSETROOT_ID", True);
+	l_esetroot_pmap_id = Xlib::InternAtom(display, "ESETROOT_PMAP_ID", True);
+	l_xrootpmap_id = Xlib::InternAtom(display, "_XROOTPMAP_ID", True);
+	l_xsetroot_id = Xlib::InternAtom(display, "_XSETROOT_ID", True);
 }
 
 
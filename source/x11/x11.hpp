@@ -5,7 +5,7 @@
 #include "colormap.hpp"
 #include "composite_manager_atom.hpp"
 #include "composite_overlay.hpp"
-// #include "damage.hpp"
+#include "damage.hpp"
 #include "display.hpp"
 #include "error_handler.hpp"
 #include "exceptions.hpp"
@@ -14,9 +14,13 @@
 #include "geometry.hpp"
 #include "pixmap.hpp"
 #include "rectangle_list.hpp"
+#include "region.hpp"
+#include "region_arena.hpp"
+#include "round_trip.hpp"
 #include "shape_extents.hpp"
 #include "visual_info.hpp"
 #include "window.hpp"
+#include "xlib.hpp"
 
 
 #endif
@@ -0,0 +1,84 @@
+#include "xlib.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xcomposite.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+
+
+
+
+namespace X11 {
+
+
+namespace Xlib {
+
+
+::Atom (*InternAtom)(::Display*, char const*, Bool) = &XInternAtom;
+Status (*GetWindowAttributes)(::Display*, ::Window, XWindowAttributes*) = &XGetWindowAttributes;
+int (*GetWindowProperty)(::Display*, ::Window, ::Atom, long, long, Bool, ::Atom, ::Atom*, int*, unsigned long*, unsigned long*, unsigned char**) = &XGetWindowProperty;
+Status (*QueryTree)(::Display*, ::Window, ::Window*, ::Window*, ::Window**, unsigned int*) = &XQueryTree;
+Status (*GetGeometry)(::Display*, ::Drawable, ::Window*, int*, int*, unsigned int*, unsigned int*, unsigned int*, unsigned int*) = &XGetGeometry;
+Bool (*TranslateCoordinates)(::Display*, ::Window, ::Window, int, int, int*, int*, ::Window*) = &XTranslateCoordinates;
+Status (*ShapeQueryExtents)(::Display*, ::Window, Bool*, int*, int*, unsigned int*, unsigned int*, Bool*, int*, int*, unsigned int*, unsigned int*) = &XShapeQueryExtents;
+XRectangle* (*ShapeGetRectangles)(::Display*, ::Window, int, int*, int*) = &XShapeGetRectangles;
+
+Visual* (*ScreenVisual)(::Display*, int) = &XDefaultVisual;
+int (*ScreenDepth)(::Display*, int) = &XDefaultDepth;
+GC (*ScreenGC)(::Display*, int) = &XDefaultGC;
+
+::Pixmap (*CompositeNameWindowPixmap)(::Display*, ::Window) = &XCompositeNameWindowPixmap;
+
+void (*CompositeRedirectSubwindows)(::Display*, ::Window, int) = &XCompositeRedirectSubwindows;
+void (*CompositeUnredirectSubwindows)(::Display*, ::Window, int) = &XCompositeUnredirectSubwindows;
+::Damage (*DamageCreate)(::Display*, ::Drawable, int) = &XDamageCreate;
+void (*DamageDestroy)(::Display*, ::Damage) = &XDamageDestroy;
+void (*DamageSubtract)(::Display*, ::Damage, XserverRegion, XserverRegion) = &XDamageSubtract;
+::Pixmap (*CreatePixmap)(::Display*, ::Drawable, unsigned int, unsigned int, unsigned int) = &XCreatePixmap;
+int (*FreePixmap)(::Display*, ::Pixmap) = &XFreePixmap;
+int (*CopyArea)(::Display*, ::Drawable, ::Drawable, GC, int, int, unsigned int, unsigned int, int, int) = &XCopyArea;
+int (*SelectInput)(::Display*, ::Window, long) = &XSelectInput;
+void (*ShapeSelectInput)(::Display*, ::Window, unsigned long) = &XShapeSelectInput;
+int (*GrabServer)(::Display*) = &XGrabServer;
+int (*UngrabServer)(::Display*) = &XUngrabServer;
+
+
+
+
+void reset()
+{
+	InternAtom = &XInternAtom;
+	GetWindowAttributes = &XGetWindowAttributes;
+	GetWindowProperty = &XGetWindowProperty;
+	QueryTree = &XQueryTree;
+	GetGeometry = &XGetGeometry;
+	TranslateCoordinates = &XTranslateCoordinates;
+	ShapeQueryExtents = &XShapeQueryExtents;
+	ShapeGetRectangles = &XShapeGetRectangles;
+
+	ScreenVisual = &XDefaultVisual;
+	ScreenDepth = &XDefaultDepth;
+	ScreenGC = &XDefaultGC;
+
+	CompositeNameWindowPixmap = &XCompositeNameWindowPixmap;
+
+	CompositeRedirectSubwindows = &XCompositeRedirectSubwindows;
+	CompositeUnredirectSubwindows = &XCompositeUnredirectSubwindows;
+	DamageCreate = &XDamageCreate;
+	DamageDestroy = &XDamageDestroy;
+	DamageSubtract = &XDamageSubtract;
+	CreatePixmap = &XCreatePixmap;
+	FreePixmap = &XFreePixmap;
+	CopyArea = &XCopyArea;
+	SelectInput = &XSelectInput;
+	ShapeSelectInput = &XShapeSelectInput;
+	GrabServer = &XGrabServer;
+	UngrabServer = &XUngrabServer;
+}
+
+
+} // namespace Xlib
+
+
+} // namespace X11
@@ -0,0 +1,81 @@
+#ifndef ORTLE_X11_XLIB_HPP
+#define ORTLE_X11_XLIB_HPP
+
+
+#include <X11/Xlib.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+
+
+
+
+// the Xlib calls that window management makes: WindowManager, the managed
+// windows, and the helpers in this directory that they use.  they are made
+// through these pointers, which point to Xlib's own functions unless
+// something has replaced them (EventRecorder, to record the replies,
+// EventPlayer, to answer from a recording, and the fake server of
+// benchmark/window_manager.cpp, to answer without a server at all).
+// replacements are installed before any thread that uses them starts, and
+// removed after they all stop.
+//
+// whoever replaces a call has to pass on calls for displays other than the
+// one they are interested in, since the render threads use some of these
+// too.
+
+namespace X11 {
+
+
+namespace Xlib {
+
+
+// with replies
+
+extern ::Atom (*InternAtom)(::Display*, char const*, Bool);
+extern Status (*GetWindowAttributes)(::Display*, ::Window, XWindowAttributes*);
+extern int (*GetWindowProperty)(::Display*, ::Window, ::Atom, long, long, Bool, ::Atom, ::Atom*, int*, unsigned long*, unsigned long*, unsigned char**);
+extern Status (*QueryTree)(::Display*, ::Window, ::Window*, ::Window*, ::Window**, unsigned int*);
+extern Status (*GetGeometry)(::Display*, ::Drawable, ::Window*, int*, int*, unsigned int*, unsigned int*, unsigned int*, unsigned int*);
+extern Bool (*TranslateCoordinates)(::Display*, ::Window, ::Window, int, int, int*, int*, ::Window*);
+extern Status (*ShapeQueryExtents)(::Display*, ::Window, Bool*, int*, int*, unsigned int*, unsigned int*, Bool*, int*, int*, unsigned int*, unsigned int*);
+extern XRectangle* (*ShapeGetRectangles)(::Display*, ::Window, int, int*, int*);
+
+// answered from what the connection already knows: XDefaultVisual,
+// XDefaultDepth and XDefaultGC, whose shorter names Xlib has taken as macros
+
+extern Visual* (*ScreenVisual)(::Display*, int);
+extern int (*ScreenDepth)(::Display*, int);
+extern GC (*ScreenGC)(::Display*, int);
+
+// no reply, but the pixmap it names is the window's contents
+
+extern ::Pixmap (*CompositeNameWindowPixmap)(::Display*, ::Window);
+
+// without replies
+
+extern void (*CompositeRedirectSubwindows)(::Display*, ::Window, int);
+extern void (*CompositeUnredirectSubwindows)(::Display*, ::Window, int);
+extern ::Damage (*DamageCreate)(::Display*, ::Drawable, int);
+extern void (*DamageDestroy)(::Display*, ::Damage);
+extern void (*DamageSubtract)(::Display*, ::Damage, XserverRegion, XserverRegion);
+extern ::Pixmap (*CreatePixmap)(::Display*, ::Drawable, unsigned int, unsigned int, unsigned int);
+extern int (*FreePixmap)(::Display*, ::Pixmap);
+extern int (*CopyArea)(::Display*, ::Drawable, ::Drawable, GC, int, int, unsigned int, unsigned int, int, int);
+extern int (*SelectInput)(::Display*, ::Window, long);
+extern void (*ShapeSelectInput)(::Display*, ::Window, unsigned long);
+extern int (*GrabServer)(::Display*);
+extern int (*UngrabServer)(::Display*);
+
+
+// points every call back at Xlib
+
+void reset();
+
+
+} // namespace Xlib
+
+
+} // namespace X11
+
+
+#endif